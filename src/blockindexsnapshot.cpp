@@ -0,0 +1,311 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockindexsnapshot.h"
+
+#include "chain.h"
+#include "crypto/sha256.h"
+#include "fs.h"
+#include "main.h"
+#include "sync.h"
+#include "uint256.h"
+#include "util.h"
+#include "utiltime.h"
+
+#include <algorithm>
+#include <limits>
+#include <string.h>
+#include <unordered_map>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace {
+//! "PBIS", stored in host byte order so a snapshot from a different architecture is rejected
+static const uint32_t SNAPSHOT_MAGIC = 0x53494250;
+static const uint32_t SNAPSHOT_VERSION = 1;
+//! Entries written per fwrite call
+static const size_t SNAPSHOT_WRITE_BATCH = 4096;
+
+struct CSnapshotHeader {
+    uint32_t nMagic;
+    uint32_t nVersion;
+    uint32_t nEntrySize;
+    uint32_t nReserved;
+    uint64_t nEntries;
+    unsigned char hashBestBlock[32];
+};
+
+/** One block index entry; links are record numbers, -1 for none */
+struct CSnapshotEntry {
+    unsigned char hashBlock[32];
+    unsigned char nChainWork[32];
+    unsigned char hashMerkleRoot[32];
+    unsigned char nAccumulatorCheckpoint[32];
+    unsigned char hashProofOfStake[32];
+    unsigned char prevoutStakeHash[32];
+    unsigned char hashPoAMerkleRoot[32];
+    unsigned char minedHash[32];
+    unsigned char hashPrevPoABlock[32];
+    int64_t nMint;
+    int64_t nMoneySupply;
+    uint64_t nStakeModifier;
+    int32_t nPrev;
+    int32_t nNext;
+    int32_t nSkip;
+    int32_t nPrevPoA;
+    int32_t nPrevPoS;
+    int32_t nHeight;
+    int32_t nFile;
+    uint32_t nDataPos;
+    uint32_t nUndoPos;
+    uint32_t nTx;
+    uint32_t nStatus;
+    uint32_t nFlags;
+    uint32_t prevoutStakeN;
+    uint32_t nStakeTime;
+    int32_t nVersion;
+    uint32_t nTime;
+    uint32_t nBits;
+    uint32_t nNonce;
+    int32_t nAuditedPoSHeight;
+    uint32_t nReserved;
+};
+
+static_assert(sizeof(CSnapshotHeader) % 8 == 0, "snapshot entries must stay aligned when mapped");
+
+fs::path GetBlockIndexSnapshotPath()
+{
+    return GetDataDir() / "blockindex.snapshot";
+}
+
+bool WriteAndHash(FILE* file, CSHA256& hasher, const void* data, size_t nLen)
+{
+    hasher.Write((const unsigned char*)data, nLen);
+    return fwrite(data, 1, nLen, file) == nLen;
+}
+
+bool LoadSnapshotEntries(const fs::path& path, const uint256& hashBestBlock, std::vector<CBlockIndex*>& vSortedByHeight)
+{
+    boost::interprocess::file_mapping mapping(path.string().c_str(), boost::interprocess::read_only);
+    boost::interprocess::mapped_region region(mapping, boost::interprocess::read_only);
+    const unsigned char* pbegin = (const unsigned char*)region.get_address();
+    const size_t nSize = region.get_size();
+
+    CSnapshotHeader header;
+    if (nSize < sizeof(header) + CSHA256::OUTPUT_SIZE)
+        return error("%s : snapshot is truncated", __func__);
+    memcpy(&header, pbegin, sizeof(header));
+    if (header.nMagic != SNAPSHOT_MAGIC || header.nVersion != SNAPSHOT_VERSION || header.nEntrySize != sizeof(CSnapshotEntry))
+        return error("%s : unsupported snapshot format", __func__);
+    if (memcmp(header.hashBestBlock, hashBestBlock.begin(), 32) != 0) {
+        LogPrintf("%s: snapshot was not written at the current best block, ignoring it\n", __func__);
+        return false;
+    }
+    if (header.nEntries == 0 || header.nEntries > (uint64_t)std::numeric_limits<int32_t>::max() ||
+        nSize != sizeof(header) + header.nEntries * sizeof(CSnapshotEntry) + CSHA256::OUTPUT_SIZE)
+        return error("%s : snapshot size does not match its %u entries", __func__, header.nEntries);
+
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(pbegin, nSize - CSHA256::OUTPUT_SIZE).Finalize(checksum);
+    if (memcmp(checksum, pbegin + nSize - CSHA256::OUTPUT_SIZE, CSHA256::OUTPUT_SIZE) != 0)
+        return error("%s : snapshot checksum mismatch", __func__);
+
+    // Check every link before touching mapBlockIndex; ancestors always come first
+    const CSnapshotEntry* pentries = (const CSnapshotEntry*)(pbegin + sizeof(header));
+    const int32_t nEntries = header.nEntries;
+    for (int32_t i = 0; i < nEntries; i++) {
+        const CSnapshotEntry& entry = pentries[i];
+        if ((i > 0 && entry.nHeight < pentries[i - 1].nHeight) ||
+            entry.nPrev < -1 || entry.nPrev >= i || entry.nSkip < -1 || entry.nSkip >= i ||
+            entry.nPrevPoA < -1 || entry.nPrevPoA >= i || entry.nPrevPoS < -1 || entry.nPrevPoS >= i ||
+            entry.nNext < -1 || entry.nNext >= nEntries)
+            return error("%s : snapshot entry %d is not linked correctly", __func__, i);
+    }
+
+    mapBlockIndex.reserve(nEntries);
+    CBlockIndex* pArena = AllocateBlockIndexArena(nEntries);
+    auto Relocate = [pArena](int32_t nPos) -> CBlockIndex* { return nPos < 0 ? NULL : pArena + nPos; };
+    vSortedByHeight.reserve(nEntries);
+    for (int32_t i = 0; i < nEntries; i++) {
+        const CSnapshotEntry& entry = pentries[i];
+        CBlockIndex* pindex = pArena + i;
+        uint256 hash;
+        memcpy(hash.begin(), entry.hashBlock, 32);
+        BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(hash, pindex)).first;
+        pindex->phashBlock = &((*mi).first);
+        pindex->pprev = Relocate(entry.nPrev);
+        pindex->pnext = Relocate(entry.nNext);
+        pindex->pskip = Relocate(entry.nSkip);
+        pindex->pprevPoA = Relocate(entry.nPrevPoA);
+        pindex->pprevPoS = Relocate(entry.nPrevPoS);
+        memcpy(pindex->nChainWork.begin(), entry.nChainWork, 32);
+        pindex->nHeight = entry.nHeight;
+        pindex->nFile = entry.nFile;
+        pindex->nDataPos = entry.nDataPos;
+        pindex->nUndoPos = entry.nUndoPos;
+        pindex->nTx = entry.nTx;
+        pindex->nStatus = entry.nStatus;
+        pindex->nVersion = entry.nVersion;
+        memcpy(pindex->hashMerkleRoot.begin(), entry.hashMerkleRoot, 32);
+        pindex->nTime = entry.nTime;
+        pindex->nBits = entry.nBits;
+        pindex->nNonce = entry.nNonce;
+        memcpy(pindex->nAccumulatorCheckpoint.begin(), entry.nAccumulatorCheckpoint, 32);
+
+        //Proof of Audit
+        memcpy(pindex->hashPoAMerkleRoot.begin(), entry.hashPoAMerkleRoot, 32);
+        memcpy(pindex->minedHash.begin(), entry.minedHash, 32);
+        memcpy(pindex->hashPrevPoABlock.begin(), entry.hashPrevPoABlock, 32);
+        pindex->nAuditedPoSHeight = entry.nAuditedPoSHeight;
+
+        //Proof Of Stake
+        pindex->nMint = entry.nMint;
+        pindex->nMoneySupply = entry.nMoneySupply;
+        pindex->nFlags = entry.nFlags;
+        pindex->nStakeModifier = entry.nStakeModifier;
+        memcpy(pindex->prevoutStake.hash.begin(), entry.prevoutStakeHash, 32);
+        pindex->prevoutStake.n = entry.prevoutStakeN;
+        pindex->nStakeTime = entry.nStakeTime;
+        memcpy(pindex->hashProofOfStake.begin(), entry.hashProofOfStake, 32);
+
+        vSortedByHeight.push_back(pindex);
+    }
+    return true;
+}
+}
+
+bool WriteBlockIndexSnapshot(const uint256& hashBestBlock)
+{
+    AssertLockHeld(cs_main);
+    if (mapBlockIndex.empty())
+        return false;
+    int64_t nStart = GetTimeMillis();
+
+    // mapBlockIndex may hold NULL entries for hashes looked up before their block is known
+    std::vector<const CBlockIndex*> vSorted;
+    vSorted.reserve(mapBlockIndex.size());
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+        if (item.second)
+            vSorted.push_back(item.second);
+    }
+    if (vSorted.empty())
+        return false;
+    std::sort(vSorted.begin(), vSorted.end(), [](const CBlockIndex* a, const CBlockIndex* b) { return a->nHeight < b->nHeight; });
+    std::unordered_map<const CBlockIndex*, int32_t> mapPos;
+    mapPos.reserve(vSorted.size());
+    for (size_t i = 0; i < vSorted.size(); i++)
+        mapPos.emplace(vSorted[i], (int32_t)i);
+    bool fLinked = true;
+    auto Position = [&mapPos, &fLinked](const CBlockIndex* pindex) -> int32_t {
+        if (!pindex) return -1;
+        auto it = mapPos.find(pindex);
+        if (it == mapPos.end()) {
+            fLinked = false;
+            return -1;
+        }
+        return it->second;
+    };
+
+    fs::path path = GetBlockIndexSnapshotPath();
+    fs::path pathTmp = path;
+    pathTmp += ".new";
+    FILE* file = fsbridge::fopen(pathTmp, "wb");
+    if (!file)
+        return error("%s : failed to open %s", __func__, pathTmp.string());
+
+    CSHA256 hasher;
+    CSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    header.nMagic = SNAPSHOT_MAGIC;
+    header.nVersion = SNAPSHOT_VERSION;
+    header.nEntrySize = sizeof(CSnapshotEntry);
+    header.nEntries = vSorted.size();
+    memcpy(header.hashBestBlock, hashBestBlock.begin(), 32);
+    bool fOk = WriteAndHash(file, hasher, &header, sizeof(header));
+
+    std::vector<CSnapshotEntry> vBatch;
+    vBatch.reserve(SNAPSHOT_WRITE_BATCH);
+    for (size_t i = 0; fOk && i < vSorted.size(); i++) {
+        const CBlockIndex* pindex = vSorted[i];
+        vBatch.emplace_back();
+        CSnapshotEntry& entry = vBatch.back();
+        memset(&entry, 0, sizeof(entry));
+        memcpy(entry.hashBlock, pindex->phashBlock->begin(), 32);
+        entry.nPrev = Position(pindex->pprev);
+        entry.nNext = Position(pindex->pnext);
+        entry.nSkip = Position(pindex->pskip);
+        entry.nPrevPoA = Position(pindex->pprevPoA);
+        entry.nPrevPoS = Position(pindex->pprevPoS);
+        memcpy(entry.nChainWork, pindex->nChainWork.begin(), 32);
+        entry.nHeight = pindex->nHeight;
+        entry.nFile = pindex->nFile;
+        entry.nDataPos = pindex->nDataPos;
+        entry.nUndoPos = pindex->nUndoPos;
+        entry.nTx = pindex->nTx;
+        entry.nStatus = pindex->nStatus;
+        entry.nVersion = pindex->nVersion;
+        memcpy(entry.hashMerkleRoot, pindex->hashMerkleRoot.begin(), 32);
+        entry.nTime = pindex->nTime;
+        entry.nBits = pindex->nBits;
+        entry.nNonce = pindex->nNonce;
+        memcpy(entry.nAccumulatorCheckpoint, pindex->nAccumulatorCheckpoint.begin(), 32);
+        memcpy(entry.hashPoAMerkleRoot, pindex->hashPoAMerkleRoot.begin(), 32);
+        memcpy(entry.minedHash, pindex->minedHash.begin(), 32);
+        memcpy(entry.hashPrevPoABlock, pindex->hashPrevPoABlock.begin(), 32);
+        entry.nAuditedPoSHeight = pindex->nAuditedPoSHeight;
+        entry.nMint = pindex->nMint;
+        entry.nMoneySupply = pindex->nMoneySupply;
+        entry.nFlags = pindex->nFlags;
+        entry.nStakeModifier = pindex->nStakeModifier;
+        memcpy(entry.prevoutStakeHash, pindex->prevoutStake.hash.begin(), 32);
+        entry.prevoutStakeN = pindex->prevoutStake.n;
+        entry.nStakeTime = pindex->nStakeTime;
+        memcpy(entry.hashProofOfStake, pindex->hashProofOfStake.begin(), 32);
+        if (vBatch.size() == SNAPSHOT_WRITE_BATCH || i + 1 == vSorted.size()) {
+            fOk = WriteAndHash(file, hasher, vBatch.data(), vBatch.size() * sizeof(CSnapshotEntry));
+            vBatch.clear();
+        }
+    }
+
+    unsigned char checksum[CSHA256::OUTPUT_SIZE];
+    hasher.Finalize(checksum);
+    fOk = fOk && fLinked && fwrite(checksum, 1, sizeof(checksum), file) == sizeof(checksum);
+    if (fOk)
+        FileCommit(file);
+    fclose(file);
+    if (!fOk || !RenameOver(pathTmp, path)) {
+        fs::remove(pathTmp);
+        return error("%s : failed to write %s", __func__, path.string());
+    }
+
+    LogPrintf("%s: wrote %u block index entries in %dms\n", __func__, vSorted.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
+bool ReadBlockIndexSnapshot(const uint256& hashBestBlock, std::vector<CBlockIndex*>& vSortedByHeight)
+{
+    AssertLockHeld(cs_main);
+    fs::path path = GetBlockIndexSnapshotPath();
+    if (!mapBlockIndex.empty() || !fs::exists(path))
+        return false;
+    int64_t nStart = GetTimeMillis();
+    try {
+        if (!LoadSnapshotEntries(path, hashBestBlock, vSortedByHeight))
+            return false;
+    } catch (const std::exception& e) {
+        return error("%s : failed to map %s: %s", __func__, path.string(), e.what());
+    }
+    LogPrintf("%s: loaded %u block index entries in %dms\n", __func__, vSortedByHeight.size(), GetTimeMillis() - nStart);
+    return true;
+}
+
+void RemoveBlockIndexSnapshot()
+{
+    try {
+        fs::remove(GetBlockIndexSnapshotPath());
+    } catch (const fs::filesystem_error& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+    }
+}
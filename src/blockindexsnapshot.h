@@ -0,0 +1,41 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PRCYCOIN_BLOCKINDEXSNAPSHOT_H
+#define PRCYCOIN_BLOCKINDEXSNAPSHOT_H
+
+#include <vector>
+
+class CBlockIndex;
+class uint256;
+
+/** Default for -blockindexsnapshot */
+static const bool DEFAULT_BLOCKINDEX_SNAPSHOT = true;
+
+/**
+ * Block index snapshot: a flat copy of the linked block index written at a
+ * clean shutdown, so the next start can map it instead of deserializing and
+ * hashing every entry of the block tree database.
+ *
+ * Entries are fixed size records stored by height. Links between entries are
+ * stored as record numbers and relocated to pointers on load; nChainWork and
+ * the skip, PoA and PoS predecessor pointers are kept so they need not be
+ * derived again. The snapshot is only valid for the block tree database it was
+ * written with, so it records the best block and is removed once read.
+ */
+
+/** Write the snapshot of mapBlockIndex for the chain state at hashBestBlock. */
+bool WriteBlockIndexSnapshot(const uint256& hashBestBlock);
+
+/**
+ * Load the snapshot into the empty mapBlockIndex if it was written at
+ * hashBestBlock. On success vSortedByHeight holds the new entries by height;
+ * on failure mapBlockIndex is left untouched.
+ */
+bool ReadBlockIndexSnapshot(const uint256& hashBestBlock, std::vector<CBlockIndex*>& vSortedByHeight);
+
+/** Remove the snapshot; it must not outlive the block tree state it describes. */
+void RemoveBlockIndexSnapshot();
+
+#endif // PRCYCOIN_BLOCKINDEXSNAPSHOT_H
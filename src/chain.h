@@ -174,6 +174,12 @@ public:
     //! pointer to the index of some further predecessor of this block
     CBlockIndex* pskip;
 
+    //! (memory only) pointer to the index of the nearest PoA predecessor of this block
+    CBlockIndex* pprevPoA;
+
+    //! (memory only) pointer to the index of the nearest PoS predecessor of this block
+    CBlockIndex* pprevPoS;
+
     //ppcoin: trust score of block chain
     uint256 bnChainTrust;
 
@@ -210,6 +216,8 @@ public:
         BLOCK_STAKE_ENTROPY = (1 << 1),  // entropy bit for stake modifier
         BLOCK_STAKE_MODIFIER = (1 << 2), // regenerated stake modifier
         BLOCK_PROOF_OF_AUDIT = (1 << 3), //Added for PoA blocks
+        BLOCK_POS_AUDITED = (1 << 4),    // PoS block passed the PoA audit checks when connected
+        BLOCK_AUDITED_HEIGHT = (1 << 5), // PoA block has nAuditedPoSHeight set
     };
 
     // proof-of-stake specific fields
@@ -235,6 +243,9 @@ public:
     uint256 minedHash;
     uint256 hashPrevPoABlock;
 
+    //! PoA blocks: height of the last PoS block audited
+    int nAuditedPoSHeight;
+
     //! (memory only) Sequential id assigned to distinguish order in which blocks are received.
     uint32_t nSequenceId;
     
@@ -243,6 +254,8 @@ public:
         phashBlock = NULL;
         pprev = NULL;
         pskip = NULL;
+        pprevPoA = NULL;
+        pprevPoS = NULL;
         nHeight = 0;
         nFile = 0;
         nDataPos = 0;
@@ -271,6 +284,7 @@ public:
         hashPoAMerkleRoot = UINT256_ZERO;
         minedHash = UINT256_ZERO;
         hashPrevPoABlock = UINT256_ZERO;
+        nAuditedPoSHeight = 0;
     }
 
     CBlockIndex()
@@ -301,6 +315,8 @@ public:
 
         if (block.IsProofOfAudit()) {
             SetProofOfAudit();
+            if (!block.posBlocksAudited.empty())
+                SetAuditedPoSHeight(block.posBlocksAudited.back().height);
             hashPrevPoABlock = block.hashPrevPoABlock;
             minedHash = block.minedHash;
             hashPoAMerkleRoot = block.hashPoAMerkleRoot;
@@ -406,6 +422,32 @@ public:
         nFlags |= BLOCK_PROOF_OF_AUDIT;
     }
 
+    bool IsPoABlockByVersion() const
+    {
+        return nVersion >= CBlockHeader::POA_BLOCK_VERSION_LOW_LIMIT;
+    }
+
+    bool HasAuditedPoSHeight() const
+    {
+        return (nFlags & BLOCK_AUDITED_HEIGHT);
+    }
+
+    void SetAuditedPoSHeight(int nHeightIn)
+    {
+        nAuditedPoSHeight = nHeightIn;
+        nFlags |= BLOCK_AUDITED_HEIGHT;
+    }
+
+    bool IsPoSAudited() const
+    {
+        return (nFlags & BLOCK_POS_AUDITED);
+    }
+
+    void SetPoSAudited()
+    {
+        nFlags |= BLOCK_POS_AUDITED;
+    }
+
     unsigned int GetStakeEntropyBit() const
     {
         unsigned int nEntropyBit = ((GetBlockHash().GetCheapHash()) & 1);
@@ -476,6 +518,9 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! Build the previous PoA and PoS block pointers for this entry; pprev must have them already.
+    void BuildPrevPoAPoS();
+
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
@@ -550,6 +595,8 @@ public:
         READWRITE(nBits);
         READWRITE(nNonce);
 
+        if (nFlags & BLOCK_AUDITED_HEIGHT)
+            READWRITE(VARINT(nAuditedPoSHeight));
     }
 
     uint256 GetBlockHash() const
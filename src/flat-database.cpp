@@ -0,0 +1,136 @@
+// Copyright (c) 2014-2015 The Dash developers
+// Copyright (c) 2015-2018 The PIVX developers
+// Copyright (c) 2018-2020 The DAPS Project developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flat-database.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "hash.h"
+#include "util.h"
+
+CFlatDB::CFlatDB(const std::string& strFilenameIn, const std::string& strMagicMessageIn)
+{
+    pathDB = GetDataDir() / strFilenameIn;
+    strFilename = strFilenameIn;
+    strMagicMessage = strMagicMessageIn;
+}
+
+template <typename Stream>
+CFlatDB::ReadResult CFlatDB::ReadHeader(Stream& s) const
+{
+    unsigned char pchMsgTmp[4];
+    std::string strMagicMessageTmp;
+    try {
+        // de-serialize file header (cache file specific magic message) and ..
+        s >> strMagicMessageTmp;
+
+        // ... verify the message matches predefined one
+        if (strMagicMessage != strMagicMessageTmp) {
+            error("%s : Invalid %s magic message", __func__, strFilename);
+            return IncorrectMagicMessage;
+        }
+
+        // de-serialize file header (network specific magic number) and ..
+        s >> FLATDATA(pchMsgTmp);
+
+        // ... verify the network matches ours
+        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
+            error("%s : Invalid network magic number", __func__);
+            return IncorrectMagicNumber;
+        }
+    } catch (const std::exception& e) {
+        error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        return IncorrectFormat;
+    }
+    return Ok;
+}
+
+CFlatDB::ReadResult CFlatDB::ReadStream(CDataStream& ssObj, bool fDryRun) const
+{
+    // open input file, and associate with CAutoFile
+    FILE* file = fsbridge::fopen(pathDB, "rb");
+    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        error("%s : Failed to open file %s", __func__, pathDB.string());
+        return FileError;
+    }
+
+    // a dry run only checks that the file is ours to overwrite
+    if (fDryRun)
+        return ReadHeader(filein);
+
+    // use file size to size memory buffer
+    int fileSize = fs::file_size(pathDB);
+    int dataSize = fileSize - sizeof(uint256);
+    // Don't try to resize to a negative number if file is small
+    if (dataSize < 0)
+        dataSize = 0;
+    std::vector<unsigned char> vchData;
+    vchData.resize(dataSize);
+    uint256 hashIn;
+
+    // read data and checksum from file
+    try {
+        filein.read((char*)&vchData[0], dataSize);
+        filein >> hashIn;
+    } catch (const std::exception& e) {
+        error("%s : Deserialize or I/O error - %s", __func__, e.what());
+        return HashReadError;
+    }
+    filein.fclose();
+
+    ssObj.clear();
+    ssObj.write((const char*)vchData.data(), vchData.size());
+
+    // verify stored checksum matches input data
+    uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
+    if (hashIn != hashTmp) {
+        error("%s : Checksum mismatch, data corrupted", __func__);
+        return IncorrectHash;
+    }
+
+    return ReadHeader(ssObj);
+}
+
+CFlatDB::ReadResult CFlatDB::DeserializeError(const std::exception& e) const
+{
+    error("%s : Deserialize or I/O error reading %s - %s", __func__, strFilename, e.what());
+    return IncorrectFormat;
+}
+
+void CFlatDB::WriteHeader(CDataStream& ssObj) const
+{
+    ssObj << strMagicMessage;                   // cache file specific magic message
+    ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
+}
+
+bool CFlatDB::WriteStream(CDataStream& ssObj) const
+{
+    // checksum the data up to that point, then append the checksum
+    uint256 hash = Hash(ssObj.begin(), ssObj.end());
+    ssObj << hash;
+
+    // write to a temporary file and move it into place, so an interrupted write keeps the previous file
+    fs::path pathTmp = pathDB.string() + ".new";
+    FILE* file = fsbridge::fopen(pathTmp, "wb");
+    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+    if (fileout.IsNull())
+        return error("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    // Write and commit header, data
+    try {
+        fileout << ssObj;
+    } catch (const std::exception& e) {
+        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout.Get());
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, pathDB))
+        return error("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
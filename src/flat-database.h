@@ -0,0 +1,88 @@
+// Copyright (c) 2014-2015 The Dash developers
+// Copyright (c) 2015-2018 The PIVX developers
+// Copyright (c) 2018-2020 The DAPS Project developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef FLAT_DATABASE_H
+#define FLAT_DATABASE_H
+
+#include "clientversion.h"
+#include "fs.h"
+#include "streams.h"
+
+#include <string>
+
+/**
+ * Common part of the flat cache files (mncache.dat, mnpayments.dat, budget.dat).
+ * Each file holds a magic message, the network magic, the serialized object
+ * and a checksum over all of it.
+ */
+class CFlatDB
+{
+public:
+    enum ReadResult {
+        Ok,
+        FileError,
+        HashReadError,
+        IncorrectHash,
+        IncorrectMagicMessage,
+        IncorrectMagicNumber,
+        IncorrectFormat
+    };
+
+protected:
+    fs::path pathDB;
+    std::string strFilename;
+    std::string strMagicMessage;
+
+    CFlatDB(const std::string& strFilenameIn, const std::string& strMagicMessageIn);
+
+    /**
+     * Read the file into obj. A dry run only checks the magic message and
+     * network magic, which is all that is needed before overwriting the file.
+     * obj is cleared when its data cannot be deserialized.
+     */
+    template <typename T>
+    ReadResult ReadObject(T& obj, bool fDryRun) const
+    {
+        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+        ReadResult result = ReadStream(ssObj, fDryRun);
+        if (result != Ok || fDryRun)
+            return result;
+        try {
+            ssObj >> obj;
+        } catch (const std::exception& e) {
+            obj.Clear();
+            return DeserializeError(e);
+        }
+        return Ok;
+    }
+
+    /** Write obj with the file header and checksum */
+    template <typename T>
+    bool WriteObject(const T& obj) const
+    {
+        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
+        WriteHeader(ssObj);
+        ssObj << obj;
+        return WriteStream(ssObj);
+    }
+
+private:
+    /** Check the magic message and network magic at the start of s */
+    template <typename Stream>
+    ReadResult ReadHeader(Stream& s) const;
+
+    /** Read and verify the file, leaving ssObj at the start of the object */
+    ReadResult ReadStream(CDataStream& ssObj, bool fDryRun) const;
+
+    ReadResult DeserializeError(const std::exception& e) const;
+
+    void WriteHeader(CDataStream& ssObj) const;
+
+    /** Append the checksum to ssObj, write it to a temporary file, commit it and move it into place */
+    bool WriteStream(CDataStream& ssObj) const;
+};
+
+#endif // FLAT_DATABASE_H
@@ -58,6 +58,8 @@ private:
 
 /* Pre-base64-encoded authentication token */
 static std::string strRPCUserColonPass;
+/* Size of the chunks streamed JSON-RPC replies are sent in */
+static const size_t RPC_REPLY_CHUNK_SIZE = 64 * 1024;
 /* Stored RPC timer interface (for unregistration) */
 static HTTPRPCTimerInterface* httpRPCTimerInterface = 0;
 
@@ -78,6 +80,73 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/**
+ * JSON-RPC reply to a single request whose result is sent in chunks as it is
+ * written, wrapped in the same envelope as JSONRPCReply. The reply is started
+ * by the first write, so errors thrown before it still get a regular error reply.
+ */
+class HTTPRPCReplyStream : public RPCResultStream
+{
+private:
+    HTTPRequest* req;
+    const UniValue& id;
+    std::string strBuffer;
+    bool fStarted;
+    bool fClosed;
+
+    void Flush()
+    {
+        if (!fClosed && !req->WriteReplyChunk(strBuffer))
+            fClosed = true;
+        strBuffer.clear();
+    }
+
+public:
+    HTTPRPCReplyStream(HTTPRequest* reqIn, const UniValue& idIn) : req(reqIn), id(idIn), fStarted(false), fClosed(false) {}
+
+    void Write(const std::string& str) override
+    {
+        if (fClosed)
+            return;
+        if (!fStarted) {
+            req->WriteHeader("Content-Type", "application/json");
+            req->StartReply(HTTP_OK);
+            fStarted = true;
+            strBuffer = "{\"result\":";
+        }
+        strBuffer += str;
+        if (strBuffer.size() >= RPC_REPLY_CHUNK_SIZE)
+            Flush();
+    }
+
+    bool IsClosed() const override
+    {
+        return fClosed;
+    }
+
+    bool IsStarted() const
+    {
+        return fStarted;
+    }
+
+    /** Close the envelope and finish the reply */
+    void End()
+    {
+        if (!fStarted)
+            Write("null");
+        Write(",\"error\":null,\"id\":" + id.write() + "}\n");
+        Flush();
+        req->EndReply();
+    }
+
+    /** Finish a reply whose result could not be completed; the client gets truncated JSON */
+    void Abort()
+    {
+        Flush();
+        req->EndReply();
+    }
+};
+
 static bool RPCAuthorized(const std::string& strAuth)
 {
     if (strRPCUserColonPass.empty()) // Belt-and-suspenders measure if InitRPCAuthentication was not called
@@ -117,6 +186,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
     }
 
     JSONRequest jreq;
+    HTTPRPCReplyStream stream(req, jreq.id);
     try {
         // Parse request
         UniValue valRequest;
@@ -128,6 +198,12 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            // Large results of some commands are sent as they are written
+            if (tableRPC.executeStreamed(jreq.strMethod, jreq.params, stream)) {
+                stream.End();
+                return true;
+            }
+
             UniValue result = tableRPC.execute(jreq.strMethod, jreq.params);
 
             // Send reply
@@ -142,9 +218,19 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
+        if (stream.IsStarted()) {
+            LogPrintf("%s: %s failed after its reply was started: %s\n", __func__, jreq.strMethod, find_value(objError, "message").getValStr());
+            stream.Abort();
+            return false;
+        }
         JSONErrorReply(req, objError, jreq.id);
         return false;
     } catch (const std::exception& e) {
+        if (stream.IsStarted()) {
+            LogPrintf("%s: %s failed after its reply was started: %s\n", __func__, jreq.strMethod, e.what());
+            stream.Abort();
+            return false;
+        }
         JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
         return false;
     }
@@ -39,6 +39,41 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Maximum size of a chunked reply waiting to be sent before the writer blocks */
+static const size_t MAX_REPLY_QUEUED_SIZE = 1 << 20;
+
+/** State of a chunked reply, shared by the worker writing it and the main http thread */
+struct HTTPReplyStream
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    bool fClosed;   //!< the connection was closed, the request is detached from it
+    size_t nQueued; //!< bytes written by the worker and not yet sent to the client
+    size_t nHanded; //!< bytes handed to libevent since its output buffer was last drained
+
+    HTTPReplyStream() : fClosed(false), nQueued(0), nHanded(0) {}
+};
+
+/** Callback for the connection of a chunked reply closing */
+static void http_reply_closed_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPReplyStream* stream = (HTTPReplyStream*)arg;
+    std::lock_guard<std::mutex> lock(stream->cs);
+    stream->fClosed = true;
+    stream->cond.notify_all();
+}
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/** Callback for the output buffer of a chunked reply being drained */
+static void http_reply_sent_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPReplyStream* stream = (HTTPReplyStream*)arg;
+    std::lock_guard<std::mutex> lock(stream->cs);
+    stream->nQueued -= stream->nHanded;
+    stream->nHanded = 0;
+    stream->cond.notify_all();
+}
+#endif
 
 /** HTTP request work item */
 class HTTPWorkItem : public HTTPClosure
@@ -557,12 +592,16 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* req) : req(req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       replyStarted(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (replyStarted && !replySent) {
+        LogPrintf("%s: Unfinished reply\n", __func__);
+        EndReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -627,6 +666,93 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+void HTTPRequest::StartReply(int nStatus)
+{
+    assert(!replySent && !replyStarted && req);
+    // Events are run by the main http thread in the order they are triggered.
+    // The connection may close while the reply is written; the close callback
+    // marks the stream so no chunk is sent on it afterwards.
+    std::shared_ptr<HTTPReplyStream> stream = replyStream = std::make_shared<HTTPReplyStream>();
+    struct evhttp_request* reqStart = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqStart, stream, nStatus]() {
+        evhttp_connection* conn = evhttp_request_get_connection(reqStart);
+        if (!conn) {
+            std::lock_guard<std::mutex> lock(stream->cs);
+            stream->fClosed = true;
+            stream->cond.notify_all();
+            return;
+        }
+        evhttp_connection_set_closecb(conn, http_reply_closed_cb, stream.get());
+        evhttp_send_reply_start(reqStart, nStatus, NULL);
+    });
+    ev->trigger(0);
+    replyStarted = true;
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(replyStarted && !replySent && req);
+    std::shared_ptr<HTTPReplyStream> stream = replyStream;
+    const size_t nSize = strChunk.size();
+    {
+        // Wait for the client to take what was written before queuing more
+        std::unique_lock<std::mutex> lock(stream->cs);
+        while (!stream->fClosed && stream->nQueued > 0 && stream->nQueued + nSize > MAX_REPLY_QUEUED_SIZE)
+            stream->cond.wait(lock);
+        if (stream->fClosed)
+            return false;
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        stream->nQueued += nSize;
+#endif
+    }
+    if (nSize == 0)
+        return true;
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), nSize);
+    struct evhttp_request* reqChunk = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqChunk, evb, stream, nSize]() {
+        {
+            std::lock_guard<std::mutex> lock(stream->cs);
+            if (stream->fClosed) {
+                evbuffer_free(evb);
+                return;
+            }
+            stream->nHanded += nSize;
+        }
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        evhttp_send_reply_chunk_with_cb(reqChunk, evb, http_reply_sent_cb, stream.get());
+#else
+        evhttp_send_reply_chunk(reqChunk, evb);
+#endif
+        evbuffer_free(evb);
+    });
+    ev->trigger(0);
+    return true;
+}
+
+void HTTPRequest::EndReply()
+{
+    assert(replyStarted && !replySent && req);
+    std::shared_ptr<HTTPReplyStream> stream = replyStream;
+    struct evhttp_request* reqEnd = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqEnd, stream]() {
+        {
+            std::lock_guard<std::mutex> lock(stream->cs);
+            if (!stream->fClosed) {
+                evhttp_connection* conn = evhttp_request_get_connection(reqEnd);
+                if (conn)
+                    evhttp_connection_set_closecb(conn, NULL, NULL);
+            }
+        }
+        // libevent keeps a request whose connection failed during the reply until it is ended, which frees it
+        evhttp_send_reply_end(reqEnd);
+    });
+    ev->trigger(0);
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -686,3 +812,30 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
         pathHandlers.erase(i);
     }
 }
+
+/** Work item running a closure queued with EnqueueHTTPWork */
+class HTTPFunctionItem : public HTTPClosure
+{
+public:
+    HTTPFunctionItem(const std::function<void()>& func) : func(func)
+    {
+    }
+    void operator()()
+    {
+        func();
+    }
+
+private:
+    std::function<void()> func;
+};
+
+bool EnqueueHTTPWork(const std::function<void()>& func)
+{
+    if (!workQueue)
+        return false;
+    std::unique_ptr<HTTPFunctionItem> item(new HTTPFunctionItem(func));
+    if (!workQueue->Enqueue(item.get()))
+        return false;
+    item.release(); /* queue took ownership */
+    return true;
+}
@@ -8,6 +8,7 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
@@ -46,11 +47,18 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run func on an HTTP worker thread. Returns false if the work queue is full
+ * or not running, in which case func is not run.
+ */
+bool EnqueueHTTPWork(const std::function<void()>& func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
 struct event_base* EventBase();
 
+struct HTTPReplyStream;
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -59,6 +67,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted;
+    std::shared_ptr<HTTPReplyStream> replyStream;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -114,6 +124,31 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply, for a body that is sent as it is produced.
+     * Write the body with WriteReplyChunk and finish the reply with EndReply.
+     *
+     * @note Write headers before calling this. Use instead of WriteReply.
+     */
+    void StartReply(int nStatus);
+
+    /**
+     * Write a chunk of a started reply. Blocks while the client is slow to take
+     * what was written before. Returns false once the client has disconnected.
+     */
+    bool WriteReplyChunk(const std::string& strChunk);
+
+    /** Whether a chunked reply was started; its status can no longer change */
+    bool IsReplyStarted() const { return replyStarted; }
+
+    /**
+     * Finish a chunked HTTP reply.
+     *
+     * @note As this will give the request back to the main thread, do not call
+     * any other HTTPRequest methods after calling this.
+     */
+    void EndReply();
 };
 
 /** Event handler closure.
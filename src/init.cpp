@@ -15,6 +15,7 @@
 #include "activemasternode.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockindexsnapshot.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
 #include "fs.h"
@@ -25,12 +26,14 @@
 #include "main.h"
 #include "masternode-budget.h"
 #include "masternode-payments.h"
+#include "masternode-preverify.h"
 #include "masternodeconfig.h"
 #include "masternodeman.h"
 #include "messagesigner.h"
 #include "miner.h"
 #include "netbase.h"
 #include "net.h"
+#include "ringctcache.h"
 #include "rpc/server.h"
 #include "script/standard.h"
 #include "script/sigcache.h"
@@ -227,6 +230,8 @@ void PrepareShutdown()
 
             //record that client took the proper shutdown procedure
             pblocktree->WriteFlag("shutdown", true);
+            if (GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCKINDEX_SNAPSHOT))
+                WriteBlockIndexSnapshot(pcoinsTip->GetBestBlock());
         }
         delete pcoinsTip;
         pcoinsTip = NULL;
@@ -359,6 +364,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-?", _("This help message"));
     strUsage += HelpMessageOpt("-version", _("Print version and exit"));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
+    strUsage += HelpMessageOpt("-blockindexsnapshot", strprintf(_("Write a snapshot of the block index on shutdown to speed up the next start (default: %u)"), DEFAULT_BLOCKINDEX_SNAPSHOT));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
     strUsage += HelpMessageOpt("-blocksizenotify=<cmd>", _("Execute command when the best block changes and its size is over (%s in cmd is replaced by block hash, %d with the block size)"));
     strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), 500));
@@ -499,6 +505,13 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf(_("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default:%u)"), 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf(_("Require high priority for relaying free or low-fee transactions (default:%u)"), 1));
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf(_("Limit size of signature cache to <n> MiB (default: %u)"), DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxmnsigcachesize=<n>", strprintf(_("Keep the signers of at most <n> masternode message signatures (default: %u)"), DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxringctcachesize=<n>", strprintf(_("Limit size of the RingCT validity cache to <n> MiB (default: %u)"), DEFAULT_MAX_RINGCT_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxblockcache=<n>", strprintf(_("Keep at most <n> recently read blocks in memory (default: %u)"), DEFAULT_BLOCK_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxtxposcache=<n>", strprintf(_("Keep at most <n> transaction index entries in memory (default: %u)"), DEFAULT_TX_POS_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxtxcache=<n>", strprintf(_("Keep at most <n> transactions read through the transaction index in memory (default: %u)"), DEFAULT_TX_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-gettransactiontrace=<file>", _("Append the txid of every transaction index lookup to <file>, for replaygettransactiontrace"));
+        strUsage += HelpMessageOpt("-maxparsedoutputcache=<n>", strprintf(_("Keep the parsed keys and commitments of at most <n> outputs in memory (default: %u)"), DEFAULT_MAX_PARSED_OUTPUT_CACHE_SIZE));
     }
     strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/Kb) smaller than this are considered zero fee for relaying (default: %s)"), CURRENCY_UNIT, FormatMoney(::minRelayTxFee.GetFeePerK())));
@@ -655,6 +668,7 @@ void ThreadImport(std::vector<fs::path> vImportFiles)
     if (fReindex) {
         CImportingNow imp;
         int nFile = 0;
+        int64_t nStart = GetTimeMillis();
         while (true) {
             CDiskBlockPos pos(nFile, 0);
             if (!fs::exists(GetBlockPosFilename(pos, "blk")))
@@ -668,7 +682,9 @@ void ThreadImport(std::vector<fs::path> vImportFiles)
         }
         pblocktree->WriteReindexing(false);
         fReindex = false;
-        LogPrintf("Reindexing finished\n");
+        int nHeight = WITH_LOCK(cs_main, return chainActive.Height());
+        int64_t nElapsed = std::max((int64_t)1, GetTimeMillis() - nStart);
+        LogPrintf("Reindexing finished: %d blocks in %ds (%.1f blocks/s)\n", nHeight + 1, nElapsed / 1000, 1000.0 * (nHeight + 1) / nElapsed);
         // To avoid ending up in a situation without genesis block, re-try initializing (no-op if reindexing worked):
         InitBlockIndex();
     }
@@ -1089,12 +1105,19 @@ bool AppInit2(bool isDaemon)
     std::ostringstream strErrors;
 
     InitSignatureCache();
+    InitParsedTxOutCache();
+    InitRingCTValidityCache();
+    InitBlockCache();
+    InitMessageSignatureCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i = 0; i < nScriptCheckThreads - 1; i++)
             threadGroup.create_thread(&ThreadScriptCheck);
+        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+            threadGroup.create_thread(&ThreadRingCTCheck);
     }
+    threadGroup.create_thread(&ThreadBlockFileWriter);
 
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue, &scheduler);
@@ -1932,6 +1955,10 @@ bool AppInit2(bool isDaemon)
     LogPrintf("Budget Mode %s\n", strBudgetMode.c_str());
 
     threadGroup.create_thread(boost::bind(&ThreadCheckMasternodes));
+    if (!fLiteMode) {
+        for (int i = 0; i < nScriptCheckThreads - 1; i++)
+            threadGroup.create_thread(&ThreadMasternodePreVerify);
+    }
 
     if (ShutdownRequested()) {
         LogPrintf("Shutdown requested. Exiting.\n");
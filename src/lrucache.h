@@ -0,0 +1,101 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PRCYCOIN_LRUCACHE_H
+#define PRCYCOIN_LRUCACHE_H
+
+#include "sync.h"
+
+#include <atomic>
+#include <list>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Thread safe map of bounded size that evicts the least recently used entry.
+ * Values are copied out, so large values should be held through a shared_ptr.
+ */
+template <typename K, typename V, typename Hash = std::hash<K> >
+class CLRUCache
+{
+private:
+    typedef std::list<std::pair<K, V> > list_type;
+    list_type listEntries; //!< most recently used first
+    std::unordered_map<K, typename list_type::iterator, Hash> mapEntries;
+    size_t nMaxSize;
+    mutable Mutex cs_cache;
+
+public:
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+
+    explicit CLRUCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn), nHits(0), nMisses(0) {}
+
+    bool Get(const K& key, V& value)
+    {
+        LOCK(cs_cache);
+        auto it = mapEntries.find(key);
+        if (it == mapEntries.end()) {
+            nMisses++;
+            return false;
+        }
+        nHits++;
+        listEntries.splice(listEntries.begin(), listEntries, it->second);
+        value = it->second->second;
+        return true;
+    }
+
+    /** Insert or replace the value of key */
+    void Insert(const K& key, const V& value)
+    {
+        LOCK(cs_cache);
+        if (nMaxSize == 0) return;
+        auto it = mapEntries.find(key);
+        if (it != mapEntries.end()) {
+            it->second->second = value;
+            listEntries.splice(listEntries.begin(), listEntries, it->second);
+            return;
+        }
+        listEntries.emplace_front(key, value);
+        mapEntries.emplace(key, listEntries.begin());
+        while (listEntries.size() > nMaxSize) {
+            mapEntries.erase(listEntries.back().first);
+            listEntries.pop_back();
+        }
+    }
+
+    void Erase(const K& key)
+    {
+        LOCK(cs_cache);
+        auto it = mapEntries.find(key);
+        if (it == mapEntries.end()) return;
+        listEntries.erase(it->second);
+        mapEntries.erase(it);
+    }
+
+    void SetMaxSize(size_t nMaxSizeIn)
+    {
+        LOCK(cs_cache);
+        nMaxSize = nMaxSizeIn;
+        while (listEntries.size() > nMaxSize) {
+            mapEntries.erase(listEntries.back().first);
+            listEntries.pop_back();
+        }
+    }
+
+    size_t Size() const
+    {
+        LOCK(cs_cache);
+        return listEntries.size();
+    }
+
+    size_t MaxSize() const
+    {
+        LOCK(cs_cache);
+        return nMaxSize;
+    }
+};
+
+#endif // PRCYCOIN_LRUCACHE_H
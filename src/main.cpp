@@ -10,24 +10,30 @@
 
 #include "addrman.h"
 #include "amount.h"
+#include "blockindexsnapshot.h"
 #include "blocksignature.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "checkqueue.h"
 #include "consensus/merkle.h"
+#include "crypto/common.h"
 #include "consensus/tx_verify.h"
 #include "consensus/validation.h"
 #include "fs.h"
 #include "init.h"
 #include "invalid.h"
 #include "kernel.h"
+#include "lrucache.h"
 #include "masternode-budget.h"
 #include "masternode-payments.h"
+#include "masternode-preverify.h"
 #include "masternode-sync.h"
 #include "masternodeman.h"
 #include "merkleblock.h"
 #include "net.h"
 #include "poa.h"
+#include "ringctcache.h"
+#include "secp256k1_mlsag.h"
 #include "swifttx.h"
 #include "txdb.h"
 #include "txmempool.h"
@@ -36,10 +42,18 @@
 #include "utilmoneystr.h"
 #include "validationinterface.h"
 
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
 #include <sstream>
+#include <tuple>
+#include <unordered_map>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/foreach.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/thread.hpp>
 
 
@@ -75,6 +89,7 @@ int64_t nTimeBestReceived = 0;
 Mutex g_best_block_mutex;
 std::condition_variable g_best_block_cv;
 uint256 g_best_block;
+static std::shared_ptr<const CChainTipSnapshot> g_chain_tip_snapshot = std::make_shared<const CChainTipSnapshot>();
 
 int nScriptCheckThreads = 0;
 std::atomic<bool> fImporting{false};
@@ -373,24 +388,52 @@ void DestroyContext()
     secp256k1_context_destroy(GetContext());
 }
 
-bool VerifyBulletProofAggregate(const CTransaction& tx)
+/** Gather the commitments and proof for the bulletproof check of tx. */
+static bool PrepareBulletProofCheck(const CTransaction& tx, CRingCTCheck& check)
 {
     if (IsInitialBlockDownload()) return true;
     size_t len = tx.bulletproofs.size();
     if (tx.vout.size() >= 5) return false;
 
     if (len == 0) return false;
-    const size_t MAX_VOUT = 5;
-    secp256k1_pedersen_commitment commitments[MAX_VOUT];
-    size_t i = 0;
-    for (i = 0; i < tx.vout.size(); i++) {
-        if (!secp256k1_pedersen_commitment_parse(GetContext(), &commitments[i], &(tx.vout[i].commitment[0])))
+    check.commitments.resize(tx.vout.size());
+    for (size_t i = 0; i < tx.vout.size(); i++) {
+        CParsedTxOut parsed;
+        if (!GetParsedTxOut(COutPoint(tx.GetHash(), i), tx.vout[i], parsed) || !parsed.fHasCommitment)
             throw std::runtime_error("Failed to parse pedersen commitment");
+        check.commitments[i] = parsed.commitment;
     }
-    return secp256k1_bulletproof_rangeproof_verify(GetContext(), GetScratch(), GetGenerator(), &(tx.bulletproofs[0]), len, NULL, commitments, tx.vout.size(), 64, &secp256k1_generator_const_h, NULL, 0);
+    check.bulletproofs = tx.bulletproofs;
+    check.fBulletProof = true;
+    return true;
 }
 
-bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex)
+bool GetRingSignatureScalars(const CTransaction& tx, size_t nRows, size_t nCols, std::vector<unsigned char>& scalars)
+{
+    //only the first nCols columns and nRows rows are part of the signature; extra scalars
+    //were always accepted (and are covered by the tx hash), so only an undersized S is rejected
+    if (tx.S.size() < nCols) {
+        LogPrintf("%s: Ring signature has %d columns, expected at least %d\n", __func__, tx.S.size(), nCols);
+        return false;
+    }
+    scalars.resize(nRows * nCols * 32);
+    for (size_t j = 0; j < nCols; j++) {
+        if (tx.S[j].size() < nRows) {
+            LogPrintf("%s: Ring signature column %d has %d rows, expected at least %d\n", __func__, j, tx.S[j].size(), nRows);
+            return false;
+        }
+        for (size_t i = 0; i < nRows; i++) {
+            memcpy(&scalars[(j * nRows + i) * 32], tx.S[j][i].begin(), 32);
+        }
+    }
+    return true;
+}
+
+/**
+ * Look up the ring members of tx and gather everything the ring signature
+ * check needs. Requires cs_main; returns false if the ring is malformed.
+ */
+static bool PrepareRingSignatureCheck(const CTransaction& tx, CBlockIndex* pindex, CRingCTCheck& check)
 {
     if (tx.nTxFee < 0) return false;
     if (IsInitialBlockDownload()) return true;
@@ -419,20 +462,29 @@ bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex)
         return false; //maximum decoys = 15
     }
 
-    unsigned char allInPubKeys[MAX_VIN + 1][MAX_DECOYS + 1][33];
-    unsigned char allKeyImages[MAX_VIN + 1][33];
-    unsigned char allInCommitments[MAX_VIN][MAX_DECOYS + 1][33];
-    unsigned char allOutCommitments[MAX_VOUT][33];
-
-    unsigned char SIJ[MAX_VIN + 1][MAX_DECOYS + 1][32];
-    unsigned char LIJ[MAX_VIN + 1][MAX_DECOYS + 1][33];
-    unsigned char RIJ[MAX_VIN + 1][MAX_DECOYS + 1][33];
+    if (tx.vout.size() > MAX_VOUT) {
+        LogPrintf("Tx output too many\n");
+        return false;
+    }
 
     secp256k1_context2* both = GetContext();
 
-    //generating LIJ and RIJ at PI
+    //ring members column by column, as expected by secp256k1_mlsag_verify_parsed;
+    //decoys come from the parsed output cache so their points are only decompressed once
+    const size_t nRows = tx.vin.size() + 1;
+    const size_t nCols = tx.vin[0].decoys.size() + 1;
+    check.nRows = nRows;
+    check.nCols = nCols;
+    check.ringPubKeys.resize(nRows * nCols);
+    check.ringHashPoints.resize(nRows * nCols);
+    check.inCommitments.resize(tx.vin.size() * nCols);
+    check.keyImages.resize(nRows);
+
     for (size_t j = 0; j < tx.vin.size(); j++) {
-        memcpy(allKeyImages[j], tx.vin[j].keyImage.begin(), 33);
+        if (!secp256k1_ec_pubkey_parse2(both, &check.keyImages[j], tx.vin[j].keyImage.begin(), 33)) {
+            LogPrintf("Failed to parse key image\n");
+            return false;
+        }
     }
 
     //extract all public keys
@@ -442,7 +494,7 @@ bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex)
         for (size_t j = 0; j < tx.vin[i].decoys.size(); j++) {
             decoysForIn.push_back(tx.vin[i].decoys[j]);
         }
-        for (size_t j = 0; j < tx.vin[0].decoys.size() + 1; j++) {
+        for (size_t j = 0; j < nCols; j++) {
             CTransaction txPrev;
             uint256 hashBlock;
             if (!GetTransaction(decoysForIn[j].hash, txPrev, hashBlock)) {
@@ -465,199 +517,267 @@ bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex)
                     return false;
                 }
             }
+            SetRingMemberBlock(decoysForIn[j].hash, hashBlock);
 
-            CPubKey extractedPub;
-            if (!ExtractPubKey(txPrev.vout[decoysForIn[j].n].scriptPubKey, extractedPub)) {
+            if (decoysForIn[j].n >= txPrev.vout.size()) {
+                LogPrintf("Ring member %s does not exist\n", decoysForIn[j].ToString());
+                return false;
+            }
+            CParsedTxOut parsed;
+            if (!GetParsedTxOut(decoysForIn[j], txPrev.vout[decoysForIn[j].n], parsed) || !parsed.fHasPubKey) {
                 LogPrintf("Failed to extract pubkey\n");
                 return false;
             }
-            memcpy(allInPubKeys[i][j], extractedPub.begin(), 33);
-            memcpy(allInCommitments[i][j], &(txPrev.vout[decoysForIn[j].n].commitment[0]), 33);
+            if (!parsed.fHasCommitment) {
+                LogPrintf("Failed to parse commitment\n");
+                return false;
+            }
+            check.ringPubKeys[j * nRows + i] = parsed.pubKey;
+            check.ringHashPoints[j * nRows + i] = parsed.hashPoint;
+            check.inCommitments[j * tx.vin.size() + i] = parsed.commitmentPoint;
         }
     }
-    memcpy(allKeyImages[tx.vin.size()], tx.ntxFeeKeyImage.begin(), 33);
-
-    for (size_t i = 0; i < tx.vin[0].decoys.size() + 1; i++) {
-        std::vector<uint256> S_column = tx.S[i];
-        for (size_t j = 0; j < tx.vin.size() + 1; j++) {
-            memcpy(SIJ[j][i], S_column[j].begin(), 32);
-        }
+    if (!secp256k1_ec_pubkey_parse2(both, &check.keyImages[tx.vin.size()], tx.ntxFeeKeyImage.begin(), 33)) {
+        LogPrintf("Failed to parse key image\n");
+        return false;
     }
 
-    //compute allInPubKeys[tx.vin.size()][..]
-    secp256k1_pedersen_commitment allInCommitmentsPacked[MAX_VIN][MAX_DECOYS + 1];
-    secp256k1_pedersen_commitment allOutCommitmentsPacked[MAX_VOUT + 1]; //+1 for tx fee
+    if (!GetRingSignatureScalars(tx, nRows, nCols, check.ringScalars))
+        return false;
 
+    check.outCommitments.resize(tx.vout.size());
     for (size_t i = 0; i < tx.vout.size(); i++) {
         if (tx.vout[i].commitment.empty()) {
             LogPrintf("Commitment can not be null\n");
             return false;
         }
-        memcpy(allOutCommitments[i], &(tx.vout[i].commitment[0]), 33);
-        if (!secp256k1_pedersen_commitment_parse(both, &allOutCommitmentsPacked[i], allOutCommitments[i])) {
+        CParsedTxOut parsed;
+        if (!GetParsedTxOut(COutPoint(tx.GetHash(), i), tx.vout[i], parsed) || !parsed.fHasCommitment) {
             LogPrintf("Failed to parse commitment\n");
             return false;
         }
+        check.outCommitments[i] = parsed.commitmentPoint;
     }
+    check.nTxFee = tx.nTxFee;
+    check.c = tx.c;
+    check.hashSig = GetTxSignatureHash(tx);
+    check.fRingSignature = true;
+    return true;
+}
+
+bool CRingCTCheck::VerifyRingSignature()
+{
+    if (!fRingSignature) return true;
+    secp256k1_context2* both = GetContext();
+    const size_t nInputs = nRows - 1;
 
-    //commitment to tx fee, blind = 0
+    //sum of all output commitments + commitment to the tx fee, blind = 0
+    std::vector<const secp256k1_pubkey2*> outPtrs;
+    for (size_t i = 0; i < outCommitments.size(); i++) {
+        outPtrs.push_back(&outCommitments[i]);
+    }
     unsigned char txFeeBlind[32];
     memset(txFeeBlind, 0, 32);
-    if (!secp256k1_pedersen_commit(both, &allOutCommitmentsPacked[tx.vout.size()], txFeeBlind, tx.nTxFee, &secp256k1_generator_const_h, &secp256k1_generator_const_g))
+    secp256k1_pedersen_commitment feeCommitment;
+    if (!secp256k1_pedersen_commit(both, &feeCommitment, txFeeBlind, nTxFee, &secp256k1_generator_const_h, &secp256k1_generator_const_g))
         throw std::runtime_error("Failed to computed commitment");
-
-    //filling the additional pubkey elements for decoys: allInPubKeys[wtxNew.vin.size()][..]
-    //allInPubKeys[wtxNew.vin.size()][j] = sum of allInPubKeys[..][j] + sum of allInCommitments[..][j] + sum of allOutCommitments
-    const secp256k1_pedersen_commitment* outCptr[MAX_VOUT + 1];
-    for (size_t i = 0; i < tx.vout.size() + 1; i++) {
-        outCptr[i] = &allOutCommitmentsPacked[i];
-    }
-
-    secp256k1_pedersen_commitment inPubKeysToCommitments[MAX_VIN][MAX_DECOYS + 1];
-    for (size_t i = 0; i < tx.vin.size(); i++) {
-        for (size_t j = 0; j < tx.vin[0].decoys.size() + 1; j++) {
-            secp256k1_pedersen_serialized_pubkey_to_commitment(allInPubKeys[i][j], 33, &inPubKeysToCommitments[i][j]);
-        }
+    unsigned char feeSer[33];
+    size_t feeSerLen;
+    secp256k1_pubkey2 feePoint;
+    if (!secp256k1_pedersen_commitment_to_serialized_pubkey(&feeCommitment, feeSer, &feeSerLen) ||
+        !secp256k1_ec_pubkey_parse2(both, &feePoint, feeSer, feeSerLen))
+        throw std::runtime_error("Failed to computed commitment");
+    outPtrs.push_back(&feePoint);
+    secp256k1_pubkey2 negOutSum;
+    if (!secp256k1_ec_pubkey_combine2(both, &negOutSum, &outPtrs[0], outPtrs.size()) || !secp256k1_ec_pubkey_negate2(both, &negOutSum)) {
+        LogPrintf("Failed to secp256k1_pedersen_commitment_sum\n");
+        return false;
     }
 
-    for (size_t j = 0; j < tx.vin[0].decoys.size() + 1; j++) {
-        const secp256k1_pedersen_commitment* inCptr[MAX_VIN * 2];
-        for (size_t k = 0; k < tx.vin.size(); k++) {
-            if (!secp256k1_pedersen_commitment_parse(both, &allInCommitmentsPacked[k][j], allInCommitments[k][j])) {
-                LogPrintf("Failed to parse commitment\n");
-                return false;
-            }
-            inCptr[k] = &allInCommitmentsPacked[k][j];
-        }
-
-        for (size_t k = tx.vin.size(); k < 2 * tx.vin.size(); k++) {
-            inCptr[k] = &inPubKeysToCommitments[k - tx.vin.size()][j];
-        }
-        secp256k1_pedersen_commitment out;
-        size_t length;
-        if (!secp256k1_pedersen_commitment_sum(both, inCptr, tx.vin.size() * 2, outCptr, tx.vout.size() + 1, &out)) {
-            LogPrintf("Failed to secp256k1_pedersen_commitment_sum\n");
-            return false;
-        }
-        if (!secp256k1_pedersen_commitment_to_serialized_pubkey(&out, allInPubKeys[tx.vin.size()][j], &length)) {
+    //filling the additional pubkey elements for decoys: ringPubKeys[..][nInputs]
+    //= sum of the input public keys + sum of the input commitments - sum of the output commitments - commitment to the fee
+    for (size_t j = 0; j < nCols; j++) {
+        std::vector<const secp256k1_pubkey2*> sumPtrs;
+        for (size_t i = 0; i < nInputs; i++) {
+            sumPtrs.push_back(&ringPubKeys[j * nRows + i]);
+            sumPtrs.push_back(&inCommitments[j * nInputs + i]);
+        }
+        sumPtrs.push_back(&negOutSum);
+        secp256k1_pubkey2& additional = ringPubKeys[j * nRows + nInputs];
+        unsigned char additionalSer[33];
+        size_t additionalLen = 33;
+        if (!secp256k1_ec_pubkey_combine2(both, &additional, &sumPtrs[0], sumPtrs.size()) ||
+            !secp256k1_ec_pubkey_serialize2(both, additionalSer, &additionalLen, &additional, SECP256K1_EC_COMPRESSED) ||
+            !secp256k1_mlsag_hash_to_point(both, &ringHashPoints[j * nRows + nInputs], additionalSer)) {
             LogPrintf("Failed to serialized pubkey\n");
             return false;
         }
     }
 
+    //verification: walk the challenge chain from c and check it closes back onto c
+    return secp256k1_mlsag_verify_parsed(both, c.begin(), &ringScalars[0], &ringPubKeys[0], &ringHashPoints[0], &keyImages[0], hashSig.begin(), nRows, nCols) == 1;
+}
 
-    //verification
-    unsigned char C[32];
-    memcpy(C, tx.c.begin(), 32);
-    for (size_t j = 0; j < tx.vin[0].decoys.size() + 1; j++) {
-        for (size_t i = 0; i < tx.vin.size() + 1; i++) {
-            //compute LIJ, RIJ
-            unsigned char P[33];
-            memcpy(P, allInPubKeys[i][j], 33);
-            if (!secp256k1_ec_pubkey_tweak_mul(P, 33, C)) {
-                LogPrintf("Failed to mul pubkey\n");
-                return false;
-            }
-
-            if (!secp256k1_ec_pubkey_tweak_add(P, 33, SIJ[i][j])) {
-                LogPrintf("Failed to add pubkey\n");
-                return false;
-            }
-
-            memcpy(LIJ[i][j], P, 33);
-
-            //compute RIJ
-            unsigned char sh[33];
-            CPubKey pkij;
-            pkij.Set(allInPubKeys[i][j], allInPubKeys[i][j] + 33);
-            PointHashingSuccessively(pkij, SIJ[i][j], sh);
-
-            unsigned char ci[33];
-            memcpy(ci, allKeyImages[i], 33);
-            if (!secp256k1_ec_pubkey_tweak_mul(ci, 33, C)) {
-                LogPrintf("Failed to mul tweak\n");
-                return false;
-            }
-
-            //convert shp into commitment
-            secp256k1_pedersen_commitment SHP_commitment;
-            secp256k1_pedersen_serialized_pubkey_to_commitment(sh, 33, &SHP_commitment);
+bool CRingCTCheck::VerifyBulletProof(secp256k1_scratch_space2* scratch)
+{
+    if (!fBulletProof) return true;
+    return secp256k1_bulletproof_rangeproof_verify(GetContext(), scratch, GetGenerator(), &bulletproofs[0], bulletproofs.size(), NULL, &commitments[0], commitments.size(), 64, &secp256k1_generator_const_h, NULL, 0);
+}
 
-            //convert CI*I into commitment
-            secp256k1_pedersen_commitment cii_commitment;
-            secp256k1_pedersen_serialized_pubkey_to_commitment(ci, 33, &cii_commitment);
+bool CRingCTCheck::operator()()
+{
+    bool fOk = VerifyRingSignature();
+    if (fOk && fBulletProof) {
+        // The shared scratch space belongs to the validation thread
+        secp256k1_scratch_space2* scratch = secp256k1_scratch_space_create(GetContext(), 1024 * 1024 * 512);
+        fOk = VerifyBulletProof(scratch);
+        secp256k1_scratch_space_destroy(scratch);
+    }
+    if (!fOk && pfOk)
+        *pfOk = false;
+    return true;
+}
 
-            const secp256k1_pedersen_commitment* twoElements[2];
-            twoElements[0] = &SHP_commitment;
-            twoElements[1] = &cii_commitment;
+bool VerifyBulletProofAggregate(const CTransaction& tx)
+{
+    CRingCTCheck check;
+    if (!PrepareBulletProofCheck(tx, check)) return false;
+    return check.VerifyBulletProof(GetScratch());
+}
 
-            secp256k1_pedersen_commitment sum;
-            if (!secp256k1_pedersen_commitment_sum_pos(both, twoElements, 2, &sum))
-                throw std::runtime_error("failed to compute secp256k1_pedersen_commitment_sum_pos");
-            size_t tempLength;
-            if (!secp256k1_pedersen_commitment_to_serialized_pubkey(&sum, RIJ[i][j], &tempLength))
-                throw std::runtime_error("failed to serialize pedersen commitment");
-        }
+bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex)
+{
+    CRingCTCheck check;
+    if (!PrepareRingSignatureCheck(tx, pindex, check)) return false;
+    return check.VerifyRingSignature();
+}
 
-        //compute C
-        unsigned char tempForHash[2 * (MAX_VIN + 1) * 33 + 32];
-        unsigned char* tempForHashPtr = tempForHash;
-        for (size_t i = 0; i < tx.vin.size() + 1; i++) {
-            memcpy(tempForHashPtr, &(LIJ[i][j][0]), 33);
-            tempForHashPtr += 33;
-            memcpy(tempForHashPtr, &(RIJ[i][j][0]), 33);
-            tempForHashPtr += 33;
-        }
-        uint256 ctsHash = GetTxSignatureHash(tx);
-        memcpy(tempForHashPtr, ctsHash.begin(), 32);
+static CCheckQueue<CRingCTCheck> ringctcheckqueue(16);
 
-        uint256 temppi1 = Hash(tempForHash, tempForHash + 2 * (tx.vin.size() + 1) * 33 + 32);
-        memcpy(C, temppi1.begin(), 32);
-    }
-    //LogPrintf("Verifying\n");
-    return HexStr(tx.c.begin(), tx.c.end()) == HexStr(C, C + 32);
+void ThreadRingCTCheck()
+{
+    util::ThreadRename("prcycoin-ringct");
+    ringctcheckqueue.Thread();
 }
 
 bool ReVerifyPoSBlock(CBlockIndex* pindex)
+{
+    std::vector<CBlockIndex*> vIndex(1, pindex);
+    std::vector<bool> vResults;
+    ReVerifyPoSBlocks(vIndex, vResults);
+    return vResults[0];
+}
+
+void ReVerifyPoSBlocks(const std::vector<CBlockIndex*>& vIndex, std::vector<bool>& vResults)
 {
     LOCK(cs_main);
-    {
-        if (!pindex) return false;
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex)) return false;
-        if (!pindex->IsProofOfStake()) return false;
-        CAmount nFees = 0;
-        CAmount nValueIn = 0;
-        CAmount nValueOut = 0;
+    vResults.assign(vIndex.size(), false);
+
+    // The audit result is recorded when the block is connected; it holds while the block is in the active chain
+    std::vector<size_t> vPending;
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        CBlockIndex* pindex = vIndex[i];
+        if (!pindex || !pindex->IsProofOfStake()) continue;
+        if (pindex->IsPoSAudited() && chainActive.Contains(pindex)) {
+            vResults[i] = true;
+            continue;
+        }
+        vPending.push_back(i);
+    }
+    if (vPending.empty()) return;
+
+    // The ring signature and bulletproof checks are skipped during the initial block download,
+    // so a block that passes then must not be recorded as audited
+    const bool fRingCTChecks = !IsInitialBlockDownload();
+
+    // Read the blocks concurrently. Holding cs_main keeps their disk positions stable.
+    const size_t nPending = vPending.size();
+    std::vector<std::shared_ptr<const CBlock> > vBlocks(nPending);
+    std::vector<std::atomic<bool> > vOk(nPending);
+    const size_t nReaders = std::min(nPending, (size_t)std::max(nScriptCheckThreads, 1));
+    std::vector<std::future<void> > vReaders;
+    for (size_t t = 0; t < nReaders; t++) {
+        vReaders.push_back(std::async(std::launch::async, [&, t]() {
+            for (size_t k = t; k < nPending; k += nReaders)
+                vBlocks[k] = ReadBlockFromDisk(vIndex[vPending[k]]);
+        }));
+    }
+    for (std::future<void>& reader : vReaders)
+        reader.get();
+    for (size_t k = 0; k < nPending; k++)
+        vOk[k] = vBlocks[k] != nullptr;
+
+    // Look up ring members here and queue the signature and range proof checks
+    std::vector<CAmount> vFees(nPending, 0);
+    std::vector<CAmount> vValueIn(nPending, 0);
+    CCheckQueueControl<CRingCTCheck> control(nScriptCheckThreads ? &ringctcheckqueue : NULL);
+    CCoinsViewCache view(pcoinsTip);
+    for (size_t k = 0; k < nPending; k++) {
+        if (!vOk[k]) continue;
+        CBlockIndex* pindex = vIndex[vPending[k]];
+        const CBlock& block = *vBlocks[k];
+        std::vector<CRingCTCheck> vChecks;
         for (unsigned int i = 0; i < block.vtx.size(); i++) {
             const CTransaction& tx = block.vtx[i];
             if (!tx.IsCoinStake()) {
-                if (!tx.IsCoinAudit()) {
-                    if (!VerifyRingSignatureWithTxFee(tx, pindex))
-                        return false;
-                    if (!VerifyBulletProofAggregate(tx))
-                        return false;
+                if (!tx.IsCoinAudit() && !IsRingCTVerified(tx, pindex)) {
+                    CRingCTCheck check;
+                    if (!PrepareRingSignatureCheck(tx, pindex, check) || !PrepareBulletProofCheck(tx, check)) {
+                        vOk[k] = false;
+                        break;
+                    }
+                    check.pfOk = &vOk[k];
+                    vChecks.push_back(CRingCTCheck());
+                    check.swap(vChecks.back());
                 }
-                nFees += tx.nTxFee;
+                vFees[k] += tx.nTxFee;
+            }
+        }
+        if (!vOk[k]) continue;
+        if (nScriptCheckThreads) {
+            control.Add(vChecks);
+        } else {
+            for (CRingCTCheck& check : vChecks) {
+                check();
+            }
+        }
+        vValueIn[k] = GetValueIn(view, block.vtx[1]);
+    }
+    control.Wait();
+
+    // Supply bookkeeping, in chain order
+    std::vector<size_t> vOrder(nPending);
+    for (size_t k = 0; k < nPending; k++)
+        vOrder[k] = k;
+    std::sort(vOrder.begin(), vOrder.end(), [&](size_t a, size_t b) {
+        return vIndex[vPending[a]]->nHeight < vIndex[vPending[b]]->nHeight;
+    });
+    for (size_t k : vOrder) {
+        if (!vOk[k]) continue;
+        CBlockIndex* pindex = vIndex[vPending[k]];
+        const CBlock& block = *vBlocks[k];
+        CAmount nFees = vFees[k];
+        CAmount nValueIn = vValueIn[k];
+        if (fRingCTChecks) {
+            for (const CTransaction& tx : block.vtx) {
+                if (!tx.IsCoinStake() && !tx.IsCoinAudit())
+                    SetRingCTVerified(tx, pindex);
             }
         }
 
-        const CTransaction coinstake = block.vtx[1];
-        CCoinsViewCache view(pcoinsTip);
-        nValueIn = GetValueIn(view, coinstake);
-        nValueOut = coinstake.GetValueOut();
+        const CTransaction& coinstake = block.vtx[1];
+        CAmount nValueOut = coinstake.GetValueOut();
 
         size_t numUTXO = coinstake.vout.size();
         if (mapBlockIndex.count(block.hashPrevBlock) < 1) {
             LogPrintf("%s: Previous block not found, received block %s, previous %s, current tip %s\n", __func__, block.GetHash().GetHex(), block.hashPrevBlock.GetHex(), chainActive.Tip()->GetBlockHash().GetHex());
-            return false;
+            continue;
         }
-        CAmount blockValue = GetBlockValue(mapBlockIndex[block.hashPrevBlock]->nHeight);
         const CTxOut& mnOut = coinstake.vout[numUTXO - 1];
         std::string mnsa(mnOut.masternodeStealthAddress.begin(), mnOut.masternodeStealthAddress.end());
         if (!VerifyDerivedAddress(mnOut, mnsa)) {
             LogPrintf("%s: Incorrect derived address for masternode rewards\n", __func__);
-            return false;
+            continue;
         }
 
         // track money supply and mint amount info
@@ -672,9 +792,13 @@ bool ReVerifyPoSBlock(CBlockIndex* pindex)
 
         if (!IsBlockValueValid(pindex->nHeight, nExpectedMint, pindex->nMint)) {
             LogPrintf("%s: reward pays too much (actual=%s vs limit=%s)\n", __func__, FormatMoney(pindex->nMint), FormatMoney(nExpectedMint));
-            return false;
+            continue;
         }
-        return true;
+        if (fRingCTChecks && chainActive.Contains(pindex)) {
+            pindex->SetPoSAudited();
+            setDirtyBlockIndex.insert(pindex);
+        }
+        vResults[vPending[k]] = true;
     }
 }
 
@@ -1391,12 +1515,7 @@ int GetInputAge(CTxIn& vin)
 
 int GetIXConfirmations(uint256 nTXHash)
 {
-    int sigs = 0;
-
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(nTXHash);
-    if (i != mapTxLocks.end()) {
-        sigs = (*i).second.CountSignatures();
-    }
+    int sigs = swiftTX.CountLockSignatures(nTXHash);
     if (sigs >= SWIFTTX_SIGNATURES_REQUIRED) {
         return nSwiftTXDepth;
     }
@@ -1636,13 +1755,18 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState& state, const CTransa
                     } else {
                         banscore = 1;
                     }
-                    if (!VerifyRingSignatureWithTxFee(tx, chainActive.Tip())) {
-                        return state.DoS(banscore, error("AcceptToMemoryPool() : Ring Signature check for transaction %s failed", tx.GetHash().ToString()),
-                            REJECT_INVALID, "bad-ring-signature");
+                    if (!IsRingCTVerified(tx, chainActive.Tip())) {
+                        if (!VerifyRingSignatureWithTxFee(tx, chainActive.Tip())) {
+                            return state.DoS(banscore, error("AcceptToMemoryPool() : Ring Signature check for transaction %s failed", tx.GetHash().ToString()),
+                                REJECT_INVALID, "bad-ring-signature");
+                        }
+                        if (!VerifyBulletProofAggregate(tx))
+                            return state.DoS(100, error("AcceptToMemoryPool() : Bulletproof check for transaction %s failed", tx.GetHash().ToString()),
+                                REJECT_INVALID, "bad-bulletproof");
+                        // Nothing was checked during the initial block download
+                        if (!IsInitialBlockDownload())
+                            SetRingCTVerified(tx, chainActive.Tip());
                     }
-                    if (!VerifyBulletProofAggregate(tx))
-                        return state.DoS(100, error("AcceptToMemoryPool() : Bulletproof check for transaction %s failed", tx.GetHash().ToString()),
-                            REJECT_INVALID, "bad-bulletproof");
                 }
             }
 
@@ -1827,8 +1951,9 @@ bool AcceptableInputs(CTxMemPool& pool, CValidationState& state, const CTransact
     // ----------- swiftTX transaction scanning -----------
 
     for (const CTxIn& in : tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
+        uint256 hashLocked;
+        if (swiftTX.GetLockedInput(in.prevout, hashLocked)) {
+            if (hashLocked != tx.GetHash()) {
                 return state.DoS(0,
                     error("AcceptableInputs : conflicts with existing transaction lock: %s", reason),
                     REJECT_INVALID, "tx-lock-conflict");
@@ -2006,43 +2131,64 @@ bool AcceptableInputs(CTxMemPool& pool, CValidationState& state, const CTransact
     return true;
 }
 
+static bool ReadTransactionFromDisk(const CDiskTxPos& postx, CTransaction& tx, uint256& hashBlock);
+
+/** Transaction index lookups are appended here when -gettransactiontrace is set */
+static FILE* fileTxTrace = NULL;
+static Mutex cs_txtrace;
+
+static void RecordGetTransaction(const uint256& hash)
+{
+    if (!fileTxTrace) return;
+    LOCK(cs_txtrace);
+    fprintf(fileTxTrace, "%s\n", hash.GetHex().c_str());
+}
+
+/** Positions of recently looked up transactions, saving transaction index reads */
+static CLRUCache<uint256, CDiskTxPos, BlockHasher> txPosCache(DEFAULT_TX_POS_CACHE_SIZE);
+/** Recently read transactions with the hash of their block */
+static CLRUCache<uint256, std::pair<std::shared_ptr<const CTransaction>, uint256>, BlockHasher> txCache(DEFAULT_TX_CACHE_SIZE);
+
+/** Look up a confirmed transaction through the transaction index; needs no cs_main */
+static bool GetTransactionFromIndex(const uint256& hash, CTransaction& txOut, uint256& hashBlock)
+{
+    std::pair<std::shared_ptr<const CTransaction>, uint256> cached;
+    if (txCache.Get(hash, cached)) {
+        txOut = *cached.first;
+        hashBlock = cached.second;
+        return true;
+    }
+    CDiskTxPos postx;
+    if (txPosCache.Get(hash, postx) || pblocktree->ReadTxIndex(hash, postx)) {
+        if (!ReadTransactionFromDisk(postx, txOut, hashBlock))
+            return false;
+        if (txOut.GetHash() != hash)
+            return error("%s : txid mismatch, %s, %s", __func__, txOut.GetHash().GetHex(), hash.GetHex());
+        txPosCache.Insert(hash, postx);
+        txCache.Insert(hash, std::make_pair(std::make_shared<const CTransaction>(txOut), hashBlock));
+        return true;
+    }
+    return false;
+}
+
 /** Return transaction in tx, and if it was found inside a block, its hash is placed in hashBlock */
 bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock, bool fAllowSlow, CBlockIndex* blockIndex)
 {
     CBlockIndex* pindexSlow = blockIndex;
 
-    LOCK(cs_main);
-
     if (!blockIndex) {
         if (mempool.lookup(hash, txOut)) {
             return true;
         }
 
         if (fTxIndex) {
-            CDiskTxPos postx;
-            if (pblocktree->ReadTxIndex(hash, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-                if (file.IsNull())
-                    return error("%s: OpenBlockFile failed", __func__);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                    file >> txOut;
-                } catch (const std::exception& e) {
-                    return error("%s : Deserialize or I/O error - %s", __func__, e.what());
-                }
-                hashBlock = header.GetHash();
-                if (txOut.GetHash() != hash)
-                    return error("%s : txid mismatch, %s, %s", __func__, txOut.GetHash().GetHex(), hash.GetHex());
-                return true;
-            }
-
-            // transaction not found in the index, nothing more can be done
-            return false;
+            RecordGetTransaction(hash);
+            // if the transaction is not found in the index, nothing more can be done
+            return GetTransactionFromIndex(hash, txOut, hashBlock);
         }
 
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+            LOCK(cs_main);
             int nHeight = -1;
             {
                 CCoinsViewCache& view = *pcoinsTip;
@@ -2056,9 +2202,15 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
     }
 
     if (pindexSlow) {
-        CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow)) {
-            for (const CTransaction& tx : block.vtx) {
+        {
+            // the block position is set under cs_main before the data flag
+            LOCK(cs_main);
+            if (!(pindexSlow->nStatus & BLOCK_HAVE_DATA))
+                return false;
+        }
+        std::shared_ptr<const CBlock> pblock = ReadBlockFromDisk(pindexSlow);
+        if (pblock) {
+            for (const CTransaction& tx : pblock->vtx) {
                 if (tx.GetHash() == hash) {
                     txOut = tx;
                     hashBlock = pindexSlow->GetBlockHash();
@@ -2068,33 +2220,406 @@ bool GetTransaction(const uint256& hash, CTransaction& txOut, uint256& hashBlock
         }
     }
 
-    return false;
+    return false;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////
+//
+// CBlock and CBlockIndex
+//
+
+static bool AbortNode(const std::string& strMessage, const std::string& userMessage);
+
+/**
+ * Writes block and undo data on a dedicated thread, so accepting or connecting
+ * a block does not wait for the disk. Positions are still reserved under
+ * cs_main by FindBlockPos and FindUndoPos; the serialized records are queued
+ * with their position and served from the queue to readers until written.
+ * Files written to are only synced by Flush, once each, which FlushStateToDisk
+ * calls before the block index that refers to them is written.
+ * Until the thread runs, and after it was interrupted, jobs run in the caller.
+ */
+class CBlockFileWriter
+{
+private:
+    enum JobType {
+        JOB_WRITE,    //!< write data so that the record starts at pos
+        JOB_ALLOCATE, //!< pre-allocate nLength bytes from pos
+        JOB_FINALIZE, //!< truncate the file to pos.nPos and sync it
+    };
+
+    struct CJob {
+        JobType type;
+        bool fUndo;
+        CDiskBlockPos pos;
+        unsigned int nLength;
+        std::shared_ptr<const CDataStream> data; //!< message start, record size and the record
+    };
+
+    typedef std::tuple<bool, int, unsigned int> PendingKey;
+
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    boost::condition_variable condQueue;
+    std::deque<CJob> queue;
+    size_t nQueuedBytes;
+    bool fRunning;
+    bool fBusy;
+    bool fFailed;
+    std::map<PendingKey, std::shared_ptr<const CDataStream> > mapPending;
+    std::set<std::pair<bool, int> > setUnsynced;
+
+    static FILE* Open(bool fUndo, const CDiskBlockPos& pos)
+    {
+        return fUndo ? OpenUndoFile(pos) : OpenBlockFile(pos);
+    }
+
+    static bool Process(const CJob& job)
+    {
+        const char* prefix = job.fUndo ? "rev" : "blk";
+        if (job.type == JOB_WRITE) {
+            // The record starts after the message start and size
+            FILE* file = Open(job.fUndo, CDiskBlockPos(job.pos.nFile, job.pos.nPos - 8));
+            if (!file)
+                return error("%s : failed to open %s%05u.dat", __func__, prefix, job.pos.nFile);
+            bool fOk = fwrite(&(*job.data)[0], 1, job.data->size(), file) == job.data->size();
+            fclose(file);
+            if (!fOk)
+                return error("%s : failed to write to %s%05u.dat", __func__, prefix, job.pos.nFile);
+        } else {
+            FILE* file = Open(job.fUndo, job.pos);
+            if (!file)
+                return job.type == JOB_ALLOCATE;
+            if (job.type == JOB_ALLOCATE) {
+                AllocateFileRange(file, job.pos.nPos, job.nLength);
+            } else {
+                TruncateFile(file, job.pos.nPos);
+                FileCommit(file);
+            }
+            fclose(file);
+        }
+        return true;
+    }
+
+    /** Record the outcome of a job; called with mutex held */
+    void Done(const CJob& job, bool fOk)
+    {
+        if (job.type == JOB_WRITE) {
+            mapPending.erase(PendingKey(job.fUndo, job.pos.nFile, job.pos.nPos));
+            nQueuedBytes -= job.data->size();
+        }
+        if (job.type == JOB_FINALIZE)
+            setUnsynced.erase(std::make_pair(job.fUndo, job.pos.nFile));
+        else
+            setUnsynced.insert(std::make_pair(job.fUndo, job.pos.nFile));
+        if (!fOk)
+            fFailed = true;
+    }
+
+    bool Push(CJob&& job)
+    {
+        boost::this_thread::disable_interruption di;
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (job.type == JOB_WRITE) {
+            while (fRunning && nQueuedBytes > 0 && nQueuedBytes + job.data->size() > MAX_BLOCK_WRITE_QUEUE_SIZE)
+                condQueue.wait(lock);
+            nQueuedBytes += job.data->size();
+        }
+        if (!fRunning) {
+            bool fOk = Process(job);
+            Done(job, fOk);
+            return fOk;
+        }
+        if (job.type == JOB_WRITE)
+            mapPending[PendingKey(job.fUndo, job.pos.nFile, job.pos.nPos)] = job.data;
+        queue.push_back(std::move(job));
+        condWorker.notify_one();
+        return true;
+    }
+
+public:
+    CBlockFileWriter() : nQueuedBytes(0), fRunning(false), fBusy(false), fFailed(false) {}
+
+    /** Queue data, serialized with its message start and size, for the record at pos */
+    bool Write(bool fUndo, const CDiskBlockPos& pos, std::shared_ptr<const CDataStream> data)
+    {
+        CJob job = {JOB_WRITE, fUndo, pos, 0, data};
+        return Push(std::move(job));
+    }
+
+    bool Allocate(bool fUndo, const CDiskBlockPos& pos, unsigned int nLength)
+    {
+        CJob job = {JOB_ALLOCATE, fUndo, pos, nLength, nullptr};
+        return Push(std::move(job));
+    }
+
+    /** Truncate file nFile to nSize once everything queued before is written, and sync it */
+    bool Finalize(bool fUndo, int nFile, unsigned int nSize)
+    {
+        CJob job = {JOB_FINALIZE, fUndo, CDiskBlockPos(nFile, nSize), 0, nullptr};
+        return Push(std::move(job));
+    }
+
+    /** Get the record at pos if it is still queued, positioned after its message start and size */
+    bool GetPending(bool fUndo, const CDiskBlockPos& pos, CDataStream& ss)
+    {
+        std::shared_ptr<const CDataStream> data;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            auto it = mapPending.find(PendingKey(fUndo, pos.nFile, pos.nPos));
+            if (it == mapPending.end())
+                return false;
+            data = it->second;
+        }
+        ss = *data;
+        ss.ignore(8);
+        return true;
+    }
+
+    /** Wait until everything queued is written, then sync each file written to */
+    bool Flush()
+    {
+        boost::this_thread::disable_interruption di;
+        std::set<std::pair<bool, int> > setSync;
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (!queue.empty() || fBusy)
+                condQueue.wait(lock);
+            if (fFailed)
+                return false;
+            setSync.swap(setUnsynced);
+        }
+        for (const std::pair<bool, int>& file : setSync) {
+            FILE* fileSync = Open(file.first, CDiskBlockPos(file.second, 0));
+            if (fileSync) {
+                FileCommit(fileSync);
+                fclose(fileSync);
+            }
+        }
+        return true;
+    }
+
+    void Thread()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fRunning = true;
+        try {
+            while (true) {
+                while (queue.empty())
+                    condWorker.wait(lock);
+                CJob job = std::move(queue.front());
+                queue.pop_front();
+                fBusy = true;
+                lock.unlock();
+                bool fOk = Process(job);
+                lock.lock();
+                fBusy = false;
+                Done(job, fOk);
+                condQueue.notify_all();
+                if (!fOk) {
+                    lock.unlock();
+                    AbortNode("Failed to write block data", "");
+                    lock.lock();
+                }
+            }
+        } catch (const boost::thread_interrupted&) {
+            // Only interrupted while idle; anything queued from now on is written by the caller
+            fRunning = false;
+            condQueue.notify_all();
+            throw;
+        }
+    }
+};
+
+static CBlockFileWriter blockFileWriter;
+
+void ThreadBlockFileWriter()
+{
+    util::ThreadRename("prcycoin-blockwr");
+    blockFileWriter.Thread();
+}
+
+//! Counters of where blocks were read from, see getblockcacheinfo
+static std::atomic<uint64_t> nBlockQueueReads(0);
+static std::atomic<uint64_t> nBlockMappedReads(0);
+static std::atomic<uint64_t> nBlockFileReads(0);
+
+/**
+ * Read-only mappings of block files that are no longer appended to, so a
+ * block is read with a memory copy instead of an open, a seek and buffered
+ * reads. The file currently written to is always read through stdio.
+ */
+class CBlockFileMapper
+{
+private:
+    Mutex cs_mapped;
+    std::map<int, std::shared_ptr<const boost::interprocess::mapped_region> > mapRegions;
+    std::deque<int> queueMapped;
+    const size_t nMaxMapped;
+
+public:
+    //! Keep the address space used modest on 32-bit systems
+    CBlockFileMapper() : nMaxMapped(sizeof(void*) >= 8 ? 64 : 2) {}
+
+    /** Get the bounds of the record at pos if its file is, or can be, mapped; region keeps the mapping alive */
+    bool Map(const CDiskBlockPos& pos, std::shared_ptr<const boost::interprocess::mapped_region>& region, const char*& pbegin, const char*& pend)
+    {
+        {
+            LOCK(cs_mapped);
+            auto it = mapRegions.find(pos.nFile);
+            if (it != mapRegions.end()) {
+                region = it->second;
+            } else {
+                {
+                    LOCK(cs_LastBlockFile);
+                    if (pos.nFile >= nLastBlockFile)
+                        return false;
+                }
+                try {
+                    boost::interprocess::file_mapping mapping(GetBlockPosFilename(pos, "blk").string().c_str(), boost::interprocess::read_only);
+                    region = std::make_shared<const boost::interprocess::mapped_region>(mapping, boost::interprocess::read_only);
+                } catch (const std::exception& e) {
+                    LogPrintf("%s: can't map blk%05u.dat: %s\n", __func__, pos.nFile, e.what());
+                    return false;
+                }
+                mapRegions.emplace(pos.nFile, region);
+                queueMapped.push_back(pos.nFile);
+                while (queueMapped.size() > nMaxMapped) {
+                    mapRegions.erase(queueMapped.front());
+                    queueMapped.pop_front();
+                }
+            }
+        }
+
+        // The record is preceded by the message start and its size
+        const unsigned char* pfile = (const unsigned char*)region->get_address();
+        const size_t nFileSize = region->get_size();
+        if (pos.nPos < 8 || pos.nPos > nFileSize)
+            return false;
+        const unsigned int nRecordSize = ReadLE32(pfile + pos.nPos - 4);
+        if (nRecordSize > nFileSize - pos.nPos)
+            return false;
+        pbegin = (const char*)pfile + pos.nPos;
+        pend = pbegin + nRecordSize;
+        return true;
+    }
+
+    size_t Size()
+    {
+        LOCK(cs_mapped);
+        return mapRegions.size();
+    }
+};
+
+static CBlockFileMapper blockFileMapper;
+
+/**
+ * Deserialize the block record at pos with reader(stream), taking it from the
+ * write queue or a mapped block file. Returns false, without calling reader,
+ * if the record has to be read from its file.
+ */
+template <typename Reader>
+static bool ReadBlockRecord(const CDiskBlockPos& pos, Reader& reader)
+{
+    CDataStream ssPending(SER_DISK, CLIENT_VERSION);
+    if (blockFileWriter.GetPending(false, pos, ssPending)) {
+        nBlockQueueReads++;
+        reader(ssPending);
+        return true;
+    }
+    std::shared_ptr<const boost::interprocess::mapped_region> region;
+    const char* pbegin;
+    const char* pend;
+    if (blockFileMapper.Map(pos, region, pbegin, pend)) {
+        nBlockMappedReads++;
+        CMemoryReader ssMapped(pbegin, pend, SER_DISK, CLIENT_VERSION);
+        reader(ssMapped);
+        return true;
+    }
+    nBlockFileReads++;
+    return false;
+}
+
+struct CBlockRecordReader {
+    CBlock& block;
+
+    template <typename Stream>
+    void operator()(Stream& s) { s >> block; }
+};
+
+/** Reads the header and the transaction at postx of a block record */
+struct CTxRecordReader {
+    const CDiskTxPos& postx;
+    CBlockHeader& header;
+    CTransaction& tx;
+
+    template <typename Stream>
+    void operator()(Stream& s)
+    {
+        s >> header;
+        s.ignore(postx.nTxOffset);
+        s >> tx;
+    }
+};
+
+/**
+ * Recently read blocks, shared between readers. Blocks are immutable for a
+ * given hash, so entries never need to be invalidated.
+ */
+static CLRUCache<uint256, std::shared_ptr<const CBlock>, BlockHasher> blockCache(DEFAULT_BLOCK_CACHE_SIZE);
+
+void InitBlockCache()
+{
+    int64_t nMaxSize = std::max((int64_t)0, GetArg("-maxblockcache", DEFAULT_BLOCK_CACHE_SIZE));
+    blockCache.SetMaxSize(nMaxSize);
+    int64_t nMaxTxPos = std::max((int64_t)0, GetArg("-maxtxposcache", DEFAULT_TX_POS_CACHE_SIZE));
+    txPosCache.SetMaxSize(nMaxTxPos);
+    int64_t nMaxTx = std::max((int64_t)0, GetArg("-maxtxcache", DEFAULT_TX_CACHE_SIZE));
+    txCache.SetMaxSize(nMaxTx);
+    LogPrintf("Using a block cache of %d blocks, a transaction position cache of %d entries and a transaction cache of %d entries\n", nMaxSize, nMaxTxPos, nMaxTx);
+
+    if (mapArgs.count("-gettransactiontrace")) {
+        fs::path pathTrace = fs::absolute(GetArg("-gettransactiontrace", ""), GetDataDir());
+        fileTxTrace = fsbridge::fopen(pathTrace, "a");
+        if (fileTxTrace)
+            LogPrintf("Recording transaction lookups to %s\n", pathTrace.string());
+        else
+            LogPrintf("Can't open %s to record transaction lookups\n", pathTrace.string());
+    }
 }
 
-
-//////////////////////////////////////////////////////////////////////////////
-//
-// CBlock and CBlockIndex
-//
+CBlockReadStats GetBlockReadStats()
+{
+    CBlockReadStats stats;
+    stats.nCacheSize = blockCache.Size();
+    stats.nCacheMaxSize = blockCache.MaxSize();
+    stats.nHits = blockCache.nHits;
+    stats.nMisses = blockCache.nMisses;
+    stats.nTxPosCacheSize = txPosCache.Size();
+    stats.nTxPosHits = txPosCache.nHits;
+    stats.nTxPosMisses = txPosCache.nMisses;
+    stats.nTxCacheSize = txCache.Size();
+    stats.nTxHits = txCache.nHits;
+    stats.nTxMisses = txCache.nMisses;
+    stats.nQueueReads = nBlockQueueReads;
+    stats.nMappedReads = nBlockMappedReads;
+    stats.nFileReads = nBlockFileReads;
+    stats.nMappedFiles = blockFileMapper.Size();
+    return stats;
+}
 
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("WriteBlockToDisk : OpenBlockFile failed");
-
-    // Write index header
-    unsigned int nSize = fileout.GetSerializeSize(block);
-    fileout << FLATDATA(Params().MessageStart()) << nSize;
-
-    // Write block
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
-        return error("WriteBlockToDisk : ftell failed");
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    // Serialize with the index header; it is written at the position reserved by FindBlockPos
+    unsigned int nSize = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+    std::shared_ptr<CDataStream> data = std::make_shared<CDataStream>(SER_DISK, CLIENT_VERSION);
+    data->reserve(nSize + 8);
+    *data << FLATDATA(Params().MessageStart()) << nSize << block;
+    pos.nPos += 8;
 
+    if (!blockFileWriter.Write(false, pos, data))
+        return error("WriteBlockToDisk : failed to write block");
     return true;
 }
 
@@ -2102,14 +2627,15 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
 {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("ReadBlockFromDisk : OpenBlockFile failed");
-
     // Read block
     try {
-        filein >> block;
+        CBlockRecordReader reader = {block};
+        if (!ReadBlockRecord(pos, reader)) {
+            CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("ReadBlockFromDisk : OpenBlockFile failed");
+            filein >> block;
+        }
     } catch (const std::exception& e) {
         return error("%s : Deserialize or I/O error - %s", __func__, e.what());
     }
@@ -2123,8 +2649,34 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos)
     return true;
 }
 
+static bool ReadTransactionFromDisk(const CDiskTxPos& postx, CTransaction& tx, uint256& hashBlock)
+{
+    CBlockHeader header;
+    try {
+        CTxRecordReader reader = {postx, header, tx};
+        if (!ReadBlockRecord(postx, reader)) {
+            CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+            if (file.IsNull())
+                return error("%s: OpenBlockFile failed", __func__);
+            file >> header;
+            fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
+            file >> tx;
+        }
+    } catch (const std::exception& e) {
+        return error("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    hashBlock = header.GetHash();
+    return true;
+}
+
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
 {
+    // Use a cached copy, but leave the cache to the callers sharing blocks so bulk scans don't flush it
+    std::shared_ptr<const CBlock> pblock;
+    if (blockCache.Get(pindex->GetBlockHash(), pblock)) {
+        block = *pblock;
+        return true;
+    }
     if (!ReadBlockFromDisk(block, pindex->GetBlockPos()))
         return false;
     if (block.GetHash() != pindex->GetBlockHash()) {
@@ -2135,6 +2687,22 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex)
     return true;
 }
 
+std::shared_ptr<const CBlock> ReadBlockFromDisk(const CBlockIndex* pindex)
+{
+    std::shared_ptr<const CBlock> pblock;
+    if (blockCache.Get(pindex->GetBlockHash(), pblock))
+        return pblock;
+    std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(*pblockNew, pindex->GetBlockPos()))
+        return nullptr;
+    if (pblockNew->GetHash() != pindex->GetBlockHash()) {
+        error("%s : block %s doesn't match index %s", __func__, pblockNew->GetHash().ToString(), pindex->GetBlockHash().ToString());
+        return nullptr;
+    }
+    blockCache.Insert(pindex->GetBlockHash(), pblockNew);
+    return pblockNew;
+}
+
 
 double ConvertBitsToDouble(unsigned int nBits)
 {
@@ -2966,27 +3534,15 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
     }
 }
 
-void static FlushBlockFile(bool fFinalize = false)
+bool static FlushBlockFile(bool fFinalize = false)
 {
-    LOCK(cs_LastBlockFile);
-
-    CDiskBlockPos posOld(nLastBlockFile, 0);
+    if (!fFinalize)
+        return blockFileWriter.Flush();
 
-    FILE* fileOld = OpenBlockFile(posOld);
-    if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nSize);
-        FileCommit(fileOld);
-        fclose(fileOld);
-    }
-
-    fileOld = OpenUndoFile(posOld);
-    if (fileOld) {
-        if (fFinalize)
-            TruncateFile(fileOld, vinfoBlockFile[nLastBlockFile].nUndoSize);
-        FileCommit(fileOld);
-        fclose(fileOld);
-    }
+    // Leaving the last file: trim the pre-allocated space once its queued data is written
+    LOCK(cs_LastBlockFile);
+    return blockFileWriter.Finalize(false, nLastBlockFile, vinfoBlockFile[nLastBlockFile].nSize) &&
+           blockFileWriter.Finalize(true, nLastBlockFile, vinfoBlockFile[nLastBlockFile].nUndoSize);
 }
 
 bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigned int nAddSize);
@@ -2999,80 +3555,170 @@ void ThreadScriptCheck()
     scriptcheckqueue.Thread();
 }
 
-bool RecalculatePRCYSupply(int nHeightStart)
+/**
+ * Change in money supply caused by a block: new outputs, less the stake and the fees it destroys.
+ * Run on several threads at once: staked outputs are read through the transaction index,
+ * which needs no cs_main, when it is enabled.
+ */
+static CAmount GetBlockSupplyDelta(const CBlock& block)
 {
-    const int chainHeight = chainActive.Height();
-    if (nHeightStart > chainHeight)
-        return false;
-
-    CBlockIndex* pindex = chainActive[nHeightStart];
-    CAmount nSupplyPrev = pindex->pprev->nMoneySupply;
-
-    uiInterface.ShowProgress(_("Recalculating PRCY supply..."), 0);
-    while (true) {
-        if (pindex->nHeight % 1000 == 0) {
-            LogPrintf("%s : block %d...\n", __func__, pindex->nHeight);
-            int percent = std::max(1, std::min(99, (int)((double)((pindex->nHeight - nHeightStart) * 100) / (chainHeight - nHeightStart))));
-            uiInterface.ShowProgress(_("Recalculating PRCY supply..."), percent);
-        }
-        CBlock block;
-        assert(ReadBlockFromDisk(block, pindex));
-
-        CAmount nValueIn = 0;
-        CAmount nValueOut = 0;
-        CAmount nFees = 0;
-        for (const CTransaction& tx : block.vtx) {
-            nFees += tx.nTxFee;
-            if (tx.IsCoinStake()) {
-                for (unsigned int i = 0; i < tx.vin.size(); i++) {
-                    CAmount nTemp; // = txPrev.vout[prevout.n].nValue;
-                    uint256 hashBlock;
-                    CTransaction txPrev;
-                    GetTransaction(tx.vin[i].prevout.hash, txPrev, hashBlock, true);
-                    const CTxOut& out = txPrev.vout[tx.vin[i].prevout.n];
-                    if (out.nValue > 0) {
-                        //UTXO created by coinbase/coin audit/coinstake transaction
-                        if (!VerifyZeroBlindCommitment(out)) {
-                            throw std::runtime_error("Commitment for coinstake not correct: failed to verify blind commitment");
-                        }
-                        nValueIn += out.nValue;
-                    } else {
-                        uint256 val = out.maskValue.amount;
-                        uint256 mask = out.maskValue.mask;
-                        CKey decodedMask;
-                        CPubKey sharedSec;
-                        sharedSec.Set(tx.vin[i].encryptionKey.begin(), tx.vin[i].encryptionKey.begin() + 33);
-                        ECDHInfo::Decode(mask.begin(), val.begin(), sharedSec, decodedMask, nTemp);
-                        //Verify commitment
-                        std::vector<unsigned char> commitment;
-                        CWallet::CreateCommitment(decodedMask.begin(), nTemp, commitment);
-                        if (commitment != out.commitment) {
-                            throw std::runtime_error("Commitment for coinstake not correct");
-                        }
-                        nValueIn += nTemp;
+    CAmount nValueIn = 0;
+    CAmount nValueOut = 0;
+    CAmount nFees = 0;
+    for (const CTransaction& tx : block.vtx) {
+        nFees += tx.nTxFee;
+        if (tx.IsCoinStake()) {
+            for (unsigned int i = 0; i < tx.vin.size(); i++) {
+                CAmount nTemp; // = txPrev.vout[prevout.n].nValue;
+                const COutPoint& prevout = tx.vin[i].prevout;
+                uint256 hashBlock;
+                CTransaction txPrev;
+                bool fFound = fTxIndex ? GetTransactionFromIndex(prevout.hash, txPrev, hashBlock) : GetTransaction(prevout.hash, txPrev, hashBlock, true);
+                if (!fFound || prevout.n >= txPrev.vout.size())
+                    throw std::runtime_error(strprintf("Staked output %s of block %s not found", prevout.ToString(), block.GetHash().ToString()));
+                const CTxOut& out = txPrev.vout[prevout.n];
+                if (out.nValue > 0) {
+                    //UTXO created by coinbase/coin audit/coinstake transaction
+                    if (!VerifyZeroBlindCommitment(out)) {
+                        throw std::runtime_error("Commitment for coinstake not correct: failed to verify blind commitment");
+                    }
+                    nValueIn += out.nValue;
+                } else {
+                    uint256 val = out.maskValue.amount;
+                    uint256 mask = out.maskValue.mask;
+                    CKey decodedMask;
+                    CPubKey sharedSec;
+                    sharedSec.Set(tx.vin[i].encryptionKey.begin(), tx.vin[i].encryptionKey.begin() + 33);
+                    ECDHInfo::Decode(mask.begin(), val.begin(), sharedSec, decodedMask, nTemp);
+                    //Verify commitment
+                    std::vector<unsigned char> commitment;
+                    CWallet::CreateCommitment(decodedMask.begin(), nTemp, commitment);
+                    if (commitment != out.commitment) {
+                        throw std::runtime_error("Commitment for coinstake not correct");
                     }
+                    nValueIn += nTemp;
                 }
             }
+        }
 
-            for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                if (i == 0 && tx.IsCoinStake())
-                    continue;
+        for (unsigned int i = 0; i < tx.vout.size(); i++) {
+            if (i == 0 && tx.IsCoinStake())
+                continue;
 
-                nValueOut += tx.vout[i].nValue;
-            }
+            nValueOut += tx.vout[i].nValue;
+        }
+    }
+    return nValueOut - nValueIn - nFees;
+}
+
+size_t LoadSupplyDeltas(const std::vector<CBlockIndex*>& vIndex, std::vector<CAmount>& vDelta, std::vector<bool>& vHaveDelta)
+{
+    vDelta.assign(vIndex.size(), 0);
+    vHaveDelta.assign(vIndex.size(), false);
+    // Deltas are stored as they are computed, so an interrupted run resumes where it stopped.
+    // They are only trusted while that run is unfinished; a new run computes every delta again.
+    bool fResume = false;
+    pblocktree->ReadFlag("supplyrecalc", fResume);
+    if (!fResume) {
+        pblocktree->EraseSupplyDeltas();
+        pblocktree->WriteFlag("supplyrecalc", true);
+        return 0;
+    }
+    size_t nResumed = 0;
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        if (pblocktree->ReadSupplyDelta(vIndex[i]->GetBlockHash(), vDelta[i])) {
+            vHaveDelta[i] = true;
+            nResumed++;
         }
+    }
+    LogPrintf("%s : resuming, %u of %u block supply deltas already computed\n", __func__, nResumed, vIndex.size());
+    return nResumed;
+}
 
-        // Rewrite money supply
-        pindex->nMoneySupply = nSupplyPrev + nValueOut - nValueIn - nFees;
+CAmount FoldSupplyDeltas(const std::vector<CBlockIndex*>& vIndex, const std::vector<CAmount>& vDelta)
+{
+    AssertLockHeld(cs_main);
+    CAmount nSupplyPrev = vIndex[0]->pprev ? vIndex[0]->pprev->nMoneySupply : 0;
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        CBlockIndex* pindex = vIndex[i];
+        pindex->nMoneySupply = nSupplyPrev + vDelta[i];
         nSupplyPrev = pindex->nMoneySupply;
+        setDirtyBlockIndex.insert(pindex);
+    }
+    return nSupplyPrev;
+}
 
-        assert(pblocktree->WriteBlockIndex(CDiskBlockIndex(pindex)));
+bool RecalculatePRCYSupply(int nHeightStart)
+{
+    int chainHeight;
+    std::vector<CBlockIndex*> vIndex;
+    {
+        LOCK(cs_main);
+        chainHeight = chainActive.Height();
+        if (nHeightStart > chainHeight)
+            return false;
+        for (int nHeight = nHeightStart; nHeight <= chainHeight; nHeight++)
+            vIndex.push_back(chainActive[nHeight]);
+    }
 
-        if (pindex->nHeight < chainHeight)
-            pindex = chainActive.Next(pindex);
-        else
-            break;
+    const size_t nBlocks = vIndex.size();
+    std::vector<CAmount> vDelta;
+    std::vector<bool> vHaveDelta;
+    const size_t nResumed = LoadSupplyDeltas(vIndex, vDelta, vHaveDelta);
+
+    // Block deltas are independent of each other: split the range across threads
+    uiInterface.ShowProgress(_("Recalculating PRCY supply..."), 0);
+    const size_t nThreads = std::max(1, nScriptCheckThreads);
+    const size_t nChunk = (nBlocks + nThreads - 1) / nThreads;
+    std::atomic<size_t> nDone{nResumed};
+    std::atomic<bool> fInterrupted{false};
+    std::vector<std::future<void> > vWorkers;
+    for (size_t nBegin = 0; nBegin < nBlocks; nBegin += nChunk) {
+        const size_t nEnd = std::min(nBegin + nChunk, nBlocks);
+        vWorkers.push_back(std::async(std::launch::async, [&, nBegin, nEnd]() {
+            std::vector<std::pair<uint256, CAmount> > vNew;
+            for (size_t i = nBegin; i < nEnd; i++) {
+                if (vHaveDelta[i]) continue;
+                if (ShutdownRequested()) {
+                    fInterrupted = true;
+                    break;
+                }
+                CBlock block;
+                if (!ReadBlockFromDisk(block, vIndex[i]))
+                    throw std::runtime_error(strprintf("Can't read block %d from disk", vIndex[i]->nHeight));
+                vDelta[i] = GetBlockSupplyDelta(block);
+                vNew.emplace_back(vIndex[i]->GetBlockHash(), vDelta[i]);
+                if (vNew.size() >= 1000) {
+                    pblocktree->WriteSupplyDeltas(vNew);
+                    vNew.clear();
+                }
+                nDone++;
+            }
+            pblocktree->WriteSupplyDeltas(vNew);
+        }));
+    }
+    for (std::future<void>& worker : vWorkers) {
+        while (worker.wait_for(std::chrono::seconds(1)) != std::future_status::ready) {
+            int percent = std::max(1, std::min(99, (int)((double)(nDone * 100) / nBlocks)));
+            uiInterface.ShowProgress(_("Recalculating PRCY supply..."), percent);
+        }
+        worker.get();
+    }
+    if (fInterrupted)
+        return false;
+
+    CAmount nSupply;
+    {
+        LOCK(cs_main);
+        nSupply = FoldSupplyDeltas(vIndex, vDelta);
+        PublishChainTipSnapshot();
+        FlushStateToDisk();
     }
+    // The run is complete, its stored deltas must not be reused by the next one
+    pblocktree->EraseSupplyDeltas();
+    pblocktree->WriteFlag("supplyrecalc", false);
+    uiInterface.ShowProgress("", 100);
+    LogPrintf("%s : supply at height %d is %s\n", __func__, chainHeight, FormatMoney(nSupply));
     return true;
 }
 
@@ -3179,6 +3825,8 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
     CAmount nValueOut = 0;
     CAmount nValueIn = 0;
     unsigned int nMaxBlockSigOps = MAX_BLOCK_SIGOPS_CURRENT;
+    // The ring signature and bulletproof checks are skipped during the initial block download
+    const bool fRingCTChecks = !IsInitialBlockDownload();
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
         const CTransaction& tx = block.vtx[i];
         nInputs += tx.vin.size();
@@ -3189,13 +3837,15 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
 
         if (!block.IsPoABlockByVersion() && !tx.IsCoinBase()) {
             if (!tx.IsCoinStake()) {
-                if (!tx.IsCoinAudit()) {
+                if (!tx.IsCoinAudit() && !IsRingCTVerified(tx, pindex)) {
                     if (!VerifyRingSignatureWithTxFee(tx, pindex))
                         return state.DoS(100, error("ConnectBlock() : Ring Signature check for transaction %s failed", tx.GetHash().ToString()),
                             REJECT_INVALID, "bad-ring-signature");
                     if (!VerifyBulletProofAggregate(tx))
                         return state.DoS(100, error("ConnectBlock() : Bulletproof check for transaction %s failed", tx.GetHash().ToString()),
                             REJECT_INVALID, "bad-bulletproof");
+                    if (fRingCTChecks)
+                        SetRingCTVerified(tx, pindex);
                 }
             }
 
@@ -3346,9 +3996,22 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         setDirtyBlockIndex.insert(pindex);
     }
 
-    if (fTxIndex)
+    // Everything ReVerifyPoSBlock checks was checked above; record it so PoA audits need not repeat the work,
+    // but only if the RingCT checks really ran for every transaction
+    if (block.IsProofOfStake() && !pindex->IsPoSAudited() && fRingCTChecks && !IsInitialBlockDownload()) {
+        pindex->SetPoSAudited();
+        setDirtyBlockIndex.insert(pindex);
+    }
+
+    if (fTxIndex) {
         if (!pblocktree->WriteTxIndex(vPos))
             return AbortNode(state, "Failed to write transaction index");
+        // The index now points these transactions at this block
+        for (const std::pair<uint256, CDiskTxPos>& txpos : vPos) {
+            txPosCache.Erase(txpos.first);
+            txCache.Erase(txpos.first);
+        }
+    }
 
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -3415,7 +4078,8 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
             if (!CheckDiskSpace(0))
                 return state.Error("out of disk space");
             // First make sure all block and undo data is flushed to disk.
-            FlushBlockFile();
+            if (!FlushBlockFile())
+                return AbortNode(state, "Failed to write block data");
             // Then update all block file information (which may refer to block and undo files).
             {
                 std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
@@ -3470,10 +4134,31 @@ void FlushStateToDisk()
     FlushStateToDisk(state, FLUSH_STATE_ALWAYS);
 }
 
+/** Return the tip snapshot last published by PublishChainTipSnapshot. */
+std::shared_ptr<const CChainTipSnapshot> GetChainTipSnapshot()
+{
+    return std::atomic_load(&g_chain_tip_snapshot);
+}
+
+/** Replace the tip snapshot with one of the current chainActive tip. */
+void PublishChainTipSnapshot()
+{
+    std::shared_ptr<CChainTipSnapshot> snapshot = std::make_shared<CChainTipSnapshot>();
+    const CBlockIndex* pindex = chainActive.Tip();
+    if (pindex) {
+        snapshot->pindex = pindex;
+        snapshot->nHeight = pindex->nHeight;
+        snapshot->hashBlock = pindex->GetBlockHash();
+        snapshot->nMoneySupply = pindex->nMoneySupply;
+    }
+    std::atomic_store(&g_chain_tip_snapshot, std::shared_ptr<const CChainTipSnapshot>(snapshot));
+}
+
 /** Update chainActive and related internal data structures. */
 void static UpdateTip(CBlockIndex* pindexNew)
 {
     chainActive.SetTip(pindexNew);
+    PublishChainTipSnapshot();
 
     // New best block
     nTimeBestReceived = GetTime();
@@ -3546,6 +4231,7 @@ bool static DisconnectTip(CValidationState& state)
     mempool.check(pcoinsTip);
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev);
+    mnodeman.BlockDisconnected(block);
     // Let wallets know transactions went from 1-confirmed to
     // 0-confirmed or conflicted:void
 
@@ -3625,6 +4311,7 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, CBlock*
     mempool.check(pcoinsTip);
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
+    mnodeman.BlockConnected(*pblock);
     // Tell wallet about transactions that went from mempool
     // to conflicted:
     for (const CTransaction& tx : txConflicted) {
@@ -4063,6 +4750,7 @@ CBlockIndex* AddToBlockIndex(const CBlock& block)
         pindexNew->pprev = (*miPrev).second;
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
+        pindexNew->BuildPrevPoAPoS();
 
         //update previous block pointer
         pindexNew->pprev->pnext = pindexNew;
@@ -4189,13 +4877,9 @@ bool FindBlockPos(CValidationState& state, CDiskBlockPos& pos, unsigned int nAdd
         unsigned int nNewChunks = (vinfoBlockFile[nFile].nSize + BLOCKFILE_CHUNK_SIZE - 1) / BLOCKFILE_CHUNK_SIZE;
         if (nNewChunks > nOldChunks) {
             if (CheckDiskSpace(nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos)) {
-                FILE* file = OpenBlockFile(pos);
-                if (file) {
-                    LogPrintf("Pre-allocating up to position 0x%x in blk%05u.dat\n", nNewChunks * BLOCKFILE_CHUNK_SIZE,
-                        pos.nFile);
-                    AllocateFileRange(file, pos.nPos, nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos);
-                    fclose(file);
-                }
+                LogPrintf("Pre-allocating up to position 0x%x in blk%05u.dat\n", nNewChunks * BLOCKFILE_CHUNK_SIZE,
+                    pos.nFile);
+                blockFileWriter.Allocate(false, pos, nNewChunks * BLOCKFILE_CHUNK_SIZE - pos.nPos);
             } else
                 return state.Error("out of disk space");
         }
@@ -4220,13 +4904,9 @@ bool FindUndoPos(CValidationState& state, int nFile, CDiskBlockPos& pos, unsigne
     unsigned int nNewChunks = (nNewSize + UNDOFILE_CHUNK_SIZE - 1) / UNDOFILE_CHUNK_SIZE;
     if (nNewChunks > nOldChunks) {
         if (CheckDiskSpace(nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos)) {
-            FILE* file = OpenUndoFile(pos);
-            if (file) {
-                LogPrintf("Pre-allocating up to position 0x%x in rev%05u.dat\n", nNewChunks * UNDOFILE_CHUNK_SIZE,
-                    pos.nFile);
-                AllocateFileRange(file, pos.nPos, nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos);
-                fclose(file);
-            }
+            LogPrintf("Pre-allocating up to position 0x%x in rev%05u.dat\n", nNewChunks * UNDOFILE_CHUNK_SIZE,
+                pos.nFile);
+            blockFileWriter.Allocate(true, pos, nNewChunks * UNDOFILE_CHUNK_SIZE - pos.nPos);
         } else
             return state.Error("out of disk space");
     }
@@ -4887,6 +5567,14 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
+void CBlockIndex::BuildPrevPoAPoS()
+{
+    if (!pprev)
+        return;
+    pprevPoA = pprev->IsPoABlockByVersion() ? pprev : pprev->pprevPoA;
+    pprevPoS = pprev->IsProofOfStake() ? pprev : pprev->pprevPoS;
+}
+
 bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDiskBlockPos* dbp)
 {
     AssertLockNotHeld(cs_main);
@@ -4895,7 +5583,7 @@ bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDis
     int64_t nStartTime = GetTimeMillis();
     bool checked = CheckBlock(*pblock, state);
 
-    if (!pblock->IsPoABlockByVersion() && !CheckBlockSignature(*pblock))
+    if (!pblock->IsPoABlockByVersion() && !pblock->fPreChecked && !CheckBlockSignature(*pblock))
         return error("ProcessNewBlock() : bad proof-of-stake block signature");
 
     if (pblock->GetHash() != Params().HashGenesisBlock() && pfrom != NULL) {
@@ -5045,13 +5733,14 @@ bool ProcessNewBlock(CValidationState& state, CNode* pfrom, CBlock* pblock, CDis
             if (chainActive.Height() > Params().COINBASE_MATURITY()) {
                 //read block chainActive.Height() - Params().COINBASE_MATURITY()
                 CBlockIndex* p = chainActive[chainActive.Height() - Params().COINBASE_MATURITY()];
-                CBlock b;
-                if (ReadBlockFromDisk(b, p)) {
+                std::shared_ptr<const CBlock> pb = ReadBlockFromDisk(p);
+                if (pb) {
+                    const CBlock& b = *pb;
                     coinbaseIdx = 0;
                     if (p->IsProofOfStake()) {
                         coinbaseIdx = 1;
                     }
-                    CTransaction& coinbase = b.vtx[coinbaseIdx];
+                    const CTransaction& coinbase = b.vtx[coinbaseIdx];
                     if (b.posBlocksAudited.size() == 0) {
                         for (int i = 0; i < (int)coinbase.vout.size(); i++) {
                             if (!coinbase.vout[i].IsNull() && !coinbase.vout[i].commitment.empty() && coinbase.vout[i].nValue > 0 && !coinbase.vout[i].IsEmpty()) {
@@ -5162,6 +5851,34 @@ fs::path GetBlockPosFilename(const CDiskBlockPos& pos, const char* prefix)
     return GetDataDir() / "blocks" / strprintf("%s%05u.dat", prefix, pos.nFile);
 }
 
+/** Block index entries loaded at startup are allocated in bulk; each arena is (first entry, count) */
+static std::vector<std::pair<CBlockIndex*, size_t> > vBlockIndexArenas;
+
+CBlockIndex* AllocateBlockIndexArena(size_t nCount)
+{
+    CBlockIndex* pArena = new CBlockIndex[nCount];
+    vBlockIndexArenas.push_back(std::make_pair(pArena, nCount));
+    return pArena;
+}
+
+/** Free a block index entry, unless it is owned by an arena */
+static void DeleteBlockIndex(CBlockIndex* pindex)
+{
+    std::less<const CBlockIndex*> less;
+    for (const std::pair<CBlockIndex*, size_t>& arena : vBlockIndexArenas) {
+        if (!less(pindex, arena.first) && less(pindex, arena.first + arena.second))
+            return;
+    }
+    delete pindex;
+}
+
+static void DeleteBlockIndexArenas()
+{
+    for (const std::pair<CBlockIndex*, size_t>& arena : vBlockIndexArenas)
+        delete[] arena.first;
+    vBlockIndexArenas.clear();
+}
+
 CBlockIndex* InsertBlockIndex(uint256 hash)
 {
     if (hash.IsNull())
@@ -5185,25 +5902,46 @@ CBlockIndex* InsertBlockIndex(uint256 hash)
 
 bool static LoadBlockIndexDB(std::string& strError)
 {
-    if (!pblocktree->LoadBlockIndexGuts())
+    int64_t nTimeStart = GetTimeMillis();
+    // A snapshot written at the last clean shutdown saves loading the index from the database
+    std::vector<CBlockIndex*> vSnapshot;
+    bool fSnapshot = false;
+    if (GetBoolArg("-blockindexsnapshot", DEFAULT_BLOCKINDEX_SNAPSHOT)) {
+        LOCK(cs_main);
+        bool fCleanShutdown = false;
+        fSnapshot = pblocktree->ReadFlag("shutdown", fCleanShutdown) && fCleanShutdown &&
+                    ReadBlockIndexSnapshot(pcoinsTip->GetBestBlock(), vSnapshot);
+    }
+    RemoveBlockIndexSnapshot();
+    if (!fSnapshot && !pblocktree->LoadBlockIndexGuts())
         return false;
+    int64_t nTimeGuts = GetTimeMillis();
 
     boost::this_thread::interruption_point();
 
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
     vSortedByHeight.reserve(mapBlockIndex.size());
-    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
-        CBlockIndex* pindex = item.second;
-        vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
+    if (fSnapshot) {
+        // Snapshot entries are stored by height, with their chain work and links
+        for (CBlockIndex* pindex : vSnapshot)
+            vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
+        std::vector<CBlockIndex*>().swap(vSnapshot);
+    } else {
+        for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+            CBlockIndex* pindex = item.second;
+            vSortedByHeight.push_back(std::make_pair(pindex->nHeight, pindex));
+        }
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end());
     }
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end());
+    int nAuditedHeightsRead = 0;
     for (const PAIRTYPE(int, CBlockIndex*) & item : vSortedByHeight) {
         // Stop if shutdown was requested
         if (ShutdownRequested()) return false;
 
         CBlockIndex* pindex = item.second;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        if (!fSnapshot)
+            pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
         if (pindex->nStatus & BLOCK_HAVE_DATA) {
             if (pindex->pprev) {
                 if (pindex->pprev->nChainTx) {
@@ -5221,13 +5959,28 @@ bool static LoadBlockIndexDB(std::string& strError)
         if (pindex->nStatus & BLOCK_FAILED_MASK &&
             (!pindexBestInvalid || pindex->nChainWork > pindexBestInvalid->nChainWork))
             pindexBestInvalid = pindex;
-        if (pindex->pprev)
+        if (pindex->pprev && !fSnapshot) {
             pindex->BuildSkip();
+            pindex->BuildPrevPoAPoS();
+        }
+        // Block index entries written by older versions lack the audited height of PoA blocks
+        if (pindex->IsPoABlockByVersion() && !pindex->HasAuditedPoSHeight() && (pindex->nStatus & BLOCK_HAVE_DATA)) {
+            CBlock block;
+            if (ReadBlockFromDisk(block, pindex) && !block.posBlocksAudited.empty()) {
+                pindex->SetAuditedPoSHeight(block.posBlocksAudited.back().height);
+                setDirtyBlockIndex.insert(pindex);
+                nAuditedHeightsRead++;
+            }
+        }
         if (pindex->IsValid(BLOCK_VALID_TREE) &&
             (pindexBestHeader == NULL || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
             pindexBestHeader = pindex;
     }
 
+    if (nAuditedHeightsRead)
+        LogPrintf("%s: read the audited PoS height of %d PoA blocks\n", __func__, nAuditedHeightsRead);
+    int64_t nTimeChainWork = GetTimeMillis();
+
     // Load block file info
     pblocktree->ReadLastBlockFile(nLastBlockFile);
     vinfoBlockFile.resize(nLastBlockFile + 1);
@@ -5260,6 +6013,8 @@ bool static LoadBlockIndexDB(std::string& strError)
             return false;
         }
     }
+    LogPrintf("%s: %u block index entries loaded in %dms (%s %dms, chain work %dms, block files %dms)\n", __func__,
+        mapBlockIndex.size(), GetTimeMillis() - nTimeStart, fSnapshot ? "snapshot" : "database", nTimeGuts - nTimeStart, nTimeChainWork - nTimeGuts, GetTimeMillis() - nTimeChainWork);
 
     //Check if the shutdown procedure was followed on last client exit
     bool fLastShutdownWasPrepared = true;
@@ -5283,6 +6038,7 @@ bool static LoadBlockIndexDB(std::string& strError)
     if (it == mapBlockIndex.end())
         return true;
     chainActive.SetTip(it->second);
+    PublishChainTipSnapshot();
 
     PruneBlockIndexCandidates();
 
@@ -5388,6 +6144,7 @@ void UnloadBlockIndex()
     LOCK(cs_main);
     setBlockIndexCandidates.clear();
     chainActive.SetTip(NULL);
+    PublishChainTipSnapshot();
     pindexBestInvalid = NULL;
     pindexBestHeader = NULL;
     mempool.clear();
@@ -5408,9 +6165,10 @@ void UnloadBlockIndex()
     recentRejects.reset(nullptr);
 
     for (BlockMap::value_type& entry : mapBlockIndex) {
-        delete entry.second;
+        DeleteBlockIndex(entry.second);
     }
     mapBlockIndex.clear();
+    DeleteBlockIndexArenas();
 }
 
 bool LoadBlockIndex(std::string& strError)
@@ -5464,6 +6222,243 @@ bool InitBlockIndex()
 }
 
 
+/**
+ * Verify the block signature, the part of ProcessNewBlock that needs no chain
+ * state. On success block.fPreChecked is set and it is not verified again.
+ * The merkle roots are always checked by CheckBlock.
+ */
+static bool PreCheckBlock(const CBlock& block)
+{
+    if (!block.IsPoABlockByVersion() && !CheckBlockSignature(block))
+        return false;
+    block.fPreChecked = true;
+    return true;
+}
+
+/**
+ * Staged import of a block file. A scanner thread locates the block records,
+ * a pool of workers deserializes them and runs PreCheckBlock, and the caller
+ * takes the blocks in file order with Next to connect them. Records read ahead
+ * are bounded by MAX_BLOCK_IMPORT_QUEUE_SIZE. A block that fails PreCheckBlock
+ * is still returned, so the full checks reject it as before.
+ *
+ * The scanner reads ahead trusting the size field of each record. If a record
+ * does not deserialize, or uses fewer bytes than its size field claims, the
+ * records read behind it are dropped and the scan restarts where it would have
+ * continued without reading ahead.
+ */
+class CBlockImporter
+{
+public:
+    struct CRecord {
+        CDiskBlockPos pos;
+        unsigned int nSize;
+        unsigned int nUsed;      //!< bytes the block used of nSize
+        uint64_t nRewind;        //!< where the scan continues if the record does not deserialize
+        std::vector<char> vData; //!< the serialized block, released once decoded
+        CBlock block;
+        std::string strError;    //!< why the record could not be decoded
+        bool fDone;
+
+        CRecord() : nSize(0), nUsed(0), nRewind(0), fDone(false) {}
+    };
+
+private:
+    CBufferedFile& blkdat;
+    const int nFile;
+    boost::mutex mutex;
+    boost::condition_variable condWorker;
+    boost::condition_variable condScanner;
+    boost::condition_variable condNext;
+    std::deque<std::shared_ptr<CRecord> > queueDecode;
+    std::deque<std::shared_ptr<CRecord> > queueOrdered;
+    size_t nQueuedBytes;
+    bool fScanDone;
+    bool fStop;
+    bool fRestart;        //!< a record read ahead was bad, scan again from nRestartPos
+    uint64_t nRestartPos;
+    std::string strScanError;
+    boost::thread_group threads;
+
+    bool Push(const std::shared_ptr<CRecord>& record)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (!fStop && !fRestart && nQueuedBytes > 0 && nQueuedBytes + record->nSize > MAX_BLOCK_IMPORT_QUEUE_SIZE)
+            condScanner.wait(lock);
+        if (fStop)
+            return false;
+        if (fRestart)
+            return true; // read from a position that is being scanned again
+        nQueuedBytes += record->nSize;
+        queueDecode.push_back(record);
+        queueOrdered.push_back(record);
+        condWorker.notify_one();
+        return true;
+    }
+
+    void Scan()
+    {
+        try {
+            uint64_t nRewind = blkdat.GetPos();
+            bool fEnd = false;
+            while (true) {
+                boost::this_thread::interruption_point();
+                {
+                    // At the end of the file wait until every record was taken, as a bad one restarts the scan
+                    boost::unique_lock<boost::mutex> lock(mutex);
+                    while (fEnd && !fStop && !fRestart && !queueOrdered.empty())
+                        condScanner.wait(lock);
+                    if (fStop)
+                        break;
+                    if (fRestart) {
+                        nRewind = nRestartPos;
+                        fRestart = false;
+                        fEnd = false;
+                    } else if (fEnd) {
+                        break;
+                    }
+                }
+
+                // the buffer only keeps a block behind the read position, seek if the restart is further back
+                if (!blkdat.SetPos(nRewind) && !blkdat.Seek(nRewind))
+                    throw std::runtime_error(strprintf("%s : failed to seek to %u", __func__, nRewind));
+                if (blkdat.eof()) {
+                    fEnd = true;
+                    continue;
+                }
+                nRewind++;         // start one byte further next time, in case of failure
+                blkdat.SetLimit(); // remove former limit
+                unsigned int nSize = 0;
+                try {
+                    // locate a header
+                    unsigned char buf[MESSAGE_START_SIZE];
+                    blkdat.FindByte(Params().MessageStart()[0]);
+                    nRewind = blkdat.GetPos() + 1;
+                    blkdat >> FLATDATA(buf);
+                    if (memcmp(buf, Params().MessageStart(), MESSAGE_START_SIZE))
+                        continue;
+                    // read size
+                    blkdat >> nSize;
+                    if (nSize < 80 || nSize > MAX_BLOCK_SIZE_CURRENT)
+                        continue;
+                } catch (const std::exception&) {
+                    // no valid block header found; don't complain
+                    fEnd = true;
+                    continue;
+                }
+                std::shared_ptr<CRecord> record = std::make_shared<CRecord>();
+                try {
+                    // read the record, it is deserialized by a worker
+                    uint64_t nBlockPos = blkdat.GetPos();
+                    blkdat.SetLimit(nBlockPos + nSize);
+                    record->pos = CDiskBlockPos(nFile, nBlockPos);
+                    record->nSize = nSize;
+                    record->nRewind = nRewind;
+                    record->vData.resize(nSize);
+                    blkdat.read(&record->vData[0], nSize);
+                    nRewind = blkdat.GetPos();
+                } catch (const std::exception& e) {
+                    LogPrintf("%s : Deserialize or I/O error - %s\n", __func__, e.what());
+                    continue;
+                }
+                if (!Push(record))
+                    break;
+            }
+        } catch (const std::runtime_error& e) {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            strScanError = e.what();
+        }
+        boost::unique_lock<boost::mutex> lock(mutex);
+        fScanDone = true;
+        condNext.notify_all();
+    }
+
+    void Decode()
+    {
+        while (true) {
+            std::shared_ptr<CRecord> record;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (!fStop && queueDecode.empty())
+                    condWorker.wait(lock);
+                if (fStop)
+                    return;
+                record = queueDecode.front();
+                queueDecode.pop_front();
+            }
+            try {
+                CMemoryReader ss(&record->vData[0], &record->vData[0] + record->vData.size(), SER_DISK, CLIENT_VERSION);
+                ss >> record->block;
+                record->nUsed = record->nSize - ss.size();
+                PreCheckBlock(record->block);
+            } catch (const std::exception& e) {
+                record->strError = e.what();
+            }
+            std::vector<char>().swap(record->vData);
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            record->fDone = true;
+            condNext.notify_all();
+        }
+    }
+
+public:
+    CBlockImporter(CBufferedFile& blkdatIn, int nFileIn) : blkdat(blkdatIn), nFile(nFileIn), nQueuedBytes(0), fScanDone(false), fStop(false), fRestart(false), nRestartPos(0)
+    {
+        // Sized by -par like script verification; the caller connects the blocks, leave it a thread
+        const int nWorkers = std::max(1, nScriptCheckThreads - 1);
+        threads.create_thread(boost::bind(&CBlockImporter::Scan, this));
+        for (int i = 0; i < nWorkers; i++)
+            threads.create_thread(boost::bind(&CBlockImporter::Decode, this));
+    }
+
+    ~CBlockImporter()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            fStop = true;
+        }
+        condWorker.notify_all();
+        condScanner.notify_all();
+        threads.interrupt_all();
+        threads.join_all();
+    }
+
+    /** Wait for the next record in file order; null once the whole file was scanned */
+    std::shared_ptr<CRecord> Next()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (true) {
+            if (!queueOrdered.empty() && queueOrdered.front()->fDone) {
+                std::shared_ptr<CRecord> record = queueOrdered.front();
+                queueOrdered.pop_front();
+                nQueuedBytes -= record->nSize;
+                if (!record->strError.empty() || record->nUsed < record->nSize) {
+                    // The size field was wrong: drop what was read behind it and scan again
+                    // from just past its header, or from the end of the block that was found
+                    fRestart = true;
+                    nRestartPos = record->strError.empty() ? record->pos.nPos + record->nUsed : record->nRewind;
+                    queueOrdered.clear();
+                    queueDecode.clear();
+                    nQueuedBytes = 0;
+                }
+                condScanner.notify_one();
+                return record;
+            }
+            if (queueOrdered.empty() && fScanDone)
+                return nullptr;
+            condNext.wait(lock);
+        }
+    }
+
+    /** The I/O error that ended the scan, if any */
+    std::string GetScanError()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        return strScanError;
+    }
+};
+
 bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp)
 {
     // Map of disk positions for blocks with unknown parent (only used for reindex)
@@ -5471,44 +6466,29 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp)
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
+    int nProcessed = 0;
+    int64_t nLastProgress = nStart;
     try {
         // This takes over fileIn and calls fclose() on it in the CBufferedFile destructor
         CBufferedFile blkdat(fileIn, 2 * MAX_BLOCK_SIZE_CURRENT, MAX_BLOCK_SIZE_CURRENT + 8, SER_DISK, CLIENT_VERSION);
-        uint64_t nRewind = blkdat.GetPos();
-        while (!blkdat.eof()) {
+        CBlockImporter importer(blkdat, dbp ? dbp->nFile : -1);
+        while (std::shared_ptr<CBlockImporter::CRecord> record = importer.Next()) {
             boost::this_thread::interruption_point();
 
-            blkdat.SetPos(nRewind);
-            nRewind++;         // start one byte further next time, in case of failure
-            blkdat.SetLimit(); // remove former limit
-            unsigned int nSize = 0;
-            try {
-                // locate a header
-                unsigned char buf[MESSAGE_START_SIZE];
-                blkdat.FindByte(Params().MessageStart()[0]);
-                nRewind = blkdat.GetPos() + 1;
-                blkdat >> FLATDATA(buf);
-                if (memcmp(buf, Params().MessageStart(), MESSAGE_START_SIZE))
-                    continue;
-                // read size
-                blkdat >> nSize;
-                if (nSize < 80 || nSize > MAX_BLOCK_SIZE_CURRENT)
-                    continue;
-            } catch (const std::exception&) {
-                // no valid block header found; don't complain
-                break;
+            if (!record->strError.empty()) {
+                LogPrintf("%s : Deserialize or I/O error - %s\n", __func__, record->strError);
+                continue;
+            }
+            if (dbp)
+                dbp->nPos = record->pos.nPos;
+            CBlock& block = record->block;
+            nProcessed++;
+            if (GetTimeMillis() - nLastProgress > 10000) {
+                nLastProgress = GetTimeMillis();
+                LogPrintf("%s : processed %d blocks, %.1f blocks/s\n", __func__, nProcessed, 1000.0 * nProcessed / (nLastProgress - nStart));
             }
-            try {
-                // read block
-                uint64_t nBlockPos = blkdat.GetPos();
-                if (dbp)
-                    dbp->nPos = nBlockPos;
-                blkdat.SetLimit(nBlockPos + nSize);
-                blkdat.SetPos(nBlockPos);
-                CBlock block;
-                blkdat >> block;
-                nRewind = blkdat.GetPos();
 
+            try {
                 // detect out of order blocks, and store them for later
                 uint256 hash = block.GetHash();
                 if (hash != Params().HashGenesisBlock() &&
@@ -5560,11 +6540,16 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos* dbp)
                 LogPrintf("%s : Deserialize or I/O error - %s\n", __func__, e.what());
             }
         }
+        std::string strScanError = importer.GetScanError();
+        if (!strScanError.empty())
+            throw std::runtime_error(strScanError);
     } catch (const std::runtime_error& e) {
         AbortNode(std::string("System error: ") + e.what());
     }
-    if (nLoaded > 0)
-        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+    if (nLoaded > 0) {
+        int64_t nElapsed = std::max((int64_t)1, GetTimeMillis() - nStart);
+        LogPrintf("Loaded %i blocks from external file in %dms (%.1f blocks/s)\n", nLoaded, nElapsed, 1000.0 * nLoaded / nElapsed);
+    }
     return nLoaded > 0;
 }
 
@@ -5798,12 +6783,11 @@ bool static AlreadyHave(const CInv& inv)
     case MSG_BLOCK:
         return mapBlockIndex.count(inv.hash);
     case MSG_TXLOCK_REQUEST:
-        return mapTxLockReq.count(inv.hash) ||
-               mapTxLockReqRejected.count(inv.hash);
+        return swiftTX.HasLockRequest(inv.hash);
     case MSG_TXLOCK_VOTE:
-        return mapTxLockVote.count(inv.hash);
+        return swiftTX.HasLockVote(inv.hash);
     case MSG_MASTERNODE_WINNER:
-        if (masternodePayments.mapMasternodePayeeVotes.count(inv.hash)) {
+        if (masternodePayments.HasPayeeVote(inv.hash)) {
             masternodeSync.AddedMasternodeWinner(inv.hash);
             return true;
         }
@@ -5949,19 +6933,21 @@ void static ProcessGetData(CNode* pfrom)
                     }
                 }
                 if (!pushed && inv.type == MSG_TXLOCK_VOTE) {
-                    if (mapTxLockVote.count(inv.hash)) {
+                    CConsensusVote vote;
+                    if (swiftTX.GetLockVote(inv.hash, vote)) {
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
-                        ss << mapTxLockVote[inv.hash];
+                        ss << vote;
                         pfrom->PushMessage(NetMsgType::IXLOCKVOTE, ss);
                         pushed = true;
                     }
                 }
                 if (!pushed && inv.type == MSG_TXLOCK_REQUEST) {
-                    if (mapTxLockReq.count(inv.hash)) {
+                    CTransaction tx;
+                    if (swiftTX.GetLockRequest(inv.hash, tx)) {
                         CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
                         ss.reserve(1000);
-                        ss << mapTxLockReq[inv.hash];
+                        ss << tx;
                         pfrom->PushMessage(NetMsgType::IX, ss);
                         pushed = true;
                     }
@@ -6827,7 +7813,7 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
             mnodeman.ProcessMessage(pfrom, strCommand, vRecv);
             budget.ProcessMessage(pfrom, strCommand, vRecv);
             masternodePayments.ProcessMessageMasternodePayments(pfrom, strCommand, vRecv);
-            ProcessMessageSwiftTX(pfrom, strCommand, vRecv);
+            swiftTX.ProcessMessage(pfrom, strCommand, vRecv);
             masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
         } else {
             // Ignore unknown commands for extensibility
@@ -6857,6 +7843,16 @@ bool ProcessMessages(CNode* pfrom)
     //
     bool fOk = true;
 
+    // Recover the signers of queued masternode messages ahead of handling them
+    for (CNetMessage& msg : pfrom->vRecvMsg) {
+        if (!msg.complete())
+            break;
+        if (!msg.fPreVerifyQueued) {
+            msg.fPreVerifyQueued = true;
+            PreVerifyMasternodeMessage(msg.hdr.GetCommand(), msg.vRecv);
+        }
+    }
+
     if (!pfrom->vRecvGetData.empty())
         ProcessGetData(pfrom);
 
@@ -7172,43 +8168,40 @@ bool SendMessages(CNode* pto)
 
 bool CBlockUndo::WriteToDisk(CDiskBlockPos& pos, const uint256& hashBlock)
 {
-    // Open history file to append
-    CAutoFile fileout(OpenUndoFile(pos), SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("CBlockUndo::WriteToDisk : OpenUndoFile failed");
-
-    // Write index header
-    unsigned int nSize = fileout.GetSerializeSize(*this);
-    fileout << FLATDATA(Params().MessageStart()) << nSize;
-
-    // Write undo data
-    long fileOutPos = ftell(fileout.Get());
-    if (fileOutPos < 0)
-        return error("CBlockUndo::WriteToDisk : ftell failed");
-    pos.nPos = (unsigned int)fileOutPos;
-    fileout << *this;
+    // Serialize with the index header; it is written at the position reserved by FindUndoPos
+    unsigned int nSize = ::GetSerializeSize(*this, SER_DISK, CLIENT_VERSION);
+    std::shared_ptr<CDataStream> data = std::make_shared<CDataStream>(SER_DISK, CLIENT_VERSION);
+    data->reserve(nSize + 40);
+    *data << FLATDATA(Params().MessageStart()) << nSize << *this;
+    pos.nPos += 8;
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << hashBlock;
     hasher << *this;
-    fileout << hasher.GetHash();
+    *data << hasher.GetHash();
 
+    if (!blockFileWriter.Write(true, pos, data))
+        return error("CBlockUndo::WriteToDisk : failed to write undo data");
     return true;
 }
 
 bool CBlockUndo::ReadFromDisk(const CDiskBlockPos& pos, const uint256& hashBlock)
 {
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
-
-    // Read block
+    // Read undo data, from the write queue if it is not on disk yet
     uint256 hashChecksum;
     try {
-        filein >> *this;
-        filein >> hashChecksum;
+        CDataStream ssPending(SER_DISK, CLIENT_VERSION);
+        if (blockFileWriter.GetPending(true, pos, ssPending)) {
+            ssPending >> *this;
+            ssPending >> hashChecksum;
+        } else {
+            CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull())
+                return error("CBlockUndo::ReadFromDisk : OpenBlockFile failed");
+            filein >> *this;
+            filein >> hashChecksum;
+        }
     } catch (const std::exception& e) {
         return error("%s : Deserialize or I/O error - %s", __func__, e.what());
     }
@@ -7240,8 +8233,9 @@ public:
         // block headers
         BlockMap::iterator it1 = mapBlockIndex.begin();
         for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
+            DeleteBlockIndex((*it1).second);
         mapBlockIndex.clear();
+        DeleteBlockIndexArenas();
 
         // orphan transactions
         mapOrphanTransactions.clear();
@@ -33,8 +33,10 @@
 #include "bignum.h"
 
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdint.h>
 #include <string>
@@ -53,6 +55,7 @@ class CBlockIndex;
 class CBlockTreeDB;
 class CBloomFilter;
 class CInv;
+class CRingCTCheck;
 class CScriptCheck;
 class CValidationInterface;
 class CValidationState;
@@ -77,6 +80,16 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 static const unsigned int BLOCKFILE_CHUNK_SIZE = 0x1000000; // 16 MiB
 /** The pre-allocation chunk size for rev?????.dat files (since 0.8) */
 static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
+/** Default for -maxblockcache, the number of recently read blocks kept in memory */
+static const unsigned int DEFAULT_BLOCK_CACHE_SIZE = 64;
+/** Default for -maxtxposcache, the number of transaction index entries kept in memory */
+static const unsigned int DEFAULT_TX_POS_CACHE_SIZE = 100000;
+/** Default for -maxtxcache, the number of transactions read through the transaction index kept in memory */
+static const unsigned int DEFAULT_TX_CACHE_SIZE = 1000;
+/** Maximum size of block and undo data waiting for the block file writer thread */
+static const unsigned int MAX_BLOCK_WRITE_QUEUE_SIZE = 0x2000000; // 32 MiB
+/** Maximum size of the block records read ahead of the block being imported by LoadExternalBlockFile */
+static const unsigned int MAX_BLOCK_IMPORT_QUEUE_SIZE = 0x4000000; // 64 MiB
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int COINBASE_MATURITY = 100;
 /** Maximum number of script-checking threads allowed */
@@ -143,6 +156,38 @@ extern Mutex g_best_block_mutex;
 extern std::condition_variable g_best_block_cv;
 extern uint256 g_best_block;
 
+/**
+ * The active chain tip as of its last change. RPCs that only need the tip read it
+ * without cs_main. Block index entries are not freed while running, so pindex
+ * stays valid after the tip moves on.
+ */
+struct CChainTipSnapshot {
+    const CBlockIndex* pindex; //!< NULL before the chain is loaded
+    int nHeight;
+    uint256 hashBlock;
+    CAmount nMoneySupply;
+
+    CChainTipSnapshot() : pindex(NULL), nHeight(-1), nMoneySupply(0) {}
+
+    /** Whether pindexIn is in the chain ending at this tip */
+    bool Contains(const CBlockIndex* pindexIn) const
+    {
+        return pindex && pindexIn->nHeight <= nHeight && pindex->GetAncestor(pindexIn->nHeight) == pindexIn;
+    }
+
+    /** The successor of pindexIn in this chain, or NULL */
+    const CBlockIndex* Next(const CBlockIndex* pindexIn) const
+    {
+        if (!Contains(pindexIn) || pindexIn->nHeight == nHeight) return NULL;
+        return pindex->GetAncestor(pindexIn->nHeight + 1);
+    }
+};
+
+/** Get the last published chain tip */
+std::shared_ptr<const CChainTipSnapshot> GetChainTipSnapshot();
+/** Publish the tip of chainActive; called whenever it changes */
+void PublishChainTipSnapshot();
+
 extern std::atomic<bool> fImporting;
 extern std::atomic<bool> fReindex;
 extern int nScriptCheckThreads;
@@ -187,9 +232,13 @@ secp256k1_scratch_space2* GetScratch();
 secp256k1_bulletproof_generators* GetGenerator();
 bool VerifyBulletProofAggregate(const CTransaction& tx);
 bool VerifyRingSignatureWithTxFee(const CTransaction& tx, CBlockIndex* pindex);
+/** Copy the first nCols columns and nRows rows of tx.S into the column-major layout of secp256k1_mlsag_verify */
+bool GetRingSignatureScalars(const CTransaction& tx, size_t nRows, size_t nCols, std::vector<unsigned char>& scalars);
 void DestroyContext();
 bool VerifyDerivedAddress(const CTxOut& out, std::string stealth);
 bool ReVerifyPoSBlock(CBlockIndex* pindex);
+/** Audit several PoS blocks at once; vResults[i] is the ReVerifyPoSBlock result for vIndex[i] */
+void ReVerifyPoSBlocks(const std::vector<CBlockIndex*>& vIndex, std::vector<bool>& vResults);
 
 /**
  * Process an incoming block. This only returns after the best known valid
@@ -232,6 +281,10 @@ bool VerifyZeroBlindCommitment(const CTxOut& out);
 bool SendMessages(CNode* pto);
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the RingCT checking thread */
+void ThreadRingCTCheck();
+/** Run the thread writing block and undo data to disk */
+void ThreadBlockFileWriter();
 
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
@@ -256,6 +309,8 @@ void SetRingSize(int nHeight);
 
 /** Create a new block index entry for a given block hash */
 CBlockIndex* InsertBlockIndex(uint256 hash);
+/** Allocate nCount block index entries at once; they are freed by UnloadBlockIndex */
+CBlockIndex* AllocateBlockIndexArena(size_t nCount);
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats& stats);
 /** Increase a node's misbehavior score. */
@@ -329,6 +384,10 @@ bool IsTransactionInChain(const uint256& txId, int& nHeightTx);
 bool IsBlockHashInChain(const uint256& hashBlock);
 bool ValidOutPoint(const COutPoint out, int nHeight = 1);
 bool RecalculatePRCYSupply(int nHeightStart);
+/** Load the supply deltas of an interrupted recalculation, or start a new one; returns how many were loaded */
+size_t LoadSupplyDeltas(const std::vector<CBlockIndex*>& vIndex, std::vector<CAmount>& vDelta, std::vector<bool>& vHaveDelta);
+/** Set each entry's money supply to its predecessor's plus its delta and mark it dirty; returns the last supply */
+CAmount FoldSupplyDeltas(const std::vector<CBlockIndex*>& vIndex, const std::vector<CAmount>& vDelta);
 
 /**
  * Check if transaction will be final in the next block to be created.
@@ -378,11 +437,91 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+/**
+ * Closure representing the ring signature and bulletproof checks of one
+ * RingCT transaction. Ring members are looked up beforehand under cs_main;
+ * the curve arithmetic done here needs no lock. The outcome is written to
+ * *pfOk rather than returned, so that a failing transaction does not stop
+ * the queue from checking transactions of other blocks.
+ */
+class CRingCTCheck
+{
+public:
+    bool fRingSignature;
+    size_t nRows;
+    size_t nCols;
+    std::vector<secp256k1_pubkey2> ringPubKeys;    //!< column major, last row filled in by VerifyRingSignature
+    std::vector<secp256k1_pubkey2> ringHashPoints; //!< Hp() of ringPubKeys
+    std::vector<secp256k1_pubkey2> inCommitments;  //!< column major, one row per input
+    std::vector<secp256k1_pubkey2> outCommitments;
+    std::vector<secp256k1_pubkey2> keyImages;
+    std::vector<unsigned char> ringScalars;
+    uint256 c;
+    uint256 hashSig;
+    CAmount nTxFee;
+
+    bool fBulletProof;
+    std::vector<secp256k1_pedersen_commitment> commitments;
+    std::vector<unsigned char> bulletproofs;
+
+    std::atomic<bool>* pfOk;
+
+    CRingCTCheck() : fRingSignature(false), nRows(0), nCols(0), nTxFee(0), fBulletProof(false), pfOk(NULL) {}
+
+    bool VerifyRingSignature();
+    bool VerifyBulletProof(secp256k1_scratch_space2* scratch);
+
+    bool operator()();
+
+    void swap(CRingCTCheck& check)
+    {
+        std::swap(fRingSignature, check.fRingSignature);
+        std::swap(nRows, check.nRows);
+        std::swap(nCols, check.nCols);
+        ringPubKeys.swap(check.ringPubKeys);
+        ringHashPoints.swap(check.ringHashPoints);
+        inCommitments.swap(check.inCommitments);
+        outCommitments.swap(check.outCommitments);
+        keyImages.swap(check.keyImages);
+        ringScalars.swap(check.ringScalars);
+        std::swap(c, check.c);
+        std::swap(hashSig, check.hashSig);
+        std::swap(nTxFee, check.nTxFee);
+        std::swap(fBulletProof, check.fBulletProof);
+        commitments.swap(check.commitments);
+        bulletproofs.swap(check.bulletproofs);
+        std::swap(pfOk, check.pfOk);
+    }
+};
+
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(CBlock& block, CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+/** Read a block, sharing it through the recently read block cache; NULL on failure */
+std::shared_ptr<const CBlock> ReadBlockFromDisk(const CBlockIndex* pindex);
+
+/** Statistics of the block read path */
+struct CBlockReadStats {
+    size_t nCacheSize;
+    size_t nCacheMaxSize;
+    uint64_t nHits;         //!< shared or copied from the block cache
+    uint64_t nMisses;
+    uint64_t nQueueReads;   //!< still waiting for the block file writer
+    uint64_t nMappedReads;  //!< from a mapped block file
+    uint64_t nFileReads;    //!< from the block file being written to, through stdio
+    size_t nMappedFiles;
+    size_t nTxPosCacheSize;
+    uint64_t nTxPosHits;    //!< transaction index reads saved
+    uint64_t nTxPosMisses;
+    size_t nTxCacheSize;
+    uint64_t nTxHits;       //!< transactions not read at all
+    uint64_t nTxMisses;
+};
+CBlockReadStats GetBlockReadStats();
+/** Size the block and transaction caches from -maxblockcache, -maxtxposcache and -maxtxcache. */
+void InitBlockCache();
 
 
 /** Functions for validating blocks and updating the block tree */
@@ -101,7 +101,7 @@ void CBudgetManager::CheckOrphanVotes()
 
 
     std::string strError = "";
-    std::map<uint256, CBudgetVote>::iterator it1 = mapOrphanMasternodeBudgetVotes.begin();
+    auto it1 = mapOrphanMasternodeBudgetVotes.begin();
     while (it1 != mapOrphanMasternodeBudgetVotes.end()) {
         if (budget.UpdateProposal(((*it1).second), NULL, strError)) {
             LogPrint(BCLog::MNBUDGET,"CBudgetManager::CheckOrphanVotes - Proposal/Budget is known, activating and removing orphan vote\n");
@@ -110,7 +110,7 @@ void CBudgetManager::CheckOrphanVotes()
             ++it1;
         }
     }
-    std::map<uint256, CFinalizedBudgetVote>::iterator it2 = mapOrphanFinalizedBudgetVotes.begin();
+    auto it2 = mapOrphanFinalizedBudgetVotes.begin();
     while (it2 != mapOrphanFinalizedBudgetVotes.end()) {
         if (budget.UpdateFinalizedBudget(((*it2).second), NULL, strError)) {
             LogPrint(BCLog::MNBUDGET,"CBudgetManager::CheckOrphanVotes - Proposal/Budget is known, activating and removing orphan vote\n");
@@ -245,10 +245,8 @@ void CBudgetManager::SubmitFinalBudget()
 // CBudgetDB
 //
 
-CBudgetDB::CBudgetDB()
+CBudgetDB::CBudgetDB() : CFlatDB("budget.dat", "MasternodeBudget")
 {
-    pathDB = GetDataDir() / "budget.dat";
-    strMagicMessage = "MasternodeBudget";
 }
 
 bool CBudgetDB::Write(const CBudgetManager& objToSave)
@@ -257,27 +255,8 @@ bool CBudgetDB::Write(const CBudgetManager& objToSave)
 
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-    ssObj << strMagicMessage;                   // masternode cache file specific magic message
-    ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssObj << objToSave;
-    uint256 hash = Hash(ssObj.begin(), ssObj.end());
-    ssObj << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathDB, "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathDB.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssObj;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-    fileout.fclose();
+    if (!WriteObject(objToSave))
+        return false;
 
     LogPrint(BCLog::MNBUDGET,"Written info to budget.dat  %dms\n", GetTimeMillis() - nStart);
 
@@ -289,82 +268,16 @@ CBudgetDB::ReadResult CBudgetDB::Read(CBudgetManager& objToLoad, bool fDryRun)
     LOCK(objToLoad.cs);
 
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathDB, "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathDB.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = fs::file_size(pathDB);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    std::vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
-
-
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
-    try {
-        // de-serialize file header (masternode cache file specific magic message) and ..
-        ssObj >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid masternode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-
-        // de-serialize file header (network specific magic number) and ..
-        ssObj >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
-
-        // de-serialize data into CBudgetManager object
-        ssObj >> objToLoad;
-    } catch (const std::exception& e) {
-        objToLoad.Clear();
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return IncorrectFormat;
-    }
+    ReadResult result = ReadObject(objToLoad, fDryRun);
+    if (result != Ok || fDryRun)
+        return result;
 
     LogPrint(BCLog::MNBUDGET,"Loaded info from budget.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint(BCLog::MNBUDGET,"  %s\n", objToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint(BCLog::MNBUDGET,"Budget manager - cleaning....\n");
-        objToLoad.CheckAndRemove();
-        LogPrint(BCLog::MNBUDGET,"Budget manager - result:\n");
-        LogPrint(BCLog::MNBUDGET,"  %s\n", objToLoad.ToString());
-    }
+    LogPrint(BCLog::MNBUDGET,"Budget manager - cleaning....\n");
+    objToLoad.CheckAndRemove();
+    LogPrint(BCLog::MNBUDGET,"Budget manager - result:\n");
+    LogPrint(BCLog::MNBUDGET,"  %s\n", objToLoad.ToString());
 
     return Ok;
 }
@@ -423,6 +336,7 @@ bool CBudgetManager::AddProposal(CBudgetProposal& budgetProposal)
     }
 
     mapProposals.insert(std::make_pair(budgetProposal.GetHash(), budgetProposal));
+    InvalidateBudgetCache();
     LogPrint(BCLog::MNBUDGET,"CBudgetManager::AddProposal - proposal %s added\n", budgetProposal.GetName ().c_str ());
     return true;
 }
@@ -459,10 +373,13 @@ void CBudgetManager::CheckAndRemove()
     }
 
     LogPrint(BCLog::MNBUDGET, "CBudgetManager::CheckAndRemove - mapProposals cleanup - size before: %d\n", mapProposals.size());
+    bool fProposalsChanged = false;
     std::map<uint256, CBudgetProposal>::iterator it2 = mapProposals.begin();
     while (it2 != mapProposals.end()) {
         CBudgetProposal* pbudgetProposal = &((*it2).second);
-        pbudgetProposal->fValid = pbudgetProposal->IsValid(strError);
+        bool fValid = pbudgetProposal->IsValid(strError);
+        if (fValid != pbudgetProposal->fValid) fProposalsChanged = true;
+        pbudgetProposal->fValid = fValid;
         if (!strError.empty ()) {
             LogPrint(BCLog::MNBUDGET,"CBudgetManager::CheckAndRemove - Invalid budget proposal - %s\n", strError);
             strError = "";
@@ -477,6 +394,7 @@ void CBudgetManager::CheckAndRemove()
 
         ++it2;
     }
+    if (fProposalsChanged) InvalidateBudgetCache();
     // Remove invalid entries by overwriting complete map
     // mapFinalizedBudgets = tmpMapFinalizedBudgets;
     // mapProposals = tmpMapProposals;
@@ -646,12 +564,13 @@ bool CBudgetManager::IsTransactionValid(const CTransaction& txNew, int nBlockHei
     if (nHighestCount < nFivePercent) return false;
 
     // check the highest finalized budgets (+/- 10% to assist in consensus)
+    int nTenPercent = mnodeman.CountEnabled(ActiveProtocol()) / 10;
 
     it = mapFinalizedBudgets.begin();
     while (it != mapFinalizedBudgets.end()) {
         CFinalizedBudget* pfinalizedBudget = &((*it).second);
 
-        if (pfinalizedBudget->GetVoteCount() > nHighestCount - mnodeman.CountEnabled(ActiveProtocol()) / 10) {
+        if (pfinalizedBudget->GetVoteCount() > nHighestCount - nTenPercent) {
             if (nBlockHeight >= pfinalizedBudget->GetBlockStart() && nBlockHeight <= pfinalizedBudget->GetBlockEnd()) {
                 if (pfinalizedBudget->IsTransactionValid(txNew, nBlockHeight)) {
                     return true;
@@ -672,10 +591,10 @@ std::vector<CBudgetProposal*> CBudgetManager::GetAllProposals()
 
     std::vector<CBudgetProposal*> vBudgetProposalRet;
 
+    CheckProposalVotes();
+
     std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
     while (it != mapProposals.end()) {
-        (*it).second.CleanAndRemove(false);
-
         CBudgetProposal* pbudgetProposal = &((*it).second);
         vBudgetProposalRet.push_back(pbudgetProposal);
 
@@ -685,6 +604,24 @@ std::vector<CBudgetProposal*> CBudgetManager::GetAllProposals()
     return vBudgetProposalRet;
 }
 
+void CBudgetManager::CheckProposalVotes()
+{
+    AssertLockHeld(cs);
+
+    int nHeight = chainActive.Height();
+    if (nHeight >= 0 && nHeight == nProposalVotesCheckedHeight) return;
+
+    std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
+    while (it != mapProposals.end()) {
+        (*it).second.CleanAndRemove(false);
+        ++it;
+    }
+
+    nProposalVotesCheckedHeight = nHeight;
+    vBudgetCache.clear();
+    fBudgetCached = false;
+}
+
 //
 // Sort by votes, if there's a tie sort by their feeHash TX
 //
@@ -702,13 +639,16 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
 {
     LOCK(cs);
 
+    // The ranking only changes with the votes and the tip
+    CheckProposalVotes();
+    if (fBudgetCached) return vBudgetCache;
+
     // ------- Sort budgets by Yes Count
 
     std::vector<std::pair<CBudgetProposal*, int> > vBudgetPorposalsSort;
 
     std::map<uint256, CBudgetProposal>::iterator it = mapProposals.begin();
     while (it != mapProposals.end()) {
-        (*it).second.CleanAndRemove(false);
         vBudgetPorposalsSort.push_back(std::make_pair(&((*it).second), (*it).second.GetYeas() - (*it).second.GetNays()));
         ++it;
     }
@@ -726,7 +666,7 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
     int nBlockStart = pindexPrev->nHeight - pindexPrev->nHeight % GetBudgetPaymentCycleBlocks() + GetBudgetPaymentCycleBlocks();
     int nBlockEnd = nBlockStart + GetBudgetPaymentCycleBlocks() - 1;
     CAmount nTotalBudget = GetTotalBudget(nBlockStart);
-
+    int nTenPercent = mnodeman.CountEnabled(ActiveProtocol()) / 10;
 
     std::vector<std::pair<CBudgetProposal*, int> >::iterator it2 = vBudgetPorposalsSort.begin();
     while (it2 != vBudgetPorposalsSort.end()) {
@@ -736,12 +676,12 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
         //prop start/end should be inside this period
         if (pbudgetProposal->fValid && pbudgetProposal->nBlockStart <= nBlockStart &&
             pbudgetProposal->nBlockEnd >= nBlockEnd &&
-            pbudgetProposal->GetYeas() - pbudgetProposal->GetNays() > mnodeman.CountEnabled(ActiveProtocol()) / 10 &&
+            pbudgetProposal->GetYeas() - pbudgetProposal->GetNays() > nTenPercent &&
             pbudgetProposal->IsEstablished()) {
 
             LogPrint(BCLog::MNBUDGET,"CBudgetManager::GetBudget() -   Check 1 passed: valid=%d | %ld <= %ld | %ld >= %ld | Yeas=%d Nays=%d Count=%d | established=%d\n",
                       pbudgetProposal->fValid, pbudgetProposal->nBlockStart, nBlockStart, pbudgetProposal->nBlockEnd,
-                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), mnodeman.CountEnabled(ActiveProtocol()) / 10,
+                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), nTenPercent,
                       pbudgetProposal->IsEstablished());
 
             if (pbudgetProposal->GetAmount() + nBudgetAllocated <= nTotalBudget) {
@@ -757,13 +697,16 @@ std::vector<CBudgetProposal*> CBudgetManager::GetBudget()
         else {
             LogPrint(BCLog::MNBUDGET,"CBudgetManager::GetBudget() -   Check 1 failed: valid=%d | %ld <= %ld | %ld >= %ld | Yeas=%d Nays=%d Count=%d | established=%d\n",
                       pbudgetProposal->fValid, pbudgetProposal->nBlockStart, nBlockStart, pbudgetProposal->nBlockEnd,
-                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), mnodeman.CountEnabled(ActiveProtocol()) / 10,
+                      nBlockEnd, pbudgetProposal->GetYeas(), pbudgetProposal->GetNays(), nTenPercent,
                       pbudgetProposal->IsEstablished());
         }
 
         ++it2;
     }
 
+    vBudgetCache = vBudgetProposalsRet;
+    fBudgetCached = true;
+
     return vBudgetProposalsRet;
 }
 
@@ -919,11 +862,7 @@ void CBudgetManager::NewBlock()
     }
 
     LogPrint(BCLog::MNBUDGET,"CBudgetManager::NewBlock - mapProposals cleanup - size: %d\n", mapProposals.size());
-    std::map<uint256, CBudgetProposal>::iterator it2 = mapProposals.begin();
-    while (it2 != mapProposals.end()) {
-        (*it2).second.CleanAndRemove(false);
-        ++it2;
-    }
+    CheckProposalVotes();
 
     LogPrint(BCLog::MNBUDGET,"CBudgetManager::NewBlock - mapFinalizedBudgets cleanup - size: %d\n", mapFinalizedBudgets.size());
     std::map<uint256, CFinalizedBudget>::iterator it3 = mapFinalizedBudgets.begin();
@@ -1178,7 +1117,7 @@ void CBudgetManager::ResetSync()
     LOCK(cs);
 
 
-    std::map<uint256, CBudgetProposalBroadcast>::iterator it1 = mapSeenMasternodeBudgetProposals.begin();
+    auto it1 = mapSeenMasternodeBudgetProposals.begin();
     while (it1 != mapSeenMasternodeBudgetProposals.end()) {
         CBudgetProposal* pbudgetProposal = FindProposal((*it1).first);
         if (pbudgetProposal && pbudgetProposal->fValid) {
@@ -1192,7 +1131,7 @@ void CBudgetManager::ResetSync()
         ++it1;
     }
 
-    std::map<uint256, CFinalizedBudgetBroadcast>::iterator it3 = mapSeenFinalizedBudgets.begin();
+    auto it3 = mapSeenFinalizedBudgets.begin();
     while (it3 != mapSeenFinalizedBudgets.end()) {
         CFinalizedBudget* pfinalizedBudget = FindFinalizedBudget((*it3).first);
         if (pfinalizedBudget && pfinalizedBudget->fValid) {
@@ -1215,7 +1154,7 @@ void CBudgetManager::MarkSynced()
         Mark that we've sent all valid items
     */
 
-    std::map<uint256, CBudgetProposalBroadcast>::iterator it1 = mapSeenMasternodeBudgetProposals.begin();
+    auto it1 = mapSeenMasternodeBudgetProposals.begin();
     while (it1 != mapSeenMasternodeBudgetProposals.end()) {
         CBudgetProposal* pbudgetProposal = FindProposal((*it1).first);
         if (pbudgetProposal && pbudgetProposal->fValid) {
@@ -1230,7 +1169,7 @@ void CBudgetManager::MarkSynced()
         ++it1;
     }
 
-    std::map<uint256, CFinalizedBudgetBroadcast>::iterator it3 = mapSeenFinalizedBudgets.begin();
+    auto it3 = mapSeenFinalizedBudgets.begin();
     while (it3 != mapSeenFinalizedBudgets.end()) {
         CFinalizedBudget* pfinalizedBudget = FindFinalizedBudget((*it3).first);
         if (pfinalizedBudget && pfinalizedBudget->fValid) {
@@ -1263,7 +1202,7 @@ void CBudgetManager::Sync(CNode* pfrom, uint256 nProp, bool fPartial)
 
     int nInvCount = 0;
 
-    std::map<uint256, CBudgetProposalBroadcast>::iterator it1 = mapSeenMasternodeBudgetProposals.begin();
+    auto it1 = mapSeenMasternodeBudgetProposals.begin();
     while (it1 != mapSeenMasternodeBudgetProposals.end()) {
         CBudgetProposal* pbudgetProposal = FindProposal((*it1).first);
         if (pbudgetProposal && pbudgetProposal->fValid && (nProp.IsNull() || (*it1).first == nProp)) {
@@ -1291,7 +1230,7 @@ void CBudgetManager::Sync(CNode* pfrom, uint256 nProp, bool fPartial)
 
     nInvCount = 0;
 
-    std::map<uint256, CFinalizedBudgetBroadcast>::iterator it3 = mapSeenFinalizedBudgets.begin();
+    auto it3 = mapSeenFinalizedBudgets.begin();
     while (it3 != mapSeenFinalizedBudgets.end()) {
         CFinalizedBudget* pfinalizedBudget = FindFinalizedBudget((*it3).first);
         if (pfinalizedBudget && pfinalizedBudget->fValid && (nProp.IsNull() || (*it3).first == nProp)) {
@@ -1341,7 +1280,10 @@ bool CBudgetManager::UpdateProposal(CBudgetVote& vote, CNode* pfrom, std::string
     }
 
 
-    return mapProposals[vote.nProposalHash].AddOrUpdateVote(vote, strError);
+    if (!mapProposals[vote.nProposalHash].AddOrUpdateVote(vote, strError)) return false;
+
+    InvalidateBudgetCache();
+    return true;
 }
 
 bool CBudgetManager::UpdateFinalizedBudget(CFinalizedBudgetVote& vote, CNode* pfrom, std::string& strError)
@@ -1378,6 +1320,7 @@ CBudgetProposal::CBudgetProposal()
     nAmount = 0;
     nTime = 0;
     fValid = true;
+    Tally();
 }
 
 CBudgetProposal::CBudgetProposal(std::string strProposalNameIn, std::string strURLIn, int nBlockStartIn, int nBlockEndIn, CScript addressIn, CAmount nAmountIn, uint256 nFeeTXHashIn)
@@ -1390,6 +1333,7 @@ CBudgetProposal::CBudgetProposal(std::string strProposalNameIn, std::string strU
     nAmount = nAmountIn;
     nFeeTXHash = nFeeTXHashIn;
     fValid = true;
+    Tally();
 }
 
 CBudgetProposal::CBudgetProposal(const CBudgetProposal& other)
@@ -1403,6 +1347,11 @@ CBudgetProposal::CBudgetProposal(const CBudgetProposal& other)
     nTime = other.nTime;
     nFeeTXHash = other.nFeeTXHash;
     mapVotes = other.mapVotes;
+    nYeas = other.nYeas;
+    nNays = other.nNays;
+    nAbstains = other.nAbstains;
+    nAllYeas = other.nAllYeas;
+    nAllNays = other.nAllNays;
     fValid = true;
 }
 
@@ -1510,7 +1459,10 @@ bool CBudgetProposal::AddOrUpdateVote(CBudgetVote& vote, std::string& strError)
         return false;
     }
 
+    std::map<uint256, CBudgetVote>::iterator it = mapVotes.find(hash);
+    if (it != mapVotes.end()) TallyVote((*it).second, -1);
     mapVotes[hash] = vote;
+    TallyVote(vote, 1);
     LogPrint(BCLog::MNBUDGET, "CBudgetProposal::AddOrUpdateVote - %s %s\n", strAction.c_str(), vote.GetHash().ToString().c_str());
 
     return true;
@@ -1522,66 +1474,56 @@ void CBudgetProposal::CleanAndRemove(bool fSignatureCheck)
     std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
 
     while (it != mapVotes.end()) {
-        (*it).second.fValid = (*it).second.SignatureValid(fSignatureCheck);
+        bool fVoteValid = (*it).second.SignatureValid(fSignatureCheck);
+        if (fVoteValid != (*it).second.fValid) {
+            TallyVote((*it).second, -1);
+            (*it).second.fValid = fVoteValid;
+            TallyVote((*it).second, 1);
+        }
         ++it;
     }
 }
 
-double CBudgetProposal::GetRatio()
+void CBudgetProposal::TallyVote(const CBudgetVote& vote, int nWeight)
 {
-    int yeas = 0;
-    int nays = 0;
-
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_YES) yeas++;
-        if ((*it).second.nVote == VOTE_NO) nays++;
-        ++it;
+    if (vote.nVote == VOTE_YES) {
+        nAllYeas += nWeight;
+        if (vote.fValid) nYeas += nWeight;
+    } else if (vote.nVote == VOTE_NO) {
+        nAllNays += nWeight;
+        if (vote.fValid) nNays += nWeight;
+    } else if (vote.nVote == VOTE_ABSTAIN) {
+        if (vote.fValid) nAbstains += nWeight;
     }
+}
 
-    if (yeas + nays == 0) return 0.0f;
-
-    return ((double)(yeas) / (double)(yeas + nays));
+void CBudgetProposal::Tally()
+{
+    nYeas = nNays = nAbstains = nAllYeas = nAllNays = 0;
+    for (const auto& item : mapVotes)
+        TallyVote(item.second, 1);
 }
 
-int CBudgetProposal::GetYeas()
+double CBudgetProposal::GetRatio()
 {
-    int ret = 0;
+    if (nAllYeas + nAllNays == 0) return 0.0f;
 
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_YES && (*it).second.fValid) ret++;
-        ++it;
-    }
+    return ((double)(nAllYeas) / (double)(nAllYeas + nAllNays));
+}
 
-    return ret;
+int CBudgetProposal::GetYeas()
+{
+    return nYeas;
 }
 
 int CBudgetProposal::GetNays()
 {
-    int ret = 0;
-
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_NO && (*it).second.fValid) ret++;
-        ++it;
-    }
-
-    return ret;
+    return nNays;
 }
 
 int CBudgetProposal::GetAbstains()
 {
-    int ret = 0;
-
-    std::map<uint256, CBudgetVote>::iterator it = mapVotes.begin();
-    while (it != mapVotes.end()) {
-        if ((*it).second.nVote == VOTE_ABSTAIN && (*it).second.fValid) ret++;
-        ++it;
-    }
-
-    return ret;
+    return nAbstains;
 }
 
 int CBudgetProposal::GetBlockStartCycle()
@@ -1689,8 +1631,7 @@ bool CBudgetVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     CPubKey pubKeyCollateralAddress;
     CKey keyCollateralAddress;
 
-    HEX_DATA_STREAM << vin.prevout << nProposalHash << nVote << nTime;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     if (!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
         LogPrint(BCLog::MNBUDGET,"CBudgetVote::Sign - Error upon calling SignMessage");
@@ -1705,11 +1646,15 @@ bool CBudgetVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     return true;
 }
 
+std::string CBudgetVote::GetStrMessage() const
+{
+    HEX_DATA_STREAM << vin.prevout << nProposalHash << nVote << nTime;
+    return HEX_STR(ser);
+}
+
 bool CBudgetVote::SignatureValid(bool fSignatureCheck)
 {
     std::string strError = "";
-    HEX_DATA_STREAM << vin.prevout << nProposalHash << nVote << nTime;
-    std::string strMessage = HEX_STR(ser);
 
     CMasternode* pmn = mnodeman.Find(vin);
 
@@ -1720,6 +1665,8 @@ bool CBudgetVote::SignatureValid(bool fSignatureCheck)
 
     if (!fSignatureCheck) return true;
 
+    std::string strMessage = GetStrMessage();
+
     if (!CMessageSigner::VerifyMessage(pmn->pubKeyMasternode, vchSig, strMessage, strError)) {
         LogPrint(BCLog::MNBUDGET,"CBudgetVote::SignatureValid() - Verify message failed, error: %s\n", strError);
         return false;
@@ -2124,8 +2071,7 @@ bool CFinalizedBudgetVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     CPubKey pubKeyCollateralAddress;
     CKey keyCollateralAddress;
 
-    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.prevout << nBudgetHash << nTime;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     if (!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
         LogPrint(BCLog::MNBUDGET,"CFinalizedBudgetVote::Sign - Error upon calling SignMessage");
@@ -2140,11 +2086,16 @@ bool CFinalizedBudgetVote::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     return true;
 }
 
+std::string CFinalizedBudgetVote::GetStrMessage() const
+{
+    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.prevout << nBudgetHash << nTime;
+    return HEX_STR(ser);
+}
+
 bool CFinalizedBudgetVote::SignatureValid(bool fSignatureCheck)
 {
     std::string strError;
-    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.prevout << nBudgetHash << nTime;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     CMasternode* pmn = mnodeman.Find(vin);
 
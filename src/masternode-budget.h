@@ -8,14 +8,18 @@
 #define MASTERNODE_BUDGET_H
 
 #include "base58.h"
+#include "flat-database.h"
 #include "init.h"
 #include "key.h"
 #include "main.h"
 #include "masternode.h"
 #include "net.h"
+#include "saltedhasher.h"
 #include "sync.h"
 #include "util.h"
 
+#include <unordered_map>
+
 
 extern RecursiveMutex cs_budget;
 
@@ -68,6 +72,8 @@ public:
     bool SignatureValid(bool fSignatureCheck);
     void Relay();
 
+    std::string GetStrMessage() const;
+
     std::string GetVoteString()
     {
         std::string ret = "ABSTAIN";
@@ -120,6 +126,8 @@ public:
     bool SignatureValid(bool fSignatureCheck);
     void Relay();
 
+    std::string GetStrMessage() const;
+
     uint256 GetHash()
     {
         CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
@@ -143,23 +151,9 @@ public:
 
 /** Save Budget Manager (budget.dat)
  */
-class CBudgetDB
+class CBudgetDB : public CFlatDB
 {
-private:
-    fs::path pathDB;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CBudgetDB();
     bool Write(const CBudgetManager& objToSave);
     ReadResult Read(CBudgetManager& objToLoad, bool fDryRun = false);
@@ -176,6 +170,15 @@ private:
     // XX42    std::map<uint256, CTransaction> mapCollateral;
     std::map<uint256, uint256> mapCollateralTxids;
 
+    // ranked budget of the next cycle as returned by GetBudget, while fBudgetCached
+    std::vector<CBudgetProposal*> vBudgetCache;
+    bool fBudgetCached;
+    // tip height the votes of all proposals were last checked at, -1 after a vote or proposal change
+    int nProposalVotesCheckedHeight;
+
+    /// Check the votes of all proposals once per tip height; requires cs
+    void CheckProposalVotes();
+
 public:
     // critical section to protect the inner data structures
     mutable RecursiveMutex cs;
@@ -184,17 +187,28 @@ public:
     std::map<uint256, CBudgetProposal> mapProposals;
     std::map<uint256, CFinalizedBudget> mapFinalizedBudgets;
 
-    std::map<uint256, CBudgetProposalBroadcast> mapSeenMasternodeBudgetProposals;
-    std::map<uint256, CBudgetVote> mapSeenMasternodeBudgetVotes;
-    std::map<uint256, CBudgetVote> mapOrphanMasternodeBudgetVotes;
-    std::map<uint256, CFinalizedBudgetBroadcast> mapSeenFinalizedBudgets;
-    std::map<uint256, CFinalizedBudgetVote> mapSeenFinalizedBudgetVotes;
-    std::map<uint256, CFinalizedBudgetVote> mapOrphanFinalizedBudgetVotes;
+    std::unordered_map<uint256, CBudgetProposalBroadcast, CSaltedHasher> mapSeenMasternodeBudgetProposals;
+    std::unordered_map<uint256, CBudgetVote, CSaltedHasher> mapSeenMasternodeBudgetVotes;
+    std::unordered_map<uint256, CBudgetVote, CSaltedHasher> mapOrphanMasternodeBudgetVotes;
+    std::unordered_map<uint256, CFinalizedBudgetBroadcast, CSaltedHasher> mapSeenFinalizedBudgets;
+    std::unordered_map<uint256, CFinalizedBudgetVote, CSaltedHasher> mapSeenFinalizedBudgetVotes;
+    std::unordered_map<uint256, CFinalizedBudgetVote, CSaltedHasher> mapOrphanFinalizedBudgetVotes;
 
     CBudgetManager()
     {
         mapProposals.clear();
         mapFinalizedBudgets.clear();
+        fBudgetCached = false;
+        nProposalVotesCheckedHeight = -1;
+    }
+
+    /// Forget the ranked budget and vote checks after a vote or proposal change
+    void InvalidateBudgetCache()
+    {
+        LOCK(cs);
+        vBudgetCache.clear();
+        fBudgetCached = false;
+        nProposalVotesCheckedHeight = -1;
     }
 
     void ClearSeen()
@@ -250,6 +264,7 @@ public:
         mapSeenFinalizedBudgetVotes.clear();
         mapOrphanMasternodeBudgetVotes.clear();
         mapOrphanFinalizedBudgetVotes.clear();
+        InvalidateBudgetCache();
     }
     void CheckAndRemove();
     std::string ToString() const;
@@ -269,6 +284,9 @@ public:
 
         READWRITE(mapProposals);
         READWRITE(mapFinalizedBudgets);
+
+        if (ser_action.ForRead())
+            InvalidateBudgetCache();
     }
 };
 
@@ -455,6 +473,19 @@ private:
     mutable RecursiveMutex cs;
     CAmount nAlloted;
 
+protected:
+    // running tallies of mapVotes: valid votes by outcome, and yeas and nays regardless of validity
+    int nYeas;
+    int nNays;
+    int nAbstains;
+    int nAllYeas;
+    int nAllNays;
+
+    /// Add (nWeight 1) or remove (nWeight -1) vote from the tallies
+    void TallyVote(const CBudgetVote& vote, int nWeight);
+    /// Recount the tallies from mapVotes
+    void Tally();
+
 public:
     bool fValid;
     std::string strProposalName;
@@ -546,6 +577,9 @@ public:
 
         //for saving to the serialized db
         READWRITE(mapVotes);
+
+        if (ser_action.ForRead())
+            Tally();
     }
 };
 
@@ -574,6 +608,11 @@ public:
         swap(first.nTime, second.nTime);
         swap(first.nFeeTXHash, second.nFeeTXHash);
         first.mapVotes.swap(second.mapVotes);
+        swap(first.nYeas, second.nYeas);
+        swap(first.nNays, second.nNays);
+        swap(first.nAbstains, second.nAbstains);
+        swap(first.nAllYeas, second.nAllYeas);
+        swap(first.nAllNays, second.nAllNays);
     }
 
     CBudgetProposalBroadcast& operator=(CBudgetProposalBroadcast from)
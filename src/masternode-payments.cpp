@@ -17,130 +17,198 @@
 
 /** Object for who's going to get paid on which blocks */
 CMasternodePayments masternodePayments;
+/** Ids of the payees in the block tallies */
+CMasternodePayeeIds masternodePayeeIds;
 
 RecursiveMutex cs_vecPayments;
 RecursiveMutex cs_mapMasternodeBlocks;
 RecursiveMutex cs_mapMasternodePayeeVotes;
 
 //
-// CMasternodePaymentDB
+// CMasternodePayeeIds
 //
 
-CMasternodePaymentDB::CMasternodePaymentDB()
+uint32_t CMasternodePayeeIds::GetId(const std::vector<unsigned char>& payee)
 {
-    pathDB = GetDataDir() / "mnpayments.dat";
-    strMagicMessage = "MasternodePayments";
+    LOCK(cs_ids);
+    auto it = mapIds.find(payee);
+    if (it != mapIds.end()) return it->second;
+    uint32_t nId;
+    if (!vFreeIds.empty()) {
+        nId = vFreeIds.back();
+        vFreeIds.pop_back();
+        vPayees[nId] = payee;
+    } else {
+        nId = vPayees.size();
+        vPayees.push_back(payee);
+    }
+    mapIds.emplace(payee, nId);
+    return nId;
 }
 
-bool CMasternodePaymentDB::Write(const CMasternodePayments& objToSave)
+bool CMasternodePayeeIds::FindId(const std::vector<unsigned char>& payee, uint32_t& nId) const
 {
-    int64_t nStart = GetTimeMillis();
-
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-    ssObj << strMagicMessage;                   // masternode cache file specific magic message
-    ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssObj << objToSave;
-    uint256 hash = Hash(ssObj.begin(), ssObj.end());
-    ssObj << hash;
+    LOCK(cs_ids);
+    auto it = mapIds.find(payee);
+    if (it == mapIds.end()) return false;
+    nId = it->second;
+    return true;
+}
 
-    // open output file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathDB, "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathDB.string());
+std::vector<unsigned char> CMasternodePayeeIds::GetPayee(uint32_t nId) const
+{
+    LOCK(cs_ids);
+    if (nId >= vPayees.size()) return std::vector<unsigned char>();
+    return vPayees[nId];
+}
 
-    // Write and commit header, data
-    try {
-        fileout << ssObj;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
+void CMasternodePayeeIds::Retain(const std::set<uint32_t>& setUsed)
+{
+    LOCK(cs_ids);
+    auto it = mapIds.begin();
+    while (it != mapIds.end()) {
+        if (setUsed.count(it->second)) {
+            ++it;
+            continue;
+        }
+        std::vector<unsigned char>().swap(vPayees[it->second]);
+        vFreeIds.push_back(it->second);
+        it = mapIds.erase(it);
     }
-    fileout.fclose();
+}
 
-    LogPrint(BCLog::MASTERNODE, "Written info to mnpayments.dat  %dms\n", GetTimeMillis() - nStart);
+//
+// CMasternodeBlockPayeesWindow
+//
 
-    return true;
+void CMasternodeBlockPayeesWindow::TrimEmpty()
+{
+    while (!deqBlocks.empty() && deqBlocks.front().nBlockHeight == 0) {
+        deqBlocks.pop_front();
+        nFirstHeight++;
+    }
+    while (!deqBlocks.empty() && deqBlocks.back().nBlockHeight == 0)
+        deqBlocks.pop_back();
 }
 
-CMasternodePaymentDB::ReadResult CMasternodePaymentDB::Read(CMasternodePayments& objToLoad, bool fDryRun)
+CMasternodeBlockPayees* CMasternodeBlockPayeesWindow::Find(int nHeight)
 {
-    int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathDB, "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathDB.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = fs::file_size(pathDB);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    std::vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssObj(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssObj.begin(), ssObj.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
-
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
-    try {
-        // de-serialize file header (masternode cache file specific magic message) and ..
-        ssObj >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid masternode payement cache magic message", __func__);
-            return IncorrectMagicMessage;
+    if (deqBlocks.empty() || nHeight < nFirstHeight || nHeight > GetNewestHeight()) return NULL;
+    CMasternodeBlockPayees& block = deqBlocks[nHeight - nFirstHeight];
+    return block.nBlockHeight == 0 ? NULL : &block;
+}
+
+CMasternodeBlockPayees* CMasternodeBlockPayeesWindow::Insert(int nHeight)
+{
+    if (nHeight <= 0) return NULL;
+    if (deqBlocks.empty()) {
+        nFirstHeight = nHeight;
+        deqBlocks.emplace_back();
+    } else if (nHeight < nFirstHeight) {
+        // Older heights are not worth dropping newer tallies for
+        if (GetNewestHeight() - nHeight >= MNPAYMENTS_MAX_BLOCK_WINDOW) return NULL;
+        deqBlocks.insert(deqBlocks.begin(), nFirstHeight - nHeight, CMasternodeBlockPayees());
+        nFirstHeight = nHeight;
+    } else if (nHeight > GetNewestHeight()) {
+        if (nHeight - nFirstHeight >= MNPAYMENTS_MAX_BLOCK_WINDOW)
+            EraseBelow(nHeight - MNPAYMENTS_MAX_BLOCK_WINDOW + 1);
+        if (deqBlocks.empty()) {
+            nFirstHeight = nHeight;
+            deqBlocks.emplace_back();
+        } else {
+            deqBlocks.resize(nHeight - nFirstHeight + 1);
         }
+    }
 
+    CMasternodeBlockPayees& block = deqBlocks[nHeight - nFirstHeight];
+    if (block.nBlockHeight == 0) {
+        block.nBlockHeight = nHeight;
+        nBlocks++;
+    }
+    return &block;
+}
 
-        // de-serialize file header (network specific magic number) and ..
-        ssObj >> FLATDATA(pchMsgTmp);
+void CMasternodeBlockPayeesWindow::EraseBelow(int nHeight)
+{
+    while (!deqBlocks.empty() && nFirstHeight < nHeight) {
+        if (deqBlocks.front().nBlockHeight != 0) nBlocks--;
+        deqBlocks.pop_front();
+        nFirstHeight++;
+    }
+    TrimEmpty();
+}
 
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
+void CMasternodeBlockPayeesWindow::Clear()
+{
+    deqBlocks.clear();
+    nFirstHeight = 0;
+    nBlocks = 0;
+}
+
+std::set<uint32_t> CMasternodeBlockPayeesWindow::GetPayeeIds() const
+{
+    LOCK(cs_vecPayments);
+    std::set<uint32_t> setIds;
+    for (const CMasternodeBlockPayees& block : deqBlocks) {
+        for (const CMasternodePayee& payee : block.vecPayments)
+            setIds.insert(payee.nPayeeId);
+    }
+    return setIds;
+}
+
+std::map<int, CMasternodeBlockPayees> CMasternodeBlockPayeesWindow::ToMap() const
+{
+    std::map<int, CMasternodeBlockPayees> mapBlocks;
+    for (const CMasternodeBlockPayees& block : deqBlocks) {
+        if (block.nBlockHeight != 0)
+            mapBlocks.emplace(block.nBlockHeight, block);
+    }
+    return mapBlocks;
+}
 
-        // de-serialize data into CMasternodePayments object
-        ssObj >> objToLoad;
-    } catch (const std::exception& e) {
-        objToLoad.Clear();
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return IncorrectFormat;
+void CMasternodeBlockPayeesWindow::FromMap(const std::map<int, CMasternodeBlockPayees>& mapBlocks)
+{
+    Clear();
+    for (const auto& item : mapBlocks) {
+        CMasternodeBlockPayees* pblock = Insert(item.first);
+        if (pblock == NULL) continue;
+        pblock->vecPayments = item.second.vecPayments;
     }
+}
+
+//
+// CMasternodePaymentDB
+//
+
+CMasternodePaymentDB::CMasternodePaymentDB() : CFlatDB("mnpayments.dat", "MasternodePayments")
+{
+}
+
+bool CMasternodePaymentDB::Write(const CMasternodePayments& objToSave)
+{
+    int64_t nStart = GetTimeMillis();
+
+    if (!WriteObject(objToSave))
+        return false;
+
+    LogPrint(BCLog::MASTERNODE, "Written info to mnpayments.dat  %dms\n", GetTimeMillis() - nStart);
+
+    return true;
+}
+
+CMasternodePaymentDB::ReadResult CMasternodePaymentDB::Read(CMasternodePayments& objToLoad, bool fDryRun)
+{
+    int64_t nStart = GetTimeMillis();
+    ReadResult result = ReadObject(objToLoad, fDryRun);
+    if (result != Ok || fDryRun)
+        return result;
 
     LogPrint(BCLog::MASTERNODE, "Loaded info from mnpayments.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint(BCLog::MASTERNODE, "  %s\n", objToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint(BCLog::MASTERNODE, "Masternode payments manager - cleaning....\n");
-        objToLoad.CleanPaymentList();
-        LogPrint(BCLog::MASTERNODE, "Masternode payments manager - result:\n");
-        LogPrint(BCLog::MASTERNODE, "  %s\n", objToLoad.ToString());
-    }
+    LogPrint(BCLog::MASTERNODE, "Masternode payments manager - cleaning....\n");
+    objToLoad.CleanPaymentList();
+    LogPrint(BCLog::MASTERNODE, "Masternode payments manager - result:\n");
+    LogPrint(BCLog::MASTERNODE, "  %s\n", objToLoad.ToString());
 
     return Ok;
 }
@@ -334,7 +402,7 @@ void CMasternodePayments::ProcessMessageMasternodePayments(CNode* pfrom, std::st
             nHeight = chainActive.Tip()->nHeight;
         }
 
-        if (masternodePayments.mapMasternodePayeeVotes.count(winner.GetHash())) {
+        if (masternodePayments.HasPayeeVote(winner.GetHash())) {
             LogPrint(BCLog::MASTERNODE, "mnw - Already seen - %s bestHeight %d\n", winner.GetHash().ToString().c_str(), nHeight);
             masternodeSync.AddedMasternodeWinner(winner.GetHash());
             return;
@@ -378,9 +446,7 @@ bool CMasternodePaymentWinner::Sign(CKey& keyMasternode, CPubKey& pubKeyMasterno
     std::string strError = "";
     std::string strMasterNodeSignMessage;
 
-    std::string payeeString(payee.begin(), payee.end());
-    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vinMasternode.prevout.GetHash() << nBlockHeight << payee;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     if (!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
         LogPrint(BCLog::MASTERNODE,"%s - SignMessage Error.%s\n", __func__);
@@ -397,13 +463,30 @@ bool CMasternodePaymentWinner::Sign(CKey& keyMasternode, CPubKey& pubKeyMasterno
 
 bool CMasternodePayments::GetBlockPayee(int nBlockHeight, std::vector<unsigned char>& payee)
 {
-    if (mapMasternodeBlocks.count(nBlockHeight)) {
-        return mapMasternodeBlocks[nBlockHeight].GetPayee(payee);
+    LOCK(cs_mapMasternodeBlocks);
+
+    CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Find(nBlockHeight);
+    if (pblockPayees) {
+        return pblockPayees->GetPayee(payee);
     }
 
     return false;
 }
 
+bool CMasternodePayments::HasPayeeVote(const uint256& hash)
+{
+    LOCK(cs_mapMasternodePayeeVotes);
+    return mapMasternodePayeeVotes.count(hash) || mapPrunedPayeeVotes.count(hash);
+}
+
+bool CMasternodePayments::HasPayeeWithVotes(int nBlockHeight, uint32_t nPayeeId, int nVotesReq)
+{
+    LOCK(cs_mapMasternodeBlocks);
+
+    CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Find(nBlockHeight);
+    return pblockPayees && pblockPayees->HasPayeeWithVotes(nPayeeId, nVotesReq);
+}
+
 // Is this masternode scheduled to get paid soon?
 // -- Only look ahead up to 8 blocks to allow for propagation of the latest 2 winners
 bool CMasternodePayments::IsScheduled(CMasternode& mn, int nNotBlockHeight)
@@ -417,15 +500,17 @@ bool CMasternodePayments::IsScheduled(CMasternode& mn, int nNotBlockHeight)
         nHeight = chainActive.Tip()->nHeight;
     }
 
-    std::vector<unsigned char> mnpayee;
-    mnpayee = mn.vin.masternodeStealthAddress;
+    // a payee without an id has never been voted for
+    uint32_t nMnPayeeId;
+    if (!masternodePayeeIds.FindId(mn.vin.masternodeStealthAddress, nMnPayeeId)) return false;
 
-    std::vector<unsigned char> payee;
+    uint32_t nPayeeId;
     for (int64_t h = nHeight; h <= nHeight + 8; h++) {
         if (h == nNotBlockHeight) continue;
-        if (mapMasternodeBlocks.count(h)) {
-            if (mapMasternodeBlocks[h].GetPayee(payee)) {
-                if (mnpayee == payee) {
+        CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Find(h);
+        if (pblockPayees) {
+            if (pblockPayees->GetPayeeId(nPayeeId)) {
+                if (nMnPayeeId == nPayeeId) {
                     return true;
                 }
             }
@@ -442,22 +527,19 @@ bool CMasternodePayments::AddWinningMasternode(CMasternodePaymentWinner& winnerI
         return false;
     }
 
-    {
-        LOCK2(cs_mapMasternodePayeeVotes, cs_mapMasternodeBlocks);
-
-        if (mapMasternodePayeeVotes.count(winnerIn.GetHash())) {
-            return false;
-        }
+    LOCK2(cs_mapMasternodePayeeVotes, cs_mapMasternodeBlocks);
 
-        mapMasternodePayeeVotes[winnerIn.GetHash()] = winnerIn;
+    if (mapMasternodePayeeVotes.count(winnerIn.GetHash()) || mapPrunedPayeeVotes.count(winnerIn.GetHash())) {
+        return false;
+    }
 
-        if (!mapMasternodeBlocks.count(winnerIn.nBlockHeight)) {
-            CMasternodeBlockPayees blockPayees(winnerIn.nBlockHeight);
-            mapMasternodeBlocks[winnerIn.nBlockHeight] = blockPayees;
-        }
+    CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Insert(winnerIn.nBlockHeight);
+    if (pblockPayees == NULL) {
+        return false;
     }
 
-    mapMasternodeBlocks[winnerIn.nBlockHeight].AddPayee(1, winnerIn.vinMasternode.masternodeStealthAddress);
+    mapMasternodePayeeVotes[winnerIn.GetHash()] = winnerIn;
+    pblockPayees->AddPayee(1, masternodePayeeIds.GetId(winnerIn.vinMasternode.masternodeStealthAddress));
 
     return true;
 }
@@ -483,9 +565,10 @@ bool CMasternodeBlockPayees::IsTransactionValid(const CTransaction& txNew)
     if (nMaxSignatures < MNPAYMENTS_SIGNATURES_REQUIRED) return true;
 
     for (CMasternodePayee& payee : vecPayments) {
+        std::vector<unsigned char> masternodeStealthAddress = masternodePayeeIds.GetPayee(payee.nPayeeId);
         bool found = false;
         for (CTxOut out : txNew.vout) {
-            if (payee.masternodeStealthAddress == out.masternodeStealthAddress) {
+            if (masternodeStealthAddress == out.masternodeStealthAddress) {
                 if (out.nValue >= requiredMasternodePayment)
                     found = true;
                 else
@@ -496,7 +579,7 @@ bool CMasternodeBlockPayees::IsTransactionValid(const CTransaction& txNew)
         if (payee.nVotes >= MNPAYMENTS_SIGNATURES_REQUIRED) {
             if (found) return true;
 
-            std::string address2(payee.masternodeStealthAddress.begin(), payee.masternodeStealthAddress.end());
+            std::string address2(masternodeStealthAddress.begin(), masternodeStealthAddress.end());
 
             if (strPayeesPossible == "") {
                 strPayeesPossible += address2;
@@ -517,7 +600,8 @@ std::string CMasternodeBlockPayees::GetRequiredPaymentsString()
 
     for (CMasternodePayee& payee : vecPayments) {
         //CTxDestination address1;
-        std::string paymentAddress(payee.masternodeStealthAddress.begin(), payee.masternodeStealthAddress.end());
+        std::vector<unsigned char> masternodeStealthAddress = masternodePayeeIds.GetPayee(payee.nPayeeId);
+        std::string paymentAddress(masternodeStealthAddress.begin(), masternodeStealthAddress.end());
 
         if (ret != "Unknown") {
             ret += ", " + paymentAddress + ":" + std::to_string(payee.nVotes);
@@ -533,8 +617,9 @@ std::string CMasternodePayments::GetRequiredPaymentsString(int nBlockHeight)
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if (mapMasternodeBlocks.count(nBlockHeight)) {
-        return mapMasternodeBlocks[nBlockHeight].GetRequiredPaymentsString();
+    CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Find(nBlockHeight);
+    if (pblockPayees) {
+        return pblockPayees->GetRequiredPaymentsString();
     }
 
     return "Unknown";
@@ -544,8 +629,9 @@ bool CMasternodePayments::IsTransactionValid(const CTransaction& txNew, int nBlo
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    if (mapMasternodeBlocks.count(nBlockHeight)) {
-        return mapMasternodeBlocks[nBlockHeight].IsTransactionValid(txNew);
+    CMasternodeBlockPayees* pblockPayees = masternodeBlocks.Find(nBlockHeight);
+    if (pblockPayees) {
+        return pblockPayees->IsTransactionValid(txNew);
     }
 
     return true;
@@ -553,8 +639,6 @@ bool CMasternodePayments::IsTransactionValid(const CTransaction& txNew, int nBlo
 
 void CMasternodePayments::CleanPaymentList()
 {
-    LOCK2(cs_mapMasternodePayeeVotes, cs_mapMasternodeBlocks);
-
     int nHeight;
     {
         TRY_LOCK(cs_main, locked);
@@ -564,20 +648,39 @@ void CMasternodePayments::CleanPaymentList()
 
     //keep up to five cycles for historical sake
     int nLimit = std::max(int(mnodeman.size() * 1.25), 1000);
+    // peers do not accept votes older than this, so they are not relayed anymore
+    int nFirstRelayed = nHeight - (mnodeman.CountEnabled() * 1.25);
+
+    LOCK2(cs_mapMasternodePayeeVotes, cs_mapMasternodeBlocks);
 
     std::map<uint256, CMasternodePaymentWinner>::iterator it = mapMasternodePayeeVotes.begin();
     while (it != mapMasternodePayeeVotes.end()) {
-        CMasternodePaymentWinner winner = (*it).second;
+        const CMasternodePaymentWinner& winner = (*it).second;
 
-        if (nHeight - winner.nBlockHeight > nLimit) {
-            LogPrint(BCLog::MASTERNODE, "CMasternodePayments::CleanPaymentList - Removing old Masternode payment - block %d\n", winner.nBlockHeight);
+        if (winner.nBlockHeight < nFirstRelayed) {
             masternodeSync.mapSeenSyncMNW.erase((*it).first);
+            if (nHeight - winner.nBlockHeight <= nLimit)
+                mapPrunedPayeeVotes.emplace((*it).first, winner.nBlockHeight);
             mapMasternodePayeeVotes.erase(it++);
-            mapMasternodeBlocks.erase(winner.nBlockHeight);
         } else {
             ++it;
         }
     }
+
+    std::map<uint256, int>::iterator itPruned = mapPrunedPayeeVotes.begin();
+    while (itPruned != mapPrunedPayeeVotes.end()) {
+        if (nHeight - (*itPruned).second > nLimit) {
+            mapPrunedPayeeVotes.erase(itPruned++);
+        } else {
+            ++itPruned;
+        }
+    }
+
+    if (masternodeBlocks.size() && masternodeBlocks.GetOldestHeight() < nHeight - nLimit) {
+        LogPrint(BCLog::MASTERNODE, "CMasternodePayments::CleanPaymentList - Removing old Masternode payments below block %d\n", nHeight - nLimit);
+        masternodeBlocks.EraseBelow(nHeight - nLimit);
+        masternodePayeeIds.Retain(masternodeBlocks.GetPayeeIds());
+    }
 }
 
 bool CMasternodePaymentWinner::IsValid(CNode* pnode, std::string& strError)
@@ -685,13 +788,18 @@ void CMasternodePaymentWinner::Relay()
     RelayInv(inv);
 }
 
+std::string CMasternodePaymentWinner::GetStrMessage() const
+{
+    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vinMasternode.prevout.GetHash() << nBlockHeight << payee;
+    return HEX_STR(ser);
+}
+
 bool CMasternodePaymentWinner::SignatureValid()
 {
     CMasternode* pmn = mnodeman.Find(vinMasternode);
 
     if (pmn != NULL) {
-        HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vinMasternode.prevout.GetHash() << nBlockHeight << payee;
-        std::string strMessage = HEX_STR(ser);
+        std::string strMessage = GetStrMessage();
 
         std::string strError = "";
         if (!CMessageSigner::VerifyMessage(pmn->pubKeyMasternode, vchSig, strMessage, strError)) {
@@ -733,9 +841,11 @@ void CMasternodePayments::Sync(CNode* node, int nCountNeeded)
 
 std::string CMasternodePayments::ToString() const
 {
+    LOCK2(cs_mapMasternodePayeeVotes, cs_mapMasternodeBlocks);
+
     std::ostringstream info;
 
-    info << "Votes: " << (int)mapMasternodePayeeVotes.size() << ", Blocks: " << (int)mapMasternodeBlocks.size();
+    info << "Votes: " << (int)mapMasternodePayeeVotes.size() << ", Pruned votes: " << (int)mapPrunedPayeeVotes.size() << ", Blocks: " << (int)masternodeBlocks.size();
 
     return info.str();
 }
@@ -745,17 +855,9 @@ int CMasternodePayments::GetOldestBlock()
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    int nOldestBlock = std::numeric_limits<int>::max();
+    if (masternodeBlocks.size() == 0) return std::numeric_limits<int>::max();
 
-    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.begin();
-    while (it != mapMasternodeBlocks.end()) {
-        if ((*it).first < nOldestBlock) {
-            nOldestBlock = (*it).first;
-        }
-        it++;
-    }
-
-    return nOldestBlock;
+    return masternodeBlocks.GetOldestHeight();
 }
 
 
@@ -763,15 +865,5 @@ int CMasternodePayments::GetNewestBlock()
 {
     LOCK(cs_mapMasternodeBlocks);
 
-    int nNewestBlock = 0;
-
-    std::map<int, CMasternodeBlockPayees>::iterator it = mapMasternodeBlocks.begin();
-    while (it != mapMasternodeBlocks.end()) {
-        if ((*it).first > nNewestBlock) {
-            nNewestBlock = (*it).first;
-        }
-        it++;
-    }
-
-    return nNewestBlock;
+    return masternodeBlocks.GetNewestHeight();
 }
@@ -7,10 +7,14 @@
 #ifndef MASTERNODE_PAYMENTS_H
 #define MASTERNODE_PAYMENTS_H
 
+#include "flat-database.h"
 #include "key.h"
 #include "main.h"
 #include "masternode.h"
 
+#include <deque>
+#include <set>
+
 
 extern RecursiveMutex cs_vecPayments;
 extern RecursiveMutex cs_mapMasternodeBlocks;
@@ -25,6 +29,9 @@ extern CMasternodePayments masternodePayments;
 #define MNPAYMENTS_SIGNATURES_REQUIRED 6
 #define MNPAYMENTS_SIGNATURES_TOTAL 10
 
+/** Maximum number of consecutive heights payee tallies are kept for */
+static const int MNPAYMENTS_MAX_BLOCK_WINDOW = 100000;
+
 void ProcessMessageMasternodePayments(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
 bool IsBlockPayeeValid(const CBlock& block, int nBlockHeight);
 std::string GetRequiredPaymentsString(int nBlockHeight);
@@ -35,43 +42,56 @@ void DumpMasternodePayments();
 
 /** Save Masternode Payment Data (mnpayments.dat)
  */
-class CMasternodePaymentDB
+class CMasternodePaymentDB : public CFlatDB
 {
-private:
-    fs::path pathDB;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CMasternodePaymentDB();
     bool Write(const CMasternodePayments& objToSave);
     ReadResult Read(CMasternodePayments& objToLoad, bool fDryRun = false);
 };
 
+/**
+ * Interned masternode payee addresses. Block tallies refer to payees by the
+ * small id assigned here instead of holding a copy of the stealth address.
+ * CleanPaymentList frees the ids no tally refers to anymore and they are
+ * handed out again, so ids are only stable while cs_mapMasternodeBlocks is held.
+ */
+class CMasternodePayeeIds
+{
+private:
+    mutable Mutex cs_ids;
+    std::map<std::vector<unsigned char>, uint32_t> mapIds;
+    std::vector<std::vector<unsigned char> > vPayees;
+    std::vector<uint32_t> vFreeIds;
+
+public:
+    /// Get the id of payee, assigning a new one if it has none yet
+    uint32_t GetId(const std::vector<unsigned char>& payee);
+    /// Get the id of payee without assigning one
+    bool FindId(const std::vector<unsigned char>& payee, uint32_t& nId) const;
+    std::vector<unsigned char> GetPayee(uint32_t nId) const;
+    /// Free every id not in setUsed
+    void Retain(const std::set<uint32_t>& setUsed);
+};
+
+extern CMasternodePayeeIds masternodePayeeIds;
+
 class CMasternodePayee
 {
 public:
     int nVotes;
-    std::vector<unsigned char> masternodeStealthAddress;
+    uint32_t nPayeeId;
 
     CMasternodePayee()
     {
         nVotes = 0;
+        nPayeeId = 0;
     }
 
-    CMasternodePayee(int nVotesIn, std::vector<unsigned char> masternodeStealthAddress)
+    CMasternodePayee(int nVotesIn, uint32_t nPayeeIdIn)
     {
         nVotes = nVotesIn;
-        this->masternodeStealthAddress = masternodeStealthAddress;
+        nPayeeId = nPayeeIdIn;
     }
 
     ADD_SERIALIZE_METHODS;
@@ -80,7 +100,15 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
     {
         READWRITE(nVotes);
-        READWRITE(masternodeStealthAddress);
+        // The payee is stored by its stealth address
+        if (ser_action.ForRead()) {
+            std::vector<unsigned char> masternodeStealthAddress;
+            READWRITE(masternodeStealthAddress);
+            nPayeeId = masternodePayeeIds.GetId(masternodeStealthAddress);
+        } else {
+            std::vector<unsigned char> masternodeStealthAddress = masternodePayeeIds.GetPayee(nPayeeId);
+            READWRITE(masternodeStealthAddress);
+        }
     }
 };
 
@@ -102,29 +130,29 @@ public:
         vecPayments.clear();
     }
 
-    void AddPayee(int nIncrement, std::vector<unsigned char> masternodeStealthAddress)
+    void AddPayee(int nIncrement, uint32_t nPayeeId)
     {
         LOCK(cs_vecPayments);
 
         for (CMasternodePayee& payee : vecPayments) {
-            if (payee.masternodeStealthAddress == masternodeStealthAddress) {
+            if (payee.nPayeeId == nPayeeId) {
                 payee.nVotes += nIncrement;
                 return;
             }
         }
 
-        CMasternodePayee c(nIncrement, masternodeStealthAddress);
+        CMasternodePayee c(nIncrement, nPayeeId);
         vecPayments.push_back(c);
     }
 
-    bool GetPayee(std::vector<unsigned char>& payee)
+    bool GetPayeeId(uint32_t& nPayeeId)
     {
         LOCK(cs_vecPayments);
 
         int nVotes = -1;
         for (CMasternodePayee& p : vecPayments) {
             if (p.nVotes > nVotes) {
-                payee = p.masternodeStealthAddress;
+                nPayeeId = p.nPayeeId;
                 nVotes = p.nVotes;
             }
         }
@@ -132,12 +160,20 @@ public:
         return (nVotes > -1);
     }
 
-    bool HasPayeeWithVotes(std::vector<unsigned char> payee, int nVotesReq)
+    bool GetPayee(std::vector<unsigned char>& payee)
+    {
+        uint32_t nPayeeId;
+        if (!GetPayeeId(nPayeeId)) return false;
+        payee = masternodePayeeIds.GetPayee(nPayeeId);
+        return true;
+    }
+
+    bool HasPayeeWithVotes(uint32_t nPayeeId, int nVotesReq)
     {
         LOCK(cs_vecPayments);
 
         for (CMasternodePayee& p : vecPayments) {
-            if (p.nVotes >= nVotesReq && p.masternodeStealthAddress == payee) return true;
+            if (p.nVotes >= nVotesReq && p.nPayeeId == nPayeeId) return true;
         }
 
         return false;
@@ -156,6 +192,42 @@ public:
     }
 };
 
+/**
+ * Payee tallies of a window of consecutive block heights, so the tally of a
+ * height is found by its offset from the oldest one. Heights nobody voted on
+ * hold an entry with nBlockHeight 0; the oldest and newest entries are never
+ * empty.
+ */
+class CMasternodeBlockPayeesWindow
+{
+private:
+    int nFirstHeight;
+    std::deque<CMasternodeBlockPayees> deqBlocks;
+    size_t nBlocks;
+
+    void TrimEmpty();
+
+public:
+    CMasternodeBlockPayeesWindow() : nFirstHeight(0), nBlocks(0) {}
+
+    /// Get the tally of nHeight, or NULL if nobody voted on it
+    CMasternodeBlockPayees* Find(int nHeight);
+    /// Get the tally of nHeight, adding it if needed; NULL if the window cannot hold it
+    CMasternodeBlockPayees* Insert(int nHeight);
+    /// Remove the tallies of heights below nHeight
+    void EraseBelow(int nHeight);
+    void Clear();
+    /// Get the ids of all payees with a tally
+    std::set<uint32_t> GetPayeeIds() const;
+
+    size_t size() const { return nBlocks; }
+    int GetOldestHeight() const { return deqBlocks.empty() ? 0 : nFirstHeight; }
+    int GetNewestHeight() const { return deqBlocks.empty() ? 0 : nFirstHeight + (int)deqBlocks.size() - 1; }
+
+    std::map<int, CMasternodeBlockPayees> ToMap() const;
+    void FromMap(const std::map<int, CMasternodeBlockPayees>& mapBlocks);
+};
+
 // for storing the winning payments
 class CMasternodePaymentWinner
 {
@@ -194,6 +266,8 @@ public:
     bool SignatureValid();
     void Relay();
 
+    std::string GetStrMessage() const;
+
     void AddPayee(std::vector<unsigned char> payeeIn)
     {
         payee = payeeIn;
@@ -235,8 +309,11 @@ private:
     int nLastBlockHeight;
 
 public:
+    // votes that may still be relayed, with their signatures
     std::map<uint256, CMasternodePaymentWinner> mapMasternodePayeeVotes;
-    std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
+    // older votes, only kept by height to recognize them until their tallies are removed
+    std::map<uint256, int> mapPrunedPayeeVotes;
+    CMasternodeBlockPayeesWindow masternodeBlocks;
     std::map<uint256, int> mapMasternodesLastVote; //prevout.hash + prevout.n, nBlockHeight
 
     CMasternodePayments()
@@ -248,10 +325,15 @@ public:
     void Clear()
     {
         LOCK2(cs_mapMasternodeBlocks, cs_mapMasternodePayeeVotes);
-        mapMasternodeBlocks.clear();
+        masternodeBlocks.Clear();
         mapMasternodePayeeVotes.clear();
+        mapPrunedPayeeVotes.clear();
     }
 
+    /// Whether the vote hash was seen, whether or not it is still relayed
+    bool HasPayeeVote(const uint256& hash);
+    bool HasPayeeWithVotes(int nBlockHeight, uint32_t nPayeeId, int nVotesReq);
+
     bool AddWinningMasternode(CMasternodePaymentWinner& winner);
     bool ProcessBlock(int nBlockHeight);
 
@@ -292,7 +374,15 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
     {
         READWRITE(mapMasternodePayeeVotes);
-        READWRITE(mapMasternodeBlocks);
+        // Tallies are stored as a map by height
+        if (ser_action.ForRead()) {
+            std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks;
+            READWRITE(mapMasternodeBlocks);
+            masternodeBlocks.FromMap(mapMasternodeBlocks);
+        } else {
+            std::map<int, CMasternodeBlockPayees> mapMasternodeBlocks = masternodeBlocks.ToMap();
+            READWRITE(mapMasternodeBlocks);
+        }
     }
 };
 
@@ -0,0 +1,116 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "masternode-preverify.h"
+
+#include "masternode.h"
+#include "masternode-budget.h"
+#include "masternode-payments.h"
+#include "messagesigner.h"
+#include "protocol.h"
+#include "streams.h"
+#include "swifttx.h"
+#include "util.h"
+
+#include <atomic>
+#include <deque>
+
+#include <boost/thread.hpp>
+
+namespace {
+class CMasternodePreVerifyQueue
+{
+private:
+    boost::mutex mutex;
+    boost::condition_variable cond;
+    std::deque<std::pair<std::string, CDataStream> > queue;
+
+public:
+    std::atomic<int> nThreads;
+
+    CMasternodePreVerifyQueue() : nThreads(0) {}
+
+    void Push(const std::string& strCommand, const CDataStream& vRecv)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        if (queue.size() >= MAX_MASTERNODE_PREVERIFY_QUEUE_SIZE) return;
+        queue.emplace_back(strCommand, vRecv);
+        cond.notify_one();
+    }
+
+    std::pair<std::string, CDataStream> Pop()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (queue.empty())
+            cond.wait(lock);
+        std::pair<std::string, CDataStream> message = std::move(queue.front());
+        queue.pop_front();
+        return message;
+    }
+};
+
+static CMasternodePreVerifyQueue preVerifyQueue;
+
+bool IsPreVerified(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::MNBROADCAST || strCommand == NetMsgType::MNPING ||
+           strCommand == NetMsgType::MNWINNER || strCommand == NetMsgType::BUDGETVOTE ||
+           strCommand == NetMsgType::FINALBUDGETVOTE || strCommand == NetMsgType::IXLOCKVOTE;
+}
+
+void PreVerify(const std::string& strCommand, CDataStream& vRecv)
+{
+    if (strCommand == NetMsgType::MNBROADCAST) {
+        CMasternodeBroadcast mnb;
+        vRecv >> mnb;
+        CMessageSigner::PreVerifyMessage(mnb.sig, mnb.GetStrMessage());
+        CMessageSigner::PreVerifyMessage(mnb.lastPing.vchSig, mnb.lastPing.GetStrMessage());
+    } else if (strCommand == NetMsgType::MNPING) {
+        CMasternodePing mnp;
+        vRecv >> mnp;
+        CMessageSigner::PreVerifyMessage(mnp.vchSig, mnp.GetStrMessage());
+    } else if (strCommand == NetMsgType::MNWINNER) {
+        CMasternodePaymentWinner winner;
+        vRecv >> winner;
+        CMessageSigner::PreVerifyMessage(winner.vchSig, winner.GetStrMessage());
+    } else if (strCommand == NetMsgType::BUDGETVOTE) {
+        CBudgetVote vote;
+        vRecv >> vote;
+        CMessageSigner::PreVerifyMessage(vote.vchSig, vote.GetStrMessage());
+    } else if (strCommand == NetMsgType::FINALBUDGETVOTE) {
+        CFinalizedBudgetVote vote;
+        vRecv >> vote;
+        CMessageSigner::PreVerifyMessage(vote.vchSig, vote.GetStrMessage());
+    } else if (strCommand == NetMsgType::IXLOCKVOTE) {
+        CConsensusVote vote;
+        vRecv >> vote;
+        CMessageSigner::PreVerifyMessage(vote.vchMasterNodeSignature, vote.GetStrMessage());
+    }
+}
+}
+
+void PreVerifyMasternodeMessage(const std::string& strCommand, const CDataStream& vRecv)
+{
+    if (preVerifyQueue.nThreads == 0 || !IsPreVerified(strCommand)) return;
+    preVerifyQueue.Push(strCommand, vRecv);
+}
+
+void ThreadMasternodePreVerify()
+{
+    util::ThreadRename("prcycoin-mnverify");
+    preVerifyQueue.nThreads++;
+    try {
+        while (true) {
+            std::pair<std::string, CDataStream> message = preVerifyQueue.Pop();
+            try {
+                PreVerify(message.first, message.second);
+            } catch (const std::exception&) {
+                // Malformed messages are reported by the message handler
+            }
+        }
+    } catch (const boost::thread_interrupted&) {
+        preVerifyQueue.nThreads--;
+        throw;
+    }
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PRCYCOIN_MASTERNODE_PREVERIFY_H
+#define PRCYCOIN_MASTERNODE_PREVERIFY_H
+
+#include <string>
+
+class CDataStream;
+
+/** Maximum number of masternode messages waiting to be pre-verified */
+static const unsigned int MAX_MASTERNODE_PREVERIFY_QUEUE_SIZE = 10000;
+
+/**
+ * Masternode message pre-verification: while a masternode, payment, budget or
+ * SwiftX vote message waits in a peer's receive queue, a worker recovers the
+ * signers of its signatures into the message signature cache. Verifying it on
+ * the message handler thread, under cs_main or a manager lock, is then a cache
+ * lookup. Messages are dropped rather than queued once the queue is full.
+ */
+void PreVerifyMasternodeMessage(const std::string& strCommand, const CDataStream& vRecv);
+
+void ThreadMasternodePreVerify();
+
+#endif // PRCYCOIN_MASTERNODE_PREVERIFY_H
@@ -217,22 +217,21 @@ void CMasternode::Check(bool forceCheck)
     }
 
     if (!unitTest) {
-        {
+        // The masternode manager keeps listed collaterals current, only look up the others
+        CMasternodeCollateral collateral;
+        if (!mnodeman.GetCollateral(vin, collateral)) {
             TRY_LOCK(cs_main, lockMain);
             if (!lockMain) return;
-
-            CCoins coins;
-            if (!pcoinsTip->GetCoins(vin.prevout.hash, coins) ||
-               (unsigned int)vin.prevout.n>=coins.vout.size() ||
-               coins.vout[vin.prevout.n].IsNull()) {
-                nActiveState = MASTERNODE_OUTPOINT_SPENT;
-                LogPrint(BCLog::MASTERNODE, "CMasternode::Check -- Failed to find Masternode UTXO, masternode=%s\n", vin.prevout.ToStringShort());
-                return;
-            }
-            if (IsSpentKeyImage(vin.keyImage.GetHex(), UINT256_ZERO)) {
-                activeState = MASTERNODE_VIN_SPENT;
-                return;
-            }
+            collateral = CMasternodeMan::LookupCollateral(vin);
+        }
+        if (!collateral.fAvailable) {
+            nActiveState = MASTERNODE_OUTPOINT_SPENT;
+            LogPrint(BCLog::MASTERNODE, "CMasternode::Check -- Failed to find Masternode UTXO, masternode=%s\n", vin.prevout.ToStringShort());
+            return;
+        }
+        if (collateral.fSpent) {
+            activeState = MASTERNODE_VIN_SPENT;
+            return;
         }
     }
     activeState = MASTERNODE_ENABLED; // OK
@@ -261,8 +260,15 @@ int64_t CMasternode::GetLastPaid()
     CBlockIndex* pindexPrev = chainActive.Tip();
     if (pindexPrev == NULL) return false;
 
-    std::vector<unsigned char> mnpayee;
-    mnpayee = vin.masternodeStealthAddress;
+    // walk the masternode list before taking cs_mapMasternodeBlocks, not while holding it
+    int nMnCount = mnodeman.CountEnabled() * 1.25;
+
+    // keep the payee id from being freed and reassigned while the tallies are searched
+    LOCK(cs_mapMasternodeBlocks);
+
+    // a payee without an id has never been voted for
+    uint32_t nPayeeId;
+    if (!masternodePayeeIds.FindId(vin.masternodeStealthAddress, nPayeeId)) return 0;
 
     CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
     ss << vin;
@@ -276,7 +282,6 @@ int64_t CMasternode::GetLastPaid()
 
     const CBlockIndex* BlockReading = chainActive.Tip();
 
-    int nMnCount = mnodeman.CountEnabled() * 1.25;
     int n = 0;
     for (unsigned int i = 1; BlockReading && BlockReading->nHeight > 0; i++) {
         if (n >= nMnCount) {
@@ -284,14 +289,12 @@ int64_t CMasternode::GetLastPaid()
         }
         n++;
 
-        if (masternodePayments.mapMasternodeBlocks.count(BlockReading->nHeight)) {
-            /*
-                Search for this payee, with at least 2 votes. This will aid in consensus allowing the network
-                to converge on the same payees quickly, then keep the same schedule.
-            */
-            if (masternodePayments.mapMasternodeBlocks[BlockReading->nHeight].HasPayeeWithVotes(mnpayee, 2)) {
-                return BlockReading->nTime + nOffset;
-            }
+        /*
+            Search for this payee, with at least 2 votes. This will aid in consensus allowing the network
+            to converge on the same payees quickly, then keep the same schedule.
+        */
+        if (masternodePayments.HasPayeeWithVotes(BlockReading->nHeight, nPayeeId, 2)) {
+            return BlockReading->nTime + nOffset;
         }
 
         if (BlockReading->pprev == NULL) {
@@ -599,7 +602,7 @@ bool CMasternodeBroadcast::CheckAndUpdate(int& nDos)
     if (pmn->pubKeyCollateralAddress == pubKeyCollateralAddress && !pmn->IsBroadcastedWithin(MASTERNODE_MIN_MNB_SECONDS)) {
         //take the newest entry
         LogPrint(BCLog::MASTERNODE,"mnb - Got updated entry for %s\n", vin.prevout.hash.ToString());
-        if (pmn->UpdateFromNewBroadcast((*this))) {
+        if (mnodeman.UpdateFromNewBroadcast(*pmn, *this)) {
             pmn->Check();
             if (pmn->IsEnabled()) Relay();
         }
@@ -758,8 +761,7 @@ bool CMasternodePing::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
     std::string strMasterNodeSignMessage;
 
     sigTime = GetAdjustedTime();
-    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.ToString() << blockHash.ToString() << sigTime;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     if (!CMessageSigner::SignMessage(strMessage, vchSig, keyMasternode)) {
         LogPrint(BCLog::MASTERNODE,"%s : SignMessage() - Error.", __func__);
@@ -776,8 +778,7 @@ bool CMasternodePing::Sign(CKey& keyMasternode, CPubKey& pubKeyMasternode)
 
 bool CMasternodePing::VerifySignature(CPubKey& pubKeyMasternode, int &nDos) {
     std::string strError = "";
-    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.ToString() << blockHash.ToString() << sigTime;
-    std::string strMessage = HEX_STR(ser);
+    std::string strMessage = GetStrMessage();
 
     if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchSig, strMessage, strError)){
         nDos = 33;
@@ -786,6 +787,12 @@ bool CMasternodePing::VerifySignature(CPubKey& pubKeyMasternode, int &nDos) {
     return true;
 }
 
+std::string CMasternodePing::GetStrMessage() const
+{
+    HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.ToString() << blockHash.ToString() << sigTime;
+    return HEX_STR(ser);
+}
+
 bool CMasternodePing::CheckAndUpdate(int& nDos, bool fRequireEnabled, bool fCheckSigTimeOnly)
 {
     if (sigTime > GetAdjustedTime() + 60 * 60) {
@@ -817,8 +824,7 @@ bool CMasternodePing::CheckAndUpdate(int& nDos, bool fRequireEnabled, bool fChec
         // last ping was more then MASTERNODE_MIN_MNP_SECONDS-60 ago comparing to this one
         if (!pmn->IsPingedWithin(MASTERNODE_MIN_MNP_SECONDS - 60, sigTime)) {
 
-            HEX_DATA_STREAM_PROTOCOL(PROTOCOL_VERSION) << vin.ToString() << blockHash.ToString() << sigTime;
-            std::string strMessage = HEX_STR(ser);
+            std::string strMessage = GetStrMessage();
 
             std::string errorMessage = "";
             if (!CMessageSigner::VerifyMessage(pmn->pubKeyMasternode, vchSig, strMessage, errorMessage)) {
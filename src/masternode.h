@@ -64,6 +64,8 @@ public:
     bool VerifySignature(CPubKey& pubKeyMasternode, int &nDos);
     void Relay();
 
+    std::string GetStrMessage() const;
+
     uint256 GetHash()
     {
         CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
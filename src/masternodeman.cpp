@@ -16,6 +16,8 @@
 #include "swifttx.h"
 #include "util.h"
 
+#include <algorithm>
+
 #define MN_WINNER_MINIMUM_AGE 8000    // Age in seconds. This should be > MASTERNODE_REMOVAL_SECONDS to avoid misconfigured new nodes in the list.
 
 /** Masternode manager */
@@ -51,38 +53,16 @@ struct CompareScoreMN {
 // CMasternodeDB
 //
 
-CMasternodeDB::CMasternodeDB()
+CMasternodeDB::CMasternodeDB() : CFlatDB("mncache.dat", "MasternodeCache")
 {
-    pathMN = GetDataDir() / "mncache.dat";
-    strMagicMessage = "MasternodeCache";
 }
 
 bool CMasternodeDB::Write(const CMasternodeMan& mnodemanToSave)
 {
     int64_t nStart = GetTimeMillis();
 
-    // serialize, checksum data up to that point, then append checksum
-    CDataStream ssMasternodes(SER_DISK, CLIENT_VERSION);
-    ssMasternodes << strMagicMessage;                   // masternode cache file specific magic message
-    ssMasternodes << FLATDATA(Params().MessageStart()); // network specific magic number
-    ssMasternodes << mnodemanToSave;
-    uint256 hash = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    ssMasternodes << hash;
-
-    // open output file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathMN, "wb");
-    CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-    if (fileout.IsNull())
-        return error("%s : Failed to open file %s", __func__, pathMN.string());
-
-    // Write and commit header, data
-    try {
-        fileout << ssMasternodes;
-    } catch (const std::exception& e) {
-        return error("%s : Serialize or I/O error - %s", __func__, e.what());
-    }
-
-    fileout.fclose();
+    if (!WriteObject(mnodemanToSave))
+        return false;
 
     LogPrint(BCLog::MASTERNODE,"Written info to mncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint(BCLog::MASTERNODE,"  %s\n", mnodemanToSave.ToString());
@@ -93,80 +73,14 @@ bool CMasternodeDB::Write(const CMasternodeMan& mnodemanToSave)
 CMasternodeDB::ReadResult CMasternodeDB::Read(CMasternodeMan& mnodemanToLoad, bool fDryRun)
 {
     int64_t nStart = GetTimeMillis();
-    // open input file, and associate with CAutoFile
-    FILE* file = fsbridge::fopen(pathMN, "rb");
-    CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        error("%s : Failed to open file %s", __func__, pathMN.string());
-        return FileError;
-    }
-
-    // use file size to size memory buffer
-    int fileSize = fs::file_size(pathMN);
-    int dataSize = fileSize - sizeof(uint256);
-    // Don't try to resize to a negative number if file is small
-    if (dataSize < 0)
-        dataSize = 0;
-    std::vector<unsigned char> vchData;
-    vchData.resize(dataSize);
-    uint256 hashIn;
-
-    // read data and checksum from file
-    try {
-        filein.read((char*)&vchData[0], dataSize);
-        filein >> hashIn;
-    } catch (const std::exception& e) {
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return HashReadError;
-    }
-    filein.fclose();
-
-    CDataStream ssMasternodes(vchData, SER_DISK, CLIENT_VERSION);
-
-    // verify stored checksum matches input data
-    uint256 hashTmp = Hash(ssMasternodes.begin(), ssMasternodes.end());
-    if (hashIn != hashTmp) {
-        error("%s : Checksum mismatch, data corrupted", __func__);
-        return IncorrectHash;
-    }
-
-    unsigned char pchMsgTmp[4];
-    std::string strMagicMessageTmp;
-    try {
-        // de-serialize file header (masternode cache file specific magic message) and ..
-
-        ssMasternodes >> strMagicMessageTmp;
-
-        // ... verify the message matches predefined one
-        if (strMagicMessage != strMagicMessageTmp) {
-            error("%s : Invalid masternode cache magic message", __func__);
-            return IncorrectMagicMessage;
-        }
-
-        // de-serialize file header (network specific magic number) and ..
-        ssMasternodes >> FLATDATA(pchMsgTmp);
-
-        // ... verify the network matches ours
-        if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp))) {
-            error("%s : Invalid network magic number", __func__);
-            return IncorrectMagicNumber;
-        }
-        // de-serialize data into CMasternodeMan object
-        ssMasternodes >> mnodemanToLoad;
-    } catch (const std::exception& e) {
-        mnodemanToLoad.Clear();
-        error("%s : Deserialize or I/O error - %s", __func__, e.what());
-        return IncorrectFormat;
-    }
+    ReadResult result = ReadObject(mnodemanToLoad, fDryRun);
+    if (result != Ok || fDryRun)
+        return result;
 
     LogPrint(BCLog::MASTERNODE,"Loaded info from mncache.dat  %dms\n", GetTimeMillis() - nStart);
     LogPrint(BCLog::MASTERNODE,"  %s\n", mnodemanToLoad.ToString());
-    if (!fDryRun) {
-        LogPrint(BCLog::MASTERNODE,"Masternode manager - cleaning....\n");
-        mnodemanToLoad.CheckAndRemove(true);
-        LogPrint(BCLog::MASTERNODE,"Masternode manager - result:\n");
-        LogPrint(BCLog::MASTERNODE,"  %s\n", mnodemanToLoad.ToString());
-    }
+    // entries are checked and expired ones removed by the first pass of ThreadCheckMasternodes,
+    // which only runs against a synced chain
 
     return Ok;
 }
@@ -213,7 +127,8 @@ bool CMasternodeMan::Add(CMasternode& mn)
     CMasternode* pmn = Find(mn.vin);
     if (pmn == NULL) {
         LogPrint(BCLog::MASTERNODE, "CMasternodeMan: Adding new Masternode %s - %i now\n", mn.vin.prevout.hash.ToString(), size() + 1);
-        vMasternodes.push_back(mn);
+        listMasternodes.push_back(mn);
+        Index(listMasternodes.back());
         return true;
     }
 
@@ -240,13 +155,122 @@ void CMasternodeMan::AskForMN(CNode* pnode, CTxIn& vin)
 
 void CMasternodeMan::Check()
 {
+    WatchCollaterals();
+
     LOCK(cs);
 
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
     }
 }
 
+CMasternodeCollateral CMasternodeMan::LookupCollateral(const CTxIn& vin)
+{
+    AssertLockHeld(cs_main);
+
+    CMasternodeCollateral collateral;
+    collateral.keyImage = vin.keyImage;
+    CCoins coins;
+    collateral.fAvailable = pcoinsTip->GetCoins(vin.prevout.hash, coins) &&
+                            vin.prevout.n < coins.vout.size() &&
+                            !coins.vout[vin.prevout.n].IsNull();
+    collateral.fSpent = IsSpentKeyImage(vin.keyImage.GetHex(), UINT256_ZERO);
+    return collateral;
+}
+
+void CMasternodeMan::WatchCollaterals()
+{
+    std::vector<CTxIn> vNew;
+    {
+        LOCK2(cs, cs_collaterals);
+        for (const CMasternode& mn : listMasternodes) {
+            if (!mapCollaterals.count(mn.vin.prevout))
+                vNew.push_back(mn.vin);
+        }
+    }
+    if (vNew.empty()) return;
+
+    // Look the new collaterals up once; blocks update them from then on
+    TRY_LOCK(cs_main, lockMain);
+    if (!lockMain) return;
+    for (const CTxIn& vin : vNew) {
+        CMasternodeCollateral collateral = LookupCollateral(vin);
+        LOCK(cs_collaterals);
+        if (!mapCollaterals.emplace(vin.prevout, collateral).second) continue;
+        if (vin.keyImage.IsValid())
+            mapCollateralKeyImages[vin.keyImage] = vin.prevout;
+    }
+}
+
+void CMasternodeMan::UnwatchCollateral(const CTxIn& vin)
+{
+    LOCK(cs_collaterals);
+    auto it = mapCollaterals.find(vin.prevout);
+    if (it == mapCollaterals.end()) return;
+    mapCollateralKeyImages.erase(it->second.keyImage);
+    mapCollaterals.erase(it);
+}
+
+bool CMasternodeMan::GetCollateral(const CTxIn& vin, CMasternodeCollateral& collateral) const
+{
+    LOCK(cs_collaterals);
+    auto it = mapCollaterals.find(vin.prevout);
+    if (it == mapCollaterals.end()) return false;
+    collateral = it->second;
+    return true;
+}
+
+void CMasternodeMan::BlockConnected(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs_collaterals);
+    if (mapCollaterals.empty()) return;
+
+    for (const CTransaction& tx : block.vtx) {
+        for (const CTxIn& txin : tx.vin) {
+            auto itKeyImage = mapCollateralKeyImages.find(txin.keyImage);
+            if (itKeyImage != mapCollateralKeyImages.end())
+                mapCollaterals[itKeyImage->second].fSpent = true;
+            // Only coinstakes spend outputs from the UTXO set
+            if (tx.IsCoinStake()) {
+                auto it = mapCollaterals.find(txin.prevout);
+                if (it != mapCollaterals.end())
+                    it->second.fAvailable = false;
+            }
+        }
+        const uint256& txid = tx.GetHash();
+        for (auto it = mapCollaterals.lower_bound(COutPoint(txid, 0)); it != mapCollaterals.end() && it->first.hash == txid; ++it) {
+            if (it->first.n < tx.vout.size() && !tx.vout[it->first.n].IsNull())
+                it->second.fAvailable = true;
+        }
+    }
+}
+
+void CMasternodeMan::BlockDisconnected(const CBlock& block)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs_collaterals);
+    if (mapCollaterals.empty()) return;
+
+    for (auto itTx = block.vtx.rbegin(); itTx != block.vtx.rend(); ++itTx) {
+        const CTransaction& tx = *itTx;
+        const uint256& txid = tx.GetHash();
+        for (auto it = mapCollaterals.lower_bound(COutPoint(txid, 0)); it != mapCollaterals.end() && it->first.hash == txid; ++it)
+            it->second.fAvailable = false;
+        for (const CTxIn& txin : tx.vin) {
+            // A key image can only be spent once in a chain
+            auto itKeyImage = mapCollateralKeyImages.find(txin.keyImage);
+            if (itKeyImage != mapCollateralKeyImages.end())
+                mapCollaterals[itKeyImage->second].fSpent = false;
+            if (tx.IsCoinStake()) {
+                auto it = mapCollaterals.find(txin.prevout);
+                if (it != mapCollaterals.end())
+                    it->second.fAvailable = true;
+            }
+        }
+    }
+}
+
 void CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
 {
     Check();
@@ -254,8 +278,8 @@ void CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
     LOCK(cs);
 
     //remove inactive and outdated
-    std::vector<CMasternode>::iterator it = vMasternodes.begin();
-    while (it != vMasternodes.end()) {
+    std::list<CMasternode>::iterator it = listMasternodes.begin();
+    while (it != listMasternodes.end()) {
         if ((*it).activeState == CMasternode::MASTERNODE_REMOVE ||
             (*it).activeState == CMasternode::MASTERNODE_VIN_SPENT ||
             (forceExpiredRemoval && (*it).activeState == CMasternode::MASTERNODE_EXPIRED) ||
@@ -285,7 +309,9 @@ void CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
                 }
             }
 
-            it = vMasternodes.erase(it);
+            UnwatchCollateral((*it).vin);
+            Unindex(*it);
+            it = listMasternodes.erase(it);
         } else {
             ++it;
         }
@@ -345,8 +371,13 @@ void CMasternodeMan::CheckAndRemove(bool forceExpiredRemoval)
 
 void CMasternodeMan::Clear()
 {
-    LOCK(cs);
-    vMasternodes.clear();
+    LOCK2(cs, cs_collaterals);
+    listMasternodes.clear();
+    mapMasternodesByVin.clear();
+    mapMasternodesByPubKey.clear();
+    mapMasternodesByPayee.clear();
+    mapCollaterals.clear();
+    mapCollateralKeyImages.clear();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -362,7 +393,7 @@ int CMasternodeMan::stable_size ()
     int64_t nMasternode_Min_Age = MN_WINNER_MINIMUM_AGE;
     int64_t nMasternode_Age = 0;
 
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         if (mn.protocolVersion < nMinProtocol) {
             continue; // Skip obsolete versions
         }
@@ -381,7 +412,7 @@ int CMasternodeMan::CountEnabled(int protocolVersion)
     int i = 0;
     protocolVersion = protocolVersion == -1 ? masternodePayments.GetMinMasternodePaymentsProto() : protocolVersion;
 
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
         if (mn.protocolVersion < protocolVersion || !mn.IsEnabled()) continue;
         i++;
@@ -394,7 +425,7 @@ void CMasternodeMan::CountNetworks(int protocolVersion, int& ipv4, int& ipv6, in
 {
     protocolVersion = protocolVersion == -1 ? masternodePayments.GetMinMasternodePaymentsProto() : protocolVersion;
 
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
         std::string strHost;
         int port;
@@ -440,37 +471,74 @@ void CMasternodeMan::DsegUpdate(CNode* pnode)
 CMasternode* CMasternodeMan::Find(const CScript& payee)
 {
     LOCK(cs);
-    CScript payee2;
-
-    for (CMasternode& mn : vMasternodes) {
-        payee2 = GetScriptForDestination(mn.pubKeyCollateralAddress);
-        if (payee2 == payee)
-            return &mn;
-    }
-    return NULL;
+    auto it = mapMasternodesByPayee.find(payee);
+    if (it == mapMasternodesByPayee.end()) return NULL;
+    return it->second.front();
 }
 
 CMasternode* CMasternodeMan::Find(const CTxIn& vin)
 {
     LOCK(cs);
-
-    for (CMasternode& mn : vMasternodes) {
-        if (mn.vin.prevout == vin.prevout)
-            return &mn;
-    }
-    return NULL;
+    auto it = mapMasternodesByVin.find(vin.prevout);
+    if (it == mapMasternodesByVin.end()) return NULL;
+    return it->second;
 }
 
 
 CMasternode* CMasternodeMan::Find(const CPubKey& pubKeyMasternode)
 {
     LOCK(cs);
+    auto it = mapMasternodesByPubKey.find(pubKeyMasternode);
+    if (it == mapMasternodesByPubKey.end()) return NULL;
+    return it->second.front();
+}
 
-    for (CMasternode& mn : vMasternodes) {
-        if (mn.pubKeyMasternode == pubKeyMasternode)
-            return &mn;
-    }
-    return NULL;
+void CMasternodeMan::Index(CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    mapMasternodesByVin[mn.vin.prevout] = &mn;
+    mapMasternodesByPubKey[mn.pubKeyMasternode].push_back(&mn);
+    mapMasternodesByPayee[GetScriptForDestination(mn.pubKeyCollateralAddress)].push_back(&mn);
+}
+
+template <typename Map, typename Key>
+static void EraseIndexEntry(Map& map, const Key& key, const CMasternode* pmn)
+{
+    auto it = map.find(key);
+    if (it == map.end()) return;
+    std::vector<CMasternode*>& vpmn = it->second;
+    vpmn.erase(std::remove(vpmn.begin(), vpmn.end(), pmn), vpmn.end());
+    if (vpmn.empty()) map.erase(it);
+}
+
+void CMasternodeMan::Unindex(CMasternode& mn)
+{
+    AssertLockHeld(cs);
+    auto it = mapMasternodesByVin.find(mn.vin.prevout);
+    if (it != mapMasternodesByVin.end() && it->second == &mn)
+        mapMasternodesByVin.erase(it);
+    EraseIndexEntry(mapMasternodesByPubKey, mn.pubKeyMasternode, &mn);
+    EraseIndexEntry(mapMasternodesByPayee, GetScriptForDestination(mn.pubKeyCollateralAddress), &mn);
+}
+
+void CMasternodeMan::Reindex()
+{
+    AssertLockHeld(cs);
+    mapMasternodesByVin.clear();
+    mapMasternodesByPubKey.clear();
+    mapMasternodesByPayee.clear();
+    for (CMasternode& mn : listMasternodes)
+        Index(mn);
+}
+
+bool CMasternodeMan::UpdateFromNewBroadcast(CMasternode& mn, CMasternodeBroadcast& mnb)
+{
+    LOCK(cs);
+    // The keys may change, so take the entry out of the indexes while it is updated
+    Unindex(mn);
+    bool fUpdated = mn.UpdateFromNewBroadcast(mnb);
+    Index(mn);
+    return fUpdated;
 }
 
 //
@@ -488,7 +556,7 @@ CMasternode* CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight
     */
 
     int nMnCount = CountEnabled();
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
         if (!mn.IsEnabled()) continue;
 
@@ -543,7 +611,7 @@ CMasternode* CMasternodeMan::GetCurrentMasterNode(int mod, int64_t nBlockHeight,
     CMasternode* winner = NULL;
 
     // scan for winner
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
         if (mn.protocolVersion < minProtocol || !mn.IsEnabled()) continue;
 
@@ -572,7 +640,7 @@ int CMasternodeMan::GetMasternodeRank(const CTxIn& vin, int64_t nBlockHeight, in
     if (!GetBlockHash(hash, nBlockHeight)) return -1;
 
     // scan for winner
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         if (mn.protocolVersion < minProtocol) {
             LogPrint(BCLog::MASTERNODE,"Skipping Masternode with obsolete version %d\n", mn.protocolVersion);
             continue;                                                       // Skip obsolete versions
@@ -611,7 +679,7 @@ std::vector<std::pair<int, CMasternode> > CMasternodeMan::GetMasternodeRanks(int
     if (!GetBlockHash(hash, nBlockHeight)) return vecMasternodeRanks;
 
     // scan for winner
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         mn.Check();
 
         if (mn.protocolVersion < minProtocol) continue;
@@ -643,7 +711,7 @@ CMasternode* CMasternodeMan::GetMasternodeByRank(int nRank, int64_t nBlockHeight
     std::vector<std::pair<int64_t, CTxIn> > vecMasternodeScores;
 
     // scan for winner
-    for (CMasternode& mn : vMasternodes) {
+    for (CMasternode& mn : listMasternodes) {
         if (mn.protocolVersion < minProtocol) continue;
         if (fOnlyActive) {
             mn.Check();
@@ -773,7 +841,7 @@ void CMasternodeMan::ProcessMessage(CNode* pfrom, std::string& strCommand, CData
 
 
         int nInvCount = 0;
-        for (CMasternode& mn : vMasternodes) {
+        for (CMasternode& mn : listMasternodes) {
             if (mn.addr.IsRFC1918()) continue; //local network
 
             if (mn.IsEnabled()) {
@@ -805,11 +873,13 @@ void CMasternodeMan::Remove(CTxIn vin)
 {
     LOCK(cs);
 
-    std::vector<CMasternode>::iterator it = vMasternodes.begin();
-    while (it != vMasternodes.end()) {
+    std::list<CMasternode>::iterator it = listMasternodes.begin();
+    while (it != listMasternodes.end()) {
         if ((*it).vin == vin) {
             LogPrint(BCLog::MASTERNODE, "CMasternodeMan: Removing Masternode %s - %i now\n", (*it).vin.prevout.hash.ToString(), size() - 1);
-            vMasternodes.erase(it);
+            UnwatchCollateral((*it).vin);
+            Unindex(*it);
+            listMasternodes.erase(it);
             break;
         }
         ++it;
@@ -830,7 +900,7 @@ void CMasternodeMan::UpdateMasternodeList(CMasternodeBroadcast mnb)
         if (Add(mn)) {
             masternodeSync.AddedMasternodeList(mnb.GetHash());
         }
-    } else if (pmn->UpdateFromNewBroadcast(mnb)) {
+    } else if (UpdateFromNewBroadcast(*pmn, mnb)) {
         masternodeSync.AddedMasternodeList(mnb.GetHash());
     }
 }
@@ -839,7 +909,7 @@ std::string CMasternodeMan::ToString() const
 {
     std::ostringstream info;
 
-    info << "Masternodes: " << (int)vMasternodes.size() << ", peers who asked us for Masternode list: " << (int)mAskedUsForMasternodeList.size() << ", peers we asked for Masternode list: " << (int)mWeAskedForMasternodeList.size() << ", entries in Masternode list we asked for: " << (int)mWeAskedForMasternodeListEntry.size();
+    info << "Masternodes: " << (int)listMasternodes.size() << ", peers who asked us for Masternode list: " << (int)mAskedUsForMasternodeList.size() << ", peers we asked for Masternode list: " << (int)mWeAskedForMasternodeList.size() << ", entries in Masternode list we asked for: " << (int)mWeAskedForMasternodeListEntry.size();
 
     return info.str();
 }
@@ -867,10 +937,13 @@ void ThreadCheckMasternodes()
             // start right after sync is considered to be done
             if (c % MASTERNODE_PING_SECONDS == 1) activeMasternode.ManageStatus();
 
+            // the first pass also drops the expired entries loaded from mncache.dat
+            if (c == 1) mnodeman.CheckAndRemove(true);
+
             if (c % 60 == 0) {
                 mnodeman.CheckAndRemove();
                 masternodePayments.CleanPaymentList();
-                CleanTransactionLocksList();
+                swiftTX.CleanTransactionLocksList();
             }
         }
     }
@@ -9,13 +9,18 @@
 
 #include "activemasternode.h"
 #include "base58.h"
+#include "flat-database.h"
 #include "key.h"
 #include "main.h"
 #include "masternode.h"
 #include "net.h"
+#include "saltedhasher.h"
 #include "sync.h"
 #include "util.h"
 
+#include <list>
+#include <unordered_map>
+
 #define MASTERNODES_DUMP_SECONDS (15 * 60)
 #define MASTERNODES_DSEG_SECONDS (3 * 60 * 60)
 
@@ -31,28 +36,23 @@ void DumpMasternodes();
 
 /** Access to the MN database (mncache.dat)
  */
-class CMasternodeDB
+class CMasternodeDB : public CFlatDB
 {
-private:
-    fs::path pathMN;
-    std::string strMagicMessage;
-
 public:
-    enum ReadResult {
-        Ok,
-        FileError,
-        HashReadError,
-        IncorrectHash,
-        IncorrectMagicMessage,
-        IncorrectMagicNumber,
-        IncorrectFormat
-    };
-
     CMasternodeDB();
     bool Write(const CMasternodeMan& mnodemanToSave);
     ReadResult Read(CMasternodeMan& mnodemanToLoad, bool fDryRun = false);
 };
 
+/** Chain state of a masternode collateral */
+struct CMasternodeCollateral {
+    CKeyImage keyImage;
+    bool fAvailable; //!< the collateral output is in the UTXO set
+    bool fSpent;     //!< the key image is spent in the active chain
+
+    CMasternodeCollateral() : fAvailable(false), fSpent(false) {}
+};
+
 class CMasternodeMan
 {
 private:
@@ -62,8 +62,13 @@ private:
     // critical section to protect the inner data structures specifically on messaging
     mutable RecursiveMutex cs_process_message;
 
-    // map to hold all MNs
-    std::vector<CMasternode> vMasternodes;
+    // list to hold all MNs; entries do not move, so the indexes can point into it
+    std::list<CMasternode> listMasternodes;
+    // MNs by collateral outpoint
+    std::unordered_map<COutPoint, CMasternode*, CSaltedHasher> mapMasternodesByVin;
+    // MNs by masternode key and by payee script; keys are not unique across the list
+    std::unordered_map<CPubKey, std::vector<CMasternode*>, CSaltedHasher> mapMasternodesByPubKey;
+    std::unordered_map<CScript, std::vector<CMasternode*>, CSaltedHasher> mapMasternodesByPayee;
     // who's asked for the Masternode list and the last time
     std::map<CNetAddr, int64_t> mAskedUsForMasternodeList;
     // who we asked for the Masternode list and the last time
@@ -71,6 +76,24 @@ private:
     // which Masternodes we've asked for
     std::map<COutPoint, int64_t> mWeAskedForMasternodeListEntry;
 
+    // critical section to protect the collateral watch set, taken after cs_main and cs
+    mutable Mutex cs_collaterals;
+    // collaterals of the listed Masternodes, kept current by BlockConnected and BlockDisconnected
+    std::map<COutPoint, CMasternodeCollateral> mapCollaterals;
+    // watched collateral by key image
+    std::map<CKeyImage, COutPoint> mapCollateralKeyImages;
+
+    /// Start watching the collaterals of listed Masternodes that are not watched yet
+    void WatchCollaterals();
+    /// Stop watching the collateral of vin
+    void UnwatchCollateral(const CTxIn& vin);
+
+    /// Add mn to or remove it from the indexes; requires cs
+    void Index(CMasternode& mn);
+    void Unindex(CMasternode& mn);
+    /// Rebuild the indexes from the list; requires cs
+    void Reindex();
+
 public:
     // Keep track of all broadcasts I've seen
     std::map<uint256, CMasternodeBroadcast> mapSeenMasternodeBroadcast;
@@ -87,7 +110,16 @@ public:
     inline void SerializationOp(Stream& s, Operation ser_action, int nType, int nVersion)
     {
         LOCK(cs);
-        READWRITE(vMasternodes);
+        // Serialized as a vector, as before the list was indexed
+        if (ser_action.ForRead()) {
+            std::vector<CMasternode> vMasternodes;
+            READWRITE(vMasternodes);
+            listMasternodes.assign(vMasternodes.begin(), vMasternodes.end());
+            Reindex();
+        } else {
+            std::vector<CMasternode> vMasternodes(listMasternodes.begin(), listMasternodes.end());
+            READWRITE(vMasternodes);
+        }
         READWRITE(mAskedUsForMasternodeList);
         READWRITE(mWeAskedForMasternodeList);
         READWRITE(mWeAskedForMasternodeListEntry);
@@ -109,6 +141,16 @@ public:
     /// Check all Masternodes
     void Check();
 
+    /// Look up the collateral of vin in the chain state; requires cs_main
+    static CMasternodeCollateral LookupCollateral(const CTxIn& vin);
+
+    /// Get the watched collateral of vin; false if it is not watched (yet)
+    bool GetCollateral(const CTxIn& vin, CMasternodeCollateral& collateral) const;
+
+    /// Update the watched collaterals for a block connected to or disconnected from the active chain; requires cs_main
+    void BlockConnected(const CBlock& block);
+    void BlockDisconnected(const CBlock& block);
+
     /// Check all Masternodes and remove inactive
     void CheckAndRemove(bool forceExpiredRemoval = false);
 
@@ -135,7 +177,8 @@ public:
     std::vector<CMasternode> GetFullMasternodeVector()
     {
         Check();
-        return vMasternodes;
+        LOCK(cs);
+        return std::vector<CMasternode>(listMasternodes.begin(), listMasternodes.end());
     }
 
     std::vector<std::pair<int, CMasternode> > GetMasternodeRanks(int64_t nBlockHeight, int minProtocol = 0);
@@ -145,7 +188,7 @@ public:
     void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
 
     /// Return the number of (unique) Masternodes
-    int size() { return vMasternodes.size(); }
+    int size() { return listMasternodes.size(); }
 
     /// Return the number of Masternodes older than (default) 8000 seconds
     int stable_size ();
@@ -156,6 +199,9 @@ public:
 
     /// Update masternode list and maps using provided CMasternodeBroadcast
     void UpdateMasternodeList(CMasternodeBroadcast mnb);
+
+    /// Update a listed masternode from a newer broadcast, keeping the indexes current
+    bool UpdateFromNewBroadcast(CMasternode& mn, CMasternodeBroadcast& mnb);
 };
 
 void ThreadCheckMasternodes();
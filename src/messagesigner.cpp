@@ -4,12 +4,80 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "base58.h"
+#include "crypto/sha256.h"
 #include "hash.h"
+#include "lrucache.h"
 #include "main.h" // For strMessageMagic
 #include "messagesigner.h"
+#include "random.h"
 #include "tinyformat.h"
+#include "util.h"
 #include "utilstrencodings.h"
 
+namespace {
+/**
+ * Signers recovered from compact signatures, so a masternode message relayed or
+ * synced again, or recovered ahead by PreVerifyHash, costs no pubkey recovery.
+ * Entries are keyed by SHA256(nonce || hash || signature).
+ */
+class CMessageSignatureCache
+{
+private:
+    uint256 nonce;
+    CLRUCache<uint256, CKeyID, BlockHasher> cache;
+
+public:
+    CMessageSignatureCache() : cache(DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE)
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(vchSig.data(), vchSig.size()).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry, CKeyID& keyID)
+    {
+        return cache.Get(entry, keyID);
+    }
+
+    void Set(const uint256& entry, const CKeyID& keyID)
+    {
+        cache.Insert(entry, keyID);
+    }
+
+    void SetMaxSize(size_t nMaxSize)
+    {
+        cache.SetMaxSize(nMaxSize);
+    }
+};
+
+static CMessageSignatureCache messageSignatureCache;
+
+/** Recover the signer of hash, through the cache */
+bool RecoverSigner(const uint256& hash, const std::vector<unsigned char>& vchSig, CKeyID& keyIDRet)
+{
+    uint256 entry;
+    messageSignatureCache.ComputeEntry(entry, hash, vchSig);
+    if (messageSignatureCache.Get(entry, keyIDRet))
+        return true;
+    CPubKey pubkeyFromSig;
+    if (!pubkeyFromSig.RecoverCompact(hash, vchSig))
+        return false;
+    keyIDRet = pubkeyFromSig.GetID();
+    messageSignatureCache.Set(entry, keyIDRet);
+    return true;
+}
+}
+
+void InitMessageSignatureCache()
+{
+    int64_t nMaxSize = std::max((int64_t)0, GetArg("-maxmnsigcachesize", DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE));
+    messageSignatureCache.SetMaxSize(nMaxSize);
+    LogPrintf("Using a message signature cache of %d entries\n", nMaxSize);
+}
+
 bool CMessageSigner::GetKeysFromSecret(const std::string& strSecret, CKey& keyRet, CPubKey& pubkeyRet)
 {
     CBitcoinSecret vchSecret;
@@ -45,6 +113,15 @@ bool CMessageSigner::VerifyMessage(const CKeyID& keyID, const std::vector<unsign
     return CHashSigner::VerifyHash(ss.GetHash(), keyID, vchSig, strErrorRet);
 }
 
+void CMessageSigner::PreVerifyMessage(const std::vector<unsigned char>& vchSig, const std::string& strMessage)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << strMessageMagic;
+    ss << strMessage;
+
+    CHashSigner::PreVerifyHash(ss.GetHash(), vchSig);
+}
+
 bool CHashSigner::SignHash(const uint256& hash, const CKey& key, std::vector<unsigned char>& vchSigRet)
 {
     return key.SignCompact(hash, vchSigRet);
@@ -57,18 +134,24 @@ bool CHashSigner::VerifyHash(const uint256& hash, const CPubKey& pubkey, const s
 
 bool CHashSigner::VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet)
 {
-    CPubKey pubkeyFromSig;
-    if(!pubkeyFromSig.RecoverCompact(hash, vchSig)) {
+    CKeyID keyIDFromSig;
+    if(!RecoverSigner(hash, vchSig, keyIDFromSig)) {
         strErrorRet = "Error recovering public key.";
         return false;
     }
 
-    if(pubkeyFromSig.GetID() != keyID) {
+    if(keyIDFromSig != keyID) {
         strErrorRet = strprintf("Keys don't match: pubkey=%s, pubkeyFromSig=%s, hash=%s, vchSig=%s",
-                    keyID.ToString(), pubkeyFromSig.GetID().ToString(), hash.ToString(),
+                    keyID.ToString(), keyIDFromSig.ToString(), hash.ToString(),
                     EncodeBase64(&vchSig[0], vchSig.size()));
         return false;
     }
 
     return true;
 }
+
+void CHashSigner::PreVerifyHash(const uint256& hash, const std::vector<unsigned char>& vchSig)
+{
+    CKeyID keyID;
+    RecoverSigner(hash, vchSig, keyID);
+}
@@ -8,6 +8,9 @@
 
 #include "key.h"
 
+/** Default for -maxmnsigcachesize, the number of recovered message signers kept */
+static const unsigned int DEFAULT_MAX_MESSAGE_SIG_CACHE_SIZE = 50000;
+
 /** Helper class for signing messages and checking their signatures
  */
 class CMessageSigner
@@ -21,6 +24,8 @@ public:
     static bool VerifyMessage(const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
     /// Verify the message signature, returns true if succcessful
     static bool VerifyMessage(const CKeyID& keyID, const std::vector<unsigned char>& vchSig, const std::string& strMessage, std::string& strErrorRet);
+    /// Recover the signer of the message into the signature cache, so verifying it later is a lookup
+    static void PreVerifyMessage(const std::vector<unsigned char>& vchSig, const std::string& strMessage);
 };
 
 /** Helper class for signing hashes and checking their signatures
@@ -34,6 +39,11 @@ public:
     static bool VerifyHash(const uint256& hash, const CPubKey& pubkey, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
     /// Verify the hash signature, returns true if succcessful
     static bool VerifyHash(const uint256& hash, const CKeyID& keyID, const std::vector<unsigned char>& vchSig, std::string& strErrorRet);
+    /// Recover the signer of the hash into the signature cache
+    static void PreVerifyHash(const uint256& hash, const std::vector<unsigned char>& vchSig);
 };
 
+/** Size the message signature cache from -maxmnsigcachesize. */
+void InitMessageSignatureCache();
+
 #endif
@@ -104,20 +104,13 @@ uint32_t GetListOfPoSInfo(uint32_t currentHeight, std::vector<PoSBlockSummary>&
 {
     //A PoA block should be mined only after at least 59 PoS blocks have not been audited
     //Look for the previous PoA block
-    uint32_t nloopIdx = currentHeight;
-    while (nloopIdx >= Params().START_POA_BLOCK()) {
-        if (chainActive[nloopIdx]->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        nloopIdx--;
-    }
+    uint32_t nloopIdx = FindLastPoABlock(chainActive[currentHeight], Params().START_POA_BLOCK() - 1)->nHeight;
     if (nloopIdx <= Params().START_POA_BLOCK()) {
         //this is the first PoA block ==> take all PoS blocks from LAST_POW_BLOCK up to currentHeight - 60 inclusive
         for (int i = Params().LAST_POW_BLOCK() + 1; i <= Params().LAST_POW_BLOCK() + (size_t)Params().MAX_NUM_POS_BLOCKS_AUDITED(); i++) {
             PoSBlockSummary pos;
             pos.hash = chainActive[i]->GetBlockHash();
-            CBlockIndex* pindex = mapBlockIndex[pos.hash];
-            pos.nTime = ReVerifyPoSBlock(pindex) ? chainActive[i]->GetBlockHeader().nTime : 0;
+            pos.nTime = chainActive[i]->GetBlockHeader().nTime;
             pos.height = i;
             audits.push_back(pos);
         }
@@ -126,23 +119,17 @@ uint32_t GetListOfPoSInfo(uint32_t currentHeight, std::vector<PoSBlockSummary>&
         uint32_t start = nloopIdx;
         if (start > Params().START_POA_BLOCK()) {
             CBlockIndex* pblockindex = chainActive[start];
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex))
-                throw std::runtime_error("Can't read block from disk");
-            PoSBlockSummary back = block.posBlocksAudited.back();
-            uint32_t lastAuditedHeight = back.height;
+            if (!pblockindex->HasAuditedPoSHeight())
+                throw std::runtime_error("Can't find the last audited PoS block");
+            uint32_t lastAuditedHeight = pblockindex->nAuditedPoSHeight;
             uint32_t nextAuditHeight = lastAuditedHeight + 1;
 
             while (nextAuditHeight <= currentHeight) {
                 CBlockIndex* posIndex = chainActive[nextAuditHeight];
-                CBlock posBlock;
-                if (!ReadBlockFromDisk(posBlock, posIndex))
-                    throw std::runtime_error("Can't read block from disk");
-                if (posBlock.IsProofOfStake()) {
+                if (posIndex->IsProofOfStake()) {
                     PoSBlockSummary pos;
                     pos.hash = chainActive[nextAuditHeight]->GetBlockHash();
-                    CBlockIndex* pindex = mapBlockIndex[pos.hash];
-                    pos.nTime = ReVerifyPoSBlock(pindex) ? chainActive[nextAuditHeight]->GetBlockHeader().nTime : 0;
+                    pos.nTime = chainActive[nextAuditHeight]->GetBlockHeader().nTime;
                     pos.height = nextAuditHeight;
                     audits.push_back(pos);
                 }
@@ -154,6 +141,17 @@ uint32_t GetListOfPoSInfo(uint32_t currentHeight, std::vector<PoSBlockSummary>&
             }
         }
     }
+
+    //audit the collected PoS blocks together; a failed audit is recorded with nTime = 0
+    std::vector<CBlockIndex*> vAudited;
+    for (const PoSBlockSummary& pos : audits)
+        vAudited.push_back(mapBlockIndex[pos.hash]);
+    std::vector<bool> vAuditResults;
+    ReVerifyPoSBlocks(vAudited, vAuditResults);
+    for (size_t i = 0; i < audits.size(); i++) {
+        if (!vAuditResults[i])
+            audits[i].nTime = 0;
+    }
     return nloopIdx;
 }
 
@@ -215,6 +215,8 @@ public:
 
     int64_t nTime; // time (in microseconds) of message receipt.
 
+    bool fPreVerifyQueued; // handed to the masternode message pre-verification threads
+
     CNetMessage(int nTypeIn, int nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn)
     {
         hdrbuf.resize(24);
@@ -222,6 +224,7 @@ public:
         nHdrPos = 0;
         nDataPos = 0;
         nTime = 0;
+        fPreVerifyQueued = false;
     }
 
     bool complete() const
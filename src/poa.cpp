@@ -60,8 +60,9 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
 
         //finding last PoS block
         CBlockIndex* pLastPoS = pindexLast->pprev;
-        while (!pLastPoS->IsProofOfStake() && pLastPoS->nHeight > Params().LAST_POW_BLOCK()) {
-            pLastPoS = pLastPoS->pprev;
+        if (!pLastPoS->IsProofOfStake() && pLastPoS->nHeight > Params().LAST_POW_BLOCK()) {
+            CBlockIndex* pPrevPoS = pLastPoS->pprevPoS;
+            pLastPoS = (pPrevPoS && pPrevPoS->nHeight >= Params().LAST_POW_BLOCK()) ? pPrevPoS : pLastPoS->GetAncestor(Params().LAST_POW_BLOCK());
         }
         int64_t nActualSpacing = 0;
         //ig
@@ -184,8 +185,18 @@ uint256 GetBlockProof(const CBlockIndex& block)
 }
 
 CBlockIndex* FindPrevPoSBlock(CBlockIndex* p) {
-    if (!p || !p->pprev) return NULL;
-    return p->pprev->IsProofOfStake()?p->pprev:FindPrevPoSBlock(p->pprev);
+    if (!p) return NULL;
+    return p->pprevPoS;
+}
+
+CBlockIndex* FindLastPoABlock(CBlockIndex* pindex, int nStopHeight)
+{
+    if (pindex->nHeight <= nStopHeight || pindex->IsPoABlockByVersion())
+        return pindex;
+    CBlockIndex* pPrevPoA = pindex->pprevPoA;
+    if (pPrevPoA && pPrevPoA->nHeight > nStopHeight)
+        return pPrevPoA;
+    return pindex->GetAncestor(nStopHeight);
 }
 
 //If blockheight = -1, the to-be-checked block is not included yet in the chain, otherwise, that is the height of the poa block
@@ -198,18 +209,13 @@ bool CheckPoAContainRecentHash(const CBlock& block)
         return error("CheckPoAContainRecentHash(): Previous block not found");
     }
     //Find the previous PoA block
-    CBlockIndex* pindex = currentTip;
-    nHeight = pindex->nHeight;
-    while (pindex->nHeight >= Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(currentTip, Params().START_POA_BLOCK() - 1);
+    nHeight = currentTip->nHeight;
     bool ret = true;
     if (pindex->nHeight <= Params().START_POA_BLOCK()) {
         //this is the first PoA block ==> check all PoS blocks from LAST_POW_BLOCK up to currentHeight - POA_BLOCK_PERIOD - 1 inclusive
         int index = 0;
+        std::vector<CBlockIndex*> vAudited;
         for (size_t i = Params().LAST_POW_BLOCK() + 1; i <= Params().LAST_POW_BLOCK() + block.posBlocksAudited.size(); i++) {
             PoSBlockSummary pos = block.posBlocksAudited.at(index);
             CBlockIndex* pidxInChain = mapBlockIndex[pos.hash];
@@ -220,15 +226,18 @@ bool CheckPoAContainRecentHash(const CBlock& block)
                 ret = false;
                 break;
             }
-            CBlockIndex* p = mapBlockIndex[pos.hash];
-            bool auditResult = ReVerifyPoSBlock(p);
-            if (!auditResult) {
-                if (pos.nTime) {
+            vAudited.push_back(pidxInChain);
+            index++;
+        }
+        if (ret) {
+            std::vector<bool> vAuditResults;
+            ReVerifyPoSBlocks(vAudited, vAuditResults);
+            for (size_t i = 0; i < vAudited.size(); i++) {
+                if (!vAuditResults[i] && block.posBlocksAudited[i].nTime) {
                     ret = false;
                     break;
                 }
             }
-            index++;
         }
     } else {
         if (pindex->nHeight >= Params().START_POA_BLOCK()) {
@@ -236,10 +245,11 @@ bool CheckPoAContainRecentHash(const CBlock& block)
             if (pindex->nHeight == 17077 || pindex->nHeight == 17154 || pindex->nHeight == 135887 || pindex->nHeight == 311272) {
                 return true;
             }
-            CBlock prevPoablock;
             CBlockIndex* pblockindex = pindex;
-            if (!ReadBlockFromDisk(prevPoablock, pblockindex))
+            std::shared_ptr<const CBlock> pprevPoablock = ReadBlockFromDisk(pblockindex);
+            if (!pprevPoablock)
                 throw std::runtime_error("Can't read block from disk");
+            const CBlock& prevPoablock = *pprevPoablock;
             PoSBlockSummary lastAuditedPoSBlockInfo = prevPoablock.posBlocksAudited.back();
             uint256 lastAuditedPoSHash = lastAuditedPoSBlockInfo.hash;
             if (mapBlockIndex.count(lastAuditedPoSHash) < 1 && !IsWrongAudit(lastAuditedPoSHash.GetHex(), nHeight)) {
@@ -270,6 +280,8 @@ bool CheckPoAContainRecentHash(const CBlock& block)
             }
 
             //alright, check all pos blocks audited in the block is conseutive in the chain
+            std::vector<CBlockIndex*> vAudited(block.posBlocksAudited.size());
+            vAudited[0] = pCurrentFirstPoSAuditedIndex;
             for(size_t i = block.posBlocksAudited.size() - 1; i > 0; i--) {
                 uint256 thisPoSAduditedHash = block.posBlocksAudited[i].hash;
                 if (mapBlockIndex.count(thisPoSAduditedHash) < 1) {
@@ -286,24 +298,23 @@ bool CheckPoAContainRecentHash(const CBlock& block)
                     previousPoSIndex->GetBlockTime() != previousSummary.nTime) {
                     return error("CheckPoAContainRecentHash(): PoS block info not matched for %s\n", thisPoSAduditedHash.GetHex());
                 }
-                bool auditResult = ReVerifyPoSBlock(thisPoSAuditedIndex);
-                if (!auditResult) {
-                    if (previousSummary.nTime) {
-                        ret = false;
-                        LogPrintf("%s: Failed to reverify block %s\n", __func__, previousSummary.hash.GetHex());
-                        break;
-                    }
-                }
+                vAudited[i] = thisPoSAuditedIndex;
             }
-            if (ret) {
-                bool auditResult = ReVerifyPoSBlock(pCurrentFirstPoSAuditedIndex);
-                if (!auditResult) {
-                    if (block.posBlocksAudited[0].nTime) {
-                        ret = false;
-                        LogPrintf("%s: Failed to reverify block %s\n", __func__, block.posBlocksAudited[0].hash.GetHex());
-                    }
+
+            //the audited blocks are independent of each other, verify them together
+            std::vector<bool> vAuditResults;
+            ReVerifyPoSBlocks(vAudited, vAuditResults);
+            for (size_t i = block.posBlocksAudited.size() - 1; i > 0; i--) {
+                if (!vAuditResults[i] && block.posBlocksAudited[i - 1].nTime) {
+                    ret = false;
+                    LogPrintf("%s: Failed to reverify block %s\n", __func__, block.posBlocksAudited[i - 1].hash.GetHex());
+                    break;
                 }
             }
+            if (ret && !vAuditResults[0] && block.posBlocksAudited[0].nTime) {
+                ret = false;
+                LogPrintf("%s: Failed to reverify block %s\n", __func__, block.posBlocksAudited[0].hash.GetHex());
+            }
         } else {
             ret = block.hashPrevPoABlock.IsNull();
         }
@@ -363,13 +374,7 @@ bool CheckPrevPoABlockHash(const CBlockHeader& block)
         return error("CheckPrevPoABlockHash(): Previous block not found");
     }
     //Find the previous PoA block
-    CBlockIndex* pindex = currentTip;
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(currentTip, Params().START_POA_BLOCK());
     bool ret = false;
 
     if (pindex->nHeight > Params().START_POA_BLOCK()) {
@@ -453,9 +458,10 @@ bool CheckPoABlockNotAuditingOverlap(const CBlock& block)
     } else {
         if (mapBlockIndex.count(block.hashPrevPoABlock) != 0) {
             CBlockIndex* pPrevPoAIndex = mapBlockIndex[block.hashPrevPoABlock];
-            CBlock prevPoablock;
-            if (!ReadBlockFromDisk(prevPoablock, pPrevPoAIndex))
+            std::shared_ptr<const CBlock> pprevPoablock = ReadBlockFromDisk(pPrevPoAIndex);
+            if (!pprevPoablock)
                 throw std::runtime_error("Can't read block from disk");
+            const CBlock& prevPoablock = *pprevPoablock;
             ret = true;
             for (size_t i = 0; i < block.posBlocksAudited.size(); i++) {
                 bool isAlreadyAudited = false;
@@ -510,9 +516,10 @@ bool CheckPoABlockPaddingAmount(const CBlock& block, const CBlockIndex* pindex)
         ret = false;
         if (mapBlockIndex.count(block.hashPrevPoABlock) != 0) {
             CBlockIndex* pPrevPoAIndex = mapBlockIndex[block.hashPrevPoABlock];
-            CBlock prevPoablock;
-            if (!ReadBlockFromDisk(prevPoablock, pPrevPoAIndex))
+            std::shared_ptr<const CBlock> pprevPoablock = ReadBlockFromDisk(pPrevPoAIndex);
+            if (!pprevPoablock)
                 throw std::runtime_error("Can't read block from disk");
+            const CBlock& prevPoablock = *pprevPoablock;
             prevPoAHeight = pPrevPoAIndex->nHeight;
             for (size_t i = 0; i < block.posBlocksAudited.size(); i++) {
                 lastPoSHeight = block.posBlocksAudited[i].height;
@@ -40,6 +40,11 @@ bool CheckPoAMerkleRoot(const CBlock& block, bool* fMutate = NULL);
 /** Check whether a block hash satisfies the proof-of-work requirement specified by nBits */
 bool CheckPoABlockMinedHash(const CBlockHeader& block);
 
+/** Find the nearest PoS block before p */
+CBlockIndex* FindPrevPoSBlock(CBlockIndex* p);
+/** Find the nearest PoA block at or before pindex, going back no further than nStopHeight */
+CBlockIndex* FindLastPoABlock(CBlockIndex* pindex, int nStopHeight);
+
 bool CheckPoAContainRecentHash(const CBlock& block);
 bool CheckNumberOfAuditedPoSBlocks(const CBlock& block, const CBlockIndex* pindex);
 bool CheckPoABlockNotContainingPoABlockInfo(const CBlock& block, const CBlockIndex* pindex);
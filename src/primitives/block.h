@@ -154,6 +154,7 @@ public:
     // memory only
     mutable CScript payee;
     mutable bool fChecked;
+    mutable bool fPreChecked; //!< block signature verified ahead of ProcessNewBlock
     mutable std::vector<uint256> poaMerkleTree;
 
     CBlock()
@@ -186,6 +187,7 @@ public:
         vtx.clear();
         posBlocksAudited.clear();
         fChecked = false;
+        fPreChecked = false;
         poaMerkleTree.clear();
         payee = CScript();
         vchBlockSig.clear();
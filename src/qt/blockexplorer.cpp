@@ -191,8 +191,10 @@ std::string BlockToString(CBlockIndex* pBlock)
     if (!pBlock)
         return "";
 
-    CBlock block;
-    ReadBlockFromDisk(block, pBlock);
+    std::shared_ptr<const CBlock> pblock = ReadBlockFromDisk(pBlock);
+    if (!pblock)
+        pblock = std::make_shared<const CBlock>();
+    const CBlock& block = *pblock;
 
     CAmount Fees = 0;
     CAmount OutVolume = 0;
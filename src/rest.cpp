@@ -8,18 +8,26 @@
 #include "primitives/transaction.h"
 #include "main.h"
 #include "httpserver.h"
+#include "lrucache.h"
+#include "pubkey.h"
 #include "rpc/server.h"
+#include "script/standard.h"
 #include "streams.h"
 #include "sync.h"
+#include "txdb.h"
 #include "txmempool.h"
 #include "utilstrencodings.h"
 #include "version.h"
 #include <univalue.h>
 
+#include <algorithm>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/dynamic_bitset.hpp>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const size_t REST_REPLY_CHUNK_SIZE = 64 * 1024; //size of the chunks streamed JSON replies are sent in
+static const size_t REST_POA_AUDIT_CACHE_SIZE = 1000; //number of PoA blocks whose audited PoS block summaries are kept
 
 
 enum RetFormat {
@@ -54,25 +62,126 @@ struct CCoin {
     }
 };
 
+/** Spend state of a key image, from the key image index */
+struct CRESTKeyImage {
+    CKeyImage keyImage;
+    bool fSpent;
+    int32_t nHeight; // -1 if not spent in the active chain
+    uint256 hashBlock;
+
+    ADD_SERIALIZE_METHODS;
+
+    template<typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(keyImage);
+        READWRITE(fSpent);
+        READWRITE(nHeight);
+        READWRITE(hashBlock);
+    }
+};
+
+/** The parts of an output a ring signature or a light wallet needs */
+struct CRESTRingCTOutput {
+    CPubKey pubKey;
+    std::vector<unsigned char> commitment;
+    std::vector<unsigned char> txPub;
+    uint256 encodedAmount;
+    uint256 encodedMask;
+
+    ADD_SERIALIZE_METHODS;
+
+    template<typename Stream, typename Operation>
+    inline void SerializationOp(Stream &s, Operation ser_action, int nType, int nVersion) {
+        READWRITE(pubKey);
+        READWRITE(commitment);
+        READWRITE(txPub);
+        READWRITE(encodedAmount);
+        READWRITE(encodedMask);
+    }
+};
+
+/** Audited PoS block summaries by PoA block hash; they are fixed once the PoA block is known */
+static CLRUCache<uint256, std::shared_ptr<const std::vector<PoSBlockSummary> >, BlockHasher> poaAuditCache(REST_POA_AUDIT_CACHE_SIZE);
 
 extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
 
-extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false, bool fTxList = true);
 
 extern UniValue mempoolInfoToJSON();
 
 extern UniValue mempoolToJSON(bool fVerbose = false);
 
+extern UniValue mempoolEntryToJSON(const CTxMemPoolEntry& e);
+
 extern void ScriptPubKeyToJSON(const CScript &scriptPubKey, UniValue &out, bool fIncludeHex);
 
 extern UniValue blockheaderToJSON(const CBlockIndex *blockindex);
 
+extern void PoSBlockInfoToJSON(const uint256 hashBlock, int64_t nTime, int height, UniValue& entry);
+
 static bool RESTERR(HTTPRequest *req, enum HTTPStatusCode status, std::string message) {
+    // Handlers validate before a streamed reply is started, its status can not change anymore
+    assert(!req->IsReplyStarted());
     req->WriteHeader("Content-Type", "text/plain");
     req->WriteReply(status, message + "\r\n");
     return false;
 }
 
+/**
+ * JSON reply sent in chunks as it is written, so large bodies such as blocks
+ * with transaction details are never held in memory as a whole.
+ * Construct it only once the request was validated: from then on the reply can
+ * only be ended, not replaced by an error.
+ */
+class RESTJSONStream
+{
+private:
+    HTTPRequest* req;
+    std::string strBuffer;
+    bool fClosed;
+
+public:
+    RESTJSONStream(HTTPRequest* reqIn) : req(reqIn), fClosed(false)
+    {
+        req->WriteHeader("Content-Type", "application/json");
+        req->StartReply(HTTP_OK);
+    }
+
+    void Write(const std::string& str)
+    {
+        if (fClosed)
+            return;
+        strBuffer += str;
+        if (strBuffer.size() >= REST_REPLY_CHUNK_SIZE)
+            Flush();
+    }
+
+    void WriteKey(const std::string& strKey)
+    {
+        Write(UniValue(strKey).write() + ":");
+    }
+
+    void Flush()
+    {
+        if (!fClosed && !req->WriteReplyChunk(strBuffer))
+            fClosed = true;
+        strBuffer.clear();
+    }
+
+    /** Whether the client disconnected, so there is no point producing more */
+    bool IsClosed() const
+    {
+        return fClosed;
+    }
+
+    void End()
+    {
+        Write("\n");
+        Flush();
+        req->EndReply();
+    }
+};
+
 static enum RetFormat ParseDataFormat(std::vector<std::string>& params, const std::string& strReq) {
     boost::split(params, strReq, boost::is_any_of("."));
     if (params.size() > 1) {
@@ -200,7 +309,7 @@ static bool rest_block(HTTPRequest *req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    CBlock block;
+    std::shared_ptr<const CBlock> pblock;
     CBlockIndex *pblockindex = NULL;
     {
         LOCK(cs_main);
@@ -211,15 +320,16 @@ static bool rest_block(HTTPRequest *req,
         if (!(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex))
+        pblock = ReadBlockFromDisk(pblockindex);
+        if (!pblock)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
     }
-
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
+    const CBlock& block = *pblock;
 
     switch (rf) {
         case RF_BINARY: {
+            CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+            ssBlock << block;
             std::string binaryBlock = ssBlock.str();
             req->WriteHeader("Content-Type", "application/octet-stream");
             req->WriteReply(HTTP_OK, binaryBlock);
@@ -227,6 +337,8 @@ static bool rest_block(HTTPRequest *req,
         }
 
         case RF_HEX: {
+            CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+            ssBlock << block;
             std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
             req->WriteReply(HTTP_OK, strHex);
@@ -234,10 +346,30 @@ static bool rest_block(HTTPRequest *req,
         }
 
         case RF_JSON: {
-            UniValue objTx(UniValue::VOBJ);
-            std::string strJSON = objTx.write() + "\n";
-            req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            // The transaction details are written one transaction at a time
+            UniValue objBlock = blockToJSON(block, pblockindex, false);
+            const std::vector<std::string>& keys = objBlock.getKeys();
+            const std::vector<UniValue>& values = objBlock.getValues();
+            RESTJSONStream stream(req);
+            stream.Write("{");
+            for (size_t i = 0; i < keys.size(); i++) {
+                if (i > 0)
+                    stream.Write(",");
+                stream.WriteKey(keys[i]);
+                if (!showTxDetails || keys[i] != "tx") {
+                    stream.Write(values[i].write());
+                    continue;
+                }
+                stream.Write("[");
+                for (size_t j = 0; j < block.vtx.size() && !stream.IsClosed(); j++) {
+                    UniValue objTx(UniValue::VOBJ);
+                    TxToJSON(block.vtx[j], UINT256_ZERO, objTx);
+                    stream.Write((j > 0 ? "," : "") + objTx.write());
+                }
+                stream.Write("]");
+            }
+            stream.Write("}");
+            stream.End();
             return true;
         }
 
@@ -315,11 +447,32 @@ static bool rest_mempool_contents(HTTPRequest *req, const std::string &strURIPar
 
     switch (rf) {
         case RF_JSON: {
-            UniValue mempoolObject = mempoolToJSON(true);
-
-            std::string strJSON = mempoolObject.write() + "\n";
-            req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            // Entries are written one at a time instead of building the whole object,
+            // without holding the mempool lock while the client takes them
+            std::vector<uint256> vtxid;
+            mempool.queryHashes(vtxid);
+            RESTJSONStream stream(req);
+            stream.Write("{");
+            bool fFirst = true;
+            for (const uint256& hash : vtxid) {
+                if (stream.IsClosed())
+                    break;
+                std::string strEntry;
+                {
+                    LOCK(mempool.cs);
+                    auto it = mempool.mapTx.find(hash);
+                    if (it == mempool.mapTx.end())
+                        continue; // removed since the hashes were taken
+                    strEntry = mempoolEntryToJSON(it->second).write();
+                }
+                if (!fFirst)
+                    stream.Write(",");
+                fFirst = false;
+                stream.WriteKey(hash.ToString());
+                stream.Write(strEntry);
+            }
+            stream.Write("}");
+            stream.End();
             return true;
         }
         default: {
@@ -584,6 +737,267 @@ static bool rest_getutxos(HTTPRequest *req, const std::string &strURIPart) {
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+static bool rest_keyimage(HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req))
+        return false;
+    std::vector<std::string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    // key images are indexed by the hex shown in transactions, which lists the bytes in reverse
+    std::string kiHex = boost::to_lower_copy(params[0]);
+    if (!IsHex(kiHex) || kiHex.size() != 66)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid key image: " + params[0]);
+    std::vector<unsigned char> vch = ParseHex(kiHex);
+    std::reverse(vch.begin(), vch.end());
+
+    CRESTKeyImage ki;
+    ki.keyImage = CKeyImage(vch.begin(), vch.end());
+    ki.fSpent = false;
+    ki.nHeight = -1;
+    int nConfirmations = 0;
+
+    std::vector<uint256> bhs;
+    if (pblocktree->ReadKeyImages(kiHex, bhs)) {
+        LOCK(cs_main);
+        for (const uint256& bh : bhs) {
+            BlockMap::iterator mi = mapBlockIndex.find(bh);
+            if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second))
+                continue;
+            ki.fSpent = true;
+            ki.nHeight = mi->second->nHeight;
+            ki.hashBlock = bh;
+            nConfirmations = 1 + chainActive.Height() - ki.nHeight;
+            break;
+        }
+    }
+
+    CDataStream ssKeyImage(SER_NETWORK, PROTOCOL_VERSION);
+    ssKeyImage << ki;
+
+    switch (rf) {
+        case RF_BINARY: {
+            std::string binaryKeyImage = ssKeyImage.str();
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, binaryKeyImage);
+            return true;
+        }
+
+        case RF_HEX: {
+            std::string strHex = HexStr(ssKeyImage.begin(), ssKeyImage.end()) + "\n";
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, strHex);
+            return true;
+        }
+
+        case RF_JSON: {
+            UniValue objKeyImage(UniValue::VOBJ);
+            objKeyImage.push_back(Pair("keyimage", kiHex));
+            objKeyImage.push_back(Pair("spent", ki.fSpent));
+            if (ki.fSpent) {
+                objKeyImage.push_back(Pair("blockhash", ki.hashBlock.GetHex()));
+                objKeyImage.push_back(Pair("height", ki.nHeight));
+                objKeyImage.push_back(Pair("confirmations", nConfirmations));
+            }
+            std::string strJSON = objKeyImage.write() + "\n";
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReply(HTTP_OK, strJSON);
+            return true;
+        }
+
+        default: {
+            return RESTERR(req, HTTP_NOT_FOUND,
+                           "output format not found (available: " + AvailableDataFormatsString() + ")");
+        }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_outputs(HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req))
+        return false;
+    std::vector<std::string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    std::string hashStr = params[0];
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    // served through the transaction index, which reads only this transaction from its block file
+    CTransaction tx;
+    uint256 hashBlock = UINT256_ZERO;
+    if (!GetTransaction(hash, tx, hashBlock, true))
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+    std::vector<CRESTRingCTOutput> outs;
+    outs.reserve(tx.vout.size());
+    for (const CTxOut& txout : tx.vout) {
+        CRESTRingCTOutput out;
+        ExtractPubKey(txout.scriptPubKey, out.pubKey);
+        out.commitment = txout.commitment;
+        out.txPub = txout.txPub;
+        out.encodedAmount = txout.maskValue.amount;
+        out.encodedMask = txout.maskValue.mask;
+        outs.push_back(out);
+    }
+
+    CDataStream ssOutputs(SER_NETWORK, PROTOCOL_VERSION);
+    ssOutputs << hashBlock << outs;
+
+    switch (rf) {
+        case RF_BINARY: {
+            std::string binaryOutputs = ssOutputs.str();
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, binaryOutputs);
+            return true;
+        }
+
+        case RF_HEX: {
+            std::string strHex = HexStr(ssOutputs.begin(), ssOutputs.end()) + "\n";
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, strHex);
+            return true;
+        }
+
+        case RF_JSON: {
+            UniValue objOutputs(UniValue::VOBJ);
+            objOutputs.push_back(Pair("txid", hash.GetHex()));
+            objOutputs.push_back(Pair("blockhash", hashBlock.GetHex()));
+            UniValue vout(UniValue::VARR);
+            for (unsigned int i = 0; i < outs.size(); i++) {
+                const CRESTRingCTOutput& out = outs[i];
+                UniValue objOut(UniValue::VOBJ);
+                objOut.push_back(Pair("n", (int64_t)i));
+                objOut.push_back(Pair("pubkey", HexStr(out.pubKey.begin(), out.pubKey.end())));
+                objOut.push_back(Pair("commitment", HexStr(out.commitment.begin(), out.commitment.end())));
+                // byte-reversed like CPubKey::GetHex, without its variable length buffer
+                CPubKey txPub(out.txPub);
+                std::vector<unsigned char> vchTxPub(txPub.begin(), txPub.end());
+                std::reverse(vchTxPub.begin(), vchTxPub.end());
+                objOut.push_back(Pair("txpubkey", HexStr(vchTxPub)));
+                objOut.push_back(Pair("encoded_amount", out.encodedAmount.GetHex()));
+                objOut.push_back(Pair("encoded_mask", out.encodedMask.GetHex()));
+                vout.push_back(objOut);
+            }
+            objOutputs.push_back(Pair("vout", vout));
+            std::string strJSON = objOutputs.write() + "\n";
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReply(HTTP_OK, strJSON);
+            return true;
+        }
+
+        default: {
+            return RESTERR(req, HTTP_NOT_FOUND,
+                           "output format not found (available: " + AvailableDataFormatsString() + ")");
+        }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
+static bool rest_poa(HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req))
+        return false;
+    std::vector<std::string> params;
+    const RetFormat rf = ParseDataFormat(params, strURIPart);
+
+    std::string hashStr = params[0];
+    uint256 hash;
+    if (!ParseHashStr(hashStr, hash))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
+
+    // copy what is needed from the block index, so the block is read without cs_main
+    int nHeight;
+    uint256 hashPrevPoABlock, hashPoAMerkleRoot, minedHash;
+    CDiskBlockPos blockPos;
+    bool fHaveData;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+        CBlockIndex* pblockindex = mi->second;
+        if (!pblockindex->IsProofOfAudit())
+            return RESTERR(req, HTTP_BAD_REQUEST, hashStr + " is not a PoA block");
+
+        nHeight = pblockindex->nHeight;
+        hashPrevPoABlock = pblockindex->hashPrevPoABlock;
+        hashPoAMerkleRoot = pblockindex->hashPoAMerkleRoot;
+        minedHash = pblockindex->minedHash;
+        blockPos = pblockindex->GetBlockPos();
+        fHaveData = (pblockindex->nStatus & BLOCK_HAVE_DATA) || pblockindex->nTx == 0;
+    }
+
+    // the header fields come from the block index; only the summaries need the block, once
+    std::shared_ptr<const std::vector<PoSBlockSummary> > paudited;
+    if (!poaAuditCache.Get(hash, paudited)) {
+        if (!fHaveData)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, blockPos) || block.GetHash() != hash)
+            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        paudited = std::make_shared<const std::vector<PoSBlockSummary> >(block.posBlocksAudited);
+        poaAuditCache.Insert(hash, paudited);
+    }
+    const std::vector<PoSBlockSummary>& vAudited = *paudited;
+
+    CDataStream ssPoA(SER_NETWORK, PROTOCOL_VERSION);
+    ssPoA << hash << nHeight << hashPrevPoABlock << hashPoAMerkleRoot << minedHash << vAudited;
+
+    switch (rf) {
+        case RF_BINARY: {
+            std::string binaryPoA = ssPoA.str();
+            req->WriteHeader("Content-Type", "application/octet-stream");
+            req->WriteReply(HTTP_OK, binaryPoA);
+            return true;
+        }
+
+        case RF_HEX: {
+            std::string strHex = HexStr(ssPoA.begin(), ssPoA.end()) + "\n";
+            req->WriteHeader("Content-Type", "text/plain");
+            req->WriteReply(HTTP_OK, strHex);
+            return true;
+        }
+
+        case RF_JSON: {
+            UniValue objPoA(UniValue::VOBJ);
+            objPoA.push_back(Pair("hash", hash.GetHex()));
+            objPoA.push_back(Pair("height", nHeight));
+            objPoA.push_back(Pair("previouspoahash", hashPrevPoABlock.GetHex()));
+            objPoA.push_back(Pair("poamerkleroot", hashPoAMerkleRoot.GetHex()));
+            objPoA.push_back(Pair("minedhash", minedHash.GetHex()));
+            UniValue posBlockInfos(UniValue::VARR);
+            bool auditResult = true;
+            for (const PoSBlockSummary& pos : vAudited) {
+                UniValue objPoSBlockInfo(UniValue::VOBJ);
+                PoSBlockInfoToJSON(pos.hash, pos.nTime, pos.height, objPoSBlockInfo);
+                posBlockInfos.push_back(objPoSBlockInfo);
+                auditResult = auditResult && pos.nTime > 0;
+            }
+            objPoA.push_back(Pair("auditsuccess", auditResult ? "true" : "false"));
+            objPoA.push_back(Pair("posblocks", posBlockInfos));
+            objPoA.push_back(Pair("poscount", (int)vAudited.size()));
+            std::string strJSON = objPoA.write() + "\n";
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReply(HTTP_OK, strJSON);
+            return true;
+        }
+
+        default: {
+            return RESTERR(req, HTTP_NOT_FOUND,
+                           "output format not found (available: " + AvailableDataFormatsString() + ")");
+        }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static const struct {
     const char *prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -596,6 +1010,9 @@ static const struct {
         {"/rest/mempool/contents", rest_mempool_contents},
         {"/rest/headers/", rest_headers},
         {"/rest/getutxos", rest_getutxos},
+        {"/rest/keyimage/", rest_keyimage},
+        {"/rest/outputs/", rest_outputs},
+        {"/rest/poa/", rest_poa},
 };
 
 bool StartREST()
@@ -0,0 +1,234 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ringctcache.h"
+
+#include "chain.h"
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "main.h"
+#include "pubkey.h"
+#include "random.h"
+#include "saltedhasher.h"
+#include "script/sigcache.h"
+#include "script/standard.h"
+#include "sync.h"
+#include "util.h"
+
+#include "secp256k1_mlsag.h"
+
+#include <deque>
+#include <unordered_map>
+
+#include <boost/thread.hpp>
+
+namespace {
+/**
+ * Parsed outputs, bounded in size. Entries are evicted oldest first: an output
+ * is looked up again mostly while it is a recent decoy or in the mempool.
+ */
+class CParsedTxOutCache
+{
+private:
+    std::unordered_map<COutPoint, CParsedTxOut, CSaltedHasher> mapParsed;
+    std::deque<COutPoint> queueInserted;
+    size_t nMaxSize;
+    Mutex cs_parsed;
+
+public:
+    CParsedTxOutCache() : nMaxSize(DEFAULT_MAX_PARSED_OUTPUT_CACHE_SIZE) {}
+
+    bool Get(const COutPoint& outpoint, CParsedTxOut& parsed)
+    {
+        LOCK(cs_parsed);
+        auto it = mapParsed.find(outpoint);
+        if (it == mapParsed.end()) return false;
+        parsed = it->second;
+        return true;
+    }
+
+    void Set(const COutPoint& outpoint, const CParsedTxOut& parsed)
+    {
+        LOCK(cs_parsed);
+        if (nMaxSize == 0) return;
+        if (!mapParsed.emplace(outpoint, parsed).second) return;
+        queueInserted.push_back(outpoint);
+        while (queueInserted.size() > nMaxSize) {
+            mapParsed.erase(queueInserted.front());
+            queueInserted.pop_front();
+        }
+    }
+
+    void SetMaxSize(size_t nMaxSizeIn)
+    {
+        LOCK(cs_parsed);
+        nMaxSize = nMaxSizeIn;
+        mapParsed.reserve(nMaxSize);
+    }
+};
+
+static CParsedTxOutCache parsedTxOutCache;
+
+/**
+ * Valid RingCT transactions, to avoid verifying the ring signature and the
+ * bulletproof of a transaction again in ConnectBlock and ReVerifyPoSBlock
+ * after it was accepted into the memory pool.
+ */
+class CRingCTCache
+{
+private:
+    //! Entries are SHA256(nonce || txid || ring member block hash || MIN_RING_SIZE || MAX_RING_SIZE)
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_ringctcache;
+
+    //! Block each ring member transaction was found in during a full verification
+    std::unordered_map<uint256, uint256, CSaltedHasher> mapMemberBlock;
+    std::deque<uint256> queueMemberInserted;
+    size_t nMaxMembers;
+    Mutex cs_members;
+
+public:
+    CRingCTCache() : nMaxMembers(0)
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void SetMemberBlock(const uint256& txid, const uint256& hashBlock)
+    {
+        LOCK(cs_members);
+        auto ret = mapMemberBlock.emplace(txid, hashBlock);
+        if (!ret.second) {
+            ret.first->second = hashBlock;
+            return;
+        }
+        queueMemberInserted.push_back(txid);
+        while (queueMemberInserted.size() > nMaxMembers) {
+            mapMemberBlock.erase(queueMemberInserted.front());
+            queueMemberInserted.pop_front();
+        }
+    }
+
+    /** Hash the blocks holding the ring members of tx; fails if one is unknown or not in the active chain. */
+    bool GetRingMemberHash(const CTransaction& tx, uint256& hash)
+    {
+        CSHA256 hasher;
+        LOCK(cs_members);
+        for (const CTxIn& in : tx.vin) {
+            for (size_t j = 0; j <= in.decoys.size(); j++) {
+                const uint256& txid = j == 0 ? in.prevout.hash : in.decoys[j - 1].hash;
+                auto it = mapMemberBlock.find(txid);
+                if (it == mapMemberBlock.end()) return false;
+                BlockMap::const_iterator mi = mapBlockIndex.find(it->second);
+                if (mi == mapBlockIndex.end() || !chainActive.Contains(mi->second)) return false;
+                hasher.Write(it->second.begin(), 32);
+            }
+        }
+        hasher.Finalize(hash.begin());
+        return true;
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& txid, const uint256& ringMemberHash, int nMinRingSize, int nMaxRingSize)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(txid.begin(), 32).Write(ringMemberHash.begin(), 32).Write((const unsigned char*)&nMinRingSize, sizeof(nMinRingSize)).Write((const unsigned char*)&nMaxRingSize, sizeof(nMaxRingSize)).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_ringctcache);
+        return setValid.contains(entry, false);
+    }
+
+    void Set(const uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_ringctcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        {
+            LOCK(cs_members);
+            nMaxMembers = n / 64;
+        }
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CRingCTCache ringCTCache;
+
+bool GetRingCTEntry(const CTransaction& tx, const CBlockIndex* pindex, uint256& entry)
+{
+    AssertLockHeld(cs_main);
+    if (!pindex) return false;
+    uint256 ringMemberHash;
+    if (!ringCTCache.GetRingMemberHash(tx, ringMemberHash)) return false;
+    SetRingSize(pindex->nHeight);
+    ringCTCache.ComputeEntry(entry, tx.GetHash(), ringMemberHash, MIN_RING_SIZE, MAX_RING_SIZE);
+    return true;
+}
+
+bool ParseTxOut(const CTxOut& out, CParsedTxOut& parsed)
+{
+    secp256k1_context2* ctx = GetContext();
+    CPubKey pubKey;
+    if (ExtractPubKey(out.scriptPubKey, pubKey) && pubKey.size() == 33) {
+        parsed.fHasPubKey = secp256k1_ec_pubkey_parse2(ctx, &parsed.pubKey, pubKey.begin(), 33) &&
+                            secp256k1_mlsag_hash_to_point(ctx, &parsed.hashPoint, pubKey.begin());
+    }
+    if (out.commitment.size() >= 33 && secp256k1_pedersen_commitment_parse(ctx, &parsed.commitment, &out.commitment[0])) {
+        unsigned char ser[33];
+        size_t len;
+        parsed.fHasCommitment = secp256k1_pedersen_commitment_to_serialized_pubkey(&parsed.commitment, ser, &len) &&
+                                secp256k1_ec_pubkey_parse2(ctx, &parsed.commitmentPoint, ser, len);
+    }
+    return parsed.fHasPubKey || parsed.fHasCommitment;
+}
+}
+
+bool GetParsedTxOut(const COutPoint& outpoint, const CTxOut& out, CParsedTxOut& parsed)
+{
+    if (parsedTxOutCache.Get(outpoint, parsed)) return true;
+    parsed = CParsedTxOut();
+    if (!ParseTxOut(out, parsed)) return false;
+    parsedTxOutCache.Set(outpoint, parsed);
+    return true;
+}
+
+void InitParsedTxOutCache()
+{
+    int64_t nMaxSize = std::max((int64_t)0, GetArg("-maxparsedoutputcache", DEFAULT_MAX_PARSED_OUTPUT_CACHE_SIZE));
+    parsedTxOutCache.SetMaxSize(nMaxSize);
+    LogPrintf("Using a parsed output cache of %d entries\n", nMaxSize);
+}
+
+bool IsRingCTVerified(const CTransaction& tx, const CBlockIndex* pindex)
+{
+    uint256 entry;
+    if (!GetRingCTEntry(tx, pindex, entry)) return false;
+    return ringCTCache.Get(entry);
+}
+
+void SetRingCTVerified(const CTransaction& tx, const CBlockIndex* pindex)
+{
+    // Nothing is verified during the initial block download
+    if (IsInitialBlockDownload()) return;
+    uint256 entry;
+    if (!GetRingCTEntry(tx, pindex, entry)) return;
+    ringCTCache.Set(entry);
+}
+
+void SetRingMemberBlock(const uint256& txid, const uint256& hashBlock)
+{
+    ringCTCache.SetMemberBlock(txid, hashBlock);
+}
+
+void InitRingCTValidityCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, GetArg("-maxringctcachesize", DEFAULT_MAX_RINGCT_CACHE_SIZE)), MAX_MAX_RINGCT_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = ringCTCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for RingCT validity cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PRCYCOIN_RINGCTCACHE_H
+#define PRCYCOIN_RINGCTCACHE_H
+
+#include "primitives/transaction.h"
+#include "secp256k1_2.h"
+#include "secp256k1_commitment.h"
+
+#include <stdint.h>
+
+class CBlockIndex;
+
+/** Default number of outputs whose parsed curve points are kept */
+static const unsigned int DEFAULT_MAX_PARSED_OUTPUT_CACHE_SIZE = 200000;
+/** Default size of the RingCT validity cache in MiB */
+static const unsigned int DEFAULT_MAX_RINGCT_CACHE_SIZE = 8;
+/** Maximum RingCT validity cache size allowed */
+static const int64_t MAX_MAX_RINGCT_CACHE_SIZE = 1024;
+
+/**
+ * Curve points of a transaction output, decompressed once.
+ * Outputs are immutable for a given outpoint, so the same entry serves
+ * mempool acceptance, block connection and every ring the output is a decoy in.
+ */
+struct CParsedTxOut {
+    bool fHasPubKey;
+    secp256k1_pubkey2 pubKey;                 //!< one-time destination key P
+    secp256k1_pubkey2 hashPoint;              //!< Hp(P), as used in the ring signature
+    bool fHasCommitment;
+    secp256k1_pedersen_commitment commitment; //!< amount commitment, for range proofs
+    secp256k1_pubkey2 commitmentPoint;        //!< amount commitment as a curve point, for ring sums
+
+    CParsedTxOut() : fHasPubKey(false), fHasCommitment(false) {}
+};
+
+/**
+ * Get the parsed curve points of out, the output at outpoint.
+ * On a cache miss the output is parsed and the result cached. Returns false if
+ * neither the destination key nor the commitment could be parsed.
+ */
+bool GetParsedTxOut(const COutPoint& outpoint, const CTxOut& out, CParsedTxOut& parsed);
+
+/** Size the parsed output cache from -maxparsedoutputcache. */
+void InitParsedTxOutCache();
+
+/**
+ * RingCT validity cache: remembers transactions whose ring signature and
+ * bulletproof passed, so a transaction verified on mempool acceptance is not
+ * verified again in ConnectBlock or when a PoA block audits its PoS block.
+ *
+ * Entries are keyed by the txid, a hash of the blocks containing the ring
+ * members and the ring size rules in force at the validation height. A
+ * result is only reused while every ring member is still confirmed in the
+ * active chain under the same rules.
+ */
+bool IsRingCTVerified(const CTransaction& tx, const CBlockIndex* pindex);
+void SetRingCTVerified(const CTransaction& tx, const CBlockIndex* pindex);
+
+/** Remember that ring member transaction txid is confirmed in block hashBlock. */
+void SetRingMemberBlock(const uint256& txid, const uint256& hashBlock);
+
+/** Size the RingCT validity cache from -maxringctcachesize. */
+void InitRingCTValidityCache();
+
+#endif // PRCYCOIN_RINGCTCACHE_H
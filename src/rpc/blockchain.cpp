@@ -20,6 +20,7 @@
 #include <mutex>
 #include <numeric>
 #include <condition_variable>
+#include <fstream>
 #include "clientversion.h"
 
 
@@ -67,11 +68,12 @@ double GetDifficulty(const CBlockIndex* blockindex)
 UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 {
     UniValue result(UniValue::VOBJ);
+    std::shared_ptr<const CChainTipSnapshot> tip = GetChainTipSnapshot();
     result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    if (tip->Contains(blockindex))
+        confirmations = tip->nHeight - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("height", blockindex->nHeight));
     result.push_back(Pair("version", blockindex->nVersion));
@@ -86,20 +88,22 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 
     if (blockindex->pprev)
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex *pnext = chainActive.Next(blockindex);
+    const CBlockIndex* pnext = tip->Next(blockindex);
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+/** With fTxList false the "tx" array is left empty, for callers that write it themselves */
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false, bool fTxList = true)
 {
     UniValue result(UniValue::VOBJ);
+    std::shared_ptr<const CChainTipSnapshot> tip = GetChainTipSnapshot();
     result.push_back(Pair("hash", block.GetHash().GetHex()));
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    if (tip->Contains(blockindex))
+        confirmations = tip->nHeight - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
     result.push_back(Pair("height", blockindex->nHeight));
@@ -107,7 +111,8 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
     result.push_back(Pair("acc_checkpoint", block.nAccumulatorCheckpoint.GetHex()));
     UniValue txs(UniValue::VARR);
-    for (const CTransaction& tx : block.vtx) {
+    for (size_t i = 0; fTxList && i < block.vtx.size(); i++) {
+        const CTransaction& tx = block.vtx[i];
         if (txDetails) {
             UniValue objTx(UniValue::VOBJ);
             TxToJSON(tx, UINT256_ZERO, objTx);
@@ -125,7 +130,7 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 
     if (blockindex->pprev)
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex* pnext = chainActive.Next(blockindex);
+    const CBlockIndex* pnext = tip->Next(blockindex);
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
 
@@ -173,8 +178,53 @@ UniValue getsupply(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getsupply", "") + HelpExampleRpc("getsupply", ""));
 
+    return ValueFromAmount(GetChainTipSnapshot()->nMoneySupply);
+}
+
+UniValue getsupplyhistory(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 2)
+        throw std::runtime_error(
+            "getsupplyhistory height range\n"
+            "\nReturns the money supply after each of the blocks "
+            "\n[height, height+1, height+2, ..., height+range-1]\n"
+
+            "\nArguments:\n"
+            "1. height             (numeric, required) block height where the series starts.\n"
+            "2. range              (numeric, required) number of blocks to include.\n"
+
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"height\": n,         (numeric) The block height\n"
+            "    \"hash\": \"hash\",      (string) The block hash\n"
+            "    \"supply\": n,         (numeric) The money supply after this block\n"
+            "    \"delta\": n,          (numeric) The change in supply caused by this block\n"
+            "    \"mint\": n            (numeric) The amount minted by this block\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+
+            "\nExamples:\n" +
+            HelpExampleCli("getsupplyhistory", "1200000 1000") +
+            HelpExampleRpc("getsupplyhistory", "1200000, 1000"));
+
+    int heightStart, heightEnd;
+    validaterange(params, heightStart, heightEnd, 0);
+
+    UniValue ret(UniValue::VARR);
     LOCK(cs_main);
-    return ValueFromAmount(chainActive.Tip()->nMoneySupply);
+    for (CBlockIndex* pindex = chainActive[heightStart]; pindex && pindex->nHeight <= heightEnd; pindex = chainActive.Next(pindex)) {
+        CAmount nSupplyPrev = pindex->pprev ? pindex->pprev->nMoneySupply : 0;
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("height", pindex->nHeight));
+        entry.push_back(Pair("hash", pindex->GetBlockHash().GetHex()));
+        entry.push_back(Pair("supply", ValueFromAmount(pindex->nMoneySupply)));
+        entry.push_back(Pair("delta", ValueFromAmount(pindex->nMoneySupply - nSupplyPrev)));
+        entry.push_back(Pair("mint", ValueFromAmount(pindex->nMint)));
+        ret.push_back(entry);
+    }
+    return ret;
 }
 
 UniValue getmaxsupply(const UniValue& params, bool fHelp)
@@ -202,8 +252,7 @@ UniValue getblockcount(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getblockcount", "") + HelpExampleRpc("getblockcount", ""));
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    return GetChainTipSnapshot()->nHeight;
 }
 
 UniValue getbestblockhash(const UniValue& params, bool fHelp)
@@ -217,8 +266,7 @@ UniValue getbestblockhash(const UniValue& params, bool fHelp)
             "\nExamples\n" +
             HelpExampleCli("getbestblockhash", "") + HelpExampleRpc("getbestblockhash", ""));
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return GetChainTipSnapshot()->hashBlock.GetHex();
 }
 
 void RPCNotifyBlockChange(bool fInitialDownload, const CBlockIndex* pindex)
@@ -372,41 +420,47 @@ UniValue getdifficulty(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getdifficulty", "") + HelpExampleRpc("getdifficulty", ""));
 
-    LOCK(cs_main);
-    return GetDifficulty();
+    // GetDifficulty would fall back to chainActive, which needs cs_main
+    const CBlockIndex* pindexTip = GetChainTipSnapshot()->pindex;
+    if (!pindexTip)
+        return 1.0;
+    return GetDifficulty(pindexTip);
 }
 
 
+UniValue mempoolEntryToJSON(const CTxMemPoolEntry& e)
+{
+    AssertLockHeld(mempool.cs);
+    UniValue info(UniValue::VOBJ);
+    info.push_back(Pair("size", (int)e.GetTxSize()));
+    info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
+    info.push_back(Pair("time", e.GetTime()));
+    info.push_back(Pair("height", (int)e.GetHeight()));
+    info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
+    info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
+    const CTransaction& tx = e.GetTx();
+    std::set<std::string> setDepends;
+    for (const CTxIn& txin : tx.vin) {
+        if (mempool.exists(txin.prevout.hash))
+            setDepends.insert(txin.prevout.hash.ToString());
+    }
+
+    UniValue depends(UniValue::VARR);
+    for (const std::string& dep : setDepends) {
+        depends.push_back(dep);
+    }
+
+    info.push_back(Pair("depends", depends));
+    return info;
+}
+
 UniValue mempoolToJSON(bool fVerbose = false)
 {
     if (fVerbose) {
         LOCK(mempool.cs);
         UniValue o(UniValue::VOBJ);
-        for (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry : mempool.mapTx) {
-            const uint256& hash = entry.first;
-            const CTxMemPoolEntry& e = entry.second;
-            UniValue info(UniValue::VOBJ);
-            info.push_back(Pair("size", (int)e.GetTxSize()));
-            info.push_back(Pair("fee", ValueFromAmount(e.GetFee())));
-            info.push_back(Pair("time", e.GetTime()));
-            info.push_back(Pair("height", (int)e.GetHeight()));
-            info.push_back(Pair("startingpriority", e.GetPriority(e.GetHeight())));
-            info.push_back(Pair("currentpriority", e.GetPriority(chainActive.Height())));
-            const CTransaction& tx = e.GetTx();
-            std::set<std::string> setDepends;
-            for (const CTxIn& txin : tx.vin) {
-                if (mempool.exists(txin.prevout.hash))
-                    setDepends.insert(txin.prevout.hash.ToString());
-            }
-
-            UniValue depends(UniValue::VARR);
-            for (const std::string& dep : setDepends) {
-                depends.push_back(dep);
-            }
-
-            info.push_back(Pair("depends", depends));
-            o.push_back(Pair(hash.ToString(), info));
-        }
+        for (const PAIRTYPE(uint256, CTxMemPoolEntry) & entry : mempool.mapTx)
+            o.push_back(Pair(entry.first.ToString(), mempoolEntryToJSON(entry.second)));
         return o;
     } else {
         std::vector<uint256> vtxid;
@@ -459,6 +513,40 @@ UniValue getrawmempool(const UniValue& params, bool fHelp)
     return mempoolToJSON(fVerbose);
 }
 
+bool getrawmempool_stream(const UniValue& params, RPCResultStream& stream)
+{
+    if (params.size() > 1)
+        return false;
+
+    // Only the verbose result is large enough to be worth streaming
+    if (params.size() == 0 || !params[0].get_bool())
+        return false;
+
+    // Entries are written one at a time, without holding the locks while the client takes them
+    std::vector<uint256> vtxid;
+    mempool.queryHashes(vtxid);
+    stream.Write("{");
+    bool fFirst = true;
+    for (const uint256& hash : vtxid) {
+        if (stream.IsClosed())
+            break;
+        std::string strEntry;
+        {
+            LOCK2(cs_main, mempool.cs);
+            auto it = mempool.mapTx.find(hash);
+            if (it == mempool.mapTx.end())
+                continue; // removed since the hashes were taken
+            strEntry = mempoolEntryToJSON(it->second).write();
+        }
+        if (!fFirst)
+            stream.Write(",");
+        fFirst = false;
+        stream.Write(UniValue(hash.ToString()).write() + ":" + strEntry);
+    }
+    stream.Write("}");
+    return true;
+}
+
 
 UniValue getblockhash(const UniValue& params, bool fHelp)
 {
@@ -473,16 +561,36 @@ UniValue getblockhash(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getblockhash", "1000") + HelpExampleRpc("getblockhash", "1000"));
 
-    LOCK(cs_main);
+    std::shared_ptr<const CChainTipSnapshot> tip = GetChainTipSnapshot();
 
     int nHeight = params[0].get_int();
-    if (nHeight < 0 || nHeight > chainActive.Height())
+    if (nHeight < 0 || nHeight > tip->nHeight)
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
 
-    CBlockIndex* pblockindex = chainActive[nHeight];
+    const CBlockIndex* pblockindex = tip->pindex->GetAncestor(nHeight);
     return pblockindex->GetBlockHash().GetHex();
 }
 
+/** Read the block whose hash is given as an RPC argument */
+static std::shared_ptr<const CBlock> ReadBlockParam(const UniValue& param, CBlockIndex*& pblockindex)
+{
+    std::string strHash = param.get_str();
+    uint256 hash(uint256S(strHash));
+
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = mi->second;
+    }
+
+    std::shared_ptr<const CBlock> pblock = ReadBlockFromDisk(pblockindex);
+    if (!pblock)
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    return pblock;
+}
+
 UniValue getblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
@@ -519,30 +627,70 @@ UniValue getblock(const UniValue& params, bool fHelp)
             "\nExamples:\n" +
             HelpExampleCli("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"") + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\""));
 
-    std::string strHash = params[0].get_str();
-    uint256 hash(uint256S(strHash));
-
     bool fVerbose = true;
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-
-    CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
-    if (!ReadBlockFromDisk(block, pblockindex))
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    CBlockIndex* pblockindex = NULL;
+    std::shared_ptr<const CBlock> pblock = ReadBlockParam(params[0], pblockindex);
 
     if (!fVerbose) {
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
+        ssBlock << *pblock;
         std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
         return strHex;
     }
 
-    return blockToJSON(block, pblockindex);
+    return blockToJSON(*pblock, pblockindex);
+}
+
+bool getblock_stream(const UniValue& params, RPCResultStream& stream)
+{
+    if (params.size() < 1 || params.size() > 2)
+        return false;
+
+    bool fVerbose = true;
+    if (params.size() > 1)
+        fVerbose = params[1].get_bool();
+
+    CBlockIndex* pblockindex = NULL;
+    std::shared_ptr<const CBlock> pblock = ReadBlockParam(params[0], pblockindex);
+
+    if (!fVerbose) {
+        // The hex string is written a slice at a time
+        static const size_t nSliceSize = 32 * 1024;
+        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
+        ssBlock << *pblock;
+        stream.Write("\"");
+        for (CDataStream::const_iterator it = ssBlock.begin(); it != ssBlock.end() && !stream.IsClosed();) {
+            CDataStream::const_iterator end = it + std::min(nSliceSize, (size_t)(ssBlock.end() - it));
+            stream.Write(HexStr(it, end));
+            it = end;
+        }
+        stream.Write("\"");
+        return true;
+    }
+
+    // The transaction ids are written from the block one at a time; the other members are small
+    UniValue result = blockToJSON(*pblock, pblockindex, false, false);
+    const std::vector<std::string>& keys = result.getKeys();
+    const std::vector<UniValue>& values = result.getValues();
+    stream.Write("{");
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (i > 0)
+            stream.Write(",");
+        stream.Write(UniValue(keys[i]).write() + ":");
+        if (keys[i] != "tx") {
+            stream.Write(values[i].write());
+            continue;
+        }
+        stream.Write("[");
+        for (size_t n = 0; n < pblock->vtx.size() && !stream.IsClosed(); n++)
+            stream.Write(std::string(n > 0 ? ",\"" : "\"") + pblock->vtx[n].GetHash().GetHex() + "\"");
+        stream.Write("]");
+    }
+    stream.Write("}");
+    return true;
 }
 
 UniValue getblockheader(const UniValue& params, bool fHelp)
@@ -577,14 +725,14 @@ UniValue getblockheader(const UniValue& params, bool fHelp)
     if (params.size() > 1)
         fVerbose = params[1].get_bool();
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-
-    CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
-
-    if (!ReadBlockFromDisk(block, pblockindex))
-        throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
+    CBlockIndex* pblockindex = NULL;
+    {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hash);
+        if (mi == mapBlockIndex.end())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        pblockindex = mi->second;
+    }
 
     if (!fVerbose) {
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
@@ -983,6 +1131,135 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp)
     return mempoolInfoToJSON();
 }
 
+UniValue getblockcacheinfo(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 0)
+        throw std::runtime_error(
+            "getblockcacheinfo\n"
+            "\nReturns statistics about reading blocks from disk.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"size\": n,            (numeric) Number of blocks in the recently read block cache\n"
+            "  \"maxsize\": n,         (numeric) Maximum number of cached blocks\n"
+            "  \"hits\": n,            (numeric) Reads served from the cache\n"
+            "  \"misses\": n,          (numeric) Reads not found in the cache\n"
+            "  \"hitrate\": x.xxx,     (numeric) Fraction of reads served from the cache\n"
+            "  \"queuereads\": n,      (numeric) Blocks read before they were written to disk\n"
+            "  \"mappedreads\": n,     (numeric) Blocks read from a memory mapped block file\n"
+            "  \"filereads\": n,       (numeric) Blocks read from the block file being written to\n"
+            "  \"mappedfiles\": n,     (numeric) Number of block files currently mapped\n"
+            "  \"txposcache\": {       (json object) Transaction index entries kept in memory\n"
+            "    \"size\": n,          (numeric) Number of cached entries\n"
+            "    \"hits\": n,          (numeric) Transaction index reads saved\n"
+            "    \"misses\": n         (numeric) Transaction index reads\n"
+            "  },\n"
+            "  \"txcache\": {          (json object) Transactions read through the transaction index kept in memory\n"
+            "    \"size\": n,          (numeric) Number of cached transactions\n"
+            "    \"hits\": n,          (numeric) Lookups served from the cache\n"
+            "    \"misses\": n         (numeric) Lookups not found in the cache\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getblockcacheinfo", "") + HelpExampleRpc("getblockcacheinfo", ""));
+
+    CBlockReadStats stats = GetBlockReadStats();
+    uint64_t nLookups = stats.nHits + stats.nMisses;
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("size", (uint64_t)stats.nCacheSize));
+    ret.push_back(Pair("maxsize", (uint64_t)stats.nCacheMaxSize));
+    ret.push_back(Pair("hits", stats.nHits));
+    ret.push_back(Pair("misses", stats.nMisses));
+    ret.push_back(Pair("hitrate", nLookups ? (double)stats.nHits / nLookups : 0.0));
+    ret.push_back(Pair("queuereads", stats.nQueueReads));
+    ret.push_back(Pair("mappedreads", stats.nMappedReads));
+    ret.push_back(Pair("filereads", stats.nFileReads));
+    ret.push_back(Pair("mappedfiles", (uint64_t)stats.nMappedFiles));
+    UniValue txpos(UniValue::VOBJ);
+    txpos.push_back(Pair("size", (uint64_t)stats.nTxPosCacheSize));
+    txpos.push_back(Pair("hits", stats.nTxPosHits));
+    txpos.push_back(Pair("misses", stats.nTxPosMisses));
+    ret.push_back(Pair("txposcache", txpos));
+    UniValue tx(UniValue::VOBJ);
+    tx.push_back(Pair("size", (uint64_t)stats.nTxCacheSize));
+    tx.push_back(Pair("hits", stats.nTxHits));
+    tx.push_back(Pair("misses", stats.nTxMisses));
+    ret.push_back(Pair("txcache", tx));
+    return ret;
+}
+
+UniValue replaygettransactiontrace(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() < 1 || params.size() > 2)
+        throw std::runtime_error(
+            "replaygettransactiontrace \"file\" ( passes )\n"
+            "\nLooks up every txid of a trace recorded with -gettransactiontrace and times the lookups.\n"
+            "\nArguments:\n"
+            "1. \"file\"    (string, required) The trace, relative to the data directory unless absolute\n"
+            "2. passes    (numeric, optional, default=1) Number of times to replay the trace\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"lookups\": n,          (numeric) Number of txids in the trace\n"
+            "  \"passes\": [            (array) One entry per replay\n"
+            "    {\n"
+            "      \"found\": n,        (numeric) Transactions found\n"
+            "      \"elapsed\": n,      (numeric) Time taken in milliseconds\n"
+            "      \"perlookup\": x.x,  (numeric) Average time per lookup in microseconds\n"
+            "      \"txhits\": n,       (numeric) Lookups served from the transaction cache\n"
+            "      \"txposhits\": n,    (numeric) Transaction index reads saved\n"
+            "      \"mappedreads\": n,  (numeric) Reads from a memory mapped block file\n"
+            "      \"filereads\": n     (numeric) Reads from the block file being written to\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("replaygettransactiontrace", "\"txtrace.log\" 3") + HelpExampleRpc("replaygettransactiontrace", "\"txtrace.log\", 3"));
+
+    fs::path path = fs::absolute(params[0].get_str(), GetDataDir());
+    int nPasses = params.size() > 1 ? params[1].get_int() : 1;
+    if (nPasses < 1 || nPasses > 100)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "passes must be between 1 and 100");
+
+    std::ifstream file(path.string().c_str());
+    if (!file)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Can't open " + path.string());
+    std::vector<uint256> vTrace;
+    std::string strLine;
+    while (std::getline(file, strLine)) {
+        if (strLine.size() == 64 && IsHex(strLine))
+            vTrace.push_back(uint256S(strLine));
+    }
+
+    UniValue passes(UniValue::VARR);
+    for (int i = 0; i < nPasses; i++) {
+        CBlockReadStats before = GetBlockReadStats();
+        int64_t nStart = GetTimeMicros();
+        uint64_t nFound = 0;
+        for (const uint256& hash : vTrace) {
+            CTransaction tx;
+            uint256 hashBlock;
+            if (GetTransaction(hash, tx, hashBlock, true))
+                nFound++;
+        }
+        int64_t nElapsed = GetTimeMicros() - nStart;
+        CBlockReadStats after = GetBlockReadStats();
+
+        UniValue pass(UniValue::VOBJ);
+        pass.push_back(Pair("found", nFound));
+        pass.push_back(Pair("elapsed", nElapsed / 1000));
+        pass.push_back(Pair("perlookup", vTrace.empty() ? 0.0 : (double)nElapsed / vTrace.size()));
+        pass.push_back(Pair("txhits", after.nTxHits - before.nTxHits));
+        pass.push_back(Pair("txposhits", after.nTxPosHits - before.nTxPosHits));
+        pass.push_back(Pair("mappedreads", after.nMappedReads - before.nMappedReads));
+        pass.push_back(Pair("filereads", after.nFileReads - before.nFileReads));
+        passes.push_back(pass);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("lookups", (uint64_t)vTrace.size()));
+    ret.push_back(Pair("passes", passes));
+    return ret;
+}
+
 UniValue invalidateblock(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() != 1)
@@ -1236,13 +1513,7 @@ UniValue getlastpoablock(const UniValue& params, bool fHelp)
 
     //Find the previous PoA block
     CBlock block;
-    CBlockIndex* pindex = chainActive.Tip();
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(chainActive.Tip(), Params().START_POA_BLOCK());
     ReadBlockFromDisk(block, pindex);
 
     return blockToJSON(block, pindex);
@@ -1262,13 +1533,7 @@ UniValue getlastpoablockhash(const UniValue& params, bool fHelp)
     LOCK(cs_main);
 
     //Find the previous PoA block
-    CBlockIndex* pindex = chainActive.Tip();
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(chainActive.Tip(), Params().START_POA_BLOCK());
 
     return pindex->GetBlockHash().GetHex();
 }
@@ -1287,13 +1552,7 @@ UniValue getlastpoablockheight(const UniValue& params, bool fHelp)
     LOCK(cs_main);
 
     //Find the previous PoA block
-    CBlockIndex* pindex = chainActive.Tip();
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(chainActive.Tip(), Params().START_POA_BLOCK());
 
     return pindex->nHeight;
 }
@@ -1312,13 +1571,7 @@ UniValue getlastpoablocktime(const UniValue& params, bool fHelp)
     LOCK(cs_main);
 
     //Find the previous PoA block
-    CBlockIndex* pindex = chainActive.Tip();
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(chainActive.Tip(), Params().START_POA_BLOCK());
 
     int nTime = pindex->nTime;
 
@@ -1341,13 +1594,7 @@ UniValue getlastpoaauditedpos(const UniValue& params, bool fHelp)
     int lastPoSHeight = 0;
     //Find the previous PoA block
     CBlock block;
-    CBlockIndex* pindex = chainActive.Tip();
-    while (pindex->nHeight > Params().START_POA_BLOCK()) {
-        if (pindex->GetBlockHeader().IsPoABlockByVersion()) {
-            break;
-        }
-        pindex = pindex->pprev;
-    }
+    CBlockIndex* pindex = FindLastPoABlock(chainActive.Tip(), Params().START_POA_BLOCK());
     ReadBlockFromDisk(block, pindex);
     for (size_t i = 0; i < block.posBlocksAudited.size(); i++) {
         lastPoSHeight = block.posBlocksAudited[i].height;
@@ -41,6 +41,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"rescanwallettransactions", 0},
         {"sendtostealthaddress", 1},
         {"sendtostealthaddress", 2},
+        {"sendmanybatch", 0},
         {"sendalltostealthaddress", 1},
         {"settxfee", 0},
         {"getreceivedbyaddress", 1},
@@ -101,9 +102,12 @@ static const CRPCConvertParam vRPCConvertParams[] =
         {"logging", 1},
         {"getblock", 1},
         {"getblockheader", 1},
+        {"replaygettransactiontrace", 1},
         {"getblockindexstats", 0},
         {"getblockindexstats", 1},
         {"getblockindexstats", 2},
+        {"getsupplyhistory", 0},
+        {"getsupplyhistory", 1},
         {"gettransaction", 1},
         {"getrawtransaction", 1},
         {"createrawtransaction", 0},
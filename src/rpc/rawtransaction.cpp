@@ -65,17 +65,29 @@ void PoSBlockInfoToJSON(const uint256 hashBlock, int64_t nTime, int height, UniV
 
 void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
 {
+    // without the wallet, this lookup is all that needs cs_main
+    CBlockIndex* pindexBlock = NULL;
+    if (!hashBlock.IsNull()) {
+        LOCK(cs_main);
+        BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
+        if (mi != mapBlockIndex.end())
+            pindexBlock = mi->second;
+    }
+
     entry.push_back(Pair("txid", tx.GetHash().GetHex()));
     entry.push_back(Pair("version", tx.nVersion));
     entry.push_back(Pair("size", (int)::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION)));
     entry.push_back(Pair("locktime", (int64_t)tx.nLockTime));
     entry.push_back(Pair("txfee", ValueFromAmount(tx.nTxFee)));
+#ifdef ENABLE_WALLET
+    // the wallet code below reads chain state and expects cs_main to be taken before cs_wallet
+    LOCK2(cs_main, pwalletMain->cs_wallet);
+#endif
     if (tx.hasPaymentID && pwalletMain->IsMine(tx)) {
         entry.push_back(Pair("paymentid", tx.paymentID));
     }
     entry.push_back(Pair("txType", (int64_t)tx.txType));
 #ifdef ENABLE_WALLET
-    LOCK(pwalletMain->cs_wallet);
     entry.push_back(Pair("direction", pwalletMain->GetTransactionType(tx)));
 #endif
     UniValue vin(UniValue::VARR);
@@ -182,13 +194,12 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
 
     if (!hashBlock.IsNull()) {
         entry.push_back(Pair("blockhash", hashBlock.GetHex()));
-        BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
-        if (mi != mapBlockIndex.end() && (*mi).second) {
-            CBlockIndex* pindex = (*mi).second;
-            if (chainActive.Contains(pindex)) {
-                entry.push_back(Pair("confirmations", 1 + chainActive.Height() - pindex->nHeight));
-                entry.push_back(Pair("time", pindex->GetBlockTime()));
-                entry.push_back(Pair("blocktime", pindex->GetBlockTime()));
+        if (pindexBlock) {
+            std::shared_ptr<const CChainTipSnapshot> tip = GetChainTipSnapshot();
+            if (tip->Contains(pindexBlock)) {
+                entry.push_back(Pair("confirmations", 1 + tip->nHeight - pindexBlock->nHeight));
+                entry.push_back(Pair("time", pindexBlock->GetBlockTime()));
+                entry.push_back(Pair("blocktime", pindexBlock->GetBlockTime()));
             }
             else
                 entry.push_back(Pair("confirmations", 0));
@@ -322,8 +333,6 @@ UniValue getrawtransaction(const UniValue& params, bool fHelp)
             + HelpExampleCli("getrawtransaction", "\"mytxid\" true \"myblockhash\"")
         );
 
-    LOCK(cs_main);
-
     bool in_active_chain = true;
     uint256 hash = ParseHashV(params[0], "parameter 1");
     CBlockIndex* blockindex = nullptr;
@@ -335,12 +344,15 @@ UniValue getrawtransaction(const UniValue& params, bool fHelp)
 
     if (!params[2].isNull()) {
         uint256 blockhash = ParseHashV(params[2], "parameter 3");
-        BlockMap::iterator it = mapBlockIndex.find(blockhash);
-        if (it == mapBlockIndex.end()) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block hash not found");
+        {
+            LOCK(cs_main);
+            BlockMap::iterator it = mapBlockIndex.find(blockhash);
+            if (it == mapBlockIndex.end()) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block hash not found");
+            }
+            blockindex = it->second;
         }
-        blockindex = it->second;
-        in_active_chain = chainActive.Contains(blockindex);
+        in_active_chain = GetChainTipSnapshot()->Contains(blockindex);
     }
 
     CTransaction tx;
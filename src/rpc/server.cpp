@@ -15,6 +15,7 @@
 #include "random.h"
 #include "sync.h"
 #include "guiinterface.h"
+#include "httpserver.h"
 #include "util.h"
 #include "utilstrencodings.h"
 
@@ -22,6 +23,12 @@
 #include "wallet/wallet.h"
 #endif
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+
 #include <boost/bind.hpp>
 #include <boost/iostreams/concepts.hpp>
 #include <boost/iostreams/stream.hpp>
@@ -288,6 +295,7 @@ static const CRPCCommand vRPCCommands[] =
         /* Block chain and UTXO */
         {"blockchain", "getsupply", &getsupply, true, false, false},
         {"blockchain", "getmaxsupply", &getmaxsupply, true, false, false},
+        {"blockchain", "getsupplyhistory", &getsupplyhistory, true, false, false},
         {"blockchain", "getblockchaininfo", &getblockchaininfo, true, false, false},
         {"blockchain", "getbestblockhash", &getbestblockhash, true, false, false},
         {"blockchain", "getblockcount", &getblockcount, true, false, false},
@@ -301,6 +309,7 @@ static const CRPCCommand vRPCCommands[] =
         {"blockchain", "getlastpoaauditedpos", &getlastpoaauditedpos, true, false, false},
         {"blockchain", "setmaxreorgdepth", &setmaxreorgdepth, true, false, false},
         {"blockchain", "resyncfrom", &resyncfrom, true, false, false},
+        {"blockchain", "getblockcacheinfo", &getblockcacheinfo, true, false, false},
         {"blockchain", "getblockheader", &getblockheader, false, false, false},
         {"blockchain", "getchaintips", &getchaintips, true, false, false},
         {"blockchain", "getdifficulty", &getdifficulty, true, false, false},
@@ -356,6 +365,7 @@ static const CRPCCommand vRPCCommands[] =
         { "hidden", "waitfornewblock", &waitfornewblock, true, true, false},
         { "hidden", "waitforblock", &waitforblock, true, true, false},
         { "hidden", "waitforblockheight", &waitforblockheight, true, true, false},
+        { "hidden", "replaygettransactiontrace", &replaygettransactiontrace, true, false, false},
 
         /* Prcycoin features */
          {"prcycoin", "masternode", &masternode, true, true, false},
@@ -400,6 +410,7 @@ static const CRPCCommand vRPCCommands[] =
         {"wallet", "getdecoyconfirmation", &getdecoyconfirmation, true, false, true},
         {"wallet", "decodestealthaddress", &decodestealthaddress, true, false, true},
         {"wallet", "sendtostealthaddress", &sendtostealthaddress, false, false, true},
+        {"wallet", "sendmanybatch", &sendmanybatch, false, false, true},
         {"wallet", "sendalltostealthaddress", &sendalltostealthaddress, false, false, true},
         {"wallet", "getbalance", &getbalance, false, false, true},
         {"wallet", "getbalances", &getbalances, false, false, true},
@@ -448,6 +459,13 @@ static const CRPCCommand vRPCCommands[] =
 #endif // ENABLE_WALLET
         };
 
+/** Commands whose large results are sent to single JSON-RPC requests as they are written */
+static const std::pair<const char*, rpcstreamfn_type> vRPCStreamCommands[] =
+    {
+        {"getblock", &getblock_stream},
+        {"getrawmempool", &getrawmempool_stream},
+        };
+
 CRPCTable::CRPCTable() {
     unsigned int vcidx;
     for (vcidx = 0; vcidx < (sizeof(vRPCCommands) / sizeof(vRPCCommands[0])); vcidx++) {
@@ -456,6 +474,8 @@ CRPCTable::CRPCTable() {
         pcmd = &vRPCCommands[vcidx];
         mapCommands[pcmd->name] = pcmd;
     }
+    for (vcidx = 0; vcidx < (sizeof(vRPCStreamCommands) / sizeof(vRPCStreamCommands[0])); vcidx++)
+        mapStreamCommands[vRPCStreamCommands[vcidx].first] = vRPCStreamCommands[vcidx].second;
 }
 
 const CRPCCommand *CRPCTable::operator[](const std::string &name) const {
@@ -558,10 +578,95 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
+/**
+ * Read-only commands that answer from the chain tip snapshot, the block index and
+ * the block files. Consecutive batch entries calling them are run concurrently.
+ */
+static const std::set<std::string> setConcurrentBatchCommands = {
+    "getbestblockhash", "getblock", "getblockcount", "getblockhash", "getblockheader",
+    "getdifficulty", "getmaxsupply", "getrawtransaction", "getsupply",
+};
+
+static bool IsConcurrentBatchRequest(const UniValue& req)
+{
+    if (!req.isObject())
+        return false;
+    const UniValue& valMethod = find_value(req.get_obj(), "method");
+    return valMethod.isStr() && setConcurrentBatchCommands.count(valMethod.get_str());
+}
+
+/** A run of concurrent batch entries, shared with the HTTP workers helping with it */
+struct CConcurrentBatchRun {
+    const UniValue* pvReq;
+    std::vector<UniValue>* pvResults;
+    unsigned int nEnd;
+    std::atomic<unsigned int> nNext;
+    std::mutex cs;
+    std::condition_variable cond;
+    int nRunning; //!< helpers executing entries of this run
+
+    /** Execute entries until none is left. Entries are only taken before the run has ended. */
+    void Work()
+    {
+        for (unsigned int i = nNext++; i < nEnd; i = nNext++)
+            (*pvResults)[i] = JSONRPCExecOne((*pvReq)[i]);
+    }
+
+    void Help()
+    {
+        {
+            std::lock_guard<std::mutex> lock(cs);
+            nRunning++;
+        }
+        Work();
+        std::lock_guard<std::mutex> lock(cs);
+        nRunning--;
+        cond.notify_all();
+    }
+};
+
 std::string JSONRPCExecBatch(const UniValue &vReq) {
+    std::vector<UniValue> vResults(vReq.size());
+    const unsigned int nThreads = std::max((int64_t)1, GetArg("-rpcthreads", DEFAULT_HTTP_THREADS));
+
+    unsigned int reqIdx = 0;
+    while (reqIdx < vReq.size()) {
+        // Other commands run one at a time, in the order of the batch
+        unsigned int nEnd = reqIdx;
+        while (nEnd < vReq.size() && IsConcurrentBatchRequest(vReq[nEnd]))
+            nEnd++;
+        if (nEnd - reqIdx < 2 || nThreads < 2) {
+            nEnd = std::max(nEnd, reqIdx + 1);
+            for (; reqIdx < nEnd; reqIdx++)
+                vResults[reqIdx] = JSONRPCExecOne(vReq[reqIdx]);
+            continue;
+        }
+
+        // Idle HTTP workers help with the run, so all batches share the -rpcthreads
+        // threads. This thread works through the run too and only waits for helpers
+        // that have started: one still queued after the run finds nothing left to do.
+        std::shared_ptr<CConcurrentBatchRun> run = std::make_shared<CConcurrentBatchRun>();
+        run->pvReq = &vReq;
+        run->pvResults = &vResults;
+        run->nEnd = nEnd;
+        run->nNext = reqIdx;
+        run->nRunning = 0;
+        for (unsigned int i = 1; i < std::min(nThreads, nEnd - reqIdx); i++) {
+            if (!EnqueueHTTPWork([run]() { run->Help(); }))
+                break;
+        }
+        run->Work();
+        {
+            std::unique_lock<std::mutex> lock(run->cs);
+            while (run->nRunning > 0)
+                run->cond.wait(lock);
+        }
+        reqIdx = nEnd;
+    }
+
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    for (const UniValue& result : vResults)
+        ret.push_back(result);
 
     return ret.write() + "\n";
 }
@@ -590,6 +695,27 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &params
     g_rpcSignals.PostCommand(*pcmd);
 }
 
+bool CRPCTable::executeStreamed(const std::string &strMethod, const UniValue &params, RPCResultStream &stream) const {
+    std::map<std::string, rpcstreamfn_type>::const_iterator it = mapStreamCommands.find(strMethod);
+    const CRPCCommand *pcmd = tableRPC[strMethod];
+    if (it == mapStreamCommands.end() || !pcmd)
+        return false;
+
+    // Return immediately if in warmup
+    std::string strWarmupStatus;
+    if (RPCIsInWarmup(&strWarmupStatus)) {
+        throw JSONRPCError(RPC_IN_WARMUP, "RPC in warm-up: " + strWarmupStatus);
+    }
+
+    g_rpcSignals.PreCommand(*pcmd);
+
+    try {
+        return it->second(params, stream);
+    } catch (const std::exception& e) {
+        throw JSONRPCError(RPC_MISC_ERROR, e.what());
+    }
+}
+
 std::vector <std::string> CRPCTable::listCommands() const {
     std::vector <std::string> commandList;
     typedef std::map<std::string, const CRPCCommand *> commandMap;
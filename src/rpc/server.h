@@ -115,6 +115,29 @@ void RPCRunLater(const std::string& name, boost::function<void(void)> func, int6
 
 typedef UniValue(*rpcfn_type)(const UniValue& params, bool fHelp);
 
+/**
+ * Sink for an RPC result that is sent as it is written instead of being
+ * returned as one UniValue.
+ */
+class RPCResultStream
+{
+public:
+    virtual ~RPCResultStream() {}
+
+    /** Append JSON text to the result */
+    virtual void Write(const std::string& str) = 0;
+
+    /** Whether the client disconnected, so there is no point producing more */
+    virtual bool IsClosed() const = 0;
+};
+
+/**
+ * Streaming variant of an RPC. Returns false without writing anything when the
+ * call is better answered by the regular actor (help, small results). Errors
+ * must be thrown before the first Write: after that the reply can only be cut off.
+ */
+typedef bool (*rpcstreamfn_type)(const UniValue& params, RPCResultStream& stream);
+
 class CRPCCommand
 {
 public:
@@ -133,6 +156,7 @@ class CRPCTable
 {
 private:
     std::map<std::string, const CRPCCommand*> mapCommands;
+    std::map<std::string, rpcstreamfn_type> mapStreamCommands;
 
 public:
     CRPCTable();
@@ -148,6 +172,14 @@ public:
      */
     UniValue execute(const std::string &method, const UniValue &params) const;
 
+    /**
+     * Execute a method that can write its result to a stream.
+     * @returns false if the method has no streaming variant or it declined the call;
+     * nothing was written then and the method should be run with execute.
+     * @throws an exception (UniValue) when an error happens.
+     */
+    bool executeStreamed(const std::string &method, const UniValue &params, RPCResultStream &stream) const;
+
     /**
     * Returns a list of registered commands
     * @returns List of registered commands.
@@ -259,6 +291,7 @@ extern UniValue setdecoyconfirmation(const UniValue& params, bool fHelp);
 extern UniValue getdecoyconfirmation(const UniValue& params, bool fHelp);
 extern UniValue decodestealthaddress(const UniValue& params, bool fHelp);
 extern UniValue sendtostealthaddress(const UniValue& params, bool fHelp);
+extern UniValue sendmanybatch(const UniValue& params, bool fHelp);
 extern UniValue sendalltostealthaddress(const UniValue& params, bool fHelp);
 extern UniValue createprivacysubaddress(const UniValue& params, bool fHelp);
 extern UniValue getwalletinfo(const UniValue& params, bool fHelp);
@@ -287,6 +320,7 @@ extern UniValue sendrawtransaction(const UniValue& params, bool fHelp);
 
 extern UniValue getsupply(const UniValue& params, bool fHelp); // in rpc/blockchain.cpp
 extern UniValue getmaxsupply(const UniValue& params, bool fHelp); // in rpc/blockchain.cpp
+extern UniValue getsupplyhistory(const UniValue& params, bool fHelp); // in rpc/blockchain.cpp
 extern UniValue getblockcount(const UniValue& params, bool fHelp); // in rpc/blockchain.cpp
 extern UniValue getbestblockhash(const UniValue& params, bool fHelp);
 extern UniValue waitfornewblock(const UniValue& params, bool fHelp);
@@ -295,7 +329,10 @@ extern UniValue waitforblockheight(const UniValue& params, bool fHelp);
 extern UniValue getdifficulty(const UniValue& params, bool fHelp);
 extern UniValue settxfee(const UniValue& params, bool fHelp);
 extern UniValue getmempoolinfo(const UniValue& params, bool fHelp);
+extern UniValue getblockcacheinfo(const UniValue& params, bool fHelp);
+extern UniValue replaygettransactiontrace(const UniValue& params, bool fHelp);
 extern UniValue getrawmempool(const UniValue& params, bool fHelp);
+extern bool getrawmempool_stream(const UniValue& params, RPCResultStream& stream);
 extern UniValue getblockhash(const UniValue& params, bool fHelp);
 extern UniValue getlastpoablock(const UniValue& params, bool fHelp);
 extern UniValue getlastpoablockhash(const UniValue& params, bool fHelp);
@@ -305,6 +342,7 @@ extern UniValue getlastpoaauditedpos(const UniValue& params, bool fHelp);
 extern UniValue setmaxreorgdepth(const UniValue& params, bool fHelp);
 extern UniValue resyncfrom(const UniValue& params, bool fHelp);
 extern UniValue getblock(const UniValue& params, bool fHelp);
+extern bool getblock_stream(const UniValue& params, RPCResultStream& stream);
 extern UniValue getblockheader(const UniValue& params, bool fHelp);
 extern UniValue getblockindexstats(const UniValue& params, bool fHelp);
 extern UniValue getfeeinfo(const UniValue& params, bool fHelp);
@@ -0,0 +1,26 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "saltedhasher.h"
+
+#include "crypto/common.h"
+#include "crypto/sha256.h"
+#include "pubkey.h"
+#include "random.h"
+
+CSaltedHasher::CSaltedHasher() : salt(GetRandHash()) {}
+
+size_t CSaltedHasher::operator()(const CPubKey& pubKey) const
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(salt.begin(), 32).Write(pubKey.begin(), pubKey.size()).Finalize(hash);
+    return ReadLE64(hash);
+}
+
+size_t CSaltedHasher::operator()(const CScript& script) const
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(salt.begin(), 32).Write(script.data(), script.size()).Finalize(hash);
+    return ReadLE64(hash);
+}
@@ -0,0 +1,37 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PRCYCOIN_SALTEDHASHER_H
+#define PRCYCOIN_SALTEDHASHER_H
+
+#include "primitives/transaction.h"
+#include "uint256.h"
+
+class CPubKey;
+
+/**
+ * Salted hasher for unordered maps whose keys peers can choose, such as the
+ * masternode, budget and SwiftX maps. Each instance draws its own salt.
+ */
+class CSaltedHasher
+{
+private:
+    uint256 salt;
+
+public:
+    CSaltedHasher();
+
+    size_t operator()(const uint256& key) const
+    {
+        return key.GetHash(salt);
+    }
+    size_t operator()(const COutPoint& outpoint) const
+    {
+        return outpoint.hash.GetHash(salt) ^ outpoint.n;
+    }
+    size_t operator()(const CPubKey& pubKey) const;
+    size_t operator()(const CScript& script) const;
+};
+
+#endif // PRCYCOIN_SALTEDHASHER_H
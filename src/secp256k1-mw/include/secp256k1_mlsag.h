@@ -0,0 +1,136 @@
+#ifndef _SECP256K1_MLSAG_
+# define _SECP256K1_MLSAG_
+
+# include "secp256k1_2.h"
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/** Multilayered linkable spontaneous anonymous group (MLSAG) signatures as used
+ *  by PRCY RingCT transactions.
+ *
+ *  A ring has n_rows layers (one per input plus the commitment balancing row)
+ *  and n_cols members per layer. Public keys are passed column by column as
+ *  33-byte compressed points: the key of row i in column j starts at
+ *  pubkeys + 33 * (j * n_rows + i). Scalars of the signature use the same
+ *  layout with 32 bytes per entry. Key images are given per row.
+ *
+ *  For every column j the challenge of the next column is
+ *      c[j + 1] = SHA256d(L[0][j] || R[0][j] || ... || L[n_rows - 1][j] || R[n_rows - 1][j] || msg32)
+ *  where L[i][j] = c[j] * P[i][j] + s[i][j] * G and
+ *        R[i][j] = s[i][j] * Hp(P[i][j]) + c[j] * I[i],
+ *  Hp being the successive double-SHA256 hash to point of the compressed key.
+ */
+
+/** Compute the key image I = x * Hp(P) of a public key P = x * G.
+ *
+ *  Returns: 1 on success, 0 if the public key could not be parsed or the secret
+ *           key is zero or overflows.
+ *  Args:    ctx:        a secp256k1 context object.
+ *  Out:     keyimage33: pointer to a 33-byte array receiving the compressed key image.
+ *  In:      pub33:      the 33-byte compressed public key.
+ *           seckey32:   the 32-byte secret key of pub33.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_mlsag_keyimage(
+    const secp256k1_context2* ctx,
+    unsigned char *keyimage33,
+    const unsigned char *pub33,
+    const unsigned char *seckey32
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4);
+
+/** Compute the hash point Hp(P) of a compressed public key.
+ *
+ *  Returns: 1 on success, 0 if no point was found within the rehashing bound.
+ *  Args:    ctx:   a secp256k1 context object.
+ *  Out:     hp:    pointer to a public key object receiving Hp(P).
+ *  In:      pub33: the 33-byte compressed public key P.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_mlsag_hash_to_point(
+    const secp256k1_context2* ctx,
+    secp256k1_pubkey2 *hp,
+    const unsigned char *pub33
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
+
+/** Complete a MLSAG ring signature.
+ *
+ *  Returns: 1 on success, 0 if a key failed to parse or a challenge/scalar is not
+ *           a valid non-zero scalar (the caller should retry with new nonces).
+ *  Args:    ctx:       a secp256k1 context object, initialized for signing and verification.
+ *  Out:     c0:        pointer to a 32-byte array receiving the challenge of column 0.
+ *  In/Out:  s:         n_rows * n_cols 32-byte scalars. Entries of column index are
+ *                      overwritten with the closing scalars, all others must be random.
+ *  In:      pubkeys:   n_rows * n_cols 33-byte public keys.
+ *           keyimages: n_rows 33-byte key images.
+ *           seckeys:   n_rows 32-byte secret keys of the public keys in column index.
+ *           alphas:    n_rows 32-byte random nonces.
+ *           msg32:     the 32-byte message being signed.
+ *           n_rows:    number of rows of the ring.
+ *           n_cols:    number of columns of the ring.
+ *           index:     column of the real keys.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_mlsag_sign(
+    const secp256k1_context2* ctx,
+    unsigned char *c0,
+    unsigned char *s,
+    const unsigned char *pubkeys,
+    const unsigned char *keyimages,
+    const unsigned char *seckeys,
+    const unsigned char *alphas,
+    const unsigned char *msg32,
+    size_t n_rows,
+    size_t n_cols,
+    size_t index
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6) SECP256K1_ARG_NONNULL(7) SECP256K1_ARG_NONNULL(8);
+
+/** Verify a MLSAG ring signature.
+ *
+ *  Returns: 1 if the challenge chain started at c0 closes back onto c0, 0 otherwise
+ *           (including unparsable keys and zero or overflowing scalars).
+ *  Args:    ctx:       a secp256k1 context object, initialized for verification.
+ *  In:      c0:        the 32-byte challenge of column 0.
+ *           s:         n_rows * n_cols 32-byte scalars.
+ *           pubkeys:   n_rows * n_cols 33-byte public keys.
+ *           keyimages: n_rows 33-byte key images.
+ *           msg32:     the 32-byte message that was signed.
+ *           n_rows:    number of rows of the ring.
+ *           n_cols:    number of columns of the ring.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_mlsag_verify(
+    const secp256k1_context2* ctx,
+    const unsigned char *c0,
+    const unsigned char *s,
+    const unsigned char *pubkeys,
+    const unsigned char *keyimages,
+    const unsigned char *msg32,
+    size_t n_rows,
+    size_t n_cols
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6);
+
+/** Verify a MLSAG ring signature over already parsed ring members.
+ *
+ *  Same as secp256k1_mlsag_verify, but the public keys, their hash points
+ *  (see secp256k1_mlsag_hash_to_point) and the key images are given as parsed
+ *  public key objects, so callers caching them never decompress a point twice.
+ *
+ *  In:      pubkeys:    n_rows * n_cols public keys, in the same layout as above.
+ *           hashpoints: n_rows * n_cols hash points Hp(P) of pubkeys.
+ *           keyimages:  n_rows key images.
+ */
+SECP256K1_API SECP256K1_WARN_UNUSED_RESULT int secp256k1_mlsag_verify_parsed(
+    const secp256k1_context2* ctx,
+    const unsigned char *c0,
+    const unsigned char *s,
+    const secp256k1_pubkey2 *pubkeys,
+    const secp256k1_pubkey2 *hashpoints,
+    const secp256k1_pubkey2 *keyimages,
+    const unsigned char *msg32,
+    size_t n_rows,
+    size_t n_cols
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3) SECP256K1_ARG_NONNULL(4) SECP256K1_ARG_NONNULL(5) SECP256K1_ARG_NONNULL(6) SECP256K1_ARG_NONNULL(7);
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
@@ -0,0 +1,129 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "include/secp256k1_2.h"
+#include "include/secp256k1_mlsag.h"
+#include "util.h"
+#include "bench.h"
+
+typedef struct {
+    secp256k1_context2 *ctx;
+    unsigned char *pubkeys;
+    unsigned char *keyimages;
+    unsigned char *seckeys;
+    unsigned char *alphas;
+    unsigned char *s;
+    unsigned char msg32[32];
+    unsigned char c0[32];
+    size_t n_rows;
+    size_t n_cols;
+    size_t index;
+    size_t iters;
+} bench_mlsag_t;
+
+/* Deterministic, valid scalars; good enough for timing. */
+static void bench_mlsag_scalar(const secp256k1_context2 *ctx, unsigned char *out32, uint32_t seed) {
+    do {
+        size_t i;
+        for (i = 0; i < 32; i++) {
+            seed = seed * 1103515245 + 12345;
+            out32[i] = seed >> 16;
+        }
+    } while (!secp256k1_ec_seckey_verify2(ctx, out32));
+}
+
+static void bench_mlsag_setup(void *arg) {
+    bench_mlsag_t *data = (bench_mlsag_t *)arg;
+    size_t i, j;
+
+    for (j = 0; j < data->n_cols; j++) {
+        for (i = 0; i < data->n_rows; i++) {
+            unsigned char sec[32];
+            secp256k1_pubkey2 pub;
+            size_t len = 33;
+            bench_mlsag_scalar(data->ctx, sec, (uint32_t)(j * data->n_rows + i + 1));
+            CHECK(secp256k1_ec_pubkey_create2(data->ctx, &pub, sec));
+            CHECK(secp256k1_ec_pubkey_serialize2(data->ctx, &data->pubkeys[33 * (j * data->n_rows + i)], &len, &pub, SECP256K1_EC_COMPRESSED));
+            if (j == data->index) {
+                memcpy(&data->seckeys[32 * i], sec, 32);
+                CHECK(secp256k1_mlsag_keyimage(data->ctx, &data->keyimages[33 * i], &data->pubkeys[33 * (j * data->n_rows + i)], sec));
+                bench_mlsag_scalar(data->ctx, &data->alphas[32 * i], (uint32_t)(0x10000 + i));
+            }
+            bench_mlsag_scalar(data->ctx, &data->s[32 * (j * data->n_rows + i)], (uint32_t)(0x20000 + j * data->n_rows + i));
+        }
+    }
+    memset(data->msg32, 0x5a, 32);
+    CHECK(secp256k1_mlsag_sign(data->ctx, data->c0, data->s, data->pubkeys, data->keyimages, data->seckeys, data->alphas, data->msg32, data->n_rows, data->n_cols, data->index));
+}
+
+static void bench_mlsag_sign(void *arg) {
+    bench_mlsag_t *data = (bench_mlsag_t *)arg;
+    size_t i;
+
+    for (i = 0; i < data->iters; i++) {
+        CHECK(secp256k1_mlsag_sign(data->ctx, data->c0, data->s, data->pubkeys, data->keyimages, data->seckeys, data->alphas, data->msg32, data->n_rows, data->n_cols, data->index));
+    }
+}
+
+static void bench_mlsag_verify(void *arg) {
+    bench_mlsag_t *data = (bench_mlsag_t *)arg;
+    size_t i;
+
+    for (i = 0; i < data->iters; i++) {
+        CHECK(secp256k1_mlsag_verify(data->ctx, data->c0, data->s, data->pubkeys, data->keyimages, data->msg32, data->n_rows, data->n_cols));
+    }
+}
+
+/* n_inputs spent inputs give n_inputs + 1 rows (the commitment row), ring_size decoys give ring_size + 1 columns. */
+static void run_mlsag_test(bench_mlsag_t *data, size_t n_inputs, size_t ring_size) {
+    char str[64];
+
+    data->n_rows = n_inputs + 1;
+    data->n_cols = ring_size + 1;
+    data->index = data->n_cols / 2;
+    data->iters = 10;
+    data->pubkeys = (unsigned char *)malloc(33 * data->n_rows * data->n_cols);
+    data->s = (unsigned char *)malloc(32 * data->n_rows * data->n_cols);
+    data->keyimages = (unsigned char *)malloc(33 * data->n_rows);
+    data->seckeys = (unsigned char *)malloc(32 * data->n_rows);
+    data->alphas = (unsigned char *)malloc(32 * data->n_rows);
+
+    sprintf(str, "mlsag_sign, %i, %i, ", (int)n_inputs, (int)ring_size);
+    run_benchmark(str, bench_mlsag_sign, bench_mlsag_setup, NULL, (void *)data, 5, data->iters);
+    sprintf(str, "mlsag_verify, %i, %i, ", (int)n_inputs, (int)ring_size);
+    run_benchmark(str, bench_mlsag_verify, bench_mlsag_setup, NULL, (void *)data, 5, data->iters);
+
+    free(data->alphas);
+    free(data->seckeys);
+    free(data->keyimages);
+    free(data->s);
+    free(data->pubkeys);
+}
+
+int main(int argc, char **argv) {
+    bench_mlsag_t data;
+
+    data.ctx = secp256k1_context_create2(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
+
+    if (have_flag(argc, argv, "ring")) {
+        run_mlsag_test(&data, 1, 11);
+        run_mlsag_test(&data, 1, 15);
+        run_mlsag_test(&data, 1, 27);
+        run_mlsag_test(&data, 1, 32);
+    }
+    if (have_flag(argc, argv, "inputs")) {
+        run_mlsag_test(&data, 2, 11);
+        run_mlsag_test(&data, 5, 11);
+        run_mlsag_test(&data, 10, 11);
+        run_mlsag_test(&data, 50, 11);
+    }
+
+    secp256k1_context_destroy(data.ctx);
+    return 0;
+}
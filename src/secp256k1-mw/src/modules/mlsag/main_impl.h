@@ -0,0 +1,364 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MLSAG_MAIN
+#define SECP256K1_MODULE_MLSAG_MAIN
+
+#include "group.h"
+#include "hash.h"
+#include "scalar.h"
+#include "eckey.h"
+#include "ecmult.h"
+#include "ecmult_const.h"
+#include "ecmult_gen.h"
+
+#include "include/secp256k1_mlsag.h"
+
+/** Upper bound on rehashing rounds in the hash to point. Roughly half of all
+ *  x coordinates are on the curve, so this is never reached in practice. */
+#define SECP256K1_MLSAG_MAX_HASH_TO_POINT_ROUNDS 256
+
+static void secp256k1_mlsag_sha256d(unsigned char *out32, const unsigned char *data, size_t len) {
+    secp256k1_sha256 sha;
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, data, len);
+    secp256k1_sha256_finalize(&sha, out32);
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, out32, 32);
+    secp256k1_sha256_finalize(&sha, out32);
+}
+
+/* Hp(P): replace the x coordinate of the compressed key by its double-SHA256
+ * (keeping the tag byte) until the result encodes a point on the curve. */
+static int secp256k1_mlsag_hash_to_point_ge(secp256k1_ge *hp, const unsigned char *pub33) {
+    unsigned char candidate[33];
+    unsigned char hash[32];
+    int i;
+    memcpy(candidate, pub33, 33);
+    for (i = 0; i < SECP256K1_MLSAG_MAX_HASH_TO_POINT_ROUNDS; i++) {
+        secp256k1_mlsag_sha256d(hash, candidate, 33);
+        memcpy(&candidate[1], hash, 32);
+        if (secp256k1_eckey_pubkey_parse(hp, candidate, 33)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* r = na * a + nb * b, sharing the doublings of both multiplications. */
+static void secp256k1_mlsag_ecmult2(const secp256k1_ecmult_context *ctx, secp256k1_gej *r, const secp256k1_gej *a, const secp256k1_scalar *na, const secp256k1_gej *b, const secp256k1_scalar *nb) {
+    secp256k1_gej prej[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_fe zr[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    secp256k1_ge pre_a[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+    struct secp256k1_strauss_point_state ps[2];
+#ifdef USE_ENDOMORPHISM
+    secp256k1_ge pre_a_lam[2 * ECMULT_TABLE_SIZE(WINDOW_A)];
+#endif
+    struct secp256k1_strauss_state state;
+    secp256k1_gej points[2];
+    secp256k1_scalar scalars[2];
+
+    points[0] = *a;
+    points[1] = *b;
+    scalars[0] = *na;
+    scalars[1] = *nb;
+    state.prej = prej;
+    state.zr = zr;
+    state.pre_a = pre_a;
+#ifdef USE_ENDOMORPHISM
+    state.pre_a_lam = pre_a_lam;
+#endif
+    state.ps = ps;
+    secp256k1_ecmult_strauss_wnaf(ctx, &state, r, 2, points, scalars, NULL);
+}
+
+/* L = c * P + s * G, R = s * Hp(P) + c * I */
+static void secp256k1_mlsag_ring_element(const secp256k1_ecmult_context *ctx, secp256k1_gej *l, secp256k1_gej *r, const secp256k1_ge *p, const secp256k1_ge *hp, const secp256k1_ge *ki, const secp256k1_scalar *c, const secp256k1_scalar *s) {
+    secp256k1_gej pj, hpj, kij;
+    secp256k1_gej_set_ge(&pj, p);
+    secp256k1_gej_set_ge(&hpj, hp);
+    secp256k1_gej_set_ge(&kij, ki);
+    secp256k1_ecmult(ctx, l, &pj, c, s);
+    secp256k1_mlsag_ecmult2(ctx, r, &hpj, s, &kij, c);
+}
+
+/* Hash the L/R pairs of one column (2 * n_rows points, converted to affine with
+ * a single field inversion) followed by the message into the next challenge. */
+static int secp256k1_mlsag_hash_column(const secp256k1_callback *cb, unsigned char *c32, secp256k1_scalar *c, secp256k1_ge *lr_ge, const secp256k1_gej *lr, size_t n_rows, const unsigned char *msg32) {
+    secp256k1_sha256 sha;
+    unsigned char ser[33];
+    size_t ser_len;
+    size_t i;
+    int overflow;
+
+    secp256k1_ge_set_all_gej_var(lr_ge, lr, 2 * n_rows, cb);
+    secp256k1_sha256_initialize(&sha);
+    for (i = 0; i < 2 * n_rows; i++) {
+        if (!secp256k1_eckey_pubkey_serialize(&lr_ge[i], ser, &ser_len, 1)) {
+            return 0;
+        }
+        secp256k1_sha256_write(&sha, ser, 33);
+    }
+    secp256k1_sha256_write(&sha, msg32, 32);
+    secp256k1_sha256_finalize(&sha, c32);
+    secp256k1_sha256_initialize(&sha);
+    secp256k1_sha256_write(&sha, c32, 32);
+    secp256k1_sha256_finalize(&sha, c32);
+
+    secp256k1_scalar_set_b32(c, c32, &overflow);
+    return !overflow && !secp256k1_scalar_is_zero(c);
+}
+
+static int secp256k1_mlsag_scalar_load(secp256k1_scalar *s, const unsigned char *s32) {
+    int overflow;
+    secp256k1_scalar_set_b32(s, s32, &overflow);
+    return !overflow && !secp256k1_scalar_is_zero(s);
+}
+
+/* Parse every ring member, its hash point and the key images exactly once. */
+static int secp256k1_mlsag_load_ring(secp256k1_ge *p, secp256k1_ge *hp, secp256k1_ge *ki, const unsigned char *pubkeys, const unsigned char *keyimages, size_t n_rows, size_t n_cols) {
+    size_t i;
+    for (i = 0; i < n_rows * n_cols; i++) {
+        if (!secp256k1_eckey_pubkey_parse(&p[i], &pubkeys[33 * i], 33) ||
+            !secp256k1_mlsag_hash_to_point_ge(&hp[i], &pubkeys[33 * i])) {
+            return 0;
+        }
+    }
+    for (i = 0; i < n_rows; i++) {
+        if (!secp256k1_eckey_pubkey_parse(&ki[i], &keyimages[33 * i], 33)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int secp256k1_mlsag_keyimage(const secp256k1_context2* ctx, unsigned char *keyimage33, const unsigned char *pub33, const unsigned char *seckey32) {
+    secp256k1_ge hp;
+    secp256k1_ge ki;
+    secp256k1_gej kij;
+    secp256k1_scalar x;
+    size_t len;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(keyimage33 != NULL);
+    ARG_CHECK(pub33 != NULL);
+    ARG_CHECK(seckey32 != NULL);
+
+    if (secp256k1_mlsag_hash_to_point_ge(&hp, pub33) && secp256k1_mlsag_scalar_load(&x, seckey32)) {
+        secp256k1_ecmult_const(&kij, &hp, &x, 256);
+        secp256k1_ge_set_gej(&ki, &kij);
+        ret = secp256k1_eckey_pubkey_serialize(&ki, keyimage33, &len, 1);
+    }
+    secp256k1_scalar_clear(&x);
+    return ret;
+}
+
+int secp256k1_mlsag_sign(const secp256k1_context2* ctx, unsigned char *c0, unsigned char *s, const unsigned char *pubkeys, const unsigned char *keyimages, const unsigned char *seckeys, const unsigned char *alphas, const unsigned char *msg32, size_t n_rows, size_t n_cols, size_t index) {
+    secp256k1_ge *p;
+    secp256k1_ge *hp;
+    secp256k1_ge *ki;
+    secp256k1_ge *lr_ge;
+    secp256k1_gej *lr;
+    secp256k1_scalar c;
+    secp256k1_scalar sc;
+    secp256k1_scalar x;
+    secp256k1_scalar alpha;
+    unsigned char c32[32];
+    size_t i, j, k;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(secp256k1_ecmult_gen_context_is_built(&ctx->ecmult_gen_ctx));
+    ARG_CHECK(c0 != NULL);
+    ARG_CHECK(s != NULL);
+    ARG_CHECK(pubkeys != NULL);
+    ARG_CHECK(keyimages != NULL);
+    ARG_CHECK(seckeys != NULL);
+    ARG_CHECK(alphas != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(n_rows > 0);
+    ARG_CHECK(index < n_cols);
+
+    p = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * (2 * n_rows * n_cols + 3 * n_rows));
+    lr = (secp256k1_gej *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_gej) * 2 * n_rows);
+    hp = p + n_rows * n_cols;
+    ki = hp + n_rows * n_cols;
+    lr_ge = ki + n_rows;
+
+    if (!secp256k1_mlsag_load_ring(p, hp, ki, pubkeys, keyimages, n_rows, n_cols)) {
+        goto done;
+    }
+
+    /* Column of the real keys: L = alpha * G, R = alpha * Hp(P) */
+    for (i = 0; i < n_rows; i++) {
+        if (!secp256k1_mlsag_scalar_load(&alpha, &alphas[32 * i])) {
+            goto done;
+        }
+        secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &lr[2 * i], &alpha);
+        secp256k1_ecmult_const(&lr[2 * i + 1], &hp[index * n_rows + i], &alpha, 256);
+    }
+    if (!secp256k1_mlsag_hash_column(&ctx->error_callback, c32, &c, lr_ge, lr, n_rows, msg32)) {
+        goto done;
+    }
+
+    /* Walk the ring from index + 1 back around to index */
+    for (k = 1; k <= n_cols; k++) {
+        j = (index + k) % n_cols;
+        if (j == 0) {
+            memcpy(c0, c32, 32);
+        }
+        if (j == index) {
+            break;
+        }
+        for (i = 0; i < n_rows; i++) {
+            if (!secp256k1_mlsag_scalar_load(&sc, &s[32 * (j * n_rows + i)])) {
+                goto done;
+            }
+            secp256k1_mlsag_ring_element(&ctx->ecmult_ctx, &lr[2 * i], &lr[2 * i + 1], &p[j * n_rows + i], &hp[j * n_rows + i], &ki[i], &c, &sc);
+        }
+        if (!secp256k1_mlsag_hash_column(&ctx->error_callback, c32, &c, lr_ge, lr, n_rows, msg32)) {
+            goto done;
+        }
+    }
+
+    /* Close the ring: s = alpha - c * x */
+    for (i = 0; i < n_rows; i++) {
+        int overflow;
+        secp256k1_scalar_set_b32(&x, &seckeys[32 * i], &overflow);
+        if (overflow || !secp256k1_mlsag_scalar_load(&alpha, &alphas[32 * i])) {
+            goto done;
+        }
+        secp256k1_scalar_mul(&x, &x, &c);
+        secp256k1_scalar_negate(&x, &x);
+        secp256k1_scalar_add(&sc, &alpha, &x);
+        secp256k1_scalar_get_b32(&s[32 * (index * n_rows + i)], &sc);
+    }
+    ret = 1;
+
+done:
+    secp256k1_scalar_clear(&x);
+    secp256k1_scalar_clear(&alpha);
+    secp256k1_scalar_clear(&sc);
+    free(lr);
+    free(p);
+    return ret;
+}
+
+/* Walk the challenge chain from c0 through every column and compare the result with c0. */
+static int secp256k1_mlsag_verify_chain(const secp256k1_context2* ctx, const unsigned char *c0, const unsigned char *s, const secp256k1_ge *p, const secp256k1_ge *hp, const secp256k1_ge *ki, const unsigned char *msg32, size_t n_rows, size_t n_cols) {
+    secp256k1_ge *lr_ge;
+    secp256k1_gej *lr;
+    secp256k1_scalar c;
+    secp256k1_scalar sc;
+    unsigned char c32[32];
+    size_t i, j;
+    int ret = 0;
+
+    if (!secp256k1_mlsag_scalar_load(&c, c0)) {
+        return 0;
+    }
+    lr_ge = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * 2 * n_rows);
+    lr = (secp256k1_gej *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_gej) * 2 * n_rows);
+    for (j = 0; j < n_cols; j++) {
+        for (i = 0; i < n_rows; i++) {
+            if (!secp256k1_mlsag_scalar_load(&sc, &s[32 * (j * n_rows + i)])) {
+                goto done;
+            }
+            secp256k1_mlsag_ring_element(&ctx->ecmult_ctx, &lr[2 * i], &lr[2 * i + 1], &p[j * n_rows + i], &hp[j * n_rows + i], &ki[i], &c, &sc);
+        }
+        if (!secp256k1_mlsag_hash_column(&ctx->error_callback, c32, &c, lr_ge, lr, n_rows, msg32)) {
+            goto done;
+        }
+    }
+    ret = memcmp(c32, c0, 32) == 0;
+
+done:
+    free(lr);
+    free(lr_ge);
+    return ret;
+}
+
+int secp256k1_mlsag_hash_to_point(const secp256k1_context2* ctx, secp256k1_pubkey2 *hp, const unsigned char *pub33) {
+    secp256k1_ge ge;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(hp != NULL);
+    memset(hp, 0, sizeof(*hp));
+    ARG_CHECK(pub33 != NULL);
+
+    if (!secp256k1_mlsag_hash_to_point_ge(&ge, pub33)) {
+        return 0;
+    }
+    secp256k1_pubkey2_save(hp, &ge);
+    return 1;
+}
+
+int secp256k1_mlsag_verify(const secp256k1_context2* ctx, const unsigned char *c0, const unsigned char *s, const unsigned char *pubkeys, const unsigned char *keyimages, const unsigned char *msg32, size_t n_rows, size_t n_cols) {
+    secp256k1_ge *p;
+    secp256k1_ge *hp;
+    secp256k1_ge *ki;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(c0 != NULL);
+    ARG_CHECK(s != NULL);
+    ARG_CHECK(pubkeys != NULL);
+    ARG_CHECK(keyimages != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(n_rows > 0);
+    ARG_CHECK(n_cols > 0);
+
+    p = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * (2 * n_rows * n_cols + n_rows));
+    hp = p + n_rows * n_cols;
+    ki = hp + n_rows * n_cols;
+    if (secp256k1_mlsag_load_ring(p, hp, ki, pubkeys, keyimages, n_rows, n_cols)) {
+        ret = secp256k1_mlsag_verify_chain(ctx, c0, s, p, hp, ki, msg32, n_rows, n_cols);
+    }
+    free(p);
+    return ret;
+}
+
+int secp256k1_mlsag_verify_parsed(const secp256k1_context2* ctx, const unsigned char *c0, const unsigned char *s, const secp256k1_pubkey2 *pubkeys, const secp256k1_pubkey2 *hashpoints, const secp256k1_pubkey2 *keyimages, const unsigned char *msg32, size_t n_rows, size_t n_cols) {
+    secp256k1_ge *p;
+    secp256k1_ge *hp;
+    secp256k1_ge *ki;
+    size_t i;
+    int ret = 0;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(secp256k1_ecmult_context_is_built(&ctx->ecmult_ctx));
+    ARG_CHECK(c0 != NULL);
+    ARG_CHECK(s != NULL);
+    ARG_CHECK(pubkeys != NULL);
+    ARG_CHECK(hashpoints != NULL);
+    ARG_CHECK(keyimages != NULL);
+    ARG_CHECK(msg32 != NULL);
+    ARG_CHECK(n_rows > 0);
+    ARG_CHECK(n_cols > 0);
+
+    p = (secp256k1_ge *)checked_malloc(&ctx->error_callback, sizeof(secp256k1_ge) * (2 * n_rows * n_cols + n_rows));
+    hp = p + n_rows * n_cols;
+    ki = hp + n_rows * n_cols;
+    for (i = 0; i < n_rows * n_cols; i++) {
+        if (!secp256k1_pubkey2_load(ctx, &p[i], &pubkeys[i]) || !secp256k1_pubkey2_load(ctx, &hp[i], &hashpoints[i])) {
+            goto done;
+        }
+    }
+    for (i = 0; i < n_rows; i++) {
+        if (!secp256k1_pubkey2_load(ctx, &ki[i], &keyimages[i])) {
+            goto done;
+        }
+    }
+    ret = secp256k1_mlsag_verify_chain(ctx, c0, s, p, hp, ki, msg32, n_rows, n_cols);
+
+done:
+    free(p);
+    return ret;
+}
+
+#endif
@@ -0,0 +1,424 @@
+/**********************************************************************
+ * Distributed under the MIT software license, see the accompanying   *
+ * file COPYING or http://www.opensource.org/licenses/mit-license.php.*
+ **********************************************************************/
+
+#ifndef SECP256K1_MODULE_MLSAG_TESTS
+#define SECP256K1_MODULE_MLSAG_TESTS
+
+#include <string.h>
+
+#include "group.h"
+#include "scalar.h"
+#include "testrand.h"
+#include "util.h"
+
+#include "include/secp256k1_mlsag.h"
+
+#define MLSAG_TEST_MAX_ROWS 4
+#define MLSAG_TEST_MAX_COLS 6
+
+/* Build a ring whose column index holds keys we own; every other member is random. */
+static void test_mlsag_make_ring(unsigned char *pubkeys, unsigned char *keyimages, unsigned char *seckeys, unsigned char *alphas, unsigned char *s, size_t n_rows, size_t n_cols, size_t index) {
+    size_t i, j;
+    for (j = 0; j < n_cols; j++) {
+        for (i = 0; i < n_rows; i++) {
+            secp256k1_scalar x;
+            secp256k1_gej pj;
+            secp256k1_ge p;
+            size_t len;
+            random_scalar_order(&x);
+            secp256k1_ecmult_gen(&ctx->ecmult_gen_ctx, &pj, &x);
+            secp256k1_ge_set_gej(&p, &pj);
+            CHECK(secp256k1_eckey_pubkey_serialize(&p, &pubkeys[33 * (j * n_rows + i)], &len, 1));
+            if (j == index) {
+                secp256k1_scalar_get_b32(&seckeys[32 * i], &x);
+                CHECK(secp256k1_mlsag_keyimage(ctx, &keyimages[33 * i], &pubkeys[33 * (j * n_rows + i)], &seckeys[32 * i]));
+                random_scalar_order(&x);
+                secp256k1_scalar_get_b32(&alphas[32 * i], &x);
+            }
+            random_scalar_order(&x);
+            secp256k1_scalar_get_b32(&s[32 * (j * n_rows + i)], &x);
+        }
+    }
+}
+
+static int test_mlsag_verify_parsed(const unsigned char *c0, const unsigned char *s, const unsigned char *pubkeys, const unsigned char *keyimages, const unsigned char *msg32, size_t n_rows, size_t n_cols) {
+    secp256k1_pubkey2 p[MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+    secp256k1_pubkey2 hp[MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+    secp256k1_pubkey2 ki[MLSAG_TEST_MAX_ROWS];
+    size_t i;
+    for (i = 0; i < n_rows * n_cols; i++) {
+        CHECK(secp256k1_ec_pubkey_parse2(ctx, &p[i], &pubkeys[33 * i], 33));
+        CHECK(secp256k1_mlsag_hash_to_point(ctx, &hp[i], &pubkeys[33 * i]));
+    }
+    for (i = 0; i < n_rows; i++) {
+        CHECK(secp256k1_ec_pubkey_parse2(ctx, &ki[i], &keyimages[33 * i], 33));
+    }
+    return secp256k1_mlsag_verify_parsed(ctx, c0, s, p, hp, ki, msg32, n_rows, n_cols);
+}
+
+void test_mlsag_sign(size_t n_rows, size_t n_cols) {
+    unsigned char pubkeys[33 * MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+    unsigned char keyimages[33 * MLSAG_TEST_MAX_ROWS];
+    unsigned char seckeys[32 * MLSAG_TEST_MAX_ROWS];
+    unsigned char alphas[32 * MLSAG_TEST_MAX_ROWS];
+    unsigned char s[32 * MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+    unsigned char msg32[32];
+    unsigned char c0[32];
+    size_t index = secp256k1_rand_int(n_cols);
+
+    secp256k1_rand256(msg32);
+    test_mlsag_make_ring(pubkeys, keyimages, seckeys, alphas, s, n_rows, n_cols, index);
+    CHECK(secp256k1_mlsag_sign(ctx, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, n_rows, n_cols, index));
+    CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+
+    /* A different message or a modified scalar breaks the ring */
+    msg32[0] ^= 1;
+    CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+    msg32[0] ^= 1;
+    s[32 * index * n_rows + 31] ^= 1;
+    CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+    s[32 * index * n_rows + 31] ^= 1;
+    CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+
+    /* Pre-parsed ring members give the same result */
+    CHECK(test_mlsag_verify_parsed(c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+
+    /* So does a key image of a different key */
+    keyimages[33 * (n_rows - 1)] ^= 1;
+    CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, n_rows, n_cols));
+}
+
+void test_mlsag_api(void) {
+    unsigned char pubkeys[33 * 2];
+    unsigned char keyimages[33];
+    unsigned char seckeys[32];
+    unsigned char alphas[32];
+    unsigned char s[32 * 2];
+    unsigned char msg32[32];
+    unsigned char c0[32];
+    secp256k1_context2 *none = secp256k1_context_create2(SECP256K1_CONTEXT_NONE);
+    int32_t ecount = 0;
+
+    secp256k1_context_set_illegal_callback(none, counting_illegal_callback_fn, &ecount);
+    secp256k1_context_set_illegal_callback(ctx, counting_illegal_callback_fn, &ecount);
+    secp256k1_rand256(msg32);
+    test_mlsag_make_ring(pubkeys, keyimages, seckeys, alphas, s, 1, 2, 1);
+
+    CHECK(secp256k1_mlsag_sign(none, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, 1, 2, 1) == 0);
+    CHECK(ecount == 1);
+    CHECK(secp256k1_mlsag_sign(ctx, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, 1, 2, 2) == 0);
+    CHECK(ecount == 2);
+    CHECK(secp256k1_mlsag_sign(ctx, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, 0, 2, 1) == 0);
+    CHECK(ecount == 3);
+    CHECK(secp256k1_mlsag_sign(ctx, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, 1, 2, 1) == 1);
+    CHECK(ecount == 3);
+
+    CHECK(secp256k1_mlsag_verify(none, c0, s, pubkeys, keyimages, msg32, 1, 2) == 0);
+    CHECK(ecount == 4);
+    CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, 1, 0) == 0);
+    CHECK(ecount == 5);
+    CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, 1, 2) == 1);
+    CHECK(ecount == 5);
+
+    /* A key that is not on the curve is rejected */
+    memset(&pubkeys[1], 0xff, 32);
+    CHECK(secp256k1_mlsag_sign(ctx, c0, s, pubkeys, keyimages, seckeys, alphas, msg32, 1, 2, 1) == 0);
+    CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, 1, 2) == 0);
+    CHECK(ecount == 5);
+
+    secp256k1_context_set_illegal_callback(ctx, NULL, NULL);
+    secp256k1_context_destroy(none);
+}
+
+/* Known-answer vectors made with the ring signing loop of CWallet::makeRingCT as it was
+ * before this module existed (secp256k1_ec_pubkey_tweak_mul/_add on serialized keys,
+ * PointHashingSuccessively for Hp and pedersen commitment sums for R), and accepted by
+ * the VerifyRingSignatureWithTxFee loop of the same code. Nonces hold the random
+ * scalars of the columns other than the signed one. */
+static const unsigned char mlsag_vector1_pubkeys[66] = {
+    0x03, 0x14, 0x4b, 0x44, 0x82, 0x9a, 0x77, 0xb9, 0x59, 0x2b, 0x7e, 0x8b,
+    0xcc, 0xf8, 0xaf, 0xac, 0xe1, 0xb9, 0xd8, 0xee, 0x15, 0x6a, 0x6a, 0x4c,
+    0x7f, 0xb7, 0x61, 0x6f, 0x69, 0x8f, 0x48, 0xdd, 0x30, 0x02, 0xff, 0x46,
+    0x98, 0xa3, 0x0c, 0xaa, 0xc7, 0x75, 0xb3, 0x71, 0xfa, 0x2b, 0x24, 0x44,
+    0x61, 0x7c, 0xed, 0xd8, 0x7c, 0xf2, 0x22, 0x43, 0x72, 0x5b, 0xc8, 0x1c,
+    0x0a, 0x58, 0x56, 0x37, 0xda, 0xc9
+};
+static const unsigned char mlsag_vector1_keyimages[33] = {
+    0x02, 0x8a, 0x11, 0xd8, 0x4a, 0x76, 0xa1, 0x6b, 0x3e, 0x19, 0x88, 0x69,
+    0x55, 0x7a, 0xff, 0xd8, 0x01, 0x0c, 0x2d, 0x02, 0x28, 0x3b, 0x2c, 0xd8,
+    0x1e, 0x65, 0xae, 0xf7, 0x78, 0xab, 0xc3, 0x84, 0x29
+};
+static const unsigned char mlsag_vector1_seckeys[32] = {
+    0x0c, 0x6b, 0xbc, 0x3b, 0x4b, 0x1b, 0x00, 0xab, 0x76, 0x51, 0x2a, 0x43,
+    0x69, 0xa2, 0xb5, 0x03, 0x2f, 0xf7, 0x33, 0x4f, 0xe7, 0x00, 0xb2, 0xe2,
+    0xab, 0xad, 0xba, 0xea, 0xfd, 0xc5, 0xf4, 0x6e
+};
+static const unsigned char mlsag_vector1_alphas[32] = {
+    0x46, 0xa4, 0xa6, 0x13, 0x36, 0x63, 0x21, 0x33, 0x96, 0x38, 0x86, 0x0f,
+    0x22, 0x5b, 0x47, 0x94, 0x93, 0x9e, 0x11, 0x53, 0x62, 0xef, 0x53, 0xf2,
+    0x00, 0x9d, 0xe8, 0x4b, 0x40, 0x04, 0xd5, 0x56
+};
+static const unsigned char mlsag_vector1_nonces[64] = {
+    0xcb, 0x15, 0xf0, 0x25, 0xf0, 0x08, 0x51, 0x6b, 0x28, 0xf9, 0x01, 0x1b,
+    0xd7, 0xc4, 0x86, 0xb9, 0x9a, 0xa4, 0x6a, 0x20, 0xdc, 0xfb, 0xb0, 0x06,
+    0x52, 0xdf, 0x4c, 0xa1, 0x48, 0xc9, 0xb8, 0x63, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00
+};
+static const unsigned char mlsag_vector1_msg32[32] = {
+    0x73, 0x70, 0xed, 0xee, 0xdb, 0xb9, 0xd6, 0x52, 0x3f, 0xe6, 0xf9, 0x84,
+    0x47, 0x12, 0x6b, 0x46, 0x88, 0x9f, 0xd4, 0x8a, 0xaa, 0x28, 0x9a, 0xd4,
+    0x30, 0xd7, 0x75, 0x9c, 0x00, 0xba, 0xd6, 0x54
+};
+static const unsigned char mlsag_vector1_c0[32] = {
+    0xdd, 0x17, 0x2f, 0x86, 0x95, 0x39, 0x81, 0xb7, 0xa4, 0x4e, 0xd7, 0x98,
+    0xc8, 0x6e, 0x63, 0x66, 0x03, 0xc3, 0x20, 0x85, 0xd9, 0x4a, 0xc8, 0x49,
+    0xe8, 0x87, 0xa8, 0x8c, 0x7f, 0x4c, 0xda, 0x00
+};
+static const unsigned char mlsag_vector1_s[64] = {
+    0xcb, 0x15, 0xf0, 0x25, 0xf0, 0x08, 0x51, 0x6b, 0x28, 0xf9, 0x01, 0x1b,
+    0xd7, 0xc4, 0x86, 0xb9, 0x9a, 0xa4, 0x6a, 0x20, 0xdc, 0xfb, 0xb0, 0x06,
+    0x52, 0xdf, 0x4c, 0xa1, 0x48, 0xc9, 0xb8, 0x63, 0x43, 0x37, 0x9e, 0x45,
+    0x43, 0x1c, 0x6f, 0xab, 0x57, 0x95, 0xcb, 0xbb, 0xab, 0x75, 0xa8, 0x54,
+    0xee, 0xa5, 0x4f, 0xad, 0x2b, 0xad, 0x82, 0xe5, 0x29, 0x6f, 0x43, 0xa8,
+    0xce, 0x59, 0x7e, 0x43
+};
+static const unsigned char mlsag_vector2_pubkeys[396] = {
+    0x03, 0xf3, 0xdd, 0x8b, 0x81, 0x41, 0x40, 0x60, 0xb9, 0x0f, 0x6c, 0xd1,
+    0x06, 0x2c, 0xde, 0x17, 0x25, 0x14, 0x0d, 0x07, 0xb9, 0xa5, 0x54, 0x5d,
+    0xc2, 0xd5, 0x45, 0xd6, 0x8f, 0xd3, 0xd3, 0xcc, 0xdf, 0x02, 0xae, 0x53,
+    0x02, 0x51, 0x6e, 0xdf, 0x61, 0x43, 0xce, 0x93, 0xe4, 0x3d, 0xe1, 0xcf,
+    0x85, 0x41, 0x4e, 0x29, 0x61, 0xd9, 0x9d, 0xb5, 0x89, 0x6b, 0xbb, 0xb8,
+    0xa2, 0x2e, 0x36, 0x98, 0x5b, 0x48, 0x02, 0x6c, 0x3b, 0xab, 0x00, 0xfe,
+    0x60, 0x54, 0x25, 0xdd, 0xe2, 0x15, 0xf2, 0x34, 0xc6, 0x67, 0x88, 0xe3,
+    0xaa, 0xef, 0xae, 0x3b, 0xeb, 0xc6, 0x15, 0x7d, 0x47, 0x38, 0x93, 0x6e,
+    0x3a, 0xe4, 0x21, 0x03, 0x97, 0x3a, 0x30, 0x11, 0x96, 0x33, 0xa9, 0x42,
+    0x3b, 0x7a, 0xa3, 0x57, 0x54, 0x09, 0xb1, 0x20, 0x85, 0xb3, 0xe1, 0xc3,
+    0x92, 0x6c, 0x18, 0xe7, 0x39, 0xee, 0xe8, 0xe3, 0x1a, 0x97, 0x4d, 0x52,
+    0x03, 0x6a, 0x09, 0xca, 0x31, 0x1b, 0x47, 0x0d, 0x85, 0x78, 0xe7, 0x05,
+    0x00, 0x04, 0x16, 0x08, 0x76, 0x8b, 0x76, 0xe6, 0xb6, 0x2e, 0xad, 0xa9,
+    0xf9, 0x2c, 0x9a, 0xf6, 0x6e, 0x60, 0xbe, 0x86, 0x2f, 0x02, 0x29, 0x55,
+    0x3a, 0x67, 0x99, 0xaf, 0x72, 0x40, 0xb6, 0x76, 0xf5, 0x89, 0xe6, 0x7e,
+    0xc8, 0x0a, 0x7f, 0xba, 0xe2, 0xae, 0x99, 0x48, 0x24, 0x40, 0xe8, 0x33,
+    0xb2, 0xdd, 0xbc, 0x10, 0x9c, 0xdd, 0x03, 0x93, 0x8f, 0x0b, 0xdb, 0xb4,
+    0xdb, 0x1d, 0x53, 0xcd, 0x5f, 0x2c, 0xa2, 0x23, 0x4f, 0x3a, 0x35, 0x12,
+    0x48, 0x8d, 0x42, 0x2c, 0x7e, 0x31, 0x91, 0x3b, 0x36, 0xa8, 0x66, 0x5b,
+    0xf1, 0xbd, 0x7f, 0x02, 0xd7, 0x90, 0x89, 0xf8, 0x06, 0xe7, 0xf0, 0x03,
+    0xd7, 0xe5, 0xf0, 0x65, 0xb9, 0x02, 0xb8, 0x53, 0xc6, 0x2f, 0x0f, 0x4a,
+    0xb2, 0xc4, 0x14, 0x73, 0x91, 0xe0, 0x99, 0xeb, 0xd2, 0xfa, 0xe4, 0x2c,
+    0x03, 0x04, 0x6b, 0x22, 0xb7, 0x26, 0xfa, 0x05, 0x38, 0x71, 0xd2, 0xca,
+    0xce, 0xf0, 0x35, 0x07, 0x70, 0x91, 0x26, 0x90, 0xa0, 0x0b, 0xb2, 0xc4,
+    0xbb, 0xbb, 0xd2, 0xba, 0xad, 0x34, 0xdb, 0x82, 0xbc, 0x02, 0x2c, 0x60,
+    0x84, 0xf0, 0x69, 0x25, 0x45, 0xa7, 0x7d, 0x9f, 0xa4, 0x8f, 0x93, 0x60,
+    0x38, 0x7d, 0x93, 0xfd, 0x2f, 0xb1, 0x65, 0x7f, 0x80, 0x5c, 0xd5, 0xf4,
+    0x44, 0x59, 0x3e, 0x56, 0x27, 0x69, 0x03, 0xea, 0xa8, 0x81, 0xbc, 0x08,
+    0x12, 0xa1, 0xb9, 0x30, 0x37, 0xec, 0xad, 0x2b, 0x99, 0xde, 0x69, 0x98,
+    0x4f, 0x5e, 0xf3, 0x0e, 0xa7, 0x51, 0x2d, 0x06, 0x82, 0xbc, 0x7c, 0xda,
+    0xd3, 0x74, 0x78, 0x03, 0x8d, 0x1c, 0xed, 0x02, 0x19, 0x07, 0xad, 0xce,
+    0x8e, 0x82, 0xac, 0xd4, 0x01, 0x09, 0xe8, 0x5e, 0x7f, 0xe7, 0xff, 0x87,
+    0x77, 0xce, 0xcd, 0x66, 0xb7, 0xb3, 0x68, 0x1e, 0x51, 0x29, 0x61, 0x93
+};
+static const unsigned char mlsag_vector2_keyimages[99] = {
+    0x02, 0x6d, 0x0c, 0xda, 0xe6, 0x77, 0x3e, 0x13, 0xd7, 0x7b, 0xf9, 0xdc,
+    0x55, 0x63, 0x90, 0xc3, 0x5d, 0x77, 0x4e, 0x99, 0x82, 0x63, 0xdc, 0xa2,
+    0x05, 0xf8, 0xc7, 0x34, 0x4d, 0x51, 0x72, 0x03, 0x4a, 0x02, 0x62, 0xe1,
+    0x09, 0x44, 0x2f, 0xc5, 0x2d, 0x91, 0x07, 0x10, 0x14, 0xb5, 0xaa, 0xab,
+    0xde, 0x2b, 0x99, 0xa3, 0x4a, 0x90, 0x3a, 0x6f, 0x90, 0xaa, 0xa9, 0x2c,
+    0xea, 0x6f, 0x9e, 0x21, 0x23, 0x3c, 0x02, 0xd2, 0x16, 0x3d, 0xd8, 0x45,
+    0xd1, 0x3b, 0xb8, 0x83, 0x52, 0x41, 0x49, 0xfc, 0xe6, 0xb8, 0x4e, 0xad,
+    0x7a, 0xdf, 0xec, 0x8b, 0x04, 0x74, 0xa2, 0x55, 0x73, 0xa2, 0xdb, 0xe5,
+    0xd4, 0x5a, 0x70
+};
+static const unsigned char mlsag_vector2_seckeys[96] = {
+    0x71, 0x73, 0xd1, 0x80, 0x00, 0x7e, 0x41, 0x20, 0x09, 0x5b, 0x18, 0x7e,
+    0x2f, 0x6b, 0x2f, 0x8e, 0xa3, 0xa9, 0x03, 0x24, 0x57, 0x9b, 0x39, 0x46,
+    0x53, 0x7c, 0x4d, 0x33, 0xa4, 0xf3, 0x05, 0x8d, 0x08, 0x67, 0xb0, 0x56,
+    0x20, 0x9d, 0x77, 0xd1, 0x1d, 0x5d, 0x13, 0xae, 0x15, 0x4b, 0xdb, 0x9a,
+    0x90, 0x01, 0xc7, 0xc1, 0x78, 0xa8, 0xb8, 0xd9, 0x0d, 0x6a, 0xd6, 0x04,
+    0x7d, 0x8e, 0x2c, 0x89, 0xdf, 0xf3, 0x69, 0xc8, 0x8e, 0x4a, 0x24, 0x9a,
+    0xf1, 0x49, 0xf0, 0x1d, 0x26, 0x37, 0xfe, 0xe9, 0x2f, 0xac, 0x03, 0x4e,
+    0x01, 0x11, 0x49, 0x9a, 0xae, 0xa6, 0x04, 0xd8, 0x14, 0xa0, 0xea, 0x04
+};
+static const unsigned char mlsag_vector2_alphas[96] = {
+    0xe9, 0x25, 0x80, 0x4b, 0x79, 0x8e, 0xdf, 0x9f, 0x9f, 0xf1, 0x53, 0x32,
+    0x0f, 0x8b, 0x14, 0xab, 0x43, 0xe0, 0x45, 0x52, 0x48, 0xa5, 0xde, 0x4f,
+    0x52, 0x00, 0xda, 0xa0, 0x41, 0x4b, 0xd1, 0x35, 0x21, 0x62, 0x00, 0x7a,
+    0x11, 0x50, 0xfd, 0x58, 0xd2, 0x32, 0x1c, 0x9c, 0xa0, 0xbd, 0x92, 0x1a,
+    0x96, 0x45, 0x4b, 0xd6, 0x31, 0x7a, 0xa2, 0x0e, 0x39, 0x75, 0x0c, 0x0a,
+    0xe0, 0xe0, 0x67, 0x8a, 0x88, 0x98, 0x6a, 0xf0, 0xba, 0x65, 0x1c, 0x13,
+    0xf7, 0x10, 0x2e, 0xac, 0x7b, 0xc6, 0x91, 0x18, 0x44, 0x8b, 0x9b, 0x44,
+    0x18, 0x46, 0x62, 0x61, 0xf3, 0x8a, 0xed, 0x7c, 0xb0, 0x93, 0x57, 0xfb
+};
+static const unsigned char mlsag_vector2_nonces[384] = {
+    0x8c, 0x8f, 0x65, 0xaf, 0x87, 0x69, 0xff, 0xcf, 0xcb, 0x50, 0x6d, 0x20,
+    0xae, 0xeb, 0x7a, 0x76, 0x79, 0x6b, 0x34, 0xb3, 0x7c, 0x64, 0x77, 0xa1,
+    0x47, 0x4d, 0xad, 0xe4, 0xde, 0xf2, 0x2b, 0x1e, 0xed, 0x91, 0x38, 0x00,
+    0x1b, 0xed, 0x25, 0x6a, 0xef, 0xaa, 0x47, 0x55, 0x01, 0x7d, 0xf6, 0x65,
+    0xb7, 0x9d, 0xf3, 0x49, 0xbb, 0x73, 0x8d, 0xe1, 0x5f, 0xf2, 0xa9, 0xde,
+    0x03, 0x2f, 0x6f, 0x70, 0xc2, 0xf4, 0x05, 0x41, 0xe9, 0xda, 0x83, 0x77,
+    0xf0, 0x09, 0x3b, 0x3f, 0x1d, 0x12, 0x30, 0x5f, 0x40, 0xb3, 0x4c, 0xd2,
+    0x1d, 0x44, 0x77, 0x40, 0x0e, 0x9e, 0xa8, 0xe7, 0x12, 0x70, 0x2d, 0x59,
+    0x49, 0x6b, 0x84, 0x3e, 0xf0, 0x46, 0x23, 0x2f, 0x94, 0x86, 0x81, 0x77,
+    0xce, 0xd0, 0xa0, 0x7c, 0xc7, 0x8f, 0x03, 0x5f, 0xc5, 0x09, 0xe3, 0x9a,
+    0xf4, 0x9f, 0x87, 0x47, 0x22, 0x37, 0x73, 0x41, 0xb5, 0xe1, 0xe5, 0x4c,
+    0x54, 0xff, 0xed, 0x02, 0x9f, 0x91, 0x17, 0x77, 0x35, 0x61, 0xd0, 0xea,
+    0x1f, 0x08, 0x98, 0x36, 0x7d, 0x52, 0x67, 0xb9, 0xcf, 0x68, 0x90, 0xf3,
+    0xad, 0x97, 0xbb, 0x59, 0xe2, 0x3f, 0xe4, 0x75, 0x79, 0xfa, 0x44, 0x09,
+    0xed, 0xee, 0xe1, 0xb6, 0x26, 0x4e, 0x00, 0x88, 0x1a, 0xbf, 0xe2, 0xa8,
+    0xee, 0x0a, 0xca, 0xb2, 0xab, 0x09, 0xb3, 0x14, 0xd8, 0x3e, 0x08, 0x07,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xc9, 0xe5, 0xe9, 0xec, 0x27, 0x81, 0x1b, 0x6b, 0xa9, 0x4a, 0x79, 0x10,
+    0x7b, 0xb1, 0x9e, 0xcf, 0x06, 0xe1, 0x31, 0x27, 0x1e, 0xf7, 0xab, 0x69,
+    0xb7, 0xda, 0xa0, 0x24, 0xf8, 0xb3, 0x75, 0x8a, 0x17, 0x02, 0x8c, 0x90,
+    0xe8, 0xca, 0xf2, 0x39, 0x6b, 0x1f, 0x15, 0x24, 0xb4, 0xa4, 0x02, 0x2f,
+    0x2c, 0x42, 0xcf, 0xb3, 0x5e, 0xc1, 0xb7, 0x72, 0x69, 0x8f, 0x21, 0xe8,
+    0xee, 0x12, 0xbd, 0x15, 0xc4, 0x24, 0x76, 0x2a, 0x29, 0x61, 0x25, 0x0e,
+    0x31, 0xaf, 0xbb, 0x3b, 0x05, 0xdc, 0x1f, 0x2c, 0xd4, 0x9f, 0x72, 0x91,
+    0x9f, 0x72, 0x52, 0x0b, 0x77, 0x56, 0x82, 0xa1, 0x9a, 0x19, 0xaf, 0xc6
+};
+static const unsigned char mlsag_vector2_msg32[32] = {
+    0xca, 0xc1, 0x12, 0xcd, 0xfe, 0xda, 0x45, 0x96, 0x41, 0xeb, 0x95, 0x7e,
+    0x3c, 0xda, 0x06, 0x7e, 0x64, 0xdc, 0xec, 0x67, 0x79, 0x66, 0xa8, 0x85,
+    0x7e, 0xd9, 0xad, 0x6d, 0x31, 0xea, 0xee, 0x17
+};
+static const unsigned char mlsag_vector2_c0[32] = {
+    0xdb, 0x70, 0x9a, 0x87, 0xf4, 0x16, 0x8c, 0xe6, 0x60, 0x89, 0xce, 0xff,
+    0xd7, 0x1c, 0xea, 0xcf, 0x98, 0x5b, 0x0b, 0x37, 0x19, 0xe3, 0x14, 0x3c,
+    0x14, 0x69, 0x9c, 0x23, 0x5c, 0x2a, 0x2b, 0x33
+};
+static const unsigned char mlsag_vector2_s[384] = {
+    0x8c, 0x8f, 0x65, 0xaf, 0x87, 0x69, 0xff, 0xcf, 0xcb, 0x50, 0x6d, 0x20,
+    0xae, 0xeb, 0x7a, 0x76, 0x79, 0x6b, 0x34, 0xb3, 0x7c, 0x64, 0x77, 0xa1,
+    0x47, 0x4d, 0xad, 0xe4, 0xde, 0xf2, 0x2b, 0x1e, 0xed, 0x91, 0x38, 0x00,
+    0x1b, 0xed, 0x25, 0x6a, 0xef, 0xaa, 0x47, 0x55, 0x01, 0x7d, 0xf6, 0x65,
+    0xb7, 0x9d, 0xf3, 0x49, 0xbb, 0x73, 0x8d, 0xe1, 0x5f, 0xf2, 0xa9, 0xde,
+    0x03, 0x2f, 0x6f, 0x70, 0xc2, 0xf4, 0x05, 0x41, 0xe9, 0xda, 0x83, 0x77,
+    0xf0, 0x09, 0x3b, 0x3f, 0x1d, 0x12, 0x30, 0x5f, 0x40, 0xb3, 0x4c, 0xd2,
+    0x1d, 0x44, 0x77, 0x40, 0x0e, 0x9e, 0xa8, 0xe7, 0x12, 0x70, 0x2d, 0x59,
+    0x49, 0x6b, 0x84, 0x3e, 0xf0, 0x46, 0x23, 0x2f, 0x94, 0x86, 0x81, 0x77,
+    0xce, 0xd0, 0xa0, 0x7c, 0xc7, 0x8f, 0x03, 0x5f, 0xc5, 0x09, 0xe3, 0x9a,
+    0xf4, 0x9f, 0x87, 0x47, 0x22, 0x37, 0x73, 0x41, 0xb5, 0xe1, 0xe5, 0x4c,
+    0x54, 0xff, 0xed, 0x02, 0x9f, 0x91, 0x17, 0x77, 0x35, 0x61, 0xd0, 0xea,
+    0x1f, 0x08, 0x98, 0x36, 0x7d, 0x52, 0x67, 0xb9, 0xcf, 0x68, 0x90, 0xf3,
+    0xad, 0x97, 0xbb, 0x59, 0xe2, 0x3f, 0xe4, 0x75, 0x79, 0xfa, 0x44, 0x09,
+    0xed, 0xee, 0xe1, 0xb6, 0x26, 0x4e, 0x00, 0x88, 0x1a, 0xbf, 0xe2, 0xa8,
+    0xee, 0x0a, 0xca, 0xb2, 0xab, 0x09, 0xb3, 0x14, 0xd8, 0x3e, 0x08, 0x07,
+    0x43, 0x97, 0x9b, 0x11, 0xde, 0x9b, 0x0d, 0x6b, 0xd2, 0x1b, 0x57, 0x16,
+    0xcd, 0xf4, 0xdb, 0x19, 0x2d, 0x09, 0x91, 0xab, 0x41, 0xb1, 0x0e, 0x2e,
+    0xef, 0xb1, 0xec, 0x44, 0xa8, 0xe6, 0x75, 0x9d, 0x31, 0x2d, 0x04, 0x96,
+    0x91, 0x3d, 0x01, 0x0d, 0x8d, 0xaf, 0x33, 0x35, 0x28, 0x6d, 0x08, 0x1d,
+    0x1d, 0x38, 0xe0, 0xa9, 0x97, 0xdf, 0x62, 0xaf, 0xa8, 0xcc, 0xd5, 0x84,
+    0x88, 0xa2, 0xbc, 0x84, 0x4f, 0x6a, 0x66, 0x60, 0xf7, 0xfb, 0x9e, 0x78,
+    0x92, 0xfa, 0xdd, 0xe5, 0xf6, 0xa9, 0x83, 0x1f, 0x94, 0x11, 0x3b, 0x07,
+    0xf0, 0xf9, 0x12, 0xda, 0x16, 0x9a, 0x97, 0x63, 0x28, 0x30, 0x73, 0xd8,
+    0xc9, 0xe5, 0xe9, 0xec, 0x27, 0x81, 0x1b, 0x6b, 0xa9, 0x4a, 0x79, 0x10,
+    0x7b, 0xb1, 0x9e, 0xcf, 0x06, 0xe1, 0x31, 0x27, 0x1e, 0xf7, 0xab, 0x69,
+    0xb7, 0xda, 0xa0, 0x24, 0xf8, 0xb3, 0x75, 0x8a, 0x17, 0x02, 0x8c, 0x90,
+    0xe8, 0xca, 0xf2, 0x39, 0x6b, 0x1f, 0x15, 0x24, 0xb4, 0xa4, 0x02, 0x2f,
+    0x2c, 0x42, 0xcf, 0xb3, 0x5e, 0xc1, 0xb7, 0x72, 0x69, 0x8f, 0x21, 0xe8,
+    0xee, 0x12, 0xbd, 0x15, 0xc4, 0x24, 0x76, 0x2a, 0x29, 0x61, 0x25, 0x0e,
+    0x31, 0xaf, 0xbb, 0x3b, 0x05, 0xdc, 0x1f, 0x2c, 0xd4, 0x9f, 0x72, 0x91,
+    0x9f, 0x72, 0x52, 0x0b, 0x77, 0x56, 0x82, 0xa1, 0x9a, 0x19, 0xaf, 0xc6
+};
+
+typedef struct {
+    size_t n_rows;
+    size_t n_cols;
+    size_t index;
+    const unsigned char *pubkeys;
+    const unsigned char *keyimages;
+    const unsigned char *seckeys;
+    const unsigned char *alphas;
+    const unsigned char *nonces;
+    const unsigned char *msg32;
+    const unsigned char *c0;
+    const unsigned char *s;
+} mlsag_test_vector;
+
+static const mlsag_test_vector mlsag_test_vectors[2] = {
+    {1, 2, 1, mlsag_vector1_pubkeys, mlsag_vector1_keyimages, mlsag_vector1_seckeys, mlsag_vector1_alphas, mlsag_vector1_nonces, mlsag_vector1_msg32, mlsag_vector1_c0, mlsag_vector1_s},
+    {3, 4, 2, mlsag_vector2_pubkeys, mlsag_vector2_keyimages, mlsag_vector2_seckeys, mlsag_vector2_alphas, mlsag_vector2_nonces, mlsag_vector2_msg32, mlsag_vector2_c0, mlsag_vector2_s}
+};
+
+/* The module must produce the key images and signatures of the legacy wallet byte for byte */
+void test_mlsag_sign_vectors(void) {
+    size_t k, i;
+    for (k = 0; k < sizeof(mlsag_test_vectors) / sizeof(mlsag_test_vectors[0]); k++) {
+        const mlsag_test_vector *v = &mlsag_test_vectors[k];
+        unsigned char keyimage[33];
+        unsigned char s[32 * MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+        unsigned char c0[32];
+        for (i = 0; i < v->n_rows; i++) {
+            CHECK(secp256k1_mlsag_keyimage(ctx, keyimage, &v->pubkeys[33 * (v->index * v->n_rows + i)], &v->seckeys[32 * i]));
+            CHECK(memcmp(keyimage, &v->keyimages[33 * i], 33) == 0);
+        }
+        memcpy(s, v->nonces, 32 * v->n_rows * v->n_cols);
+        CHECK(secp256k1_mlsag_sign(ctx, c0, s, v->pubkeys, v->keyimages, v->seckeys, v->alphas, v->msg32, v->n_rows, v->n_cols, v->index));
+        CHECK(memcmp(c0, v->c0, 32) == 0);
+        CHECK(memcmp(s, v->s, 32 * v->n_rows * v->n_cols) == 0);
+    }
+}
+
+/* Signatures of the legacy wallet must verify, and stop verifying once any part is changed */
+void test_mlsag_verify_vectors(void) {
+    size_t k;
+    for (k = 0; k < sizeof(mlsag_test_vectors) / sizeof(mlsag_test_vectors[0]); k++) {
+        const mlsag_test_vector *v = &mlsag_test_vectors[k];
+        const size_t n = v->n_rows * v->n_cols;
+        unsigned char pubkeys[33 * MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+        unsigned char keyimages[33 * MLSAG_TEST_MAX_ROWS];
+        unsigned char s[32 * MLSAG_TEST_MAX_ROWS * MLSAG_TEST_MAX_COLS];
+        unsigned char msg32[32];
+        unsigned char c0[32];
+        memcpy(pubkeys, v->pubkeys, 33 * n);
+        memcpy(keyimages, v->keyimages, 33 * v->n_rows);
+        memcpy(s, v->s, 32 * n);
+        memcpy(msg32, v->msg32, 32);
+        memcpy(c0, v->c0, 32);
+        CHECK(secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        CHECK(test_mlsag_verify_parsed(c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+
+        c0[0] ^= 1;
+        CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        c0[0] ^= 1;
+        msg32[31] ^= 1;
+        CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        msg32[31] ^= 1;
+        s[32 * (n - 1)] ^= 1;
+        CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        CHECK(!test_mlsag_verify_parsed(c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        s[32 * (n - 1)] ^= 1;
+        /* Swapping two ring members keeps every key valid but breaks the chain */
+        memcpy(pubkeys, &v->pubkeys[33 * (n - 1)], 33);
+        memcpy(&pubkeys[33 * (n - 1)], v->pubkeys, 33);
+        CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        memcpy(pubkeys, v->pubkeys, 33 * n);
+        memcpy(keyimages, &v->keyimages[33 * (v->n_rows - 1)], 33);
+        memcpy(&keyimages[33 * (v->n_rows - 1)], v->keyimages, 33);
+        if (v->n_rows > 1) {
+            CHECK(!secp256k1_mlsag_verify(ctx, c0, s, pubkeys, keyimages, msg32, v->n_rows, v->n_cols));
+        }
+    }
+}
+
+void run_mlsag_tests(void) {
+    size_t i;
+    test_mlsag_api();
+    test_mlsag_sign_vectors();
+    test_mlsag_verify_vectors();
+    for (i = 0; i < (size_t)count; i++) {
+        test_mlsag_sign(1 + i % MLSAG_TEST_MAX_ROWS, 1 + i % MLSAG_TEST_MAX_COLS);
+    }
+}
+
+#endif
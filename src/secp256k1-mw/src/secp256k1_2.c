@@ -35,6 +35,10 @@
 # include "include/secp256k1_bulletproofs.h"
 #endif
 
+#ifdef ENABLE_MODULE_MLSAG
+# include "include/secp256k1_mlsag.h"
+#endif
+
 #define ARG_CHECK(cond) do { \
     if (EXPECT(!(cond), 0)) { \
         secp256k1_callback_call(&ctx->illegal_callback, #cond); \
@@ -640,6 +644,10 @@ int secp256k1_ec_pubkey_combine2(const secp256k1_context2* ctx, secp256k1_pubkey
 # include "modules/bulletproofs/main_impl.h"
 #endif
 
+#ifdef ENABLE_MODULE_MLSAG
+# include "modules/mlsag/main_impl.h"
+#endif
+
 #ifdef ENABLE_MODULE_WHITELIST
 # include "modules/whitelist/main_impl.h"
 #endif
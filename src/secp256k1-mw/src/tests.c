@@ -5070,6 +5070,10 @@ void run_ecdsa_openssl(void) {
 # include "modules/bulletproofs/tests_impl.h"
 #endif
 
+#ifdef ENABLE_MODULE_MLSAG
+# include "modules/mlsag/tests_impl.h"
+#endif
+
 #ifdef ENABLE_MODULE_WHITELIST
 # include "modules/whitelist/tests_impl.h"
 #endif
@@ -5214,6 +5218,10 @@ int main(int argc, char **argv) {
     run_bulletproofs_tests();
 #endif
 
+#ifdef ENABLE_MODULE_MLSAG
+    run_mlsag_tests();
+#endif
+
 #ifdef ENABLE_MODULE_WHITELIST
     /* Key whitelisting tests */
     run_whitelist_tests();
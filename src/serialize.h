@@ -17,6 +17,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -551,6 +552,16 @@ void Serialize(Stream& os, const std::map<K, T, Pred, A>& m, int nType, int nVer
 template <typename Stream, typename K, typename T, typename Pred, typename A>
 void Unserialize(Stream& is, std::map<K, T, Pred, A>& m, int nType, int nVersion);
 
+/**
+ * unordered_map, in the same format as map
+ */
+template <typename K, typename T, typename H, typename Pred, typename A>
+unsigned int GetSerializeSize(const std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion);
+template <typename Stream, typename K, typename T, typename H, typename Pred, typename A>
+void Serialize(Stream& os, const std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion);
+template <typename Stream, typename K, typename T, typename H, typename Pred, typename A>
+void Unserialize(Stream& is, std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion);
+
 /**
  * set
  */
@@ -851,6 +862,39 @@ void Unserialize(Stream& is, std::map<K, T, Pred, A>& m, int nType, int nVersion
 }
 
 
+/**
+ * unordered_map
+ */
+template <typename K, typename T, typename H, typename Pred, typename A>
+unsigned int GetSerializeSize(const std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion)
+{
+    unsigned int nSize = GetSizeOfCompactSize(m.size());
+    for (typename std::unordered_map<K, T, H, Pred, A>::const_iterator mi = m.begin(); mi != m.end(); ++mi)
+        nSize += GetSerializeSize((*mi), nType, nVersion);
+    return nSize;
+}
+
+template <typename Stream, typename K, typename T, typename H, typename Pred, typename A>
+void Serialize(Stream& os, const std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion)
+{
+    WriteCompactSize(os, m.size());
+    for (typename std::unordered_map<K, T, H, Pred, A>::const_iterator mi = m.begin(); mi != m.end(); ++mi)
+        Serialize(os, (*mi), nType, nVersion);
+}
+
+template <typename Stream, typename K, typename T, typename H, typename Pred, typename A>
+void Unserialize(Stream& is, std::unordered_map<K, T, H, Pred, A>& m, int nType, int nVersion)
+{
+    m.clear();
+    unsigned int nSize = ReadCompactSize(is);
+    for (unsigned int i = 0; i < nSize; i++) {
+        std::pair<K, T> item;
+        Unserialize(is, item, nType, nVersion);
+        m.insert(item);
+    }
+}
+
+
 /**
  * set
  */
@@ -21,12 +21,7 @@
 #include <boost/foreach.hpp>
 
 
-std::map<uint256, CTransaction> mapTxLockReq;
-std::map<uint256, CTransaction> mapTxLockReqRejected;
-std::map<uint256, CConsensusVote> mapTxLockVote;
-std::map<uint256, CTransactionLock> mapTxLocks;
-std::map<COutPoint, uint256> mapLockedInputs;
-std::map<uint256, int64_t> mapUnknownVotes; //track votes with no tx for DOS
+CSwiftTXManager swiftTX;
 int nCompleteTXLocks;
 
 //txlock - Locks transaction
@@ -36,7 +31,7 @@ int nCompleteTXLocks;
 //         Send "txvote", CTransaction, Signature, Approve
 //step 3.) Top 1 masternode, waits for SWIFTTX_SIGNATURES_REQUIRED messages. Upon success, sends "txlock'
 
-void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
+void CSwiftTXManager::ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv)
 {
     if (fLiteMode) return; //disable all masternode related functionality
     if (!masternodeSync.IsBlockchainSynced()) return;
@@ -50,7 +45,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
         pfrom->AddInventoryKnown(inv);
         GetMainSignals().Inventory(inv.hash);
 
-        if (mapTxLockReq.count(tx.GetHash()) || mapTxLockReqRejected.count(tx.GetHash())) {
+        if (HasLockRequest(tx.GetHash())) {
             return;
         }
 
@@ -82,7 +77,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
 
             DoConsensusVote(tx, nBlockHeight);
 
-            mapTxLockReq.insert(std::make_pair(tx.GetHash(), tx));
+            AddLockRequest(tx);
 
             LogPrintf("ProcessMessageSwiftTX::ix - Transaction Lock Request: %s %s : accepted %s\n",
                 pfrom->addr.ToString().c_str(), pfrom->cleanSubVer.c_str(),
@@ -95,6 +90,7 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
             return;
 
         } else {
+            LOCK(cs);
             mapTxLockReqRejected.insert(std::make_pair(tx.GetHash(), tx));
 
             // can we get the conflicting transaction as proof?
@@ -104,16 +100,14 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
                 tx.GetHash().ToString().c_str());
 
             for (const CTxIn& in : tx.vin) {
-                if (!mapLockedInputs.count(in.prevout)) {
-                    mapLockedInputs.insert(std::make_pair(in.prevout, tx.GetHash()));
-                }
+                mapLockedInputs.insert(std::make_pair(in.prevout, tx.GetHash()));
             }
 
             // resolve conflicts
-            std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(tx.GetHash());
+            auto i = mapTxLocks.find(tx.GetHash());
             if (i != mapTxLocks.end()) {
                 //we only care if we have a complete tx lock
-                if ((*i).second.CountSignatures() >= SWIFTTX_SIGNATURES_REQUIRED) {
+                if (i->second.CountSignatures() >= SWIFTTX_SIGNATURES_REQUIRED) {
                     if (!CheckForConflictingLocks(tx)) {
                         LogPrintf("ProcessMessageSwiftTX::ix - Found Existing Complete IX Lock\n");
 
@@ -133,12 +127,13 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
         CInv inv(MSG_TXLOCK_VOTE, ctx.GetHash());
         pfrom->AddInventoryKnown(inv);
 
-        if (mapTxLockVote.count(ctx.GetHash())) {
-            return;
+        {
+            LOCK(cs);
+            if (!mapTxLockVote.insert(std::make_pair(ctx.GetHash(), ctx)).second) {
+                return;
+            }
         }
 
-        mapTxLockVote.insert(std::make_pair(ctx.GetHash(), ctx));
-
         if (ProcessConsensusVote(pfrom, ctx)) {
             //Spam/Dos protection
             /*
@@ -146,26 +141,31 @@ void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& v
                 This tracks those messages and allows it at the same rate of the rest of the network, if
                 a peer violates it, it will simply be ignored
             */
-            if (!mapTxLockReq.count(ctx.txHash) && !mapTxLockReqRejected.count(ctx.txHash)) {
-                if (!mapUnknownVotes.count(ctx.vinMasternode.prevout.hash)) {
-                    mapUnknownVotes[ctx.vinMasternode.prevout.hash] = GetTime() + (60 * 10);
-                }
+            {
+                LOCK(cs);
+                if (!mapTxLockReq.count(ctx.txHash) && !mapTxLockReqRejected.count(ctx.txHash)) {
+                    const uint256& hashMasternode = ctx.vinMasternode.prevout.hash;
+                    if (!mapUnknownVotes.count(hashMasternode)) {
+                        SetUnknownVoteTime(hashMasternode, GetTime() + (60 * 10));
+                    }
 
-                if (mapUnknownVotes[ctx.vinMasternode.prevout.hash] > GetTime() &&
-                    mapUnknownVotes[ctx.vinMasternode.prevout.hash] - GetAverageVoteTime() > 60 * 10) {
-                    LogPrintf("ProcessMessageSwiftTX::ix - masternode is spamming transaction votes: %s %s\n",
-                        ctx.vinMasternode.ToString().c_str(),
-                        ctx.txHash.ToString().c_str());
-                    return;
-                } else {
-                    mapUnknownVotes[ctx.vinMasternode.prevout.hash] = GetTime() + (60 * 10);
+                    int64_t nVoteTime = mapUnknownVotes[hashMasternode];
+                    if (nVoteTime > GetTime() && nVoteTime - GetAverageVoteTime() > 60 * 10) {
+                        LogPrintf("ProcessMessageSwiftTX::ix - masternode is spamming transaction votes: %s %s\n",
+                            ctx.vinMasternode.ToString().c_str(),
+                            ctx.txHash.ToString().c_str());
+                        return;
+                    } else {
+                        SetUnknownVoteTime(hashMasternode, GetTime() + (60 * 10));
+                    }
                 }
             }
             RelayInv(inv);
         }
 
-        if (mapTxLockReq.count(ctx.txHash) && GetTransactionLockSignatures(ctx.txHash) == SWIFTTX_SIGNATURES_REQUIRED) {
-            GetMainSignals().NotifyTransactionLock(mapTxLockReq[ctx.txHash]);
+        CTransaction tx;
+        if (GetLockRequest(ctx.txHash, tx) && GetTransactionLockSignatures(ctx.txHash) == SWIFTTX_SIGNATURES_REQUIRED) {
+            GetMainSignals().NotifyTransactionLock(tx);
         }
 
         return;
@@ -214,7 +214,7 @@ bool IsIXTXValid(const CTransaction& txCollateral)
     return true;
 }
 
-int64_t CreateNewLock(CTransaction tx)
+int64_t CSwiftTXManager::CreateNewLock(const CTransaction& tx)
 {
     int64_t nTxAge = 0;
     BOOST_REVERSE_FOREACH (CTxIn i, tx.vin) {
@@ -231,19 +231,15 @@ int64_t CreateNewLock(CTransaction tx)
         This prevents attackers from using transaction mallibility to predict which masternodes
         they'll use.
     */
-    int nBlockHeight = (chainActive.Tip()->nHeight - nTxAge) + 4;
+    int nBlockHeight = (WITH_LOCK(cs_main, return chainActive.Height()) - nTxAge) + 4;
 
-    if (!mapTxLocks.count(tx.GetHash())) {
+    LOCK(cs);
+    auto it = mapTxLocks.find(tx.GetHash());
+    if (it == mapTxLocks.end()) {
         LogPrintf("CreateNewLock - New Transaction Lock %s !\n", tx.GetHash().ToString().c_str());
-
-        CTransactionLock newLock;
-        newLock.nBlockHeight = nBlockHeight;
-        newLock.nExpiration = GetTime() + (60 * 60); //locks expire after 60 minutes (24 confirmations)
-        newLock.nTimeout = GetTime() + (60 * 5);
-        newLock.txHash = tx.GetHash();
-        mapTxLocks.insert(std::make_pair(tx.GetHash(), newLock));
+        GetOrCreateLock(tx.GetHash(), nBlockHeight);
     } else {
-        mapTxLocks[tx.GetHash()].nBlockHeight = nBlockHeight;
+        it->second.nBlockHeight = nBlockHeight;
         LogPrint(BCLog::MASTERNODE, "CreateNewLock - Transaction Lock Exists %s !\n", tx.GetHash().ToString().c_str());
     }
 
@@ -251,8 +247,32 @@ int64_t CreateNewLock(CTransaction tx)
     return nBlockHeight;
 }
 
+CTransactionLock& CSwiftTXManager::GetOrCreateLock(const uint256& txHash, int nBlockHeight)
+{
+    AssertLockHeld(cs);
+    auto ret = mapTxLocks.insert(std::make_pair(txHash, CTransactionLock()));
+    CTransactionLock& txLock = ret.first->second;
+    if (ret.second) {
+        txLock.nBlockHeight = nBlockHeight;
+        txLock.nExpiration = GetTime() + (60 * 60); //locks expire after 60 minutes (24 confirmations)
+        txLock.nTimeout = GetTime() + (60 * 5);
+        txLock.txHash = txHash;
+        queueExpiration.push(std::make_pair((int64_t)txLock.nExpiration, txHash));
+    }
+    return txLock;
+}
+
+void CSwiftTXManager::SetLockExpiration(const uint256& txHash, int64_t nExpiration)
+{
+    AssertLockHeld(cs);
+    auto it = mapTxLocks.find(txHash);
+    if (it == mapTxLocks.end()) return;
+    it->second.nExpiration = nExpiration;
+    queueExpiration.push(std::make_pair(nExpiration, txHash));
+}
+
 // check if we need to vote on this transaction
-void DoConsensusVote(CTransaction& tx, int64_t nBlockHeight)
+void CSwiftTXManager::DoConsensusVote(const CTransaction& tx, int64_t nBlockHeight)
 {
     if (!fMasterNode) return;
 
@@ -286,14 +306,17 @@ void DoConsensusVote(CTransaction& tx, int64_t nBlockHeight)
         return;
     }
 
-    mapTxLockVote[ctx.GetHash()] = ctx;
+    {
+        LOCK(cs);
+        mapTxLockVote[ctx.GetHash()] = ctx;
+    }
 
     CInv inv(MSG_TXLOCK_VOTE, ctx.GetHash());
     RelayInv(inv);
 }
 
 //received a consensus vote
-bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx)
+bool CSwiftTXManager::ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx)
 {
     int n = mnodeman.GetMasternodeRank(ctx.vinMasternode, ctx.nBlockHeight, MIN_SWIFTTX_PROTO_VERSION);
 
@@ -320,71 +343,55 @@ bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx)
         return false;
     }
 
-    if (!mapTxLocks.count(ctx.txHash)) {
-        LogPrintf("SwiftX::ProcessConsensusVote - New Transaction Lock %s !\n", ctx.txHash.ToString().c_str());
-
-        CTransactionLock newLock;
-        newLock.nBlockHeight = 0;
-        newLock.nExpiration = GetTime() + (60 * 60);
-        newLock.nTimeout = GetTime() + (60 * 5);
-        newLock.txHash = ctx.txHash;
-        mapTxLocks.insert(std::make_pair(ctx.txHash, newLock));
-    } else
-        LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Exists %s !\n", ctx.txHash.ToString().c_str());
-
-    //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(ctx.txHash);
-    if (i != mapTxLocks.end()) {
-        (*i).second.AddSignature(ctx);
-
-#ifdef ENABLE_WALLET
-        if (pwalletMain) {
-            //when we get back signatures, we'll count them as requests. Otherwise the client will think it didn't propagate.
-            if (pwalletMain->mapRequestCount.count(ctx.txHash))
-                pwalletMain->mapRequestCount[ctx.txHash]++;
+    // the wallet is updated once the lock is complete and does not conflict
+    bool fUpdateWallet = false;
+    {
+        LOCK(cs);
+        if (!mapTxLocks.count(ctx.txHash)) {
+            LogPrintf("SwiftX::ProcessConsensusVote - New Transaction Lock %s !\n", ctx.txHash.ToString().c_str());
+        } else
+            LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Exists %s !\n", ctx.txHash.ToString().c_str());
+
+        //compile consessus vote
+        CTransactionLock& txLock = GetOrCreateLock(ctx.txHash, 0);
+        txLock.AddSignature(ctx);
+
+        int nSignatures = txLock.CountSignatures();
+        LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Votes %d - %s !\n", nSignatures, ctx.GetHash().ToString().c_str());
+
+        if (nSignatures >= SWIFTTX_SIGNATURES_REQUIRED) {
+            LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Is Complete %s !\n", txLock.GetHash().ToString().c_str());
+
+            auto itReq = mapTxLockReq.find(ctx.txHash);
+            if (itReq == mapTxLockReq.end()) {
+                fUpdateWallet = true;
+            } else if (!CheckForConflictingLocks(itReq->second)) {
+                fUpdateWallet = true;
+                for (const CTxIn& in : itReq->second.vin) {
+                    mapLockedInputs.insert(std::make_pair(in.prevout, ctx.txHash));
+                }
+            }
         }
-#endif
-
-        LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Votes %d - %s !\n", (*i).second.CountSignatures(), ctx.GetHash().ToString().c_str());
-
-        if ((*i).second.CountSignatures() >= SWIFTTX_SIGNATURES_REQUIRED) {
-            LogPrint(BCLog::MASTERNODE, "SwiftX::ProcessConsensusVote - Transaction Lock Is Complete %s !\n", (*i).second.GetHash().ToString().c_str());
+    }
 
-            CTransaction& tx = mapTxLockReq[ctx.txHash];
-            if (!CheckForConflictingLocks(tx)) {
 #ifdef ENABLE_WALLET
-                if (pwalletMain) {
-                    if (pwalletMain->UpdatedTransaction((*i).second.txHash)) {
-                        nCompleteTXLocks++;
-                    }
-                }
-#endif
-
-                if (mapTxLockReq.count(ctx.txHash)) {
-                    for (const CTxIn& in : tx.vin) {
-                        if (!mapLockedInputs.count(in.prevout)) {
-                            mapLockedInputs.insert(std::make_pair(in.prevout, ctx.txHash));
-                        }
-                    }
-                }
-
-                // resolve conflicts
+    if (pwalletMain) {
+        //when we get back signatures, we'll count them as requests. Otherwise the client will think it didn't propagate.
+        if (pwalletMain->mapRequestCount.count(ctx.txHash))
+            pwalletMain->mapRequestCount[ctx.txHash]++;
 
-                //if this tx lock was rejected, we need to remove the conflicting blocks
-                if (mapTxLockReqRejected.count((*i).second.txHash)) {
-                    //reprocess the last 15 blocks
-                }
-            }
+        if (fUpdateWallet && pwalletMain->UpdatedTransaction(ctx.txHash)) {
+            nCompleteTXLocks++;
         }
-        return true;
     }
+#endif
 
-
-    return false;
+    return true;
 }
 
-bool CheckForConflictingLocks(CTransaction& tx)
+bool CSwiftTXManager::CheckForConflictingLocks(const CTransaction& tx)
 {
+    AssertLockHeld(cs);
     /*
         It's possible (very unlikely though) to get 2 conflicting transaction locks approved by the network.
         In that case, they will cancel each other out.
@@ -393,72 +400,135 @@ bool CheckForConflictingLocks(CTransaction& tx)
         rescan the blocks and find they're acceptable and then take the chain with the most work.
     */
     for (const CTxIn& in : tx.vin) {
-        if (mapLockedInputs.count(in.prevout)) {
-            if (mapLockedInputs[in.prevout] != tx.GetHash()) {
-                LogPrintf("SwiftX::CheckForConflictingLocks - found two complete conflicting locks - removing both. %s %s", tx.GetHash().ToString().c_str(), mapLockedInputs[in.prevout].ToString().c_str());
-                if (mapTxLocks.count(tx.GetHash())) mapTxLocks[tx.GetHash()].nExpiration = GetTime();
-                if (mapTxLocks.count(mapLockedInputs[in.prevout])) mapTxLocks[mapLockedInputs[in.prevout]].nExpiration = GetTime();
-                return true;
-            }
+        auto it = mapLockedInputs.find(in.prevout);
+        if (it != mapLockedInputs.end() && it->second != tx.GetHash()) {
+            LogPrintf("SwiftX::CheckForConflictingLocks - found two complete conflicting locks - removing both. %s %s", tx.GetHash().ToString().c_str(), it->second.ToString().c_str());
+            SetLockExpiration(tx.GetHash(), GetTime());
+            SetLockExpiration(it->second, GetTime());
+            return true;
         }
     }
 
     return false;
 }
 
-int64_t GetAverageVoteTime()
+void CSwiftTXManager::SetUnknownVoteTime(const uint256& hash, int64_t nTime)
 {
-    std::map<uint256, int64_t>::iterator it = mapUnknownVotes.begin();
-    int64_t total = 0;
-    int64_t count = 0;
-
-    while (it != mapUnknownVotes.end()) {
-        total += it->second;
-        count++;
-        it++;
+    AssertLockHeld(cs);
+    auto ret = mapUnknownVotes.insert(std::make_pair(hash, nTime));
+    if (!ret.second) {
+        nUnknownVotesTimeTotal -= ret.first->second;
+        ret.first->second = nTime;
     }
+    nUnknownVotesTimeTotal += nTime;
+}
 
-    return total / count;
+int64_t CSwiftTXManager::GetAverageVoteTime() const
+{
+    AssertLockHeld(cs);
+    if (mapUnknownVotes.empty()) return 0;
+    return nUnknownVotesTimeTotal / (int64_t)mapUnknownVotes.size();
 }
 
-void CleanTransactionLocksList()
+void CSwiftTXManager::CleanTransactionLocksList()
 {
     if (chainActive.Tip() == NULL) return;
 
-    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.begin();
+    LOCK(cs);
+    int64_t nNow = GetTime();
+    while (!queueExpiration.empty() && queueExpiration.top().first < nNow) {
+        uint256 txHash = queueExpiration.top().second;
+        queueExpiration.pop();
 
-    while (it != mapTxLocks.end()) {
-        if (GetTime() > it->second.nExpiration) { //keep them for an hour
-            LogPrintf("Removing old transaction lock %s\n", it->second.txHash.ToString().c_str());
+        auto it = mapTxLocks.find(txHash);
+        if (it == mapTxLocks.end() || nNow <= it->second.nExpiration) continue; //keep them for an hour
 
-            if (mapTxLockReq.count(it->second.txHash)) {
-                CTransaction& tx = mapTxLockReq[it->second.txHash];
+        LogPrintf("Removing old transaction lock %s\n", txHash.ToString().c_str());
 
-                for (const CTxIn& in : tx.vin)
-                    mapLockedInputs.erase(in.prevout);
+        auto itReq = mapTxLockReq.find(txHash);
+        if (itReq != mapTxLockReq.end()) {
+            for (const CTxIn& in : itReq->second.vin)
+                mapLockedInputs.erase(in.prevout);
 
-                mapTxLockReq.erase(it->second.txHash);
-                mapTxLockReqRejected.erase(it->second.txHash);
+            mapTxLockReq.erase(itReq);
+            mapTxLockReqRejected.erase(txHash);
 
-                for (CConsensusVote& v : it->second.vecConsensusVotes)
-                    mapTxLockVote.erase(v.GetHash());
-            }
-
-            mapTxLocks.erase(it++);
-        } else {
-            it++;
+            for (CConsensusVote& v : it->second.vecConsensusVotes)
+                mapTxLockVote.erase(v.GetHash());
         }
+
+        mapTxLocks.erase(it);
     }
 }
 
-int GetTransactionLockSignatures(uint256 txHash)
+int CSwiftTXManager::CountLockSignatures(const uint256& txHash) const
+{
+    LOCK(cs);
+    auto it = mapTxLocks.find(txHash);
+    if (it != mapTxLocks.end()) return it->second.CountSignatures();
+
+    return -1;
+}
+
+int CSwiftTXManager::GetTransactionLockSignatures(const uint256& txHash) const
 {
     if(fLargeWorkForkFound || fLargeWorkInvalidChainFound) return -2;
 
-    std::map<uint256, CTransactionLock>::iterator it = mapTxLocks.find(txHash);
-    if(it != mapTxLocks.end()) return it->second.CountSignatures();
+    return CountLockSignatures(txHash);
+}
 
-    return -1;
+bool CSwiftTXManager::IsTransactionLockTimedOut(const uint256& txHash) const
+{
+    LOCK(cs);
+    auto it = mapTxLocks.find(txHash);
+    if (it != mapTxLocks.end()) return GetTime() > it->second.nTimeout;
+
+    return false;
+}
+
+void CSwiftTXManager::AddLockRequest(const CTransaction& tx)
+{
+    LOCK(cs);
+    mapTxLockReq.insert(std::make_pair(tx.GetHash(), tx));
+}
+
+bool CSwiftTXManager::HasLockRequest(const uint256& txHash) const
+{
+    LOCK(cs);
+    return mapTxLockReq.count(txHash) || mapTxLockReqRejected.count(txHash);
+}
+
+bool CSwiftTXManager::GetLockRequest(const uint256& txHash, CTransaction& tx) const
+{
+    LOCK(cs);
+    auto it = mapTxLockReq.find(txHash);
+    if (it == mapTxLockReq.end()) return false;
+    tx = it->second;
+    return true;
+}
+
+bool CSwiftTXManager::HasLockVote(const uint256& hash) const
+{
+    LOCK(cs);
+    return mapTxLockVote.count(hash);
+}
+
+bool CSwiftTXManager::GetLockVote(const uint256& hash, CConsensusVote& vote) const
+{
+    LOCK(cs);
+    auto it = mapTxLockVote.find(hash);
+    if (it == mapTxLockVote.end()) return false;
+    vote = it->second;
+    return true;
+}
+
+bool CSwiftTXManager::GetLockedInput(const COutPoint& outpoint, uint256& txHash) const
+{
+    LOCK(cs);
+    auto it = mapLockedInputs.find(outpoint);
+    if (it == mapLockedInputs.end()) return false;
+    txHash = it->second;
+    return true;
 }
 
 uint256 CConsensusVote::GetHash() const
@@ -467,10 +537,15 @@ uint256 CConsensusVote::GetHash() const
 }
 
 
+std::string CConsensusVote::GetStrMessage() const
+{
+    return Hash(txHash.begin(), txHash.end(), BEGIN(nBlockHeight), END(nBlockHeight)).GetHex();
+}
+
 bool CConsensusVote::SignatureValid()
 {
     std::string strError = "";
-    std::string strMessage = Hash(txHash.begin(), txHash.end(), BEGIN(nBlockHeight), END(nBlockHeight)).ToString();
+    std::string strMessage = GetStrMessage();
 
     CMasternode* pmn = mnodeman.Find(vinMasternode);
 
@@ -493,7 +568,7 @@ bool CConsensusVote::Sign()
 
     CKey key2;
     CPubKey pubkey2;
-    std::string strMessage = Hash(txHash.begin(), txHash.end(), BEGIN(nBlockHeight), END(nBlockHeight)).GetHex();
+    std::string strMessage = GetStrMessage();
 
     if (!CMessageSigner::GetKeysFromSecret(strMasterNodePrivKey, key2, pubkey2)) {
         return error("%s : Invalid masternodeprivkey", __func__);
@@ -540,7 +615,7 @@ void CTransactionLock::AddSignature(CConsensusVote& cv)
     vecConsensusVotes.push_back(cv);
 }
 
-int CTransactionLock::CountSignatures()
+int CTransactionLock::CountSignatures() const
 {
     /*
         Only count signatures where the BlockHeight matches the transaction's blockheight.
@@ -550,7 +625,7 @@ int CTransactionLock::CountSignatures()
     if (nBlockHeight == 0) return -1;
 
     int n = 0;
-    for (CConsensusVote v : vecConsensusVotes) {
+    for (const CConsensusVote& v : vecConsensusVotes) {
         if (v.nBlockHeight == nBlockHeight) {
             n++;
         }
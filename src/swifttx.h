@@ -11,9 +11,13 @@
 #include "key.h"
 #include "main.h"
 #include "net.h"
+#include "saltedhasher.h"
 #include "sync.h"
 #include "util.h"
 
+#include <queue>
+#include <unordered_map>
+
 /*
     At 15 signatures, 1/2 of the masternode network can be owned by
     one party without comprimising the security of SwiftX
@@ -30,40 +34,16 @@
 class CConsensusVote;
 class CTransaction;
 class CTransactionLock;
+class CSwiftTXManager;
 
 static const int MIN_SWIFTTX_PROTO_VERSION = 70103;
 
-extern std::map<uint256, CTransaction> mapTxLockReq;
-extern std::map<uint256, CTransaction> mapTxLockReqRejected;
-extern std::map<uint256, CConsensusVote> mapTxLockVote;
-extern std::map<uint256, CTransactionLock> mapTxLocks;
-extern std::map<COutPoint, uint256> mapLockedInputs;
+extern CSwiftTXManager swiftTX;
 extern int nCompleteTXLocks;
 
 
-int64_t CreateNewLock(CTransaction tx);
-
 bool IsIXTXValid(const CTransaction& txCollateral);
 
-// if two conflicting locks are approved by the network, they will cancel out
-bool CheckForConflictingLocks(CTransaction& tx);
-
-void ProcessMessageSwiftTX(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
-
-//check if we need to vote on this transaction
-void DoConsensusVote(CTransaction& tx, int64_t nBlockHeight);
-
-//process consensus vote message
-bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx);
-
-// keep transaction locks in memory for an hour
-void CleanTransactionLocksList();
-
-// get the accepted transaction lock signatures
-int GetTransactionLockSignatures(uint256 txHash);
-
-int64_t GetAverageVoteTime();
-
 class CConsensusVote
 {
 public:
@@ -76,6 +56,7 @@ public:
 
     bool SignatureValid();
     bool Sign();
+    std::string GetStrMessage() const;
 
     ADD_SERIALIZE_METHODS;
 
@@ -99,7 +80,7 @@ public:
     int nTimeout;
 
     bool SignaturesValid();
-    int CountSignatures();
+    int CountSignatures() const;
     void AddSignature(CConsensusVote& cv);
 
     uint256 GetHash()
@@ -109,4 +90,71 @@ public:
 };
 
 
+
+/**
+ * Keeps the transaction lock requests, votes and locks.
+ *
+ * The state has its own lock, so votes are handled without cs_main. cs_main may be
+ * held when calling in, but cs_main, wallet and masternode locks are never taken
+ * while cs is held. Locks are removed through a queue ordered by expiration time.
+ */
+class CSwiftTXManager
+{
+private:
+    // critical section to protect the inner data structures
+    mutable RecursiveMutex cs;
+
+    std::unordered_map<uint256, CTransaction, CSaltedHasher> mapTxLockReq;
+    std::unordered_map<uint256, CTransaction, CSaltedHasher> mapTxLockReqRejected;
+    std::unordered_map<uint256, CConsensusVote, CSaltedHasher> mapTxLockVote;
+    std::unordered_map<uint256, CTransactionLock, CSaltedHasher> mapTxLocks;
+    std::unordered_map<COutPoint, uint256, CSaltedHasher> mapLockedInputs;
+    // track votes with no tx for DOS, with the sum of the times for GetAverageVoteTime
+    std::unordered_map<uint256, int64_t, CSaltedHasher> mapUnknownVotes;
+    int64_t nUnknownVotesTimeTotal;
+
+    // (expiration time, tx hash) of the locks, soonest first. An entry is stale
+    // when its lock is gone or was given a later expiration time.
+    typedef std::pair<int64_t, uint256> expiration_t;
+    std::priority_queue<expiration_t, std::vector<expiration_t>, std::greater<expiration_t> > queueExpiration;
+
+    CTransactionLock& GetOrCreateLock(const uint256& txHash, int nBlockHeight);
+    void SetLockExpiration(const uint256& txHash, int64_t nExpiration);
+    void SetUnknownVoteTime(const uint256& hash, int64_t nTime);
+    int64_t GetAverageVoteTime() const;
+    // if two conflicting locks are approved by the network, they will cancel out
+    bool CheckForConflictingLocks(const CTransaction& tx);
+
+public:
+    CSwiftTXManager() : nUnknownVotesTimeTotal(0) {}
+
+    void ProcessMessage(CNode* pfrom, std::string& strCommand, CDataStream& vRecv);
+
+    int64_t CreateNewLock(const CTransaction& tx);
+
+    //check if we need to vote on this transaction
+    void DoConsensusVote(const CTransaction& tx, int64_t nBlockHeight);
+
+    //process consensus vote message
+    bool ProcessConsensusVote(CNode* pnode, CConsensusVote& ctx);
+
+    // keep transaction locks in memory for an hour
+    void CleanTransactionLocksList();
+
+    // get the transaction lock signatures, -1 if there is no lock
+    int CountLockSignatures(const uint256& txHash) const;
+    // get the accepted transaction lock signatures
+    int GetTransactionLockSignatures(const uint256& txHash) const;
+    bool IsTransactionLockTimedOut(const uint256& txHash) const;
+
+    void AddLockRequest(const CTransaction& tx);
+    bool HasLockRequest(const uint256& txHash) const;
+    bool GetLockRequest(const uint256& txHash, CTransaction& tx) const;
+    bool HasLockVote(const uint256& hash) const;
+    bool GetLockVote(const uint256& hash, CConsensusVote& vote) const;
+
+    // the transaction an input is locked to, if any
+    bool GetLockedInput(const COutPoint& outpoint, uint256& txHash) const;
+};
+
 #endif
@@ -0,0 +1,119 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockindexsnapshot.h"
+#include "chain.h"
+#include "main.h"
+#include "test/test_prcycoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockindexsnapshot_tests, TestingSetup)
+
+static uint256 LinkHash(const CBlockIndex* pindex)
+{
+    return pindex ? pindex->GetBlockHash() : uint256();
+}
+
+static void CheckEntry(const CBlockIndex* pindex, const CBlockIndex* pexpected)
+{
+    BOOST_CHECK_EQUAL(pindex->GetBlockHash().GetHex(), pexpected->GetBlockHash().GetHex());
+    BOOST_CHECK_EQUAL(LinkHash(pindex->pprev).GetHex(), LinkHash(pexpected->pprev).GetHex());
+    BOOST_CHECK_EQUAL(LinkHash(pindex->pskip).GetHex(), LinkHash(pexpected->pskip).GetHex());
+    BOOST_CHECK_EQUAL(LinkHash(pindex->pprevPoA).GetHex(), LinkHash(pexpected->pprevPoA).GetHex());
+    BOOST_CHECK_EQUAL(LinkHash(pindex->pprevPoS).GetHex(), LinkHash(pexpected->pprevPoS).GetHex());
+    BOOST_CHECK_EQUAL(pindex->nChainWork.GetHex(), pexpected->nChainWork.GetHex());
+    BOOST_CHECK_EQUAL(pindex->nHeight, pexpected->nHeight);
+    BOOST_CHECK_EQUAL(pindex->nFile, pexpected->nFile);
+    BOOST_CHECK_EQUAL(pindex->nDataPos, pexpected->nDataPos);
+    BOOST_CHECK_EQUAL(pindex->nTx, pexpected->nTx);
+    BOOST_CHECK_EQUAL(pindex->nStatus, pexpected->nStatus);
+    BOOST_CHECK_EQUAL(pindex->nTime, pexpected->nTime);
+    BOOST_CHECK_EQUAL(pindex->nBits, pexpected->nBits);
+    BOOST_CHECK_EQUAL(pindex->nNonce, pexpected->nNonce);
+    BOOST_CHECK(pindex->hashMerkleRoot == pexpected->hashMerkleRoot);
+    BOOST_CHECK(pindex->hashPrevPoABlock == pexpected->hashPrevPoABlock);
+    BOOST_CHECK_EQUAL(pindex->nAuditedPoSHeight, pexpected->nAuditedPoSHeight);
+    BOOST_CHECK_EQUAL(pindex->nMint, pexpected->nMint);
+    BOOST_CHECK_EQUAL(pindex->nMoneySupply, pexpected->nMoneySupply);
+    BOOST_CHECK_EQUAL(pindex->nFlags, pexpected->nFlags);
+    BOOST_CHECK_EQUAL(pindex->nStakeModifier, pexpected->nStakeModifier);
+    BOOST_CHECK(pindex->prevoutStake == pexpected->prevoutStake);
+}
+
+BOOST_AUTO_TEST_CASE(blockindexsnapshot_roundtrip)
+{
+    LOCK(cs_main);
+    BOOST_CHECK(!mapBlockIndex.empty());
+
+    // Extend the genesis entry with a short chain and a fork
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    for (int i = 0; i < 20; i++) {
+        CBlockIndex* pindex = new CBlockIndex();
+        pindex->nHeight = pindexPrev->nHeight + 1;
+        pindex->pprev = pindexPrev;
+        pindex->BuildSkip();
+        pindex->nChainWork = pindexPrev->nChainWork + 1;
+        pindex->nTime = pindexPrev->nTime + 60;
+        pindex->nBits = pindexPrev->nBits;
+        pindex->nNonce = InsecureRand32();
+        pindex->nTx = 1 + i;
+        pindex->nFile = 0;
+        pindex->nDataPos = 80 * (i + 1);
+        pindex->nStatus = BLOCK_HAVE_DATA | BLOCK_VALID_SCRIPTS;
+        pindex->hashMerkleRoot = InsecureRand256();
+        pindex->nMoneySupply = 1000 * pindex->nHeight;
+        pindex->nStakeModifier = InsecureRand32();
+        pindex->prevoutStake = COutPoint(InsecureRand256(), i);
+        if (i % 5 == 4) {
+            pindex->hashPrevPoABlock = InsecureRand256();
+            pindex->nAuditedPoSHeight = pindex->nHeight - 1;
+        }
+        pindex->pprevPoS = pindexPrev;
+        BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(InsecureRand256(), pindex)).first;
+        pindex->phashBlock = &mi->first;
+        if (i == 10) {
+            CBlockIndex* pfork = new CBlockIndex(*pindex);
+            pfork->nNonce++;
+            pfork->pprevPoA = pindex->pprev;
+            BlockMap::iterator mf = mapBlockIndex.insert(std::make_pair(InsecureRand256(), pfork)).first;
+            pfork->phashBlock = &mf->first;
+        }
+        pindexPrev = pindex;
+    }
+    // A wallet lookup of an unknown block leaves a NULL entry behind
+    const uint256 hashUnknown = InsecureRand256();
+    mapBlockIndex[hashUnknown];
+    const uint256 hashBest = pindexPrev->GetBlockHash();
+
+    BOOST_CHECK(WriteBlockIndexSnapshot(hashBest));
+
+    // Set the entries aside; the snapshot only loads into an empty map
+    BlockMap mapExpected;
+    mapExpected.swap(mapBlockIndex);
+    std::vector<CBlockIndex*> vSorted;
+    BOOST_CHECK(!ReadBlockIndexSnapshot(InsecureRand256(), vSorted));
+    BOOST_CHECK(mapBlockIndex.empty());
+    BOOST_CHECK(ReadBlockIndexSnapshot(hashBest, vSorted));
+
+    BOOST_CHECK_EQUAL(mapBlockIndex.size(), mapExpected.size() - 1);
+    BOOST_CHECK_EQUAL(vSorted.size(), mapBlockIndex.size());
+    BOOST_CHECK(!mapBlockIndex.count(hashUnknown));
+    for (size_t i = 1; i < vSorted.size(); i++)
+        BOOST_CHECK(vSorted[i - 1]->nHeight <= vSorted[i]->nHeight);
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapExpected) {
+        if (!item.second)
+            continue;
+        BlockMap::const_iterator mi = mapBlockIndex.find(item.first);
+        BOOST_CHECK(mi != mapBlockIndex.end());
+        if (mi != mapBlockIndex.end())
+            CheckEntry(mi->second, item.second);
+    }
+
+    // Loaded entries live in an arena released by UnloadBlockIndex
+    mapBlockIndex.swap(mapExpected);
+    RemoveBlockIndexSnapshot();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
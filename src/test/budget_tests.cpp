@@ -31,4 +31,46 @@ BOOST_AUTO_TEST_CASE(budget_value)
     CheckBudgetValue(nHeightTest, "mainnet", 43200*COIN);
 }
 
+BOOST_AUTO_TEST_CASE(budget_vote_tallies)
+{
+    CBudgetProposal proposal;
+    std::string strError;
+    CTxIn vin1(COutPoint(GetRandHash(), 0));
+    CTxIn vin2(COutPoint(GetRandHash(), 1));
+
+    CBudgetVote vote1(vin1, proposal.GetHash(), VOTE_YES);
+    vote1.nTime = GetTime() - BUDGET_VOTE_UPDATE_MIN;
+    BOOST_CHECK(proposal.AddOrUpdateVote(vote1, strError));
+    CBudgetVote vote2(vin2, proposal.GetHash(), VOTE_NO);
+    BOOST_CHECK(proposal.AddOrUpdateVote(vote2, strError));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetRatio(), 0.5);
+
+    // A newer vote of the same masternode replaces its tally
+    CBudgetVote vote3(vin1, proposal.GetHash(), VOTE_ABSTAIN);
+    vote3.nTime = GetTime();
+    BOOST_CHECK(proposal.AddOrUpdateVote(vote3, strError));
+    BOOST_CHECK_EQUAL(proposal.GetYeas(), 0);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 1);
+    BOOST_CHECK_EQUAL(proposal.GetAbstains(), 1);
+
+    // Copies and deserialized proposals keep the tallies
+    CBudgetProposal copy(proposal);
+    BOOST_CHECK_EQUAL(copy.GetNays(), 1);
+    BOOST_CHECK_EQUAL(copy.GetAbstains(), 1);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << proposal;
+    CBudgetProposal loaded;
+    ss >> loaded;
+    BOOST_CHECK_EQUAL(loaded.GetNays(), 1);
+    BOOST_CHECK_EQUAL(loaded.GetAbstains(), 1);
+
+    // Votes of unknown masternodes stop counting, but still weigh in the ratio
+    proposal.CleanAndRemove(false);
+    BOOST_CHECK_EQUAL(proposal.GetNays(), 0);
+    BOOST_CHECK_EQUAL(proposal.GetAbstains(), 0);
+    BOOST_CHECK_EQUAL(proposal.GetRatio(), 0.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "lrucache.h"
+#include "test/test_prcycoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(lrucache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lrucache_eviction)
+{
+    CLRUCache<int, int> cache(3);
+    for (int i = 0; i < 3; i++)
+        cache.Insert(i, i * 10);
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+
+    // Using 0 makes 1 the least recently used entry
+    int value = 0;
+    BOOST_CHECK(cache.Get(0, value));
+    BOOST_CHECK_EQUAL(value, 0);
+    cache.Insert(3, 30);
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK(!cache.Get(1, value));
+    BOOST_CHECK(cache.Get(0, value));
+    BOOST_CHECK(cache.Get(2, value));
+    BOOST_CHECK(cache.Get(3, value));
+    BOOST_CHECK_EQUAL(value, 30);
+    BOOST_CHECK_EQUAL(cache.nHits, 4U);
+    BOOST_CHECK_EQUAL(cache.nMisses, 1U);
+}
+
+BOOST_AUTO_TEST_CASE(lrucache_replace_erase)
+{
+    CLRUCache<int, int> cache(2);
+    cache.Insert(1, 10);
+    cache.Insert(2, 20);
+    // Replacing a value refreshes the entry instead of adding one
+    cache.Insert(1, 11);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+    cache.Insert(3, 30);
+    int value = 0;
+    BOOST_CHECK(!cache.Get(2, value));
+    BOOST_CHECK(cache.Get(1, value));
+    BOOST_CHECK_EQUAL(value, 11);
+
+    cache.Erase(1);
+    cache.Erase(4);
+    BOOST_CHECK_EQUAL(cache.Size(), 1U);
+    BOOST_CHECK(!cache.Get(1, value));
+}
+
+BOOST_AUTO_TEST_CASE(lrucache_resize)
+{
+    CLRUCache<int, int> cache(4);
+    for (int i = 0; i < 4; i++)
+        cache.Insert(i, i);
+    cache.SetMaxSize(2);
+    BOOST_CHECK_EQUAL(cache.Size(), 2U);
+    BOOST_CHECK_EQUAL(cache.MaxSize(), 2U);
+    int value = 0;
+    BOOST_CHECK(!cache.Get(1, value));
+    BOOST_CHECK(cache.Get(2, value));
+    BOOST_CHECK(cache.Get(3, value));
+
+    // A cache of size 0 is disabled
+    cache.SetMaxSize(0);
+    cache.Insert(5, 5);
+    BOOST_CHECK_EQUAL(cache.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,142 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chain.h"
+#include "main.h"
+#include "masternode-payments.h"
+#include "masternodeman.h"
+#include "test/test_prcycoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(masternode_payments_tests, TestingSetup)
+
+static std::vector<unsigned char> RandomPayee()
+{
+    uint256 r = InsecureRand256();
+    return std::vector<unsigned char>(r.begin(), r.end());
+}
+
+static CMasternodePaymentWinner AddVote(CMasternodePayments& payments, int nBlockHeight)
+{
+    CMasternodePaymentWinner winner;
+    winner.nBlockHeight = nBlockHeight;
+    winner.AddPayee(RandomPayee());
+    winner.vchSig.resize(65);
+    payments.mapMasternodePayeeVotes[winner.GetHash()] = winner;
+    payments.masternodeBlocks.Insert(nBlockHeight)->AddPayee(1, masternodePayeeIds.GetId(winner.payee));
+    return winner;
+}
+
+BOOST_AUTO_TEST_CASE(masternode_payee_ids)
+{
+    CMasternodePayeeIds ids;
+    const std::vector<unsigned char> a = RandomPayee(), b = RandomPayee(), c = RandomPayee(), d = RandomPayee();
+
+    BOOST_CHECK_EQUAL(ids.GetId(a), 0U);
+    BOOST_CHECK_EQUAL(ids.GetId(b), 1U);
+    BOOST_CHECK_EQUAL(ids.GetId(a), 0U);
+    BOOST_CHECK(ids.GetPayee(1) == b);
+    BOOST_CHECK(ids.GetPayee(5).empty());
+
+    // Looking a payee up does not assign it an id
+    uint32_t nId;
+    BOOST_CHECK(!ids.FindId(c, nId));
+    BOOST_CHECK(ids.FindId(b, nId) && nId == 1);
+    BOOST_CHECK_EQUAL(ids.GetId(c), 2U);
+
+    // Freed ids are handed out again
+    std::set<uint32_t> setUsed;
+    setUsed.insert(0);
+    setUsed.insert(2);
+    ids.Retain(setUsed);
+    BOOST_CHECK(!ids.FindId(b, nId));
+    BOOST_CHECK(ids.GetPayee(1).empty());
+    BOOST_CHECK(ids.FindId(a, nId) && nId == 0);
+    BOOST_CHECK(ids.FindId(c, nId) && nId == 2);
+    BOOST_CHECK_EQUAL(ids.GetId(d), 1U);
+    BOOST_CHECK(ids.GetPayee(1) == d);
+    BOOST_CHECK_EQUAL(ids.GetId(b), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(masternode_payees_window)
+{
+    CMasternodeBlockPayeesWindow window;
+    BOOST_CHECK(window.Insert(0) == NULL);
+    window.Insert(12)->AddPayee(1, 7);
+    window.Insert(10)->AddPayee(2, 8);
+    window.Insert(12)->AddPayee(1, 7);
+    BOOST_CHECK_EQUAL(window.size(), 2U);
+    BOOST_CHECK_EQUAL(window.GetOldestHeight(), 10);
+    BOOST_CHECK_EQUAL(window.GetNewestHeight(), 12);
+    BOOST_CHECK(window.Find(11) == NULL);
+    BOOST_CHECK(window.Find(12)->HasPayeeWithVotes(7, 2));
+    BOOST_CHECK_EQUAL(window.GetPayeeIds().size(), 2U);
+
+    // Heights too far below the newest one are refused, newer ones push the oldest out
+    BOOST_CHECK(window.Insert(12 - MNPAYMENTS_MAX_BLOCK_WINDOW) == NULL);
+    window.Insert(10 + MNPAYMENTS_MAX_BLOCK_WINDOW)->AddPayee(1, 9);
+    BOOST_CHECK(window.Find(10) == NULL);
+    BOOST_CHECK_EQUAL(window.GetOldestHeight(), 12);
+
+    // Erasing leaves no empty height at either end
+    window.EraseBelow(13);
+    BOOST_CHECK_EQUAL(window.size(), 1U);
+    BOOST_CHECK_EQUAL(window.GetOldestHeight(), 10 + MNPAYMENTS_MAX_BLOCK_WINDOW);
+    BOOST_CHECK(window.GetPayeeIds() == std::set<uint32_t>{9});
+}
+
+BOOST_AUTO_TEST_CASE(masternode_payments_clean)
+{
+    // With no masternodes, votes are relayed from the tip on and kept for 1000 blocks
+    const int nHeight = 2000;
+    {
+        LOCK(cs_main);
+        CBlockIndex* pindexPrev = chainActive.Tip();
+        while (pindexPrev->nHeight < nHeight) {
+            CBlockIndex* pindex = new CBlockIndex();
+            pindex->nHeight = pindexPrev->nHeight + 1;
+            pindex->pprev = pindexPrev;
+            BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(InsecureRand256(), pindex)).first;
+            pindex->phashBlock = &mi->first;
+            pindexPrev = pindex;
+        }
+        chainActive.SetTip(pindexPrev);
+    }
+    BOOST_CHECK_EQUAL(mnodeman.CountEnabled(), 0);
+
+    CMasternodePayments payments;
+    CMasternodePaymentWinner voteExpired = AddVote(payments, nHeight - 1100);
+    CMasternodePaymentWinner votePruned = AddVote(payments, nHeight - 5);
+    CMasternodePaymentWinner voteRelayed = AddVote(payments, nHeight);
+    payments.mapPrunedPayeeVotes.emplace(InsecureRand256(), nHeight - 1050);
+    const uint256 hashPrunedKept = InsecureRand256();
+    payments.mapPrunedPayeeVotes.emplace(hashPrunedKept, nHeight - 500);
+
+    payments.CleanPaymentList();
+
+    // Only votes Sync still serves keep their signature
+    BOOST_CHECK_EQUAL(payments.mapMasternodePayeeVotes.size(), 1U);
+    BOOST_CHECK(payments.mapMasternodePayeeVotes.count(voteRelayed.GetHash()));
+    BOOST_CHECK_EQUAL(payments.mapMasternodePayeeVotes[voteRelayed.GetHash()].vchSig.size(), 65U);
+
+    // Older votes are still recognized until they leave the kept range
+    BOOST_CHECK_EQUAL(payments.mapPrunedPayeeVotes.size(), 2U);
+    BOOST_CHECK_EQUAL(payments.mapPrunedPayeeVotes[votePruned.GetHash()], nHeight - 5);
+    BOOST_CHECK(payments.mapPrunedPayeeVotes.count(hashPrunedKept));
+    BOOST_CHECK(payments.HasPayeeVote(votePruned.GetHash()));
+    BOOST_CHECK(payments.HasPayeeVote(voteRelayed.GetHash()));
+    BOOST_CHECK(!payments.HasPayeeVote(voteExpired.GetHash()));
+
+    // Tallies below the kept range are removed and their payee ids freed
+    uint32_t nId;
+    BOOST_CHECK_EQUAL(payments.masternodeBlocks.size(), 2U);
+    BOOST_CHECK_EQUAL(payments.masternodeBlocks.GetOldestHeight(), nHeight - 5);
+    BOOST_CHECK(!masternodePayeeIds.FindId(voteExpired.payee, nId));
+    BOOST_CHECK(masternodePayeeIds.FindId(votePruned.payee, nId));
+    BOOST_CHECK(payments.HasPayeeWithVotes(nHeight - 5, nId, 1));
+    BOOST_CHECK(masternodePayeeIds.FindId(voteRelayed.payee, nId));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
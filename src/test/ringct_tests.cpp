@@ -0,0 +1,107 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "primitives/transaction.h"
+#include "random.h"
+#include "test/test_prcycoin.h"
+#include "utilstrencodings.h"
+
+#include "secp256k1_mlsag.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(ringct_tests, BasicTestingSetup)
+
+// A ring of 3 rows and 4 columns signed by the pre-MLSAG-module wallet code and
+// accepted by its verifier; the same vector is in the secp256k1 mlsag module tests
+static const size_t nRows = 3;
+static const size_t nCols = 4;
+static const std::string strPubKeys =
+    "03f3dd8b81414060b90f6cd1062cde1725140d07b9a5545dc2d545d68fd3d3ccdf02ae5302516edf6143ce93e43de1cf85414e2961d99db5896bbbb8a22e36985b48"
+    "026c3bab00fe605425dde215f234c66788e3aaefae3bebc6157d4738936e3ae42103973a30119633a9423b7aa3575409b12085b3e1c3926c18e739eee8e31a974d52"
+    "036a09ca311b470d8578e70500041608768b76e6b62eada9f92c9af66e60be862f0229553a6799af7240b676f589e67ec80a7fbae2ae99482440e833b2ddbc109cdd"
+    "03938f0bdbb4db1d53cd5f2ca2234f3a3512488d422c7e31913b36a8665bf1bd7f02d79089f806e7f003d7e5f065b902b853c62f0f4ab2c4147391e099ebd2fae42c"
+    "03046b22b726fa053871d2cacef0350770912690a00bb2c4bbbbd2baad34db82bc022c6084f0692545a77d9fa48f9360387d93fd2fb1657f805cd5f444593e562769"
+    "03eaa881bc0812a1b93037ecad2b99de69984f5ef30ea7512d0682bc7cdad37478038d1ced021907adce8e82acd40109e85e7fe7ff8777cecd66b7b3681e51296193";
+static const std::string strKeyImages =
+    "026d0cdae6773e13d77bf9dc556390c35d774e998263dca205f8c7344d5172034a0262e109442fc52d91071014b5aaabde2b99a34a903a6f90aaa92cea6f9e21233c"
+    "02d2163dd845d13bb883524149fce6b84ead7adfec8b0474a25573a2dbe5d45a70";
+static const std::string strMsg = "cac112cdfeda459641eb957e3cda067e64dcec677966a8857ed9ad6d31eaee17";
+static const std::string strC = "db709a87f4168ce66089ceffd71ceacf985b0b3719e3143c14699c235c2a2b33";
+static const std::string strS =
+    "8c8f65af8769ffcfcb506d20aeeb7a76796b34b37c6477a1474dade4def22b1eed9138001bed256aefaa4755017df665b79df349bb738de15ff2a9de032f6f70"
+    "c2f40541e9da8377f0093b3f1d12305f40b34cd21d4477400e9ea8e712702d59496b843ef046232f94868177ced0a07cc78f035fc509e39af49f874722377341"
+    "b5e1e54c54ffed029f9117773561d0ea1f0898367d5267b9cf6890f3ad97bb59e23fe47579fa4409edeee1b6264e00881abfe2a8ee0acab2ab09b314d83e0807"
+    "43979b11de9b0d6bd21b5716cdf4db192d0991ab41b10e2eefb1ec44a8e6759d312d0496913d010d8daf3335286d081d1d38e0a997df62afa8ccd58488a2bc84"
+    "4f6a6660f7fb9e7892fadde5f6a9831f94113b07f0f912da169a9763283073d8c9e5e9ec27811b6ba94a79107bb19ecf06e131271ef7ab69b7daa024f8b3758a"
+    "17028c90e8caf2396b1f1524b4a4022f2c42cfb35ec1b772698f21e8ee12bd15c424762a2961250e31afbb3b05dc1f2cd49f72919f72520b775682a19a19afc6";
+
+static uint256 Scalar(const std::vector<unsigned char>& vch, size_t nPos)
+{
+    uint256 s;
+    memcpy(s.begin(), &vch[nPos * 32], 32);
+    return s;
+}
+
+// tx.S as makeRingCT lays it out: one vector of nRows scalars per column
+static CMutableTransaction RingTransaction()
+{
+    std::vector<unsigned char> vchS = ParseHex(strS);
+    CMutableTransaction tx;
+    for (size_t j = 0; j < nCols; j++) {
+        std::vector<uint256> column;
+        for (size_t i = 0; i < nRows; i++)
+            column.push_back(Scalar(vchS, j * nRows + i));
+        tx.S.push_back(column);
+    }
+    memcpy(tx.c.begin(), &ParseHex(strC)[0], 32);
+    return tx;
+}
+
+static bool VerifyRing(const CTransaction& tx)
+{
+    std::vector<unsigned char> scalars;
+    if (!GetRingSignatureScalars(tx, nRows, nCols, scalars))
+        return false;
+    std::vector<unsigned char> vchPubKeys = ParseHex(strPubKeys);
+    std::vector<unsigned char> vchKeyImages = ParseHex(strKeyImages);
+    std::vector<unsigned char> vchMsg = ParseHex(strMsg);
+    return secp256k1_mlsag_verify(GetContext(), tx.c.begin(), &scalars[0], &vchPubKeys[0], &vchKeyImages[0], &vchMsg[0], nRows, nCols) == 1;
+}
+
+BOOST_AUTO_TEST_CASE(ringct_legacy_signature)
+{
+    CMutableTransaction tx = RingTransaction();
+    BOOST_CHECK(VerifyRing(tx));
+
+    CMutableTransaction tampered = tx;
+    tampered.S[1][2].begin()[31] ^= 1;
+    BOOST_CHECK(!VerifyRing(tampered));
+
+    tampered = tx;
+    tampered.c.begin()[0] ^= 1;
+    BOOST_CHECK(!VerifyRing(tampered));
+}
+
+BOOST_AUTO_TEST_CASE(ringct_signature_dimensions)
+{
+    // Scalars past the ring were never read; transactions carrying them must keep verifying
+    CMutableTransaction tx = RingTransaction();
+    for (std::vector<uint256>& column : tx.S)
+        column.push_back(GetRandHash());
+    tx.S.push_back(std::vector<uint256>(nRows + 2, GetRandHash()));
+    BOOST_CHECK(VerifyRing(tx));
+
+    // An undersized S is rejected instead of being read out of bounds
+    tx = RingTransaction();
+    tx.S.pop_back();
+    BOOST_CHECK(!VerifyRing(tx));
+
+    tx = RingTransaction();
+    tx.S[2].pop_back();
+    BOOST_CHECK(!VerifyRing(tx));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
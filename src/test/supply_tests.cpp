@@ -0,0 +1,97 @@
+// Copyright (c) 2020-2022 The PRivaCY Coin Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "chain.h"
+#include "main.h"
+#include "txdb.h"
+#include "test/test_prcycoin.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(supply_tests, TestingSetup)
+
+// Entries are added to mapBlockIndex, so UnloadBlockIndex frees them with the fixture
+static std::vector<CBlockIndex*> ExtendChain(int nBlocks)
+{
+    std::vector<CBlockIndex*> vIndex;
+    CBlockIndex* pindexPrev = chainActive.Tip();
+    for (int i = 0; i < nBlocks; i++) {
+        CBlockIndex* pindex = new CBlockIndex();
+        pindex->nHeight = pindexPrev->nHeight + 1;
+        pindex->pprev = pindexPrev;
+        pindex->nMoneySupply = -1;
+        BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(InsecureRand256(), pindex)).first;
+        pindex->phashBlock = &mi->first;
+        vIndex.push_back(pindex);
+        pindexPrev = pindex;
+    }
+    return vIndex;
+}
+
+BOOST_AUTO_TEST_CASE(supply_fold_deltas)
+{
+    LOCK(cs_main);
+    const CAmount nGenesisSupply = chainActive.Tip()->nMoneySupply;
+    std::vector<CBlockIndex*> vIndex = ExtendChain(5);
+    const CAmount deltas[] = {100 * COIN, 5 * COIN, -3 * COIN, 0, 10 * COIN};
+    std::vector<CAmount> vDelta(deltas, deltas + 5);
+
+    BOOST_CHECK_EQUAL(FoldSupplyDeltas(vIndex, vDelta), nGenesisSupply + 112 * COIN);
+    CAmount nSupply = nGenesisSupply;
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        nSupply += vDelta[i];
+        BOOST_CHECK_EQUAL(vIndex[i]->nMoneySupply, nSupply);
+    }
+
+    // A range that starts mid-chain builds on the supply below it and leaves that untouched
+    std::vector<CBlockIndex*> vTail(vIndex.begin() + 3, vIndex.end());
+    std::vector<CAmount> vTailDelta(2, 1 * COIN);
+    BOOST_CHECK_EQUAL(FoldSupplyDeltas(vTail, vTailDelta), vIndex[2]->nMoneySupply + 2 * COIN);
+    BOOST_CHECK_EQUAL(vIndex[2]->nMoneySupply, nGenesisSupply + 102 * COIN);
+    BOOST_CHECK_EQUAL(vIndex[3]->nMoneySupply, nGenesisSupply + 103 * COIN);
+    BOOST_CHECK_EQUAL(vIndex[4]->nMoneySupply, nGenesisSupply + 104 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(supply_resume_deltas)
+{
+    LOCK(cs_main);
+    std::vector<CBlockIndex*> vIndex = ExtendChain(6);
+    std::vector<CAmount> vDelta;
+    std::vector<bool> vHaveDelta;
+
+    // Deltas left by a finished run are dropped when a new run starts
+    std::vector<std::pair<uint256, CAmount> > vStale;
+    vStale.emplace_back(vIndex[0]->GetBlockHash(), 7 * COIN);
+    BOOST_CHECK(pblocktree->WriteSupplyDeltas(vStale));
+    BOOST_CHECK_EQUAL(LoadSupplyDeltas(vIndex, vDelta, vHaveDelta), 0U);
+    BOOST_CHECK_EQUAL(vDelta.size(), vIndex.size());
+    BOOST_CHECK_EQUAL(vHaveDelta.size(), vIndex.size());
+    bool fRunning = false;
+    BOOST_CHECK(pblocktree->ReadFlag("supplyrecalc", fRunning) && fRunning);
+    CAmount nDelta;
+    BOOST_CHECK(!pblocktree->ReadSupplyDelta(vIndex[0]->GetBlockHash(), nDelta));
+
+    // That run stores some deltas and is interrupted: the next run picks them up
+    std::vector<std::pair<uint256, CAmount> > vStored;
+    vStored.emplace_back(vIndex[1]->GetBlockHash(), 2 * COIN);
+    vStored.emplace_back(vIndex[4]->GetBlockHash(), -1 * COIN);
+    BOOST_CHECK(pblocktree->WriteSupplyDeltas(vStored));
+    BOOST_CHECK_EQUAL(LoadSupplyDeltas(vIndex, vDelta, vHaveDelta), 2U);
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        const bool fStored = (i == 1 || i == 4);
+        BOOST_CHECK(vHaveDelta[i] == fStored);
+        BOOST_CHECK_EQUAL(vDelta[i], i == 1 ? 2 * COIN : i == 4 ? -1 * COIN : 0);
+    }
+
+    // A finished run erases its deltas and clears the flag, so nothing is resumed after it
+    BOOST_CHECK(pblocktree->EraseSupplyDeltas());
+    BOOST_CHECK(pblocktree->WriteFlag("supplyrecalc", false));
+    BOOST_CHECK(!pblocktree->ReadSupplyDelta(vIndex[1]->GetBlockHash(), nDelta));
+    BOOST_CHECK(!pblocktree->ReadSupplyDelta(vIndex[4]->GetBlockHash(), nDelta));
+    BOOST_CHECK_EQUAL(LoadSupplyDeltas(vIndex, vDelta, vHaveDelta), 0U);
+    for (size_t i = 0; i < vIndex.size(); i++)
+        BOOST_CHECK(!vHaveDelta[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,7 @@
 #include "poa.h"
 #include "uint256.h"
 
+#include <future>
 #include <stdint.h>
 
 #include <boost/thread.hpp>
@@ -26,6 +27,7 @@ static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
 static const char DB_INT = 'I';
 static const char DB_KEYIMAGE = 'k';
+static const char DB_SUPPLY_DELTA = 'S';
 
 
 CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe)
@@ -211,6 +213,35 @@ bool CBlockTreeDB::WriteKeyImage(const std::string& keyImage, const uint256& bh)
     return Write(std::make_pair(DB_KEYIMAGE, keyImage + std::to_string(i)), bh);
 }
 
+bool CBlockTreeDB::ReadSupplyDelta(const uint256& hashBlock, CAmount& nDelta)
+{
+    return Read(std::make_pair(DB_SUPPLY_DELTA, hashBlock), nDelta);
+}
+
+bool CBlockTreeDB::WriteSupplyDeltas(const std::vector<std::pair<uint256, CAmount> >& vDeltas)
+{
+    CDBBatch batch;
+    for (const std::pair<uint256, CAmount>& delta : vDeltas) {
+        batch.Write(std::make_pair(DB_SUPPLY_DELTA, delta.first), delta.second);
+    }
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::EraseSupplyDeltas()
+{
+    CDBBatch batch;
+    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(std::make_pair(DB_SUPPLY_DELTA, UINT256_ZERO));
+    while (pcursor->Valid()) {
+        std::pair<char, uint256> key;
+        if (!pcursor->GetKey(key) || key.first != DB_SUPPLY_DELTA)
+            break;
+        batch.Erase(key);
+        pcursor->Next();
+    }
+    return WriteBatch(batch);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string& name, bool fValue)
 {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
@@ -237,66 +268,95 @@ bool CBlockTreeDB::ReadInt(const std::string& name, int& nValue)
 
 bool CBlockTreeDB::LoadBlockIndexGuts()
 {
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, UINT256_ZERO));
-
-    // Load mapBlockIndex
-    uint256 nPreviousCheckpoint;
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = InsertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
-                pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
-                pindexNew->nHeight = diskindex.nHeight;
-                pindexNew->nFile = diskindex.nFile;
-                pindexNew->nDataPos = diskindex.nDataPos;
-                pindexNew->nUndoPos = diskindex.nUndoPos;
-                pindexNew->nVersion = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime = diskindex.nTime;
-                pindexNew->nBits = diskindex.nBits;
-                pindexNew->nNonce = diskindex.nNonce;
-                pindexNew->nStatus = diskindex.nStatus;
-                pindexNew->nTx = diskindex.nTx;
-
-                //Proof of Audit
-                pindexNew->hashPoAMerkleRoot = diskindex.hashPoAMerkleRoot;
-                pindexNew->hashPrevPoABlock = diskindex.hashPrevPoABlock;
-                pindexNew->minedHash = diskindex.minedHash;
-
-                //Proof Of Stake
-                pindexNew->nMint = diskindex.nMint;
-                pindexNew->nMoneySupply = diskindex.nMoneySupply;
-                pindexNew->nFlags = diskindex.nFlags;
-                pindexNew->nStakeModifier = diskindex.nStakeModifier;
-                pindexNew->prevoutStake = diskindex.prevoutStake;
-                pindexNew->nStakeTime = diskindex.nStakeTime;
-                pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
-
-                if (pindexNew->nHeight <= Params().LAST_POW_BLOCK()) {
-                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
-                        return error("LoadBlockIndex() : CheckProofOfWork failed: %s", pindexNew->ToString());
+    // Block index keys are ('b', hash); split the key space on the first hash byte and
+    // deserialize the ranges concurrently. Hashing each entry dominates the cost.
+    int64_t nStart = GetTimeMillis();
+    const int nRanges = std::max(1, std::min((int)boost::thread::hardware_concurrency(), 16));
+    std::vector<std::vector<std::pair<uint256, CDiskBlockIndex> > > vRanges(nRanges);
+    std::vector<std::future<std::string> > vLoaders;
+    for (int r = 0; r < nRanges; r++) {
+        vLoaders.push_back(std::async(std::launch::async, [this, r, nRanges, &vRanges]() -> std::string {
+            const int nBegin = r * 256 / nRanges;
+            const int nEnd = (r + 1) * 256 / nRanges;
+            uint256 seek;
+            *seek.begin() = nBegin;
+            boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+            pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, seek));
+            while (pcursor->Valid()) {
+                std::pair<char, uint256> key;
+                if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX || *key.second.begin() >= nEnd)
+                    break;
+                CDiskBlockIndex diskindex;
+                if (!pcursor->GetValue(diskindex))
+                    return "failed to read value";
+                uint256 hash = diskindex.GetBlockHash();
+                if (diskindex.nHeight <= Params().LAST_POW_BLOCK()) {
+                    if (!CheckProofOfWork(hash, diskindex.nBits))
+                        return strprintf("CheckProofOfWork failed: %s", diskindex.ToString());
                 }
-
-                //populate accumulator checksum map in memory
-                if(pindexNew->nAccumulatorCheckpoint != 0 && pindexNew->nAccumulatorCheckpoint != nPreviousCheckpoint) {
-                    nPreviousCheckpoint = pindexNew->nAccumulatorCheckpoint;
-                }
-
+                vRanges[r].push_back(std::make_pair(hash, diskindex));
                 pcursor->Next();
-            } else {
-                return error("%s : failed to read value", __func__);
             }
-        } else {
-            break;
+            return "";
+        }));
+    }
+    size_t nEntries = 0;
+    for (int r = 0; r < nRanges; r++) {
+        std::string strError = vLoaders[r].get();
+        if (!strError.empty())
+            return error("%s : %s", __func__, strError);
+        nEntries += vRanges[r].size();
+    }
+    boost::this_thread::interruption_point();
+    int64_t nRead = GetTimeMillis();
+
+    // Load mapBlockIndex
+    mapBlockIndex.reserve(nEntries);
+    CBlockIndex* pArena = AllocateBlockIndexArena(nEntries);
+    for (const std::vector<std::pair<uint256, CDiskBlockIndex> >& vRange : vRanges) {
+        for (const std::pair<uint256, CDiskBlockIndex>& entry : vRange) {
+            CBlockIndex* pindexNew = pArena++;
+            BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(entry.first, pindexNew)).first;
+            pindexNew->phashBlock = &((*mi).first);
+        }
+    }
+    for (std::vector<std::pair<uint256, CDiskBlockIndex> >& vRange : vRanges) {
+        for (const std::pair<uint256, CDiskBlockIndex>& entry : vRange) {
+            const CDiskBlockIndex& diskindex = entry.second;
+            // Construct block index object
+            CBlockIndex* pindexNew = InsertBlockIndex(entry.first);
+            pindexNew->pprev = InsertBlockIndex(diskindex.hashPrev);
+            pindexNew->pnext = InsertBlockIndex(diskindex.hashNext);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nTx = diskindex.nTx;
+
+            //Proof of Audit
+            pindexNew->hashPoAMerkleRoot = diskindex.hashPoAMerkleRoot;
+            pindexNew->hashPrevPoABlock = diskindex.hashPrevPoABlock;
+            pindexNew->minedHash = diskindex.minedHash;
+            pindexNew->nAuditedPoSHeight = diskindex.nAuditedPoSHeight;
+
+            //Proof Of Stake
+            pindexNew->nMint = diskindex.nMint;
+            pindexNew->nMoneySupply = diskindex.nMoneySupply;
+            pindexNew->nFlags = diskindex.nFlags;
+            pindexNew->nStakeModifier = diskindex.nStakeModifier;
+            pindexNew->prevoutStake = diskindex.prevoutStake;
+            pindexNew->nStakeTime = diskindex.nStakeTime;
+            pindexNew->hashProofOfStake = diskindex.hashProofOfStake;
         }
+        std::vector<std::pair<uint256, CDiskBlockIndex> >().swap(vRange);
     }
 
+    LogPrintf("%s: loaded %u entries using %d threads, read %dms, link %dms\n", __func__, nEntries, nRanges, nRead - nStart, GetTimeMillis() - nRead);
     return true;
 }
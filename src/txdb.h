@@ -99,5 +99,9 @@ public:
     bool ReadKeyImages(const std::string& keyImage, std::vector<uint256>& bhs);
 
     bool WriteKeyImage(const std::string& keyImage, const uint256& height);
+
+    bool ReadSupplyDelta(const uint256& hashBlock, CAmount& nDelta);
+    bool WriteSupplyDeltas(const std::vector<std::pair<uint256, CAmount> >& vDeltas);
+    bool EraseSupplyDeltas();
 };
 #endif // BITCOIN_TXDB_H
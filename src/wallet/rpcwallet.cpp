@@ -2860,6 +2860,78 @@ UniValue sendtostealthaddress(const UniValue& params, bool fHelp)
     return wtx.GetHash().GetHex();
 }
 
+UniValue sendmanybatch(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() != 1)
+        throw std::runtime_error(
+                "sendmanybatch {\"prcystealthaddress\":amount,...}\n"
+                "\nCreate and send one transaction per recipient, planning the whole batch under a single wallet lock.\n"
+                "Ring member transactions read for one transaction are reused by the rest of the batch.\n" +
+                HelpRequiringPassphrase() +
+                "\nArguments:\n"
+                "1. \"amounts\"               (string, required) A json object with stealth addresses and amounts\n"
+                "    {\n"
+                "      \"prcystealthaddress\":amount   (numeric) The prcycoin stealth address is the key, the numeric amount in PRCY is the value\n"
+                "      ,...\n"
+                "    }\n"
+                "\nResult:\n"
+                "[                          (json array of objects, in the order of the recipients)\n"
+                "  {\n"
+                "    \"address\":\"address\",    (string) The recipient stealth address\n"
+                "    \"amount\": x.xxx,        (numeric) The amount sent\n"
+                "    \"txid\":\"transactionid\", (string) The transaction id, if the transaction was created\n"
+                "    \"error\":\"reason\"        (string) The failure reason, if the transaction was not created\n"
+                "  }\n"
+                "  ,...\n"
+                "]\n"
+                "\nExamples:\n" +
+                HelpExampleCli("sendmanybatch", "\"{\\\"Pap5WCV4SjVMGLyYf98MEX82ErBEMVpg9ViQ1up3aBib6Fz4841SahrRXG6eSNSLBSNvEiGuQiWKXJC3RDfmotKv15oCrh6N2Ym\\\":0.1}\"") +
+                HelpExampleRpc("sendmanybatch", "{\"Pap5WCV4SjVMGLyYf98MEX82ErBEMVpg9ViQ1up3aBib6Fz4841SahrRXG6eSNSLBSNvEiGuQiWKXJC3RDfmotKv15oCrh6N2Ym\":0.1}"));
+
+    EnsureWalletIsUnlocked();
+
+    UniValue sendTo = params[0].get_obj();
+    std::set<std::string> setDestination;
+    std::vector<std::pair<std::string, CAmount> > vecSend;
+    std::vector<std::string> keys = sendTo.getKeys();
+    for (const std::string& name_ : keys) {
+        CPubKey pubViewKey, pubSpendKey;
+        bool hasPaymentID;
+        uint64_t paymentID;
+        if (!CWallet::DecodeStealthAddress(name_, pubViewKey, pubSpendKey, hasPaymentID, paymentID))
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, std::string("Invalid PRCY stealth address: ") + name_);
+
+        // the same keys and payment id can be written as different address strings
+        std::string strDestination = pubViewKey.GetHex() + pubSpendKey.GetHex() + (hasPaymentID ? std::to_string(paymentID) : "");
+        if (!setDestination.insert(strDestination).second)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, std::string("Invalid parameter, duplicated address: ") + name_);
+
+        CAmount nAmount = AmountFromValue(sendTo[name_]);
+        if (nAmount <= 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, std::string("Invalid amount for ") + name_);
+        vecSend.push_back(std::make_pair(name_, nAmount));
+    }
+    if (vecSend.empty())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid parameter, no recipients");
+
+    std::vector<uint256> vTxHashes;
+    std::vector<std::string> vErrors;
+    pwalletMain->SendToStealthAddressBatch(vecSend, vTxHashes, vErrors);
+
+    UniValue ret(UniValue::VARR);
+    for (size_t i = 0; i < vecSend.size(); i++) {
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("address", vecSend[i].first));
+        entry.push_back(Pair("amount", ValueFromAmount(vecSend[i].second)));
+        if (vErrors[i].empty())
+            entry.push_back(Pair("txid", vTxHashes[i].GetHex()));
+        else
+            entry.push_back(Pair("error", vErrors[i]));
+        ret.push_back(entry);
+    }
+    return ret;
+}
+
 UniValue sendalltostealthaddress(const UniValue& params, bool fHelp)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
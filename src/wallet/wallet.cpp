@@ -36,6 +36,7 @@
 #include "secp256k1_bulletproofs.h"
 #include "secp256k1_commitment.h"
 #include "secp256k1_generator.h"
+#include "secp256k1_mlsag.h"
 #include "txdb.h"
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/thread.hpp>
@@ -2112,8 +2113,8 @@ void CWalletTx::RelayWalletTransaction(std::string strCommand)
             LogPrintf("Relaying wtx %s\n", hash.ToString());
 
             if (strCommand == NetMsgType::IX) {
-                mapTxLockReq.insert(std::make_pair(hash, (CTransaction) * this));
-                CreateNewLock(((CTransaction) * this));
+                swiftTX.AddLockRequest((CTransaction) * this);
+                swiftTX.CreateNewLock(((CTransaction) * this));
                 RelayTransactionLockReq((CTransaction) * this, true);
             } else {
                 RelayTransaction((CTransaction) * this);
@@ -3262,11 +3263,15 @@ bool CWallet::CreateTransactionBulletProof(const CKey& txPrivDes, const CPubKey&
                 *static_cast<CTransaction*>(&wtxNew) = CTransaction(txNew);
                 break;
             }
+            //the range proof only depends on the output amounts and blinds, prove it while the ring is built
+            std::future<std::vector<unsigned char> > bulletproof;
+            if (ret) bulletproof = startBulletProofAggregate(wtxNew);
+
             if (ret && !makeRingCT(wtxNew, ringSize, strFailReason)) {
                 ret = false;
             }
 
-            if (ret && !generateBulletProofAggregate(wtxNew)) {
+            if (ret && !generateBulletProofAggregate(wtxNew, bulletproof)) {
                 strFailReason = _("Failed to generate bulletproof");
                 ret = false;
             }
@@ -3498,27 +3503,46 @@ bool CWallet::CreateTransaction(const std::vector<std::pair<CScript, CAmount> >&
     return true;
 }
 
-bool CWallet::generateBulletProofAggregate(CTransaction& tx)
+std::future<std::vector<unsigned char> > CWallet::startBulletProofAggregate(const CTransaction& tx)
 {
-    unsigned char proof[2000];
-    size_t len = 2000;
     const size_t MAX_VOUT = 5;
-    unsigned char nonce[32];
-    GetRandBytes(nonce, 32);
-    unsigned char blinds[MAX_VOUT][32];
-    uint64_t values[MAX_VOUT];
-    size_t i = 0;
-    const unsigned char* blind_ptr[MAX_VOUT];
-    if (tx.vout.size() > MAX_VOUT) return false;
-    memset(blinds, 0, tx.vout.size() * 32);
-    for (i = 0; i < tx.vout.size(); i++) {
-        memcpy(&blinds[i][0], tx.vout[i].maskValue.inMemoryRawBind.begin(), 32);
-        blind_ptr[i] = blinds[i];
-        values[i] = tx.vout[i].nValue;
-    }
-    int ret = secp256k1_bulletproof_rangeproof_prove(GetContext(), GetScratch(), GetGenerator(), proof, &len, values, NULL, blind_ptr, tx.vout.size(), &secp256k1_generator_const_h, 64, nonce, NULL, 0);
-    std::copy(proof, proof + len, std::back_inserter(tx.bulletproofs));
-    return ret;
+    std::vector<uint64_t> values;
+    std::vector<CKey> blinds;
+    for (const CTxOut& out : tx.vout) {
+        values.push_back(out.nValue);
+        blinds.push_back(out.maskValue.inMemoryRawBind);
+    }
+    //the shared context and generators are created here so that the worker only reads them
+    secp256k1_context2* ctx = GetContext();
+    secp256k1_bulletproof_generators* gens = GetGenerator();
+    return std::async(std::launch::async, [ctx, gens, values, blinds]() {
+        std::vector<unsigned char> ret;
+        if (values.empty() || values.size() > MAX_VOUT) return ret;
+        unsigned char proof[2000];
+        size_t len = 2000;
+        unsigned char nonce[32];
+        GetRandBytes(nonce, 32);
+        const unsigned char* blind_ptr[MAX_VOUT];
+        for (size_t i = 0; i < blinds.size(); i++) {
+            blind_ptr[i] = blinds[i].begin();
+        }
+        //a private scratch space, the global one belongs to the validation code
+        secp256k1_scratch_space2* scratch = secp256k1_scratch_space_create(ctx, 1024 * 1024 * 512);
+        if (secp256k1_bulletproof_rangeproof_prove(ctx, scratch, gens, proof, &len, &values[0], NULL, blind_ptr, values.size(), &secp256k1_generator_const_h, 64, nonce, NULL, 0)) {
+            ret.assign(proof, proof + len);
+        }
+        secp256k1_scratch_space_destroy(scratch);
+        return ret;
+    });
+}
+
+bool CWallet::generateBulletProofAggregate(CTransaction& tx, std::future<std::vector<unsigned char> >& pending)
+{
+    if (!pending.valid()) return false;
+    std::vector<unsigned char> proof = pending.get();
+    if (proof.empty()) return false;
+    std::copy(proof.begin(), proof.end(), std::back_inserter(tx.bulletproofs));
+    return true;
 }
 
 bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFailReason)
@@ -3652,12 +3676,10 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
 
     int PI = myRealIndex;
     unsigned char SIJ[MAX_VIN + 1][MAX_DECOYS + 1][32];
-    unsigned char LIJ[MAX_VIN + 1][MAX_DECOYS + 1][33];
-    unsigned char RIJ[MAX_VIN + 1][MAX_DECOYS + 1][33];
     unsigned char ALPHA[MAX_VIN + 1][32];
     unsigned char AllPrivKeys[MAX_VIN + 1][32];
 
-    //generating LIJ and RIJ at PI: LIJ[j][PI], RIJ[j][PI], j=0..wtxNew.vin.size()
+    //collecting my private keys, key images and the nonces used at PI
     for (size_t j = 0; j < wtxNew.vin.size(); j++) {
         COutPoint myOutpoint;
         if (myIndex == -1) {
@@ -3683,9 +3705,6 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
         CKey alpha;
         alpha.MakeNewKey(true);
         memcpy(ALPHA[j], alpha.begin(), 32);
-        CPubKey LIJ_PI = alpha.GetPubKey();
-        memcpy(LIJ[j][PI], LIJ_PI.begin(), 33);
-        PointHashingSuccessively(tempPubKey, alpha.begin(), RIJ[j][PI]);
     }
 
     //computing additional input pubkey and key images
@@ -3703,13 +3722,9 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
 
     //verify that additional public key = sum of wtx.vin.size() real public keys + sum of wtx.vin.size() commitments - sum of wtx.vout.size() commitments - commitment to zero of transction fee
 
-    //filling LIJ & RIJ at [j][PI]
     CKey alpha_additional;
     alpha_additional.MakeNewKey(true);
     memcpy(ALPHA[wtxNew.vin.size()], alpha_additional.begin(), 32);
-    CPubKey LIJ_PI_additional = alpha_additional.GetPubKey();
-    memcpy(LIJ[wtxNew.vin.size()][PI], LIJ_PI_additional.begin(), 33);
-    PointHashingSuccessively(additionalPubKey, alpha_additional.begin(), RIJ[wtxNew.vin.size()][PI]);
 
     //Initialize SIJ except S[..][PI]
     for (int i = 0; i < (int)wtxNew.vin.size() + 1; i++) {
@@ -3733,7 +3748,7 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
             if (j != PI) {
                 CTransaction txPrev;
                 uint256 hashBlock;
-                if (!GetTransaction(decoysForIn[j].hash, txPrev, hashBlock)) {
+                if (!getRingMemberTransaction(decoysForIn[j].hash, txPrev, hashBlock)) {
                     return false;
                 }
                 CPubKey extractedPub;
@@ -3802,117 +3817,35 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
         }
     }
 
-    //Computing C
-    int PI_interator = PI + 1; //PI_interator: PI + 1 .. wtxNew.vin[0].decoys.size() + 1 .. PI
-    //unsigned char SIJ[wtxNew.vin.size() + 1][wtxNew.vin[0].decoys.size() + 1][32];
-    //unsigned char LIJ[wtxNew.vin.size() + 1][wtxNew.vin[0].decoys.size() + 1][33];
-    //unsigned char RIJ[wtxNew.vin.size() + 1][wtxNew.vin[0].decoys.size() + 1][33];
-    unsigned char CI[MAX_DECOYS + 1][32];
-    unsigned char tempForHash[2 * (MAX_VIN + 1) * 33 + 32];
-    unsigned char* tempForHashPtr = tempForHash;
-    for (size_t i = 0; i < wtxNew.vin.size() + 1; i++) {
-        memcpy(tempForHashPtr, &LIJ[i][PI][0], 33);
-        tempForHashPtr += 33;
-        memcpy(tempForHashPtr, &RIJ[i][PI][0], 33);
-        tempForHashPtr += 33;
+    //Computing C and closing the ring at PI: S[j][PI] = alpha_j - c_pi * x_j
+    //the ring is kept in group element form inside secp256k1 so every L and R is computed
+    //with a single multi-multiplication instead of a serialize/parse per tweak
+    const size_t nRows = wtxNew.vin.size() + 1;
+    const size_t nCols = wtxNew.vin[0].decoys.size() + 1;
+    std::vector<unsigned char> ringPubKeys(nRows * nCols * 33);
+    std::vector<unsigned char> ringScalars(nRows * nCols * 32);
+    for (size_t j = 0; j < nCols; j++) {
+        for (size_t i = 0; i < nRows; i++) {
+            memcpy(&ringPubKeys[(j * nRows + i) * 33], allInPubKeys[i][j], 33);
+            if ((int)j != PI) {
+                memcpy(&ringScalars[(j * nRows + i) * 32], SIJ[i][j], 32);
+            }
+        }
     }
     uint256 ctsHash = GetTxSignatureHash(wtxNew);
-    memcpy(tempForHashPtr, ctsHash.begin(), 32);
-
-    if (PI_interator == (int)wtxNew.vin[0].decoys.size() + 1) PI_interator = 0;
-    uint256 temppi1 = Hash(tempForHash, tempForHash + 2 * (wtxNew.vin.size() + 1) * 33 + 32);
-    if (PI_interator == 0) {
-        memcpy(CI[0], temppi1.begin(), 32);
-    } else {
-        memcpy(CI[PI_interator], temppi1.begin(), 32);
+    unsigned char c0[32];
+    if (!secp256k1_mlsag_sign(both, c0, &ringScalars[0], &ringPubKeys[0], &allKeyImages[0][0], &AllPrivKeys[0][0], &ALPHA[0][0], ctsHash.begin(), nRows, nCols, PI)) {
+        memory_cleanse(ALPHA, sizeof(ALPHA));
+        memory_cleanse(AllPrivKeys, sizeof(AllPrivKeys));
+        strFailReason = _("Cannot compute ring signature");
+        return false;
     }
-
-    while (PI_interator != PI) {
-        for (int j = 0; j < (int)wtxNew.vin.size() + 1; j++) {
-            //compute LIJ
-            unsigned char CP[33];
-            memcpy(CP, allInPubKeys[j][PI_interator], 33);
-            if (!secp256k1_ec_pubkey_tweak_mul(CP, 33, CI[PI_interator])) {
-                strFailReason = _("Cannot compute LIJ for ring signature in secp256k1_ec_pubkey_tweak_mul");
-                return false;
-            }
-            if (!secp256k1_ec_pubkey_tweak_add(CP, 33, SIJ[j][PI_interator])) {
-                strFailReason = _("Cannot compute LIJ for ring signature in secp256k1_ec_pubkey_tweak_add");
-                return false;
-            }
-            memcpy(LIJ[j][PI_interator], CP, 33);
-
-            //compute RIJ
-            //first compute CI * I
-            memcpy(RIJ[j][PI_interator], allKeyImages[j], 33);
-            if (!secp256k1_ec_pubkey_tweak_mul(RIJ[j][PI_interator], 33, CI[PI_interator])) {
-                strFailReason = _("Cannot compute RIJ for ring signature in secp256k1_ec_pubkey_tweak_mul");
-                return false;
-            }
-
-            //compute S*H(P)
-            unsigned char SHP[33];
-            CPubKey tempP;
-            tempP.Set(allInPubKeys[j][PI_interator], allInPubKeys[j][PI_interator] + 33);
-            PointHashingSuccessively(tempP, SIJ[j][PI_interator], SHP);
-            //convert shp into commitment
-            secp256k1_pedersen_commitment SHP_commitment;
-            secp256k1_pedersen_serialized_pubkey_to_commitment(SHP, 33, &SHP_commitment);
-
-            //convert CI*I into commitment
-            secp256k1_pedersen_commitment cii_commitment;
-            secp256k1_pedersen_serialized_pubkey_to_commitment(RIJ[j][PI_interator], 33, &cii_commitment);
-
-            const secp256k1_pedersen_commitment* twoElements[2];
-            twoElements[0] = &SHP_commitment;
-            twoElements[1] = &cii_commitment;
-
-            secp256k1_pedersen_commitment sum;
-            if (!secp256k1_pedersen_commitment_sum_pos(both, twoElements, 2, &sum))
-                throw std::runtime_error("Cannot compute sum of commitments");
-            size_t tempLength;
-            if (!secp256k1_pedersen_commitment_to_serialized_pubkey(&sum, RIJ[j][PI_interator], &tempLength)) {
-                strFailReason = _("Cannot compute two elements and serialize it to pubkey");
-            }
-        }
-
-        PI_interator++;
-        if (PI_interator == (int)wtxNew.vin[0].decoys.size() + 1) PI_interator = 0;
-
-        int prev, ciIdx;
-        if (PI_interator == 0) {
-            prev = wtxNew.vin[0].decoys.size();
-            ciIdx = 0;
-        } else {
-            prev = PI_interator - 1;
-            ciIdx = PI_interator;
-        }
-
-        tempForHashPtr = tempForHash;
-        for (int i = 0; i < (int)wtxNew.vin.size() + 1; i++) {
-            memcpy(tempForHashPtr, LIJ[i][prev], 33);
-            tempForHashPtr += 33;
-            memcpy(tempForHashPtr, RIJ[i][prev], 33);
-            tempForHashPtr += 33;
-        }
-        memcpy(tempForHashPtr, ctsHash.begin(), 32);
-        uint256 ciHashTmp = Hash(tempForHash, tempForHash + 2 * (wtxNew.vin.size() + 1) * 33 + 32);
-        memcpy(CI[ciIdx], ciHashTmp.begin(), 32);
-    }
-
-    //compute S[j][PI] = alpha_j - c_pi * x_j, x_j = private key corresponding to key image I
-    for (size_t j = 0; j < wtxNew.vin.size() + 1; j++) {
-        unsigned char cx[32];
-        memcpy(cx, CI[PI], 32);
-        if (!secp256k1_ec_privkey_tweak_mul(cx, AllPrivKeys[j]))
-            throw std::runtime_error("Cannot compute EC mul");
-        const unsigned char* sumArray[2];
-        sumArray[0] = ALPHA[j];
-        sumArray[1] = cx;
-        if (!secp256k1_pedersen_blind_sum(both, SIJ[j][PI], sumArray, 2, 1))
-            throw std::runtime_error("Cannot compute pedersen blind sum");
-    }
-    memcpy(wtxNew.c.begin(), CI[0], 32);
+    memory_cleanse(ALPHA, sizeof(ALPHA));
+    memory_cleanse(AllPrivKeys, sizeof(AllPrivKeys));
+    for (size_t i = 0; i < nRows; i++) {
+        memcpy(SIJ[i][PI], &ringScalars[(PI * nRows + i) * 32], 32);
+    }
+    memcpy(wtxNew.c.begin(), c0, 32);
     //i for decoy index => PI
     for (int i = 0; i < (int)wtxNew.vin[0].decoys.size() + 1; i++) {
         std::vector<uint256> S_column;
@@ -3927,6 +3860,25 @@ bool CWallet::makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFai
     return true;
 }
 
+bool CWallet::getRingMemberTransaction(const uint256& hash, CTransaction& tx, uint256& hashBlock)
+{
+    if (fCacheRingMembers) {
+        std::map<uint256, std::pair<CTransaction, uint256> >::const_iterator it = mapRingMemberTxCache.find(hash);
+        if (it != mapRingMemberTxCache.end()) {
+            tx = it->second.first;
+            hashBlock = it->second.second;
+            return true;
+        }
+    }
+    if (!GetTransaction(hash, tx, hashBlock)) {
+        return false;
+    }
+    if (fCacheRingMembers) {
+        mapRingMemberTxCache[hash] = std::make_pair(tx, hashBlock);
+    }
+    return true;
+}
+
 bool CWallet::MakeShnorrSignature(CTransaction& wtxNew)
 {
     LOCK(cs_wallet);
@@ -3980,15 +3932,16 @@ bool CWallet::selectDecoysAndRealIndex(CTransaction& tx, int& myIndex, int ringS
         for (int i = chainActive.Height() - Params().COINBASE_MATURITY(); i > 0; i--) {
             if (coinbaseDecoysPool.size() > 100) break;
             CBlockIndex* p = chainActive[i];
-            CBlock b;
-            if (ReadBlockFromDisk(b, p)) {
+            std::shared_ptr<const CBlock> pb = ReadBlockFromDisk(p);
+            if (pb) {
+                const CBlock& b = *pb;
                 int coinbaseIdx = 0;
                 if (p->IsProofOfStake()) {
                     coinbaseIdx = 1;
                 }
                 //dont select poa as decoy
                 if (b.posBlocksAudited.size() > 0) continue;
-                CTransaction& coinbase = b.vtx[coinbaseIdx];
+                const CTransaction& coinbase = b.vtx[coinbaseIdx];
 
                 for (size_t i = 0; i < coinbase.vout.size(); i++) {
                     if (!coinbase.vout[i].IsNull() && !coinbase.vout[i].commitment.empty() && coinbase.vout[i].nValue > 0 && !coinbase.vout[i].IsEmpty()) {
@@ -4020,7 +3973,7 @@ bool CWallet::selectDecoysAndRealIndex(CTransaction& tx, int& myIndex, int ringS
         //generate key images and choose decoys
         CTransaction txPrev;
         uint256 hashBlock;
-        if (!GetTransaction(tx.vin[i].prevout.hash, txPrev, hashBlock)) {
+        if (!getRingMemberTransaction(tx.vin[i].prevout.hash, txPrev, hashBlock)) {
             LogPrintf("Selected transaction: %s is not in the main chain\n", tx.vin[i].prevout.hash.GetHex().c_str());
             return false;
         }
@@ -5355,6 +5308,7 @@ bool CWallet::SendAll(std::string des, CWalletTx& wtxNew, bool inclLocked)
                                 break;
                             }
 
+                            std::future<std::vector<unsigned char> > bulletproof = startBulletProofAggregate(wtxNew);
                             if (!makeRingCT(wtxNew, ringSize, strFailReason)) {
                                 strFailReason = _("Failed to generate RingCT");
                                 ret = false;
@@ -5362,7 +5316,7 @@ bool CWallet::SendAll(std::string des, CWalletTx& wtxNew, bool inclLocked)
                                 throw std::runtime_error(strFailReason);
                             }
 
-                            if (ret && !generateBulletProofAggregate(wtxNew)) {
+                            if (ret && !generateBulletProofAggregate(wtxNew, bulletproof)) {
                                 strFailReason = _("Failed to generate bulletproof");
                                 ret = false;
                                 LogPrintf("%s: %s\n", __func__, strFailReason);
@@ -5619,11 +5573,12 @@ bool CWallet::CreateSweepingTransaction(CAmount target, CAmount threshold, uint3
                             }
 
                             std::string strFailReason;
+                            std::future<std::vector<unsigned char> > bulletproof = startBulletProofAggregate(wtxNew);
                             if (!makeRingCT(wtxNew, ringSize, strFailReason)) {
                                 ret = false;
                             }
 
-                            if (ret && !generateBulletProofAggregate(wtxNew)) {
+                            if (ret && !generateBulletProofAggregate(wtxNew, bulletproof)) {
                                 strFailReason = _("There is an internal error in generating bulletproofs. Please try again later.");
                                 ret = false;
                             }
@@ -5993,26 +5948,14 @@ int CMerkleTx::GetTransactionLockSignatures() const
     if (fLargeWorkForkFound || fLargeWorkInvalidChainFound) return -2;
     if (!fEnableSwiftTX) return -1;
 
-    //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(GetHash());
-    if (i != mapTxLocks.end()) {
-        return (*i).second.CountSignatures();
-    }
-
-    return -1;
+    return swiftTX.CountLockSignatures(GetHash());
 }
 
 bool CMerkleTx::IsTransactionLockTimedOut() const
 {
     if (!fEnableSwiftTX) return 0;
 
-    //compile consessus vote
-    std::map<uint256, CTransactionLock>::iterator i = mapTxLocks.find(GetHash());
-    if (i != mapTxLocks.end()) {
-        return GetTime() > (*i).second.nTimeout;
-    }
-
-    return false;
+    return swiftTX.IsTransactionLockTimedOut(GetHash());
 }
 
 std::string CWallet::GetUniqueWalletBackupName() const
@@ -6639,6 +6582,38 @@ bool CWallet::SendToStealthAddress(const std::string& stealthAddr, const CAmount
     return true;
 }
 
+void CWallet::SendToStealthAddressBatch(const std::vector<std::pair<std::string, CAmount> >& vecSend, std::vector<uint256>& vTxHashes, std::vector<std::string>& vErrors)
+{
+    LOCK2(cs_main, cs_wallet);
+
+    if (IsLocked()) {
+        std::string strFailReason = "Error: Wallet locked, unable to create transaction!";
+        LogPrintf("%s: %s\n", __func__, strFailReason);
+        throw std::runtime_error(strFailReason);
+    }
+
+    vTxHashes.clear();
+    vErrors.clear();
+
+    //Decoys are drawn from the same pools for every transaction of the batch,
+    //keep the ring members read from disk until the whole batch is built
+    CRingMemberCacheScope ringMemberCache(*this);
+    int nCreated = 0;
+    for (const PAIRTYPE(std::string, CAmount) & s : vecSend) {
+        CWalletTx wtx;
+        try {
+            SendToStealthAddress(s.first, s.second, wtx);
+            vTxHashes.push_back(wtx.GetHash());
+            vErrors.push_back("");
+            nCreated++;
+        } catch (const std::exception& e) {
+            vTxHashes.push_back(UINT256_ZERO);
+            vErrors.push_back(e.what());
+        }
+    }
+    LogPrintf("%s: created %d transactions for %d recipients\n", __func__, nCreated, vecSend.size());
+}
+
 bool CWallet::IsTransactionForMe(const CTransaction& tx)
 {
     LOCK(cs_wallet);
@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <future>
 #include <map>
 #include <memory>
 #include <set>
@@ -374,6 +375,27 @@ public:
     mutable std::map<CScript, CKey> blindMap;
     mutable std::map<COutPoint, uint256> userDecoysPool;	//used in transaction spending user transaction
     mutable std::map<COutPoint, uint256> coinbaseDecoysPool; //used in transction spending coinbase
+    std::map<uint256, std::pair<CTransaction, uint256> > mapRingMemberTxCache; //ring member and spent transactions, with their block, read while a send batch is in progress
+    bool fCacheRingMembers = false;
+
+    /** Keeps ring member transactions cached while in scope, for a batch of sends */
+    class CRingMemberCacheScope
+    {
+    private:
+        CWallet& wallet;
+
+    public:
+        explicit CRingMemberCacheScope(CWallet& walletIn) : wallet(walletIn)
+        {
+            wallet.mapRingMemberTxCache.clear();
+            wallet.fCacheRingMembers = true;
+        }
+        ~CRingMemberCacheScope()
+        {
+            wallet.fCacheRingMembers = false;
+            wallet.mapRingMemberTxCache.clear();
+        }
+    };
 
     CAmount dirtyCachedBalance = 0;
 
@@ -621,6 +643,7 @@ public:
     static bool DecodeStealthAddress(const std::string& stealth, CPubKey& pubViewKey, CPubKey& pubSpendKey, bool& hasPaymentID, uint64_t& paymentID);
     static bool ComputeStealthDestination(const CKey& secret, const CPubKey& pubViewKey, const CPubKey& pubSpendKey, CPubKey& des);
     bool SendToStealthAddress(const std::string& stealthAddr, CAmount nValue, CWalletTx& wtxNew, bool fUseIX = false, int ringSize = 5);
+    void SendToStealthAddressBatch(const std::vector<std::pair<std::string, CAmount> >& vecSend, std::vector<uint256>& vTxHashes, std::vector<std::string>& vErrors);
     bool GenerateAddress(CPubKey& pub, CPubKey& txPub, CKey& txPriv) const;
     bool IsTransactionForMe(const CTransaction& tx);
     bool ReadAccountList(std::string& accountList);
@@ -665,9 +688,11 @@ private:
     bool encodeStealthBase58(const std::vector<unsigned char>& raw, std::string& stealth);
     bool allMyPrivateKeys(std::vector<CKey>& spends, std::vector<CKey>& views);
     void createMasterKey() const;
-    bool generateBulletProofAggregate(CTransaction& tx);
+    std::future<std::vector<unsigned char> > startBulletProofAggregate(const CTransaction& tx);
+    bool generateBulletProofAggregate(CTransaction& tx, std::future<std::vector<unsigned char> >& pending);
     bool selectDecoysAndRealIndex(CTransaction& tx, int& myIndex, int ringSize);
     bool makeRingCT(CTransaction& wtxNew, int ringSize, std::string& strFailReason);
+    bool getRingMemberTransaction(const uint256& hash, CTransaction& tx, uint256& hashBlock);
     int walletIdxCache = 0;
     bool isMatchMyKeyImage(const CKeyImage& ki, const COutPoint& out);
     void ScanWalletKeyImages();
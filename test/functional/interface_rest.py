@@ -20,6 +20,19 @@ def deser_uint256(f):
         r += t << (i * 32)
     return r
 
+def deser_compact_size(f):
+    nit = unpack("<B", f.read(1))[0]
+    if nit == 253:
+        nit = unpack("<H", f.read(2))[0]
+    elif nit == 254:
+        nit = unpack("<I", f.read(4))[0]
+    elif nit == 255:
+        nit = unpack("<Q", f.read(8))[0]
+    return nit
+
+def deser_bytes(f):
+    return f.read(deser_compact_size(f))
+
 #allows simple http get calls
 def http_get_call(host, port, path, response_object = 0):
     conn = http.client.HTTPConnection(host, port)
@@ -315,6 +328,99 @@ class RESTTest (BitcoinTestFramework):
         for tx in txs:
             assert_equal(tx in json_obj['tx'], True)
 
+        #the block object matches the RPC one, with the transaction ids in the same order
+        rpc_block_json = self.nodes[0].getblock(newblockhash[0])
+        for key in ['hash', 'height', 'merkleroot', 'time', 'nonce', 'bits', 'previousblockhash', 'tx']:
+            assert_equal(json_obj[key], rpc_block_json[key])
+
+        ##################
+        # /rest/outputs/ #
+        ##################
+        rpc_tx_json = self.nodes[0].getrawtransaction(txs[0], 1)
+
+        json_string = http_get_call(url.hostname, url.port, '/rest/outputs/'+txs[0]+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['txid'], txs[0])
+        assert_equal(json_obj['blockhash'], newblockhash[0])
+        assert_equal(len(json_obj['vout']), len(rpc_tx_json['vout']))
+        for out, rpc_out in zip(json_obj['vout'], rpc_tx_json['vout']):
+            assert_equal(out['n'], rpc_out['n'])
+            assert_equal(out['commitment'], rpc_out['commitment'])
+            assert_equal(out['txpubkey'], rpc_out['txpubkey'])
+            assert_equal(out['encoded_amount'], rpc_out['encoded_amount'])
+            assert_equal(out['encoded_mask'], rpc_out['encoded_mask'])
+
+        response = http_get_call(url.hostname, url.port, '/rest/outputs/'+txs[0]+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        output = BytesIO(response.read())
+        assert_equal(hex(deser_uint256(output))[2:].zfill(64), newblockhash[0])
+        assert_equal(deser_compact_size(output), len(json_obj['vout']))
+        for out in json_obj['vout']:
+            assert_equal(bytes_to_hex_str(deser_bytes(output)), out['pubkey'])
+            assert_equal(bytes_to_hex_str(deser_bytes(output)), out['commitment'])
+            assert_equal(bytes_to_hex_str(deser_bytes(output)[::-1]), out['txpubkey'])
+            assert_equal(hex(deser_uint256(output))[2:].zfill(64), out['encoded_amount'])
+            assert_equal(hex(deser_uint256(output))[2:].zfill(64), out['encoded_mask'])
+        assert_equal(output.read(), b'')
+
+        response = http_get_call(url.hostname, url.port, '/rest/outputs/'+'0'*64+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+
+        ###################
+        # /rest/keyimage/ #
+        ###################
+        keyimage = rpc_tx_json['vin'][0]['keyimage']
+
+        json_string = http_get_call(url.hostname, url.port, '/rest/keyimage/'+keyimage+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['keyimage'], keyimage)
+        assert_equal(json_obj['spent'], True)
+        assert_equal(json_obj['blockhash'], newblockhash[0])
+        assert_equal(json_obj['height'], rpc_block_json['height'])
+        assert_equal(json_obj['confirmations'], self.nodes[0].getblockcount() - rpc_block_json['height'] + 1)
+
+        response = http_get_call(url.hostname, url.port, '/rest/keyimage/'+keyimage+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        output = BytesIO(response.read())
+        assert_equal(bytes_to_hex_str(deser_bytes(output)[::-1]), keyimage)
+        assert_equal(unpack("<?", output.read(1))[0], True)
+        assert_equal(unpack("<i", output.read(4))[0], rpc_block_json['height'])
+        assert_equal(hex(deser_uint256(output))[2:].zfill(64), newblockhash[0])
+
+        #a key image that was never spent, listed in reverse like the one above
+        unspent_keyimage = '11'*32 + '02'
+        json_string = http_get_call(url.hostname, url.port, '/rest/keyimage/'+unspent_keyimage+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string)
+        assert_equal(json_obj['spent'], False)
+        assert('blockhash' not in json_obj)
+
+        response = http_get_call(url.hostname, url.port, '/rest/keyimage/'+unspent_keyimage+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        output = BytesIO(response.read())
+        assert_equal(bytes_to_hex_str(deser_bytes(output)[::-1]), unspent_keyimage)
+        assert_equal(unpack("<?", output.read(1))[0], False)
+        assert_equal(unpack("<i", output.read(4))[0], -1)
+
+        response = http_get_call(url.hostname, url.port, '/rest/keyimage/'+keyimage[2:]+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 400)
+
+        ##############
+        # /rest/poa/ #
+        ##############
+        # the chain here ends before the first PoA block, so only the error replies are checked
+        response = http_get_call(url.hostname, url.port, '/rest/poa/'+newblockhash[0]+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 400)
+        assert('is not a PoA block' in response.read().decode('utf-8'))
+
+        response = http_get_call(url.hostname, url.port, '/rest/poa/'+newblockhash[0]+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 400)
+
+        response = http_get_call(url.hostname, url.port, '/rest/poa/'+'0'*64+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 404)
+
+        response = http_get_call(url.hostname, url.port, '/rest/poa/'+newblockhash[0][2:]+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 400)
+
         #test rest bestblock
         bb_hash = self.nodes[0].getbestblockhash()
 